@@ -0,0 +1,290 @@
+/******************************************************************************
+ * Copyright (c) 2017-2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+// examples/benchmarks/benchmark_shared.h
+//
+// Timing, statistics and JSON reporting shared by the benchmark suites.
+
+#ifndef BENCHMARK_SHARED_H
+#define BENCHMARK_SHARED_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Wall clock stop watch based on the steady clock. The watch accumulates the time between
+// start() and stop() calls, which allows excluding setup and cleanup work from a measurement.
+class Timer {
+public:
+    Timer() : m_elapsed(0.0), m_running(false) {}
+
+    // Starts or resumes the measurement.
+    void start()
+    {
+        if (!m_running) {
+            m_start   = std::chrono::steady_clock::now();
+            m_running = true;
+        }
+    }
+
+    // Pauses the measurement.
+    void stop()
+    {
+        if (m_running) {
+            m_elapsed += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - m_start).count();
+            m_running = false;
+        }
+    }
+
+    // Returns the accumulated time in seconds.
+    double elapsed() const
+    {
+        if (!m_running)
+            return m_elapsed;
+        return m_elapsed + std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    double                                m_elapsed;
+    bool                                  m_running;
+};
+
+// The measurements of one benchmark case.
+//
+// The first run of a case is reported separately as the "cold" run: it pays for everything
+// that is initialized lazily (JIT setup, imported modules, file system caches, ...). All
+// following runs are "warm" runs.
+struct Benchmark_result {
+    std::string         suite;    // the measured operation, e.g. "load" or "execute"
+    std::string         corpus;   // "synthetic", "real_world" or "micro"
+    std::string         name;     // the measured entity, e.g. a module name
+    double              cold;     // time of the cold run in seconds, < 0 if there was none
+    std::vector<double> warm;     // times of the warm runs in seconds
+    double              items;    // number of items processed per run, 0 if not applicable
+    std::string         unit;     // the unit of the items, e.g. "materials"
+    std::string         error;    // non-empty if the case failed
+
+    Benchmark_result() : cold(-1.0), items(0.0) {}
+
+    // Records the time of one run; the first one is the cold run.
+    void add_run(double seconds, bool is_cold)
+    {
+        if (is_cold)
+            cold = seconds;
+        else
+            warm.push_back(seconds);
+    }
+
+    // Returns the median of the warm runs, or the cold run if there are no warm runs.
+    double median() const
+    {
+        if (warm.empty())
+            return cold;
+        std::vector<double> sorted(warm);
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        return (n & 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+};
+
+// Collects the results of all suites and writes them as JSON and as a human readable summary.
+class Benchmark_report {
+public:
+    // Adds a new result and returns it.
+    Benchmark_result &add(
+        std::string const &suite,
+        std::string const &corpus,
+        std::string const &name)
+    {
+        m_results.push_back(Benchmark_result());
+        Benchmark_result &res = m_results.back();
+        res.suite  = suite;
+        res.corpus = corpus;
+        res.name   = name;
+        return res;
+    }
+
+    // Adds an entry to the "config" object of the JSON output.
+    void set_config(std::string const &key, std::string const &value)
+    {
+        m_config.push_back(std::make_pair(key, value));
+    }
+
+    // Returns the number of failed cases.
+    size_t get_failure_count() const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < m_results.size(); ++i)
+            if (!m_results[i].error.empty())
+                ++n;
+        return n;
+    }
+
+    // Writes all results as one JSON document.
+    void write_json(std::ostream &os) const
+    {
+        os << "{\n  \"schema\": 1,\n  \"config\": {";
+        for (size_t i = 0; i < m_config.size(); ++i) {
+            os << (i == 0 ? "\n" : ",\n") << "    " << quote(m_config[i].first) << ": "
+               << quote(m_config[i].second);
+        }
+        os << "\n  },\n  \"results\": [";
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            Benchmark_result const &res = m_results[i];
+
+            os << (i == 0 ? "\n" : ",\n") << "    {"
+               << "\"suite\": "   << quote(res.suite)
+               << ", \"corpus\": " << quote(res.corpus)
+               << ", \"name\": "   << quote(res.name);
+            if (res.cold >= 0.0)
+                os << ", \"cold_s\": " << number(res.cold);
+            if (!res.warm.empty()) {
+                double sum = 0.0;
+                for (size_t k = 0; k < res.warm.size(); ++k)
+                    sum += res.warm[k];
+                double mean = sum / res.warm.size();
+                double var  = 0.0;
+                for (size_t k = 0; k < res.warm.size(); ++k)
+                    var += (res.warm[k] - mean) * (res.warm[k] - mean);
+
+                os << ", \"warm\": {\"runs\": " << res.warm.size()
+                   << ", \"min_s\": "    << number(*std::min_element(res.warm.begin(), res.warm.end()))
+                   << ", \"median_s\": " << number(res.median())
+                   << ", \"mean_s\": "   << number(mean)
+                   << ", \"max_s\": "    << number(*std::max_element(res.warm.begin(), res.warm.end()))
+                   << ", \"stddev_s\": " << number(std::sqrt(var / res.warm.size()))
+                   << "}";
+            }
+            if (res.items > 0.0) {
+                os << ", \"items\": " << number(res.items) << ", \"unit\": " << quote(res.unit);
+                double t = res.median();
+                if (t > 0.0)
+                    os << ", \"throughput_per_s\": " << number(res.items / t);
+            }
+            if (!res.error.empty())
+                os << ", \"error\": " << quote(res.error);
+            os << "}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    // Prints one line per result with the cold time and the median of the warm runs.
+    void print_summary(std::ostream &os) const
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%-10s %-10s %-52s %12s %12s %14s\n",
+            "suite", "corpus", "name", "cold [ms]", "warm [ms]", "items/s");
+        os << line;
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            Benchmark_result const &res = m_results[i];
+            if (!res.error.empty()) {
+                snprintf(line, sizeof(line), "%-10s %-10s %-52s FAILED: %s\n",
+                    res.suite.c_str(), res.corpus.c_str(), res.name.c_str(), res.error.c_str());
+                os << line;
+                continue;
+            }
+            double t = res.median();
+            snprintf(line, sizeof(line), "%-10s %-10s %-52s %12.3f %12.3f %14.4g\n",
+                res.suite.c_str(), res.corpus.c_str(), res.name.c_str(),
+                res.cold >= 0.0 ? res.cold * 1000.0 : 0.0,
+                res.warm.empty() ? 0.0 : t * 1000.0,
+                res.items > 0.0 && t > 0.0 ? res.items / t : 0.0);
+            os << line;
+        }
+    }
+
+private:
+    // Returns the given string as a quoted and escaped JSON string.
+    static std::string quote(std::string const &s)
+    {
+        std::string res("\"");
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            switch (c) {
+            case '"':  res += "\\\""; break;
+            case '\\': res += "\\\\"; break;
+            case '\n': res += "\\n";  break;
+            case '\r': res += "\\r";  break;
+            case '\t': res += "\\t";  break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    res += buf;
+                } else
+                    res += char(c);
+                break;
+            }
+        }
+        res += '"';
+        return res;
+    }
+
+    // Formats a number for JSON output.
+    static std::string number(double d)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.9g", d);
+        return buf;
+    }
+
+    std::vector<Benchmark_result>                    m_results;
+    std::vector<std::pair<std::string, std::string> > m_config;
+};
+
+// Runs the given function once cold and num_warm times warm and records the times.
+// The function receives the index of the run and the running timer, which it may stop and
+// restart around work that should not be measured. It returns false on failure, in which case
+// the measurement ends and the result is marked as failed.
+template<typename F>
+bool measure(Benchmark_result &res, unsigned num_warm, F func)
+{
+    for (unsigned run = 0; run <= num_warm; ++run) {
+        Timer timer;
+        timer.start();
+        bool ok = func(run, timer);
+        timer.stop();
+        if (!ok) {
+            if (res.error.empty())
+                res.error = "run failed";
+            return false;
+        }
+        res.add_run(timer.elapsed(), run == 0);
+    }
+    return true;
+}
+
+#endif // BENCHMARK_SHARED_H
@@ -0,0 +1,992 @@
+/******************************************************************************
+ * Copyright (c) 2017-2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+// examples/benchmarks/mdl_sdk_benchmarks.cpp
+//
+// End-to-end benchmarks of the MDL SDK. Measures module loading, instance and class compilation,
+// native and PTX code generation, native execution and texture loading on a synthetic and a
+// real-world corpus, and access/release churn of DB elements from many threads. The results are
+// printed as a table and written as JSON, so they can be tracked over time on CPU-only machines.
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mi/mdl_sdk.h>
+
+#include "example_shared.h"
+#include "benchmark_shared.h"
+
+
+// Command line options structure.
+struct Options {
+    // The JSON output file name.
+    std::string json_file;
+
+    // Number of warm runs per benchmark case (in addition to the cold run).
+    unsigned num_warm;
+
+    // Number of modules and materials per module of the synthetic corpus.
+    unsigned num_synthetic_modules;
+    unsigned num_synthetic_materials;
+
+    // Number of native evaluations per material and run.
+    unsigned num_samples;
+
+    // Whether the synthetic resp. real-world corpus is used.
+    bool use_synthetic;
+    bool use_real_world;
+
+    // Comma separated list of suites to run.
+    std::string suites;
+
+    // List of MDL module paths.
+    std::vector<std::string> mdl_paths;
+
+    Options()
+        : json_file("mdl_sdk_benchmarks.json")
+        , num_warm(5)
+        , num_synthetic_modules(4)
+        , num_synthetic_materials(8)
+        , num_samples(16384)
+        , use_synthetic(true)
+        , use_real_world(true)
+        , suites("load,compile,translate,execute,texture,churn")
+    {}
+
+    // Returns true if the given suite should be run.
+    bool has_suite(char const *suite) const
+    {
+        std::string list = "," + suites + ",";
+        return list.find(std::string(",") + suite + ",") != std::string::npos;
+    }
+};
+
+// The backends and compilation modes measured by the translate suite.
+enum Compilation_mode { CM_INSTANCE, CM_CLASS, CM_COUNT };
+
+char const *get_mode_name(Compilation_mode mode)
+{
+    return mode == CM_CLASS ? "class" : "instance";
+}
+
+// One module of the benchmark corpus.
+struct Corpus_module {
+    // "synthetic" or "real_world".
+    std::string corpus;
+
+    // The MDL name of the module.
+    std::string name;
+
+    // The MDL source of synthetic modules, empty for file based modules.
+    std::string source;
+
+    // DB names of the material instances created from the materials of the module.
+    std::vector<std::string> instances;
+
+    // Native target code of the instance compiled materials, used by the execute suite.
+    std::vector<mi::base::Handle<mi::neuraylib::ITarget_code const> > native_code;
+
+    // Returns the DB name of the compiled material for the given instance.
+    std::string get_compiled_name(size_t i, Compilation_mode mode) const
+    {
+        return instances[i] + "_" + get_mode_name(mode);
+    }
+};
+
+// The modules of the real-world corpus, shipped with the examples.
+char const * const g_real_world_modules[] = {
+    "::nvidia::sdk_examples::tutorials",
+    "::nvidia::sdk_examples::carbon_composite",
+    "::nvidia::sdk_examples::carpaint_measured",
+    "::nvidia::sdk_examples::gun_metal",
+    "::nvidia::sdk_examples::measured_metal",
+    "::nvidia::sdk_examples::metal_single_diamond_plate",
+    "::nvidia::sdk_examples::procedural_noise",
+};
+
+// The textures of the real-world corpus, relative to the MDL search root of the examples.
+char const * const g_real_world_textures[] = {
+    "nvidia/sdk_examples/resources/example.png",
+    "nvidia/sdk_examples/resources/carbon_bump.png",
+    "nvidia/sdk_examples/resources/brushed_antique_copper_diff.jpg",
+    "nvidia/sdk_examples/resources/metal_diamond_pattern_norm.jpg",
+};
+
+// Creates the MDL source of a synthetic module.
+//
+// Each material layers a glossy over a textured diffuse BSDF and perturbs the normal. The
+// coordinates are warped by a loop whose trip count is a material parameter, so instance
+// compilation can fold it while class compilation cannot.
+std::string create_synthetic_module(unsigned index, unsigned num_materials)
+{
+    std::stringstream src;
+    src.setf(std::ios::fixed);
+    src.precision(3);
+    src << "mdl 1.4;\n"
+        << "import ::anno::*;\n"
+        << "import ::df::*;\n"
+        << "import ::math::*;\n"
+        << "import ::state::*;\n"
+        << "import ::tex::*;\n"
+        << "\n"
+        << "float3 warp(float3 p, int octaves, float freq) {\n"
+        << "    float3 r = p;\n"
+        << "    for (int i = 0; i < octaves; ++i) {\n"
+        << "        float f = freq * float(i + 1);\n"
+        << "        r = float3(\n"
+        << "            r.x + 0.1 * math::sin(r.y * f + " << index << ".0),\n"
+        << "            r.y + 0.1 * math::cos(r.z * f - float(i)),\n"
+        << "            r.z + 0.1 * math::sin(r.x * f + 0.5 * float(i)));\n"
+        << "    }\n"
+        << "    return r;\n"
+        << "}\n";
+
+    for (unsigned i = 0; i < num_materials; ++i) {
+        float r = 0.2f + 0.6f * float((index * 7 + i * 3) % 11) / 10.0f;
+        float g = 0.2f + 0.6f * float((index * 5 + i * 7) % 13) / 12.0f;
+        float b = 0.2f + 0.6f * float((index * 3 + i * 5) % 7) / 6.0f;
+
+        src << "\n"
+            << "export material material_" << i << "(\n"
+            << "    color tint = color(" << r << ", " << g << ", " << b << "),\n"
+            << "    float roughness = " << 0.05f + 0.05f * float(i % 8) << ",\n"
+            << "    int octaves = " << 2 + (i % 4) << ",\n"
+            << "    uniform texture_2d tex = texture_2d(\n"
+            << "        \"/nvidia/sdk_examples/resources/example.png\", ::tex::gamma_srgb)\n"
+            << ") [[ anno::description(\"synthetic benchmark material\") ]]\n"
+            << "= let {\n"
+            << "    float3 uvw = state::texture_coordinate(0);\n"
+            << "    float3 w = warp(uvw, octaves, " << 1.0f + float(i) << ");\n"
+            << "    color base = tex::lookup_color(tex, float2(w.x, w.y)) * tint;\n"
+            << "    bsdf diffuse = df::diffuse_reflection_bsdf(tint: base);\n"
+            << "    bsdf glossy = df::simple_glossy_bsdf(\n"
+            << "        roughness_u: roughness, tint: color(1.0), mode: df::scatter_reflect);\n"
+            << "} in material(\n"
+            << "    surface: material_surface(\n"
+            << "        scattering: df::fresnel_layer(\n"
+            << "            ior: color(1.5),\n"
+            << "            layer: glossy,\n"
+            << "            base: df::weighted_layer(\n"
+            << "                weight: math::saturate(0.5 + 0.5 * w.z),\n"
+            << "                layer: diffuse,\n"
+            << "                base: df::diffuse_reflection_bsdf(tint: tint)))),\n"
+            << "    geometry: material_geometry(\n"
+            << "        normal: math::normalize(state::normal() + 0.05 * (w - uvw))));\n";
+    }
+    return src.str();
+}
+
+// Returns the first error message of the context, or a generic message if there is none.
+std::string get_error(mi::neuraylib::IMdl_execution_context *context, char const *what)
+{
+    if (context->get_error_messages_count() > 0) {
+        mi::base::Handle<const mi::neuraylib::IMessage> message(context->get_error_message(0));
+        return message->get_string();
+    }
+    return what;
+}
+
+// Loads a module of the corpus. Returns the result of the load operation.
+mi::Sint32 load_module(
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_compiler* mdl_compiler,
+    mi::neuraylib::IMdl_execution_context* context,
+    Corpus_module const &module)
+{
+    if (module.source.empty())
+        return mdl_compiler->load_module(transaction, module.name.c_str(), context);
+    return mdl_compiler->load_module_from_string(
+        transaction, module.name.c_str(), module.source.c_str(), context);
+}
+
+// Measures loading the modules of the corpus.
+//
+// Every run loads the module into a new child scope of the global scope, so it is really
+// compiled again instead of being found in the database. The cold run additionally pays for
+// the imported modules and resources seen for the first time.
+void run_load_benchmarks(
+    Benchmark_report &report,
+    mi::neuraylib::INeuray* neuray,
+    mi::neuraylib::IMdl_compiler* mdl_compiler,
+    std::vector<Corpus_module> const &corpus,
+    Options const &options)
+{
+    mi::base::Handle<mi::neuraylib::IDatabase> database(
+        neuray->get_api_component<mi::neuraylib::IDatabase>());
+    mi::base::Handle<mi::neuraylib::IScope> global_scope(database->get_global_scope());
+    mi::base::Handle<mi::neuraylib::IMdl_factory> mdl_factory(
+        neuray->get_api_component<mi::neuraylib::IMdl_factory>());
+
+    for (size_t m = 0; m < corpus.size(); ++m) {
+        Corpus_module const &module = corpus[m];
+        Benchmark_result &res = report.add("load", module.corpus, module.name);
+
+        measure(res, options.num_warm, [&](unsigned, Timer &timer) {
+            timer.stop();
+            mi::base::Handle<mi::neuraylib::IScope> scope(
+                database->create_scope(global_scope.get(), 1));
+            mi::base::Handle<mi::neuraylib::ITransaction> transaction(
+                scope->create_transaction());
+            mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+                mdl_factory->create_execution_context());
+            timer.start();
+
+            mi::Sint32 result = load_module(transaction.get(), mdl_compiler, context.get(), module);
+
+            timer.stop();
+            if (result != 0)
+                res.error = result == 1
+                    ? "module was not reloaded" : get_error(context.get(), "load failed");
+            transaction->abort();
+            transaction = 0;
+            database->remove_scope(scope->get_id());
+            return result == 0;
+        });
+    }
+}
+
+// Loads all modules of the corpus into the given transaction and creates an instance with
+// default arguments for every material that has defaults for all its parameters. Modules that
+// fail to load are removed from the corpus.
+void prepare_corpus(
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_compiler* mdl_compiler,
+    mi::neuraylib::IMdl_factory* mdl_factory,
+    std::vector<Corpus_module> &corpus)
+{
+    for (size_t m = 0; m < corpus.size(); ) {
+        Corpus_module &module = corpus[m];
+
+        mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+            mdl_factory->create_execution_context());
+        if (load_module(transaction, mdl_compiler, context.get(), module) < 0) {
+            std::cerr << "Failed to load module \"" << module.name << "\", skipping it.\n";
+            print_messages(context.get());
+            corpus.erase(corpus.begin() + m);
+            continue;
+        }
+
+        mi::base::Handle<const mi::neuraylib::IModule> mdl_module(
+            transaction->access<mi::neuraylib::IModule>(("mdl" + module.name).c_str()));
+        for (mi::Size i = 0, n = mdl_module->get_material_count(); i < n; ++i) {
+            char const *material_db_name = mdl_module->get_material(i);
+            mi::base::Handle<const mi::neuraylib::IMaterial_definition> material_definition(
+                transaction->access<mi::neuraylib::IMaterial_definition>(material_db_name));
+
+            mi::Sint32 result = 0;
+            mi::base::Handle<mi::neuraylib::IMaterial_instance> material_instance(
+                material_definition->create_material_instance(0, &result));
+            if (result != 0 || !material_instance)
+                continue;  // parameters without defaults
+
+            std::string instance_name = std::string("benchmark instance of ") + material_db_name;
+            transaction->store(material_instance.get(), instance_name.c_str());
+            module.instances.push_back(instance_name);
+        }
+        ++m;
+    }
+}
+
+// Compiles all material instances of a module in the given mode and stores the results.
+bool compile_materials(
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_execution_context* context,
+    Corpus_module const &module,
+    Compilation_mode mode,
+    Timer &timer,
+    std::string &error)
+{
+    mi::Uint32 flags = mode == CM_CLASS
+        ? mi::neuraylib::IMaterial_instance::CLASS_COMPILATION
+        : mi::neuraylib::IMaterial_instance::DEFAULT_OPTIONS;
+
+    for (size_t i = 0; i < module.instances.size(); ++i) {
+        mi::base::Handle<const mi::neuraylib::IMaterial_instance> material_instance(
+            transaction->access<mi::neuraylib::IMaterial_instance>(
+                module.instances[i].c_str()));
+        mi::base::Handle<mi::neuraylib::ICompiled_material> compiled_material(
+            material_instance->create_compiled_material(flags, context));
+        if (!compiled_material) {
+            error = module.instances[i] + ": " + get_error(context, "compilation failed");
+            return false;
+        }
+
+        timer.stop();
+        transaction->store(
+            compiled_material.get(), module.get_compiled_name(i, mode).c_str());
+        timer.start();
+    }
+    return true;
+}
+
+// Measures instance and class compilation of the corpus materials.
+void run_compile_benchmarks(
+    Benchmark_report &report,
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_factory* mdl_factory,
+    std::vector<Corpus_module> const &corpus,
+    Options const &options)
+{
+    for (size_t m = 0; m < corpus.size(); ++m) {
+        Corpus_module const &module = corpus[m];
+        if (module.instances.empty())
+            continue;
+
+        for (int mode = 0; mode < CM_COUNT; ++mode) {
+            Benchmark_result &res = report.add(
+                "compile", module.corpus,
+                module.name + "/" + get_mode_name(Compilation_mode(mode)));
+            res.items = double(module.instances.size());
+            res.unit  = "materials";
+
+            measure(res, options.num_warm, [&](unsigned, Timer &timer) {
+                mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+                    mdl_factory->create_execution_context());
+                return compile_materials(
+                    transaction, context.get(), module, Compilation_mode(mode),
+                    timer, res.error);
+            });
+        }
+    }
+}
+
+// Translates the surface BSDF and the normal of all compiled materials of a module, using one
+// link unit per material. Returns the target code of the last run in code.
+bool translate_materials(
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_backend* backend,
+    mi::neuraylib::IMdl_execution_context* context,
+    Corpus_module const &module,
+    Compilation_mode mode,
+    std::vector<mi::base::Handle<mi::neuraylib::ITarget_code const> > &code,
+    std::string &error)
+{
+    code.clear();
+    for (size_t i = 0; i < module.instances.size(); ++i) {
+        std::string compiled_name = module.get_compiled_name(i, mode);
+        mi::base::Handle<const mi::neuraylib::ICompiled_material> compiled_material(
+            transaction->access<mi::neuraylib::ICompiled_material>(compiled_name.c_str()));
+
+        mi::base::Handle<mi::neuraylib::ILink_unit> link_unit(
+            backend->create_link_unit(transaction, context));
+        if (!link_unit
+            || link_unit->add_material_df(
+                compiled_material.get(), "surface.scattering", "bsdf", context) != 0
+            || link_unit->add_material_expression(
+                compiled_material.get(), "geometry.normal", "normal", context) != 0)
+        {
+            error = compiled_name + ": " + get_error(context, "link unit creation failed");
+            return false;
+        }
+
+        mi::base::Handle<mi::neuraylib::ITarget_code const> target_code(
+            backend->translate_link_unit(link_unit.get(), context));
+        if (!target_code) {
+            error = compiled_name + ": " + get_error(context, "translation failed");
+            return false;
+        }
+        code.push_back(target_code);
+    }
+    return true;
+}
+
+// Measures native and PTX code generation for the corpus materials.
+void run_translate_benchmarks(
+    Benchmark_report &report,
+    mi::neuraylib::ITransaction* transaction,
+    mi::neuraylib::IMdl_compiler* mdl_compiler,
+    mi::neuraylib::IMdl_factory* mdl_factory,
+    std::vector<Corpus_module> &corpus,
+    Options const &options,
+    bool measure_translation)
+{
+    mi::base::Handle<mi::neuraylib::IMdl_backend> be_native(
+        mdl_compiler->get_backend(mi::neuraylib::IMdl_compiler::MB_NATIVE));
+    check_success(be_native->set_option("num_texture_spaces", "1") == 0);
+    check_success(be_native->set_option("num_texture_results", "16") == 0);
+
+    mi::base::Handle<mi::neuraylib::IMdl_backend> be_cuda_ptx(
+        mdl_compiler->get_backend(mi::neuraylib::IMdl_compiler::MB_CUDA_PTX));
+    check_success(be_cuda_ptx->set_option("num_texture_spaces", "1") == 0);
+    check_success(be_cuda_ptx->set_option("num_texture_results", "16") == 0);
+    check_success(be_cuda_ptx->set_option("sm_version", "50") == 0);
+
+    for (size_t m = 0; m < corpus.size(); ++m) {
+        Corpus_module &module = corpus[m];
+        if (module.instances.empty())
+            continue;
+
+        if (!measure_translation) {
+            // only produce the code needed by the execute suite
+            mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+                mdl_factory->create_execution_context());
+            std::string error;
+            if (!translate_materials(
+                    transaction, be_native.get(), context.get(), module, CM_INSTANCE,
+                    module.native_code, error))
+                std::cerr << "Native translation failed: " << error << "\n";
+            continue;
+        }
+
+        for (int backend = 0; backend < 2; ++backend) {
+            mi::neuraylib::IMdl_backend *be = backend == 0 ? be_native.get() : be_cuda_ptx.get();
+            char const *be_name = backend == 0 ? "native" : "ptx";
+
+            for (int mode = 0; mode < CM_COUNT; ++mode) {
+                Benchmark_result &res = report.add(
+                    "translate", module.corpus,
+                    module.name + "/" + be_name + "/" + get_mode_name(Compilation_mode(mode)));
+                res.items = double(module.instances.size());
+                res.unit  = "materials";
+
+                std::vector<mi::base::Handle<mi::neuraylib::ITarget_code const> > code;
+                measure(res, options.num_warm, [&](unsigned, Timer &) {
+                    mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+                        mdl_factory->create_execution_context());
+                    return translate_materials(
+                        transaction, be, context.get(), module, Compilation_mode(mode),
+                        code, res.error);
+                });
+
+                if (backend == 0 && mode == CM_INSTANCE && res.error.empty())
+                    module.native_code.swap(code);
+            }
+        }
+    }
+}
+
+// Returns the index of the callable function with the given name, or -1.
+mi::Sint32 find_function(mi::neuraylib::ITarget_code const *code, char const *name)
+{
+    for (mi::Size i = 0, n = code->get_callable_function_count(); i < n; ++i)
+        if (strcmp(code->get_callable_function(i), name) == 0)
+            return mi::Sint32(i);
+    return -1;
+}
+
+// Returns a deterministic pseudo-random number in [0, 1).
+float random_float(mi::Uint32 &seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return float(seed >> 8) * (1.0f / 16777216.0f);
+}
+
+// The last row is always implied to be (0, 0, 0, 1).
+const mi::Float32_3_4 identity(
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f
+);
+
+// Measures the throughput of the native code generated by the translate suite: BSDF init plus
+// evaluation, and evaluation of the normal expression.
+void run_execute_benchmarks(
+    Benchmark_report &report,
+    std::vector<Corpus_module> const &corpus,
+    Options const &options)
+{
+    for (size_t m = 0; m < corpus.size(); ++m) {
+        Corpus_module const &module = corpus[m];
+        if (module.native_code.empty())
+            continue;
+
+        for (int kind = 0; kind < 2; ++kind) {
+            bool bsdf = kind == 0;
+            Benchmark_result &res = report.add(
+                "execute", module.corpus, module.name + (bsdf ? "/bsdf" : "/normal"));
+            res.items = double(options.num_samples) * module.native_code.size();
+            res.unit  = "evaluations";
+
+            measure(res, options.num_warm, [&](unsigned, Timer &) {
+                mi::neuraylib::tct_float3 texture_coords[1]    = { { 0.0f, 0.0f, 0.0f } };
+                mi::neuraylib::tct_float3 texture_tangent_u[1] = { { 1.0f, 0.0f, 0.0f } };
+                mi::neuraylib::tct_float3 texture_tangent_v[1] = { { 0.0f, 1.0f, 0.0f } };
+                mi::neuraylib::tct_float4 texture_results[16];
+
+                mi::neuraylib::Shading_state_material mdl_state = {
+                    /*normal=*/           { 0.0f, 0.0f, 1.0f },
+                    /*geom_normal=*/      { 0.0f, 0.0f, 1.0f },
+                    /*position=*/         { 0.0f, 0.0f, 0.0f },
+                    /*animation_time=*/   0.0f,
+                    /*texture_coords=*/   texture_coords,
+                    /*tangent_u=*/        texture_tangent_u,
+                    /*tangent_v=*/        texture_tangent_v,
+                    /*text_results=*/     texture_results,
+                    /*ro_data_segment=*/  nullptr,
+                    /*world_to_object=*/  &identity[0],
+                    /*object_to_world=*/  &identity[0],
+                    /*object_id=*/        0
+                };
+
+                for (size_t c = 0; c < module.native_code.size(); ++c) {
+                    mi::neuraylib::ITarget_code const *code = module.native_code[c].get();
+                    mi::Sint32 init_index   = find_function(code, "bsdf_init");
+                    mi::Sint32 eval_index   = find_function(code, "bsdf_evaluate");
+                    mi::Sint32 normal_index = find_function(code, "normal");
+                    if (init_index < 0 || eval_index < 0 || normal_index < 0) {
+                        res.error = "generated functions not found";
+                        return false;
+                    }
+
+                    mi::Uint32 seed = 1;
+                    for (unsigned s = 0; s < options.num_samples; ++s) {
+                        float u = random_float(seed);
+                        float v = random_float(seed);
+                        mdl_state.normal.x = mdl_state.normal.y = 0.0f;
+                        mdl_state.normal.z = 1.0f;
+                        mdl_state.position.x = 2.0f * u - 1.0f;
+                        mdl_state.position.y = 2.0f * v - 1.0f;
+                        texture_coords[0].x = u;
+                        texture_coords[0].y = v;
+
+                        mi::Sint32 result;
+                        if (bsdf) {
+                            mi::neuraylib::Bsdf_evaluate_data eval_data;
+                            eval_data.ior1.x = eval_data.ior1.y = eval_data.ior1.z = 1.0f;
+                            eval_data.ior2.x = MI_NEURAYLIB_BSDF_USE_MATERIAL_IOR;
+                            eval_data.k1.x = 0.0f;
+                            eval_data.k1.y = 0.6f;
+                            eval_data.k1.z = 0.8f;
+                            eval_data.k2.x = 0.6f * (2.0f * u - 1.0f);
+                            eval_data.k2.y = 0.6f * (2.0f * v - 1.0f);
+                            eval_data.k2.z = 0.5f;
+
+                            result = code->execute_bsdf_init(
+                                init_index, mdl_state, nullptr, nullptr);
+                            if (result == 0)
+                                result = code->execute_bsdf_evaluate(
+                                    eval_index, &eval_data, mdl_state, nullptr, nullptr);
+                        } else {
+                            mi::neuraylib::tct_float3 normal;
+                            result = code->execute(
+                                normal_index, mdl_state, nullptr, nullptr, &normal);
+                        }
+                        if (result != 0) {
+                            res.error = bsdf ? "BSDF execution failed" : "execution failed";
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            });
+        }
+    }
+}
+
+// Writes the synthetic textures to the working directory and returns their file names.
+std::vector<std::string> create_synthetic_textures(
+    mi::neuraylib::IMdl_compiler* mdl_compiler,
+    mi::neuraylib::IImage_api* image_api)
+{
+    std::vector<std::string> files;
+
+    // an 8-bit RGBA image with a smooth gradient and noise, so it does not compress trivially
+    {
+        mi::Uint32 const res = 2048;
+        mi::base::Handle<mi::neuraylib::ICanvas> canvas(
+            image_api->create_canvas("Rgba", res, res));
+        mi::base::Handle<mi::neuraylib::ITile> tile(canvas->get_tile(0, 0));
+        mi::Uint8 *data = static_cast<mi::Uint8 *>(tile->get_data());
+        mi::Uint32 seed = 1;
+        for (mi::Uint32 y = 0; y < res; ++y) {
+            for (mi::Uint32 x = 0; x < res; ++x) {
+                mi::Uint8 *p = &data[4 * (y * res + x)];
+                mi::Uint8 noise = mi::Uint8(random_float(seed) * 32.0f);
+                p[0] = mi::Uint8((x * 223u / res) + noise);
+                p[1] = mi::Uint8((y * 223u / res) + noise);
+                p[2] = mi::Uint8(((x ^ y) & 0xff) * 223u / 255u + noise);
+                p[3] = 255;
+            }
+        }
+        std::string file = "mdl_sdk_benchmarks_synthetic_2048.png";
+        if (mdl_compiler->export_canvas(file.c_str(), canvas.get()) == 0)
+            files.push_back(file);
+    }
+
+    // a floating point image
+    {
+        mi::Uint32 const res = 1024;
+        mi::base::Handle<mi::neuraylib::ICanvas> canvas(
+            image_api->create_canvas("Color", res, res));
+        mi::base::Handle<mi::neuraylib::ITile> tile(canvas->get_tile(0, 0));
+        mi::Float32 *data = static_cast<mi::Float32 *>(tile->get_data());
+        mi::Uint32 seed = 2;
+        for (mi::Uint32 y = 0; y < res; ++y) {
+            for (mi::Uint32 x = 0; x < res; ++x) {
+                mi::Float32 *p = &data[4 * (y * res + x)];
+                p[0] = 4.0f * float(x) / res + random_float(seed);
+                p[1] = 4.0f * float(y) / res + random_float(seed);
+                p[2] = random_float(seed);
+                p[3] = 1.0f;
+            }
+        }
+        std::string file = "mdl_sdk_benchmarks_synthetic_1024.exr";
+        if (mdl_compiler->export_canvas(file.c_str(), canvas.get()) == 0)
+            files.push_back(file);
+    }
+    return files;
+}
+
+// Measures loading the given texture files through the image plugins.
+void run_texture_benchmarks(
+    Benchmark_report &report,
+    mi::neuraylib::ITransaction* transaction,
+    std::vector<std::string> const &files,
+    char const *corpus,
+    Options const &options)
+{
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::string const &file = files[i];
+        Benchmark_result &res = report.add("texture", corpus, file);
+        res.unit = "pixels";
+
+        measure(res, options.num_warm, [&](unsigned, Timer &timer) {
+            timer.stop();
+            mi::base::Handle<mi::neuraylib::IImage> image(
+                transaction->create<mi::neuraylib::IImage>("Image"));
+            timer.start();
+
+            if (image->reset_file(file.c_str()) != 0) {
+                res.error = "cannot load " + file;
+                return false;
+            }
+            // make sure the pixel data is really there
+            mi::base::Handle<const mi::neuraylib::ICanvas> canvas(image->get_canvas());
+            mi::base::Handle<const mi::neuraylib::ITile> tile(canvas->get_tile(0, 0));
+            if (!tile || !tile->get_data()) {
+                res.error = "no pixel data for " + file;
+                return false;
+            }
+            res.items = double(canvas->get_resolution_x()) * canvas->get_resolution_y();
+            return true;
+        });
+    }
+}
+
+// Measures access/release churn of DB elements: several threads repeatedly access and release
+// the module, material and function definitions of the corpus through the same transaction.
+void run_churn_benchmarks(
+    Benchmark_report &report,
+    mi::neuraylib::ITransaction* transaction,
+    std::vector<Corpus_module> const &corpus,
+    Options const &options)
+{
+    std::vector<std::string> names;
+    for (size_t m = 0; m < corpus.size(); ++m) {
+        std::string module_name = "mdl" + corpus[m].name;
+        mi::base::Handle<const mi::neuraylib::IModule> module(
+            transaction->access<mi::neuraylib::IModule>(module_name.c_str()));
+        if (!module)
+            continue;
+        names.push_back(module_name);
+        for (mi::Size i = 0, n = module->get_material_count(); i < n; ++i)
+            names.push_back(module->get_material(i));
+        for (mi::Size i = 0, n = module->get_function_count(); i < n; ++i)
+            names.push_back(module->get_function(i));
+    }
+    if (names.empty())
+        return;
+
+    unsigned const num_accesses = 20000;
+    unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned num_threads = 1; ; num_threads = std::min(2 * num_threads, max_threads)) {
+        std::stringstream name;
+        name << num_threads << (num_threads == 1 ? " thread" : " threads");
+        Benchmark_result &res = report.add("churn", "mixed", name.str());
+        res.unit  = "accesses";
+        res.items = double(num_threads) * num_accesses;
+
+        measure(res, options.num_warm, [&](unsigned, Timer &) {
+            std::vector<char> ok(num_threads, 1);
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < num_threads; ++t) {
+                threads.push_back(std::thread([&, t]() {
+                    // start at different elements, but let the threads overlap
+                    size_t k = t * names.size() / num_threads;
+                    for (unsigned i = 0; i < num_accesses; ++i) {
+                        mi::base::Handle<const mi::base::IInterface> element(
+                            transaction->access(names[k].c_str()));
+                        if (!element) {
+                            ok[t] = 0;
+                            return;
+                        }
+                        if (++k == names.size())
+                            k = 0;
+                    }
+                }));
+            }
+            for (unsigned t = 0; t < num_threads; ++t)
+                threads[t].join();
+            if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+                res.error = "cannot access DB element";
+                return false;
+            }
+            return true;
+        });
+
+        if (num_threads == max_threads)
+            break;
+    }
+}
+
+// Print command line usage to console and terminate the application.
+void usage(char const *prog_name)
+{
+    std::cout
+        << "Usage: " << prog_name << " [options]\n"
+        << "Options:\n"
+        << "  -o <file>               JSON output file (default: mdl_sdk_benchmarks.json)\n"
+        << "  --iterations <n>        warm runs per case after the cold run (default: 5)\n"
+        << "  --suites <list>         comma separated list of suites to run (default: load,\n"
+        << "                          compile,translate,execute,texture,churn)\n"
+        << "  --modules <n>           number of synthetic modules (default: 4)\n"
+        << "  --materials <n>         materials per synthetic module (default: 8)\n"
+        << "  --samples <n>           native evaluations per material and run (default: 16384)\n"
+        << "  --no_synthetic          skip the synthetic corpus\n"
+        << "  --no_real_world         skip the real-world corpus\n"
+        << "  --mdl_path <path>       additional mdl search path, can occur multiple times."
+        << std::endl;
+    keep_console_open();
+    exit(EXIT_FAILURE);
+}
+
+
+//------------------------------------------------------------------------------
+//
+// Main function
+//
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    // Parse command line options
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        char const *opt = argv[i];
+        if (strcmp(opt, "-o") == 0 && i < argc - 1) {
+            options.json_file = argv[++i];
+        } else if (strcmp(opt, "--iterations") == 0 && i < argc - 1) {
+            options.num_warm = unsigned(std::max(atoi(argv[++i]), 0));
+        } else if (strcmp(opt, "--suites") == 0 && i < argc - 1) {
+            options.suites = argv[++i];
+        } else if (strcmp(opt, "--modules") == 0 && i < argc - 1) {
+            options.num_synthetic_modules = unsigned(std::max(atoi(argv[++i]), 0));
+        } else if (strcmp(opt, "--materials") == 0 && i < argc - 1) {
+            options.num_synthetic_materials = unsigned(std::max(atoi(argv[++i]), 1));
+        } else if (strcmp(opt, "--samples") == 0 && i < argc - 1) {
+            options.num_samples = unsigned(std::max(atoi(argv[++i]), 1));
+        } else if (strcmp(opt, "--no_synthetic") == 0) {
+            options.use_synthetic = false;
+        } else if (strcmp(opt, "--no_real_world") == 0) {
+            options.use_real_world = false;
+        } else if (strcmp(opt, "--mdl_path") == 0 && i < argc - 1) {
+            options.mdl_paths.push_back(argv[++i]);
+        } else {
+            std::cout << "Unknown option: \"" << opt << "\"" << std::endl;
+            usage(argv[0]);
+        }
+    }
+    options.mdl_paths.push_back(get_samples_mdl_root());
+
+    Benchmark_report report;
+    {
+        std::stringstream s;
+        s << options.num_warm;
+        report.set_config("warm_runs", s.str());
+        s.str("");
+        s << options.num_synthetic_modules << "x" << options.num_synthetic_materials;
+        report.set_config("synthetic_corpus", options.use_synthetic ? s.str() : "off");
+        report.set_config("real_world_corpus", options.use_real_world ? "on" : "off");
+        s.str("");
+        s << options.num_samples;
+        report.set_config("samples", s.str());
+        report.set_config("suites", options.suites);
+#ifdef NDEBUG
+        report.set_config("build", "release");
+#else
+        report.set_config("build", "debug");
+#endif
+    }
+
+    // Collect the corpus
+    std::vector<Corpus_module> corpus;
+    if (options.use_synthetic) {
+        for (unsigned i = 0; i < options.num_synthetic_modules; ++i) {
+            Corpus_module module;
+            module.corpus = "synthetic";
+            std::stringstream name;
+            name << "::mdl_sdk_benchmarks::synthetic_" << i;
+            module.name   = name.str();
+            module.source = create_synthetic_module(i, options.num_synthetic_materials);
+            corpus.push_back(module);
+        }
+    }
+    if (options.use_real_world) {
+        for (size_t i = 0; i < sizeof(g_real_world_modules) / sizeof(g_real_world_modules[0]); ++i) {
+            Corpus_module module;
+            module.corpus = "real_world";
+            module.name   = g_real_world_modules[i];
+            corpus.push_back(module);
+        }
+    }
+
+    bool need_sdk = options.has_suite("load") || options.has_suite("compile")
+        || options.has_suite("translate") || options.has_suite("execute")
+        || options.has_suite("texture") || options.has_suite("churn");
+    if (need_sdk) {
+        // Access the MDL SDK
+        mi::base::Handle<mi::neuraylib::INeuray> neuray(load_and_get_ineuray());
+        check_success(neuray.is_valid_interface());
+
+        mi::base::Handle<mi::neuraylib::IMdl_compiler> mdl_compiler(
+            neuray->get_api_component<mi::neuraylib::IMdl_compiler>());
+
+        // Configure the MDL SDK
+        check_success(mdl_compiler->load_plugin_library("nv_freeimage" MI_BASE_DLL_FILE_EXT) == 0);
+        for (std::size_t i = 0; i < options.mdl_paths.size(); ++i)
+            check_success(mdl_compiler->add_module_path(options.mdl_paths[i].c_str()) == 0);
+
+        // Start the MDL SDK
+        mi::Sint32 result = neuray->start();
+        check_start_success(result);
+
+        {
+            mi::base::Handle<const mi::neuraylib::IVersion> version(
+                neuray->get_api_component<const mi::neuraylib::IVersion>());
+            report.set_config("mdl_sdk_version", version->get_string());
+
+            mi::base::Handle<mi::neuraylib::IMdl_factory> mdl_factory(
+                neuray->get_api_component<mi::neuraylib::IMdl_factory>());
+
+            if (options.has_suite("load"))
+                run_load_benchmarks(report, neuray.get(), mdl_compiler.get(), corpus, options);
+
+            mi::base::Handle<mi::neuraylib::IDatabase> database(
+                neuray->get_api_component<mi::neuraylib::IDatabase>());
+            mi::base::Handle<mi::neuraylib::IScope> scope(database->get_global_scope());
+            mi::base::Handle<mi::neuraylib::ITransaction> transaction(scope->create_transaction());
+            {
+                bool do_compile   = options.has_suite("compile");
+                bool do_translate = options.has_suite("translate");
+                bool do_execute   = options.has_suite("execute");
+                bool do_churn     = options.has_suite("churn");
+
+                if (do_compile || do_translate || do_execute || do_churn) {
+                    prepare_corpus(
+                        transaction.get(), mdl_compiler.get(), mdl_factory.get(), corpus);
+
+                    if (do_compile) {
+                        run_compile_benchmarks(
+                            report, transaction.get(), mdl_factory.get(), corpus, options);
+                    } else if (do_translate || do_execute) {
+                        // only produce the compiled materials needed by the following suites
+                        for (size_t m = 0; m < corpus.size(); ++m) {
+                            for (int mode = 0; mode < CM_COUNT; ++mode) {
+                                mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+                                    mdl_factory->create_execution_context());
+                                Timer timer;
+                                std::string error;
+                                if (!compile_materials(
+                                        transaction.get(), context.get(), corpus[m],
+                                        Compilation_mode(mode), timer, error))
+                                    std::cerr << "Compilation failed: " << error << "\n";
+                            }
+                        }
+                    }
+                }
+
+                if (do_translate || do_execute)
+                    run_translate_benchmarks(
+                        report, transaction.get(), mdl_compiler.get(), mdl_factory.get(),
+                        corpus, options, do_translate);
+
+                if (do_execute)
+                    run_execute_benchmarks(report, corpus, options);
+
+                if (do_churn)
+                    run_churn_benchmarks(report, transaction.get(), corpus, options);
+
+                // Release the target code before the transaction is gone
+                for (size_t m = 0; m < corpus.size(); ++m)
+                    corpus[m].native_code.clear();
+
+                if (options.has_suite("texture")) {
+                    mi::base::Handle<mi::neuraylib::IImage_api> image_api(
+                        neuray->get_api_component<mi::neuraylib::IImage_api>());
+
+                    if (options.use_synthetic) {
+                        std::vector<std::string> files(
+                            create_synthetic_textures(mdl_compiler.get(), image_api.get()));
+                        run_texture_benchmarks(
+                            report, transaction.get(), files, "synthetic", options);
+                        for (size_t i = 0; i < files.size(); ++i)
+                            remove(files[i].c_str());
+                    }
+                    if (options.use_real_world) {
+                        std::vector<std::string> files;
+                        size_t n = sizeof(g_real_world_textures) / sizeof(g_real_world_textures[0]);
+                        for (size_t i = 0; i < n; ++i)
+                            files.push_back(get_samples_mdl_root() + "/" + g_real_world_textures[i]);
+                        run_texture_benchmarks(
+                            report, transaction.get(), files, "real_world", options);
+                    }
+                }
+            }
+            transaction->commit();
+        }
+
+        // Free MDL compiler before shutting down MDL SDK
+        mdl_compiler = 0;
+
+        // Shut down the MDL SDK
+        check_success(neuray->shutdown() == 0);
+        neuray = 0;
+
+        // Unload the MDL SDK
+        check_success(unload());
+    }
+
+    // Report the results
+    report.print_summary(std::cout);
+
+    std::ofstream json(options.json_file.c_str());
+    if (!json) {
+        std::cerr << "Cannot write \"" << options.json_file << "\"." << std::endl;
+        return EXIT_FAILURE;
+    }
+    report.write_json(json);
+    std::cout << "\nResults written to \"" << options.json_file << "\"." << std::endl;
+
+    keep_console_open();
+    return report.get_failure_count() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
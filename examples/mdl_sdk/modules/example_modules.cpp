@@ -28,7 +28,7 @@
 
 // examples/example_modules.cpp
 //
-// Loads an MDL module and inspects it contents.
+// Loads an MDL module and inspects it contents, and reloads a module after changing its source.
 
 #include <iostream>
 #include <string>
@@ -252,6 +252,93 @@ void load_module( mi::neuraylib::INeuray* neuray)
     transaction->commit();
 }
 
+// Reloads a module that was loaded from a string and shows which changes are accepted.
+void reload_module( mi::neuraylib::INeuray* neuray)
+{
+    mi::base::Handle<mi::neuraylib::IDatabase> database(
+        neuray->get_api_component<mi::neuraylib::IDatabase>());
+    mi::base::Handle<mi::neuraylib::IScope> scope( database->get_global_scope());
+    mi::base::Handle<mi::neuraylib::ITransaction> transaction( scope->create_transaction());
+
+    {
+        mi::base::Handle<mi::neuraylib::IMdl_compiler> mdl_compiler(
+            neuray->get_api_component<mi::neuraylib::IMdl_compiler>());
+
+        mi::base::Handle<mi::neuraylib::IMdl_factory> mdl_factory(
+            neuray->get_api_component<mi::neuraylib::IMdl_factory>());
+
+        mi::base::Handle<mi::neuraylib::IMdl_execution_context> context(
+            mdl_factory->create_execution_context());
+
+        // Load the first version of the module and instantiate its material.
+        const char* source_v1 =
+            "mdl 1.0;\n"
+            "import df::*;\n"
+            "export color tint(color c) { return c; }\n"
+            "export material m(color c = color(0.5)) = material(\n"
+            "    surface: material_surface(\n"
+            "        scattering: df::diffuse_reflection_bsdf(tint: tint(c))));\n";
+        check_success( mdl_compiler->load_module_from_string(
+            transaction.get(), "::example_reload", source_v1, context.get()) >= 0);
+        print_messages( context.get());
+
+        mi::base::Handle<const mi::neuraylib::IMaterial_definition> material_definition(
+            transaction->access<mi::neuraylib::IMaterial_definition>(
+                "mdl::example_reload::m"));
+        mi::base::Handle<mi::neuraylib::IMaterial_instance> material_instance(
+            material_definition->create_material_instance( 0));
+        check_success( material_instance.is_valid_interface());
+        transaction->store( material_instance.get(), "example_reload_instance");
+        material_definition = 0;
+        material_instance = 0;
+
+        // Changing the body of a function is accepted. The DB elements of the function and of
+        // the material calling it are replaced in place, the material instance remains valid.
+        const char* source_v2 =
+            "mdl 1.0;\n"
+            "import df::*;\n"
+            "export color tint(color c) { return c * 0.5; }\n"
+            "export material m(color c = color(0.5)) = material(\n"
+            "    surface: material_surface(\n"
+            "        scattering: df::diffuse_reflection_bsdf(tint: tint(c))));\n";
+        mi::Sint32 result = mdl_compiler->reload_module_from_string(
+            transaction.get(), "::example_reload", source_v2, context.get());
+        print_messages( context.get());
+        check_success( result == 0);
+        std::cout << "Reloaded module \"::example_reload\" with a changed function body."
+                  << std::endl;
+
+        mi::base::Handle<const mi::neuraylib::IMaterial_instance> reloaded_instance(
+            transaction->access<mi::neuraylib::IMaterial_instance>( "example_reload_instance"));
+        mi::base::Handle<mi::neuraylib::ICompiled_material> compiled_material(
+            reloaded_instance->create_compiled_material(
+                mi::neuraylib::IMaterial_instance::DEFAULT_OPTIONS, context.get()));
+        check_success( compiled_material.is_valid_interface());
+
+        // Reloading the same source again does not change anything.
+        result = mdl_compiler->reload_module_from_string(
+            transaction.get(), "::example_reload", source_v2, context.get());
+        check_success( result == 1);
+
+        // Changing the parameters of the material is rejected since existing material instances
+        // would no longer match the definition. The database is left unchanged.
+        const char* source_v3 =
+            "mdl 1.0;\n"
+            "import df::*;\n"
+            "export color tint(color c) { return c * 0.5; }\n"
+            "export material m(float f = 0.5) = material(\n"
+            "    surface: material_surface(\n"
+            "        scattering: df::diffuse_reflection_bsdf(tint: tint(color(f)))));\n";
+        result = mdl_compiler->reload_module_from_string(
+            transaction.get(), "::example_reload", source_v3, context.get());
+        check_success( result == -6);
+        std::cout << "Reloading module \"::example_reload\" with changed material parameters "
+                  << "was rejected." << std::endl << std::endl;
+    }
+
+    transaction->commit();
+}
+
 int main( int /*argc*/, char* /*argv*/[])
 {
     // Access the MDL SDK
@@ -268,6 +355,9 @@ int main( int /*argc*/, char* /*argv*/[])
     // Load an MDL module and dump its contents
     load_module( neuray.get());
 
+    // Reload an MDL module after changing its source
+    reload_module( neuray.get());
+
     // Shut down the MDL SDK
     check_success( neuray->shutdown() == 0);
     neuray = 0;
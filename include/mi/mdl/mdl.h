@@ -88,6 +88,11 @@ extern "C" {
 ///               memory allocations in this compiler.
 ///               If NULL, a malloc-based allocator will be used.
 ///
+/// \note Memory of the compiler's internal arenas is not returned to \p alloc immediately. Up to
+///       1 MiB per thread is kept in a per-thread pool for reuse by later compilations on that
+///       thread. The pool holds a reference on \p alloc and returns its memory only when the
+///       thread exits.
+///
 /// \returns    A pointer to the primary MDL interface.
 DLL_EXPORT mi::mdl::IMDL *mi_mdl_factory(mi::base::IAllocator *alloc);
 
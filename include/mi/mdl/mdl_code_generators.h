@@ -856,9 +856,16 @@ public:
 
 /// The JIT code generator interface.
 class ICode_generator_jit : public
-    mi::base::Interface_declare<0x059c7e80,0x696c,0x4684,0xad,0x08,0xb7,0x17,0x72,0x5a,0x55,0x20,
+    mi::base::Interface_declare<0xec616266,0xc965,0x47e2,0x9c,0x18,0x4a,0x6b,0xe4,0x86,0x39,0xbc,
     ICode_generator>
 {
+    /// The name of the option to collect optimizer timing statistics in the JIT code generator.
+    #define MDL_JIT_OPTION_COLLECT_TIMING "jit_collect_timing"
+
+    /// The name of the option to profile the expression lambdas of distribution functions
+    /// ("off", "record" or "use"). Only native code records the profile, all targets can use it.
+    #define MDL_JIT_OPTION_DF_LAMBDA_PROFILE "jit_df_lambda_profile"
+
     /// The name of the option to disable exception handling in the JIT code generator.
     #define MDL_JIT_OPTION_DISABLE_EXCEPTIONS "jit_disable_exceptions"
 
@@ -881,6 +888,10 @@ class ICode_generator_jit : public
     /// The name of the option to set the optimization level of the JIT code generator.
     #define MDL_JIT_OPTION_OPT_LEVEL "jit_opt_level"
 
+    /// The name of the option to select the optimization pipeline of the JIT code generator
+    /// ("default", "preview" or "final").
+    #define MDL_JIT_OPTION_OPT_PIPELINE "jit_opt_pipeline"
+
     /// The name of the option that steers the call mode for the GPU texture lookup.
     #define MDL_JIT_OPTION_TEX_LOOKUP_CALL_MODE "jit_tex_lookup_call_mode"
 
@@ -1143,6 +1154,13 @@ public:
     /// \return the compiled function or NULL on compilation errors
     virtual IGenerated_code_executable *compile_unit(
         ILink_unit const *unit) = 0;
+
+    /// Discard the expression lambda use counts recorded so far, see
+    /// MDL_JIT_OPTION_DF_LAMBDA_PROFILE.
+    ///
+    /// The profile is shared by all JIT code generators of the process. Code generated before
+    /// is not affected, but native code recording the profile starts counting from zero.
+    virtual void clear_df_lambda_profile() = 0;
 };
 
 /*!
@@ -139,7 +139,7 @@ public:
 
 /// The base executable code interface.
 class IGenerated_code_executable : public
-    mi::base::Interface_declare<0x11c439a5,0x3eaf,0x4e48,0x8b,0xd3,0xb2,0x23,0x3e,0x6a,0x79,0x68,
+    mi::base::Interface_declare<0xb493f465,0x87d5,0x4ac4,0x91,0x02,0x7b,0x98,0xb9,0x06,0xd6,0xbc,
     IGenerated_code>
 {
 public:
@@ -207,6 +207,15 @@ public:
     ///
     /// \note that the id 0 is ALWAYS mapped to the empty string ""
     virtual char const *get_string_constant(size_t id) const = 0;
+
+    /// Get the timing report of the optimizer.
+    ///
+    /// The report is only available if the code was compiled with the option
+    /// "jit_collect_timing" enabled, it lists the time spent in the function and module
+    /// pass managers and the time spent in every LLVM pass.
+    ///
+    /// \returns the report or the empty string if no timing data was collected
+    virtual char const *get_timing_report() const = 0;
 };
 
 /// A handler for MDL runtime exceptions.
@@ -1093,7 +1102,7 @@ public:
 /// code.
 /// If compiled for GPU execution only PTX code is provided.
 class IGenerated_code_lambda_function : public
-    mi::base::Interface_declare<0x7e100527,0x0ae6,0x46e3,0x83,0x7a,0x45,0x84,0x99,0x4f,0xe4,0x22,
+    mi::base::Interface_declare<0xce4e1b53,0xf055,0x48b0,0x98,0x24,0x90,0x68,0xc9,0x47,0x12,0x6f,
     IGenerated_code_executable>
 {
 public:
@@ -1269,6 +1278,33 @@ public:
         void                         *tex_data,
         void const                   *cap_args) = 0;
 
+    /// Run a compiled function on the CPU for a packet of lanes.
+    ///
+    /// \param[in]    index          the index of the function to execute
+    /// \param[in]    count          the number of lanes in the packet
+    /// \param[inout] results        the per-lane data, \p result_stride bytes apart
+    /// \param[in]    result_stride  the distance in bytes between the data of two lanes
+    /// \param[in]    states         the core states, one per lane, \p state_stride bytes apart
+    /// \param[in]    state_stride   the distance in bytes between the states of two lanes, i.e.
+    ///                              the size of the state layout the code was generated for
+    /// \param[in]    tex_data       extra thread data for the texture handler
+    /// \param[in]    cap_args       the captured arguments block shared by all lanes
+    ///
+    /// \returns false if execution was aborted by runtime error, true otherwise
+    ///
+    /// \note Equivalent to calling run_generic() for every lane, but the resource data and the
+    ///       exception frame are set up only once per packet. If the execution of a lane is
+    ///       aborted, the remaining lanes are not executed.
+    virtual bool run_generic_packet(
+        size_t                       index,
+        size_t                       count,
+        void                         *results,
+        size_t                       result_stride,
+        Shading_state_material const *states,
+        size_t                       state_stride,
+        void                         *tex_data,
+        void const                   *cap_args) = 0;
+
     /// Run a compiled init function on the CPU. This may modify the texture results buffer
     /// of the given state and the normal field.
     ///
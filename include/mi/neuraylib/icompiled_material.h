@@ -234,6 +234,10 @@ public:
     ///       later loaded again. IDs might be different if the module is loaded in different
     ///       processes.
     ///
+    /// \note The hash values are only stable for a given #MI_NEURAYLIB_API_VERSION. Do not
+    ///       compare them with hash values computed by other versions, e.g., in persistent
+    ///       caches.
+    ///
     /// \see #get_slot_hash() for hashes for individual material slots
     virtual base::Uuid get_hash() const = 0;
 
@@ -255,6 +259,10 @@ public:
     ///       later loaded again. IDs might be different if the module is loaded in different
     ///       processes.
     ///
+    /// \note The hash values are only stable for a given #MI_NEURAYLIB_API_VERSION. Do not
+    ///       compare them with hash values computed by other versions, e.g., in persistent
+    ///       caches.
+    ///
     /// \see #get_hash() for a hash covering all slots together
     virtual base::Uuid get_slot_hash( Material_slot slot) const = 0;
 
@@ -50,6 +50,32 @@ class IDebug_configuration : public
 public:
     /// Sets a particular debug option.
     ///
+    /// The following options of the MDL compiler are evaluated when \neurayProductName is
+    /// started:
+    /// - \c mdl_arena_pool_size: The number of bytes of memory arena chunks kept per thread for
+    ///   reuse by later compilations on the same thread. Defaults to 1 MiB, 0 disables pooling.
+    ///   Pooling is enabled by default. The pooled memory is held until the thread exits or
+    ///   \neurayProductName is shut down.
+    /// - \c mdl_trace: Records the time spent in the phases of the MDL compiler. 1 aggregates
+    ///   per-phase counters, 2 records every phase as an event, 3 does both.
+    /// - \c mdl_trace_buffer_size: The number of events kept per thread, older events are
+    ///   overwritten.
+    /// - \c mdl_trace_file: If set, the recorded events are written to this file in the Chrome
+    ///   trace event format when \neurayProductName is shut down.
+    /// - \c mdl_trace_counters_file: If set, the phase counters and the memory arena statistics
+    ///   are written to this file in the Prometheus text exposition format when
+    ///   \neurayProductName is shut down.
+    /// - \c mdl_trace_counters_interval: If set, the counters file is additionally rewritten
+    ///   every that many seconds.
+    ///
+    /// The following option is evaluated whenever a shared MDL resource (texture, light profile,
+    /// or BSDF measurement) is loaded:
+    /// - \c mdl_resource_content_dedup: If set to 1, the contents of resource files are hashed.
+    ///   A resource whose contents are identical to an already loaded resource still gets its own
+    ///   DB element, but shares the loaded data of the existing element instead of loading the
+    ///   file again. Defaults to 0. When \neurayProductName is shut down, the number of shared
+    ///   resources and the number of bytes saved are logged.
+    ///
     /// \param option    The option to be set in the form \c key=value.
     /// \return
     ///                  -  0: Success.
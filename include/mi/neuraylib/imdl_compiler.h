@@ -87,7 +87,7 @@ struct Target_function_description;
 ///
 /// It also allows to load plugins to add support for loading and exporting images and videos.
 class IMdl_compiler : public
-    mi::base::Interface_declare<0x8fff0a2d,0x7df7,0x4552,0x92,0xf7,0x36,0x1d,0x31,0xc6,0x30,0x08>
+    mi::base::Interface_declare<0x2a6b8d53,0x4c1e,0x4f0a,0x9b,0x37,0xe1,0x58,0x0d,0x6c,0xa4,0x92>
 {
 public:
     /// \name General configuration
@@ -765,6 +765,85 @@ public:
     ///                          available.
     virtual IMdl_backend* get_backend( Mdl_backend_kind kind) = 0;
 
+    //@}
+    /// \name Reloading
+    //@{
+
+    /// Reloads an MDL module from disk that has been loaded into the database before.
+    ///
+    /// The module and all modules in the database that import it (directly or indirectly) are
+    /// recompiled. The DB elements of the modules, and of the material and function definitions
+    /// therein, are only replaced if they actually changed. Definitions that did not change keep
+    /// their DB elements, and therefore all material instances, function calls, and compiled
+    /// materials referencing them remain valid. All modules are compiled and compared before the
+    /// first DB element is created or replaced, hence the database is left unchanged if any
+    /// module fails to compile or cannot be reloaded.
+    ///
+    /// Definitions cannot be removed by a reload since they might still be referenced by other
+    /// DB elements. This includes changing the signature of a function definition, which is part
+    /// of its DB name, and changing the parameter names or types of a material definition.
+    ///
+    /// \param transaction   The transaction to be used.
+    /// \param module_name   The fully-qualified MDL name of the MDL module (including package
+    ///                      names, starting with "::").
+    /// \param context       The execution context can be used to pass options to control the
+    ///                      behavior of the MDL compiler, see #load_module(). During module
+    ///                      loading, compiler messages like errors or warnings are stored in the
+    ///                      context. Can be \c NULL.
+    /// \return
+    ///                      -  1: Success (neither the module nor any importing module changed).
+    ///                      -  0: Success (at least one module was reloaded).
+    ///                      - -1: The module name \p module_name is invalid, a \c NULL pointer, or
+    ///                            the name of a builtin module.
+    ///                      - -2: Failed to find or to compile the module \p module_name or one
+    ///                            of the modules importing it, or one of the modules importing it
+    ///                            was loaded by #load_module_from_string() and cannot be
+    ///                            recompiled.
+    ///                      - -3: The DB name for a module is already in use but is not an MDL
+    ///                            module, or the DB name for a new definition is already in use.
+    ///                      - -4: Initialization of an imported module failed.
+    ///                      - -5: There is no module \p module_name in the database.
+    ///                      - -6: A definition was removed, the signature or the return type of
+    ///                            a function changed, or the parameters of a material changed.
+    virtual Sint32 reload_module(
+        ITransaction* transaction, const char* module_name, IMdl_execution_context* context = 0) = 0;
+
+    /// Reloads an MDL module from memory that has been loaded into the database before.
+    ///
+    /// Same as #reload_module(), except that the new source of the module \p module_name itself
+    /// is given by \p module_source. Modules importing it are reloaded from disk. This is the
+    /// only way to reload modules that have been loaded by #load_module_from_string().
+    ///
+    /// \param transaction   The transaction to be used.
+    /// \param module_name   The fully-qualified MDL name of the MDL module (including package
+    ///                      names, starting with "::").
+    /// \param module_source The new MDL source code of the module.
+    /// \param context       The execution context can be used to pass options to control the
+    ///                      behavior of the MDL compiler, see #load_module(). During module
+    ///                      loading, compiler messages like errors or warnings are stored in the
+    ///                      context. Can be \c NULL.
+    /// \return
+    ///                      -  1: Success (neither the module nor any importing module changed).
+    ///                      -  0: Success (at least one module was reloaded).
+    ///                      - -1: The module name \p module_name is invalid or the name of a
+    ///                            builtin module, or \p module_name or \p module_source is a
+    ///                            \c NULL pointer.
+    ///                      - -2: Failed to find or to compile the module \p module_name or one
+    ///                            of the modules importing it, or one of the modules importing it
+    ///                            was loaded by #load_module_from_string() and cannot be
+    ///                            recompiled.
+    ///                      - -3: The DB name for a module is already in use but is not an MDL
+    ///                            module, or the DB name for a new definition is already in use.
+    ///                      - -4: Initialization of an imported module failed.
+    ///                      - -5: There is no module \p module_name in the database.
+    ///                      - -6: A definition was removed, the signature or the return type of
+    ///                            a function changed, or the parameters of a material changed.
+    virtual Sint32 reload_module_from_string(
+        ITransaction* transaction,
+        const char* module_name,
+        const char* module_source,
+        IMdl_execution_context* context = 0) = 0;
+
     //@}
 };
 
@@ -772,7 +851,7 @@ mi_static_assert( sizeof( IMdl_compiler::Mdl_backend_kind)== sizeof( Uint32));
 
 /// MDL backends allow to transform compiled material instances or function calls into target code.
 class IMdl_backend : public
-    mi::base::Interface_declare<0x9ecdd747,0x20b8,0x4a8a,0xb1,0xe2,0x62,0xb2,0x62,0x30,0xd3,0x67>
+    mi::base::Interface_declare<0xa9b7e0c4,0x2a37,0x4d0d,0xb3,0xc2,0x02,0xe3,0xd0,0x2a,0xc4,0x83>
 {
 public:
     /// Sets a backend option.
@@ -810,6 +889,37 @@ public:
     /// - \c "texture_runtime_with_derivs": Enables/disables derivative support for texture lookup
     ///   functions. If enabled, the user-provided texture runtime has to provide functions with
     ///   derivative parameters for the texture coordinates.
+    /// - \c "num_translation_threads": Set the maximum number of threads used to optimize the
+    ///   expression lambdas of the distribution functions added by
+    ///   #mi::neuraylib::ILink_unit::add_material() and
+    ///   #mi::neuraylib::ILink_unit::add_material_df(). Only this preparation step runs in
+    ///   parallel, and only if derivatives are not enabled. The \c translate_*() methods, the
+    ///   LLVM IR generation, the LLVM optimization, and the native or PTX code generation are
+    ///   always serial. The threads are taken from a worker pool shared by the whole SDK, so
+    ///   the value is an upper bound. Default: \c "1".
+    /// - \c "optimization_pipeline": Select the optimization pipeline. Possible values:
+    ///   * \c "default": use the pipeline given by \c "opt_level" (default)
+    ///   * \c "preview": fast compilation, only cheap cleanup passes, no inlining heuristics
+    ///   * \c "final": slow compilation, aggressive inlining and, except for PTX, loop and
+    ///     SLP vectorization
+    ///   The \c "preview" and \c "final" pipelines override \c "opt_level".
+    /// - \c "collect_timing": Enables/disables the collection of optimizer timing statistics,
+    ///   see #mi::neuraylib::ITarget_code::get_timing_report(). LLVM pass timers are process
+    ///   global, hence a timed optimizer run blocks all other optimizer and code generator
+    ///   runs of the process until it is finished. Possible values:
+    ///   \c "on", \c "off". Default: \c "off".
+    /// - \c "df_lambda_profile": Selects how the expressions precalculated by the init function
+    ///   of a distribution function into the text_results array are chosen within the budget given
+    ///   by \c "num_texture_results". Possible values:
+    ///   * \c "off": choose by statically estimated costs (default)
+    ///   * \c "record": like \c "off", but the generated sample, evaluate and pdf functions count
+    ///     how often they use the result of each expression. The counts are kept per process and
+    ///     accumulate over all executions until #clear_df_lambda_profile() is called. Only
+    ///     supported by the native backend.
+    ///   * \c "use": weight the estimated costs by the recorded counts, expressions whose result
+    ///     was never used are only precalculated if other expressions depend on them. Falls back
+    ///     to \c "off" for materials without recorded counts. Can be used by all backends, for
+    ///     example to tune PTX code with counts recorded by native code.
     ///
     /// The following options are supported by the LLVM-IR backend only:
     /// - \c "enable_simd": Enables/disables the use of SIMD instructions. Possible values:
@@ -1644,6 +1754,15 @@ public:
     virtual const ITarget_code* translate_link_unit(
         const ILink_unit* lu, IMdl_execution_context* context) = 0;
 
+    /// Discards the expression use counts recorded with the backend option
+    /// \c "df_lambda_profile" set to \c "record".
+    ///
+    /// The counts are shared by all backends of the process. Target code translated before is
+    /// not affected, but native code recording the counts starts again from zero. The number of
+    /// recorded counts is bounded: when the bound is reached, the oldest counts that are not
+    /// recorded by any existing target code are discarded automatically.
+    virtual void clear_df_lambda_profile() = 0;
+
 };
 
 /// A callback interface to allow the user to handle resources when creating new
@@ -1796,7 +1915,7 @@ public:
 
 /// Represents target code of an MDL backend.
 class ITarget_code : public
-    mi::base::Interface_declare<0xefca46ae,0xd530,0x4b97,0x9d,0xab,0x3a,0xdb,0x0c,0x58,0xc3,0xac>
+    mi::base::Interface_declare<0x5c1e27d9,0x83f4,0x4b62,0xa0,0x1d,0x6e,0xb3,0x92,0x47,0xf8,0x15>
 {
 public:
     /// The potential state usage properties.
@@ -2303,6 +2422,148 @@ public:
         const Shading_state_material& state,
         Texture_handler_base* tex_handler,
         const ITarget_argument_block *cap_args) const = 0;
+
+    /// Returns the timing report of the JIT optimizer.
+    ///
+    /// The report is only collected if the backend option \c "collect_timing" was set to
+    /// \c "on" when this code was generated. It contains the time spent in the function and
+    /// module pass managers of the selected optimization pipeline, the time spent in the function
+    /// pass manager per function (most expensive first), and the per-pass timing report of LLVM
+    /// for the module passes.
+    ///
+    /// \return  The report, or the empty string if no timing data was collected.
+    virtual const char* get_timing_report() const = 0;
+
+    /// Create a new target argument block for an edited class-compiled material, reusing this
+    /// target code.
+    ///
+    /// In contrast to #create_argument_block(), this method checks that the edit preserved the
+    /// structure of the class-compiled material which was used to generate the target argument
+    /// block \p index, i.e., that the hash of \p material is identical to the hash of that
+    /// material. Since the arguments of class-compiled materials are not included in the hash,
+    /// edits which only change argument values keep the hash, and the returned argument block can
+    /// be used with this target code without translating the material again.
+    ///
+    /// \param index              The index of the base target argument block of this target code.
+    /// \param material           The edited class-compiled MDL material.
+    /// \param resource_callback  Callback for retrieving resource indices for resource values.
+    ///
+    /// \returns the generated target argument block, or \c NULL if the index was invalid, no
+    ///          hash was recorded for the argument block, or the structure of the material
+    ///          changed. In the latter cases, the material has to be translated again.
+    virtual ITarget_argument_block *create_argument_block_for_edit(
+        Size index,
+        const ICompiled_material *material,
+        ITarget_resource_callback *resource_callback) const = 0;
+
+    /// Run the BSDF sample function for this code on the native CPU for a packet of samples.
+    ///
+    /// This is equivalent to calling #execute_bsdf_sample() for every element of the packet
+    /// with the same function and captured arguments, but the function lookup, the argument
+    /// block resolution and the setup of the runtime are done only once per packet. The elements
+    /// are still processed one after the other by the scalar code.
+    ///
+    /// \param[in]    index       The index of the callable function.
+    /// \param[in]    count       The number of elements in the packet.
+    /// \param[inout] data        The input and output fields for the BSDF sampling, an array
+    ///                           of \p count elements.
+    /// \param[in]    states      The core states, an array of \p count elements. If the code
+    ///                           was generated with derivative support, this must point to an
+    ///                           array of #Shading_state_material_with_derivs instead.
+    /// \param[in]  tex_handler   Texture handler containing the vtable for the user-defined
+    ///                           texture lookup functions. Can be NULL if the built-in resource
+    ///                           handler is used.
+    /// \param[in]    cap_args    The captured arguments to use for all elements of the packet.
+    ///                           If \p cap_args is \c NULL, the captured arguments of this
+    ///                           \c ITarget_code object for the given callable function will be
+    ///                           used, if any.
+    ///
+    /// \returns
+    ///    - 0  on success
+    ///    - -1 if execution was aborted by runtime error, the elements following the aborted
+    ///         one are not processed
+    ///    - -2 cannot execute: not native code or the given function is not a BSDF sample function
+    virtual Sint32 execute_bsdf_sample_packet(
+        Size index,
+        Size count,
+        Bsdf_sample_data *data,
+        const Shading_state_material *states,
+        Texture_handler_base* tex_handler,
+        const ITarget_argument_block *cap_args) const = 0;
+
+    /// Run the BSDF evaluation function for this code on the native CPU for a packet of
+    /// directions.
+    ///
+    /// This is equivalent to calling #execute_bsdf_evaluate() for every element of the packet
+    /// with the same function and captured arguments, but the function lookup, the argument
+    /// block resolution and the setup of the runtime are done only once per packet. The elements
+    /// are still processed one after the other by the scalar code.
+    ///
+    /// \param[in]    index       The index of the callable function.
+    /// \param[in]    count       The number of elements in the packet.
+    /// \param[inout] data        The input and output fields for the BSDF evaluation, an array
+    ///                           of \p count elements.
+    /// \param[in]    states      The core states, an array of \p count elements. If the code
+    ///                           was generated with derivative support, this must point to an
+    ///                           array of #Shading_state_material_with_derivs instead.
+    /// \param[in]  tex_handler   Texture handler containing the vtable for the user-defined
+    ///                           texture lookup functions. Can be NULL if the built-in resource
+    ///                           handler is used.
+    /// \param[in]    cap_args    The captured arguments to use for all elements of the packet.
+    ///                           If \p cap_args is \c NULL, the captured arguments of this
+    ///                           \c ITarget_code object for the given callable function will be
+    ///                           used, if any.
+    ///
+    /// \returns
+    ///    - 0  on success
+    ///    - -1 if execution was aborted by runtime error, the elements following the aborted
+    ///         one are not processed
+    ///    - -2 cannot execute: not native code or the given function is not a BSDF evaluation
+    ///         function
+    virtual Sint32 execute_bsdf_evaluate_packet(
+        Size index,
+        Size count,
+        Bsdf_evaluate_data *data,
+        const Shading_state_material *states,
+        Texture_handler_base* tex_handler,
+        const ITarget_argument_block *cap_args) const = 0;
+
+    /// Run the BSDF PDF calculation function for this code on the native CPU for a packet of
+    /// directions.
+    ///
+    /// This is equivalent to calling #execute_bsdf_pdf() for every element of the packet
+    /// with the same function and captured arguments, but the function lookup, the argument
+    /// block resolution and the setup of the runtime are done only once per packet. The elements
+    /// are still processed one after the other by the scalar code.
+    ///
+    /// \param[in]    index       The index of the callable function.
+    /// \param[in]    count       The number of elements in the packet.
+    /// \param[inout] data        The input and output fields for the BSDF PDF calculation, an
+    ///                           array of \p count elements.
+    /// \param[in]    states      The core states, an array of \p count elements. If the code
+    ///                           was generated with derivative support, this must point to an
+    ///                           array of #Shading_state_material_with_derivs instead.
+    /// \param[in]  tex_handler   Texture handler containing the vtable for the user-defined
+    ///                           texture lookup functions. Can be NULL if the built-in resource
+    ///                           handler is used.
+    /// \param[in]    cap_args    The captured arguments to use for all elements of the packet.
+    ///                           If \p cap_args is \c NULL, the captured arguments of this
+    ///                           \c ITarget_code object for the given callable function will be
+    ///                           used, if any.
+    ///
+    /// \returns
+    ///    - 0  on success
+    ///    - -1 if execution was aborted by runtime error, the elements following the aborted
+    ///         one are not processed
+    ///    - -2 cannot execute: not native code or the given function is not a BSDF PDF calculation
+    ///         function
+    virtual Sint32 execute_bsdf_pdf_packet(
+        Size index,
+        Size count,
+        Bsdf_pdf_data *data,
+        const Shading_state_material *states,
+        Texture_handler_base* tex_handler,
+        const ITarget_argument_block *cap_args) const = 0;
 };
 
 /// Represents a link-unit of an MDL backend.
@@ -71,7 +71,7 @@ namespace neuraylib {
 /// \endcode
 ///
 class IMdl_i18n_configuration : public
-    mi::base::Interface_declare<0xb28d4381,0x5760,0x4c1a,0xbe,0xa1,0x3f,0xa7,0x96,0x8a,0x86,0x28>
+    mi::base::Interface_declare<0x15be002d,0x3be1,0x4c70,0xbc,0x36,0x4b,0xe9,0x8a,0xb8,0x7b,0x2b>
 {
 public:
     /// \name MDL Locale
@@ -128,6 +128,39 @@ public:
     ///
     virtual const char* get_system_keyword() const = 0;
 
+    //@}
+    /// \name Translation table cache
+    //@{
+
+    /// Specifies the directory for compiled translation tables.
+    ///
+    /// XLIFF files are compiled into binary translation tables, which are cached to speed up
+    /// later loads. By default, they are cached in a per-user directory: \c mdl_i18n in
+    /// \c $XDG_CACHE_HOME or \c ~/.cache on Linux and Mac OS, \c mdl_i18n_cache in the user
+    /// data directory on Windows.
+    ///
+    /// This function can only be called before \neurayProductName has been started.
+    ///
+    /// \param directory
+    ///     The directory to cache the compiled tables in, created if needed, or \c NULL to
+    ///     disable the cache. Without the cache, XLIFF files are compiled in memory each time
+    ///     they are loaded.
+    ///
+    /// \return
+    ///     -  0: Success.
+    ///     - -1: Failure.
+    ///           This function can only be called before \neurayProductName has been started.
+    ///
+    virtual Sint32 set_cache_directory( const char* directory) = 0;
+
+    /// Returns the directory for compiled translation tables.
+    ///
+    /// \return
+    ///     The directory used to cache compiled translation tables, or \c NULL if the cache
+    ///     is disabled.
+    ///
+    virtual const char* get_cache_directory() const = 0;
+
     //@}
 };
 
@@ -553,13 +553,19 @@ public:
     /// The returned scene elements are in such an order that all elements referenced by a given
     /// element are listed before that element (before in the sense of smaller array indices).
     ///
-    /// \param root_element   The root of the subgraph to traverse.
+    /// If \p root_element is \c NULL, all named scene elements of the database are considered.
+    /// In this case the method uses indexes on the type and name of the scene elements instead of
+    /// a graph traversal, and the returned scene elements are ordered by name.
+    ///
+    /// \param root_element   The root of the subgraph to traverse, or \c NULL to list all scene
+    ///                       elements.
     /// \param name_pattern   A regular expression that acts as filter on the names of returned
     ///                       scene elements. The regular expression must be compliant to extended
     ///                       regular expressions as defined in POSIX 1003.2. The regular expression
     ///                       is matched to \em any \em part of the scene element name, not just to
     ///                       the \em entire scene element name. The value \c NULL is handled as
-    ///                       \c ".*".
+    ///                       \c ".*". Patterns of the form \c "^literal" without further special
+    ///                       characters are handled as name prefix, which is considerably faster.
     /// \param type_names     A list of type names that acts as filter on the names of returned
     ///                       scene elements. Only scene elements with a matching type name pass
     ///                       the filter. The value \c NULL lets all scene elements pass the filter
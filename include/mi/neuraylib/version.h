@@ -51,7 +51,7 @@
 ///
 /// A change in this version number indicates that the binary compatibility
 /// of the interfaces offered through the shared library have changed.
-#define MI_NEURAYLIB_API_VERSION  33
+#define MI_NEURAYLIB_API_VERSION  34
 
 // The following three to four macros define the API version.
 // The macros thereafter are defined in terms of the first four.
@@ -39,6 +39,7 @@
 #include <base/lib/log/i_log_logger.h>
 #include <base/lib/log/i_log_module.h>
 
+#include <algorithm>
 #include <cstdarg>
 
 namespace MI {
@@ -76,29 +77,115 @@ public:
     }
 };
 
+namespace {
+
+/// Source for Logger::m_generation.
+std::atomic<mi::Uint32> g_logger_generation( 0);
+
+} // namespace
+
+thread_local Logger::Ring_buffer_holder Logger::s_ring_buffer_holder;
+
+bool Logger::Ring_buffer::push(
+    mi::base::Message_severity level,
+    const char* category,
+    const char* message,
+    mi::Uint64 sequence)
+{
+    mi::Uint32 head = m_head.load( std::memory_order_relaxed);
+    mi::Uint32 tail = m_tail.load( std::memory_order_acquire);
+    if( head - tail >= s_capacity)
+        return false;
+
+    // assigning to the existing strings reuses their buffers
+    Message& slot = m_slots[head % s_capacity];
+    slot.m_level = level;
+    slot.m_category = category;
+    slot.m_message = message;
+    slot.m_sequence = sequence;
+
+    m_head.store( head + 1, std::memory_order_release);
+    return true;
+}
+
+void Logger::Ring_buffer::pop_until( mi::Uint64 limit, std::vector<Message>& messages)
+{
+    mi::Uint32 tail = m_tail.load( std::memory_order_relaxed);
+    mi::Uint32 head = m_head.load( std::memory_order_acquire);
+
+    // the sequence numbers of a ring buffer are increasing
+    for( ; tail != head; ++tail) {
+        Message& slot = m_slots[tail % s_capacity];
+        if( slot.m_sequence >= limit)
+            break;
+        messages.push_back( Message());
+        Message& m = messages.back();
+        m.m_level = slot.m_level;
+        m.m_category.swap( slot.m_category);
+        m.m_message.swap( slot.m_message);
+        m.m_sequence = slot.m_sequence;
+    }
+
+    m_tail.store( tail, std::memory_order_release);
+}
+
 Logger::Logger()
+  : m_delay_messages( false),
+    m_delivering( false),
+    m_enqueued_count( 0),
+    m_delivered_count( 0),
+    m_severity_limit( mi::base::MESSAGE_SEVERITY_INFO),
+    m_next_sequence( 0),
+    m_dropped_messages( 0),
+    m_reported_dropped_messages( 0),
+    m_generation( ++g_logger_generation),
+    m_drain_pending( false),
+    m_stop_drain_thread( false)
 {
     g_logger = this;
     m_default_logger = new Default_logger();
     m_logger = m_default_logger;
-    m_delay_messages = false;
+    m_drain_thread = std::thread( &Logger::run_drain_thread, this);
 }
 
 Logger::~Logger()
 {
     g_logger = 0;
+
+    {
+        std::lock_guard<std::mutex> lock( m_drain_mutex);
+        m_stop_drain_thread = true;
+    }
+    m_drain_condition.notify_one();
+    m_drain_thread.join();
+    flush();
+
+    // ring buffers of threads that are still alive are released by their holders
+    {
+        mi::base::Lock::Block block( &m_ring_buffers_lock);
+        m_ring_buffers.clear();
+    }
+
     m_logger = 0;
     m_default_logger = 0;
 }
 
 void Logger::set_logger( mi::base::ILogger* logger)
 {
-    m_logger = logger ? make_handle_dup( logger) : m_default_logger;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex);
+        collect_locked();
+        deliver_and_wait( lock);
+        m_logger = logger ? make_handle_dup( logger) : m_default_logger;
+        m_severity_limit = logger
+            ? mi::base::MESSAGE_SEVERITY_DEBUG : mi::base::MESSAGE_SEVERITY_INFO;
+    }
     emit_delayed_log_messages();
 }
 
 mi::base::ILogger* Logger::get_logger()
 {
+    std::lock_guard<std::mutex> lock( m_mutex);
     m_logger->retain();
     return m_logger.get();
 }
@@ -106,33 +193,213 @@ mi::base::ILogger* Logger::get_logger()
 void Logger::message(
     mi::base::Message_severity level, const char* category, const char* message)
 {
-    if( m_delay_messages) {
-        mi::base::Lock::Block block( &m_delayed_messages_lock);
-        m_delayed_messages.push_back( Message( level, category, message));
+    if( !is_enabled( level))
         return;
-    }
 
-    if( !m_delayed_messages.empty())
-        emit_delayed_log_messages();
+    // errors and fatal messages are delivered synchronously, e.g., fatal messages are followed by
+    // abort()
+    if( level > mi::base::MESSAGE_SEVERITY_ERROR) {
+        Ring_buffer* ring_buffer = get_ring_buffer();
+
+        // The busy flag is set before the sequence number is taken. Consumers wait for it to be
+        // cleared, such that they never miss a message with a smaller sequence number than the
+        // ones they deliver.
+        ring_buffer->m_busy.store( true);
+        mi::Uint64 sequence = m_next_sequence++;
+        bool pushed = ring_buffer->push( level, category, message, sequence);
+        ring_buffer->m_busy.store( false, std::memory_order_release);
+
+        if( pushed) {
+            // only the first message after the drain thread woke up needs to notify it
+            if( !m_drain_pending.exchange( true)) {
+                { std::lock_guard<std::mutex> lock( m_drain_mutex); }
+                m_drain_condition.notify_one();
+            }
+            return;
+        }
+        // drop less important messages if the ring buffer is full
+        if( level > mi::base::MESSAGE_SEVERITY_WARNING) {
+            ++m_dropped_messages;
+            return;
+        }
+    }
 
-    m_logger->message( level, category, message);
+    std::unique_lock<std::mutex> lock( m_mutex);
+    collect_locked();
+    if( m_delay_messages)
+        m_delayed_messages.push_back( Message( level, category, message));
+    else {
+        m_queue.push_back( Message( level, category, message));
+        ++m_enqueued_count;
+    }
+    deliver_and_wait( lock);
 }
 
 void Logger::delay_log_messages( bool delay)
 {
+    std::unique_lock<std::mutex> lock( m_mutex);
+    collect_locked();
     m_delay_messages = delay;
+    if( !delay)
+        collect_locked();
+    deliver_and_wait( lock);
 }
 
 void Logger::emit_delayed_log_messages()
 {
-    mi::base::Lock::Block block( &m_delayed_messages_lock);
+    std::unique_lock<std::mutex> lock( m_mutex);
 
-    for( mi::Size i = 0; i < m_delayed_messages.size(); ++i) {
-        const Message& m = m_delayed_messages[i];
-        m_logger->message( m.m_level, m.m_category.c_str(), m.m_message.c_str());
-    }
+    // pending messages might have to be delayed, too
+    collect_locked();
 
+    m_queue.insert( m_queue.end(), m_delayed_messages.begin(), m_delayed_messages.end());
+    m_enqueued_count += m_delayed_messages.size();
     m_delayed_messages.clear();
+
+    deliver_and_wait( lock);
+}
+
+void Logger::flush()
+{
+    std::unique_lock<std::mutex> lock( m_mutex);
+    collect_locked();
+    deliver_and_wait( lock);
+}
+
+Logger::Ring_buffer* Logger::get_ring_buffer()
+{
+    Ring_buffer_holder& holder = s_ring_buffer_holder;
+    if( holder.m_generation != m_generation) {
+        // a ring buffer of a previous logger instance is no longer referenced by that logger
+        std::shared_ptr<Ring_buffer> ring_buffer( new Ring_buffer());
+        {
+            mi::base::Lock::Block block( &m_ring_buffers_lock);
+            m_ring_buffers.push_back( ring_buffer);
+        }
+        holder.m_ring_buffer = ring_buffer;
+        holder.m_generation = m_generation;
+    }
+
+    return holder.m_ring_buffer.get();
+}
+
+void Logger::collect_locked()
+{
+    // All messages with smaller sequence numbers are either pushed already or their producer
+    // is still busy.
+    mi::Uint64 limit = m_next_sequence.load();
+
+    m_batch.clear();
+    {
+        mi::base::Lock::Block block( &m_ring_buffers_lock);
+        mi::Size j = 0;
+        for( mi::Size i = 0; i < m_ring_buffers.size(); ++i) {
+            Ring_buffer* ring_buffer = m_ring_buffers[i].get();
+            while( ring_buffer->m_busy.load())
+                std::this_thread::yield();
+            ring_buffer->pop_until( limit, m_batch);
+
+            // release ring buffers of exited threads once they are drained
+            if( ring_buffer->m_retired.load() && ring_buffer->empty())
+                continue;
+            if( i != j)
+                m_ring_buffers[j].swap( m_ring_buffers[i]);
+            ++j;
+        }
+        m_ring_buffers.resize( j);
+    }
+
+    // restore the global order of messages from different threads
+    std::sort( m_batch.begin(), m_batch.end(),
+        []( const Message& lhs, const Message& rhs) { return lhs.m_sequence < rhs.m_sequence; });
+
+    mi::Uint64 dropped_messages = m_dropped_messages;
+    if( dropped_messages != m_reported_dropped_messages) {
+        std::string message = "Dropped " + std::to_string( dropped_messages
+            - m_reported_dropped_messages) + " log messages due to overload.";
+        m_reported_dropped_messages = dropped_messages;
+        m_batch.insert( m_batch.begin(),
+            Message( mi::base::MESSAGE_SEVERITY_WARNING, "MDL", message.c_str()));
+    }
+
+    if( m_delay_messages) {
+        m_delayed_messages.insert(
+            m_delayed_messages.end(), m_batch.begin(), m_batch.end());
+        m_batch.clear();
+        return;
+    }
+
+    // delayed messages are emitted before the current ones
+    if( !m_delayed_messages.empty()) {
+        m_queue.insert( m_queue.end(), m_delayed_messages.begin(), m_delayed_messages.end());
+        m_enqueued_count += m_delayed_messages.size();
+        m_delayed_messages.clear();
+    }
+
+    m_queue.insert( m_queue.end(), m_batch.begin(), m_batch.end());
+    m_enqueued_count += m_batch.size();
+    m_batch.clear();
+}
+
+void Logger::deliver( std::unique_lock<std::mutex>& lock)
+{
+    // Only one thread delivers at a time to keep the order. A call from within the installed
+    // logger ends up here as well and leaves its messages to the outer call.
+    if( m_delivering)
+        return;
+
+    m_delivering = true;
+    m_deliverer = std::this_thread::get_id();
+
+    std::vector<Message> batch;
+    while( !m_queue.empty()) {
+        batch.swap( m_queue);
+        mi::base::Handle<mi::base::ILogger> logger( m_logger);
+
+        lock.unlock();
+        for( mi::Size i = 0; i < batch.size(); ++i) {
+            const Message& m = batch[i];
+            logger->message( m.m_level, m.m_category.c_str(), m.m_message.c_str());
+        }
+        logger = 0;
+        lock.lock();
+
+        m_delivered_count += batch.size();
+        batch.clear();
+        m_delivered_condition.notify_all();
+    }
+
+    m_delivering = false;
+    m_deliverer = std::thread::id();
+}
+
+void Logger::deliver_and_wait( std::unique_lock<std::mutex>& lock)
+{
+    mi::Uint64 target = m_enqueued_count;
+    deliver( lock);
+
+    // do not wait for ourselves if called from within the installed logger
+    if( m_delivering && m_deliverer == std::this_thread::get_id())
+        return;
+
+    m_delivered_condition.wait( lock, [this, target] { return m_delivered_count >= target; });
+}
+
+void Logger::run_drain_thread()
+{
+    std::unique_lock<std::mutex> lock( m_drain_mutex);
+    for( ;;) {
+        m_drain_condition.wait( lock, [this] {
+            return m_stop_drain_thread || m_drain_pending.load(); });
+        if( m_stop_drain_thread)
+            break;
+
+        // messages pushed from now on notify again
+        m_drain_pending = false;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
 }
 
 } // namespace MDL
@@ -141,86 +408,65 @@ namespace LOG {
 
 class Logger : public ILogger
 {
-    void fatal( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
+    /// Formats the message and forwards it to MDL::Logger.
+    ///
+    /// Messages that are filtered out anyway are not formatted at all.
+    static void forward( mi::base::Message_severity level, const char* fmt, va_list args)
     {
+        MDL::Logger* logger = MDL::g_logger;
+        if( !logger || !logger->is_enabled( level))
+            return;
+
         char buf[32768];
         vsnprintf( buf, sizeof( buf), fmt, args);
 
         // TODO support category
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_FATAL, "MDL", buf);
+        logger->message( level, "MDL", buf);
     }
 
-    void error( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
+    void fatal( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
+        forward( mi::base::MESSAGE_SEVERITY_FATAL, fmt, args);
+    }
 
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_ERROR, "MDL", buf);
+    void error( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
+    {
+        forward( mi::base::MESSAGE_SEVERITY_ERROR, fmt, args);
     }
 
     void warning( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_WARNING, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_WARNING, fmt, args);
     }
 
     void stat( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_VERBOSE, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_VERBOSE, fmt, args);
     }
 
     void vstat( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_VERBOSE, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_VERBOSE, fmt, args);
     }
 
     void progress( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_VERBOSE, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_VERBOSE, fmt, args);
     }
 
     void info( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_INFO, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_INFO, fmt, args);
     }
 
     void debug( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args)
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_DEBUG, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_DEBUG, fmt, args);
     }
 
     void vdebug( const char* /*mod*/, Category /*cat*/, const char* fmt, va_list args) //-V524 PVS
     {
-        char buf[32768];
-        vsnprintf( buf, sizeof( buf), fmt, args);
-
-        if( MDL::g_logger)
-            MDL::g_logger->message( mi::base::MESSAGE_SEVERITY_DEBUG, "MDL", buf);
+        forward( mi::base::MESSAGE_SEVERITY_DEBUG, fmt, args);
     }
 
     void assertfailed( const char* /*mod*/, const char* expr, const char* file, int line)
@@ -33,7 +33,12 @@
 #ifndef API_API_MDL_LOG_MODULE_STUB_H
 #define API_API_MDL_LOG_MODULE_STUB_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <mi/base/enums.h>
@@ -52,6 +57,21 @@ namespace MDL {
 /// If no logger is explicitly installed, a default logger is used that prints all messages of
 /// severity #mi::base::MESSAGE_SEVERITY_INFO or higher to stderr. The .cpp file contains also
 /// stubs for the LOG module to forward its methods to this  class.
+///
+/// Messages are delivered asynchronously: each thread enqueues its messages into its own
+/// lock-free ring buffer, and a background thread drains all ring buffers (in the order in which
+/// the messages were enqueued) and forwards them to the installed logger. Hence, logging does not
+/// block the calling threads on the installed logger. If a ring buffer is full, messages of
+/// severity #mi::base::MESSAGE_SEVERITY_INFO or lower are dropped (and counted), more severe
+/// messages are delivered synchronously. Errors and fatal messages are always delivered
+/// synchronously (after all pending messages).
+///
+/// The installed logger is called by one thread at a time, and never while a lock is held.
+/// Hence, it may call back into the SDK, and messages logged from within the callback are
+/// delivered after the current batch. Ring buffers are released when their threads exit.
+///
+/// Messages that are less severe than the severity limit are rejected by #is_enabled(), which
+/// allows to skip formatting them at all.
 class Logger
 {
 public:
@@ -61,12 +81,20 @@ public:
 
     /// Install a new logger (replaces the old one).
     ///
-    /// \c NULL can be used to re-install the default logger.
+    /// \c NULL can be used to re-install the default logger. Pending messages are delivered to
+    /// the old logger.
     void set_logger( mi::base::ILogger* logger);
 
     /// Returns the installed logger.
     mi::base::ILogger* get_logger();
 
+    /// Indicates whether messages of the given severity are forwarded at all.
+    ///
+    /// The default logger ignores messages less severe than #mi::base::MESSAGE_SEVERITY_INFO,
+    /// other loggers receive all messages.
+    bool is_enabled( mi::base::Message_severity level) const
+    { return static_cast<mi::Uint32>( level) <= m_severity_limit.load( std::memory_order_relaxed); }
+
     /// Forwards the message to the installed logger.
     void message( mi::base::Message_severity level, const char* category, const char* message);
 
@@ -81,30 +109,156 @@ public:
     /// Does not change the flag for delaying upcoming log messages.
     void emit_delayed_log_messages();
 
+    /// Delivers all pending messages of all threads to the installed logger.
+    void flush();
+
+    /// Returns the number of messages that have been dropped due to full ring buffers.
+    mi::Uint64 get_dropped_messages() const { return m_dropped_messages; }
+
 private:
-    /// Represents a delayed log message.
+    /// Represents a log message.
     struct Message {
 
+        /// Default constructor
+        Message() : m_level( mi::base::MESSAGE_SEVERITY_INFO), m_sequence( 0) { }
+
         /// Constructor
         Message( mi::base::Message_severity level, const char* category, const char* message)
-          : m_level( level), m_category( category), m_message( message) { }
+          : m_level( level), m_category( category), m_message( message), m_sequence( 0) { }
 
         /// Fields
         mi::base::Message_severity m_level;
         std::string m_category;
         std::string m_message;
+        mi::Uint64 m_sequence;
+    };
+
+    /// Single-producer single-consumer ring buffer of messages.
+    ///
+    /// The producer is the thread owning the ring buffer, consumers need #m_mutex.
+    struct Ring_buffer {
+
+        /// Number of slots.
+        static const mi::Uint32 s_capacity = 1024;
+
+        /// Constructor
+        Ring_buffer()
+          : m_head( 0), m_tail( 0), m_busy( false), m_retired( false), m_slots( s_capacity) { }
+
+        /// Enqueues a message. Returns \c false if the ring buffer is full.
+        bool push(
+            mi::base::Message_severity level,
+            const char* category,
+            const char* message,
+            mi::Uint64 sequence);
+
+        /// Moves all pending messages with sequence numbers less than \p limit to the end of
+        /// \p messages.
+        void pop_until( mi::Uint64 limit, std::vector<Message>& messages);
+
+        /// Indicates whether there are no pending messages.
+        bool empty() const { return m_head.load() == m_tail.load(); }
+
+        /// Index of the next slot to write (modified only by the producer).
+        std::atomic<mi::Uint32> m_head;
+        /// Index of the next slot to read (modified only by consumers).
+        std::atomic<mi::Uint32> m_tail;
+        /// Set by the producer from taking a sequence number until the message is pushed.
+        std::atomic<bool> m_busy;
+        /// Set when the producer thread exits.
+        std::atomic<bool> m_retired;
+        /// The slots.
+        std::vector<Message> m_slots;
     };
 
-    /// The used logger.
+    /// Thread-local owner of the ring buffer of a thread, retires it when the thread exits.
+    struct Ring_buffer_holder {
+
+        /// Constructor
+        Ring_buffer_holder() : m_generation( 0) { }
+
+        /// Destructor
+        ~Ring_buffer_holder() { if( m_ring_buffer) m_ring_buffer->m_retired = true; }
+
+        /// The generation of the logger the ring buffer belongs to.
+        mi::Uint32 m_generation;
+        /// The ring buffer, shared with #m_ring_buffers.
+        std::shared_ptr<Ring_buffer> m_ring_buffer;
+    };
+
+    /// Returns the ring buffer of the calling thread (created on first use).
+    Ring_buffer* get_ring_buffer();
+
+    /// Moves all messages enqueued so far from the ring buffers to #m_queue (or to
+    /// #m_delayed_messages). Needs #m_mutex.
+    void collect_locked();
+
+    /// Delivers #m_queue unless another thread (or an outer call of this thread) already does.
+    /// Needs \p lock, which is released while the installed logger is called.
+    void deliver( std::unique_lock<std::mutex>& lock);
+
+    /// Delivers #m_queue and waits until all messages queued so far have been delivered, unless
+    /// called from within the installed logger.
+    void deliver_and_wait( std::unique_lock<std::mutex>& lock);
+
+    /// Main function of the drain thread.
+    void run_drain_thread();
+
+    /// The ring buffer of the current thread.
+    static thread_local Ring_buffer_holder s_ring_buffer_holder;
+
+    /// The used logger. Needs #m_mutex.
     mi::base::Handle<mi::base::ILogger> m_logger;
     /// The default logger.
     mi::base::Handle<mi::base::ILogger> m_default_logger;
-    /// Indicates whether log messages are delayed.
+    /// Indicates whether log messages are delayed. Needs #m_mutex.
     bool m_delay_messages;
-    /// Delayed log messages. Needs #m_delayed_messages_lock.
+    /// Delayed log messages. Needs #m_mutex.
     std::vector<Message> m_delayed_messages;
-    /// Lock for #m_delayed_messages.
-    mi::base::Lock m_delayed_messages_lock;
+
+    /// Lock for the delivery state and for consuming messages from ring buffers.
+    std::mutex m_mutex;
+    /// Signals that messages have been delivered.
+    std::condition_variable m_delivered_condition;
+    /// Messages to be delivered, in order. Needs #m_mutex.
+    std::vector<Message> m_queue;
+    /// Messages drained from the ring buffers. Needs #m_mutex.
+    std::vector<Message> m_batch;
+    /// Indicates whether a thread is calling the installed logger. Needs #m_mutex.
+    bool m_delivering;
+    /// The thread calling the installed logger, if #m_delivering is set. Needs #m_mutex.
+    std::thread::id m_deliverer;
+    /// Number of messages added to #m_queue so far. Needs #m_mutex.
+    mi::Uint64 m_enqueued_count;
+    /// Number of messages delivered so far. Needs #m_mutex.
+    mi::Uint64 m_delivered_count;
+
+    /// Most verbose severity that is forwarded.
+    std::atomic<mi::Uint32> m_severity_limit;
+    /// Sequence number for the next message.
+    std::atomic<mi::Uint64> m_next_sequence;
+    /// Number of dropped messages.
+    std::atomic<mi::Uint64> m_dropped_messages;
+    /// Number of dropped messages that have already been reported. Needs #m_mutex.
+    mi::Uint64 m_reported_dropped_messages;
+
+    /// Identifies this instance for the thread-local ring buffer holders.
+    mi::Uint32 m_generation;
+    /// All ring buffers. Needs #m_ring_buffers_lock.
+    std::vector<std::shared_ptr<Ring_buffer> > m_ring_buffers;
+    /// Lock for #m_ring_buffers.
+    mi::base::Lock m_ring_buffers_lock;
+
+    /// The drain thread.
+    std::thread m_drain_thread;
+    /// Mutex for #m_drain_condition and #m_stop_drain_thread.
+    std::mutex m_drain_mutex;
+    /// Signals the drain thread that messages are pending or that it should stop.
+    std::condition_variable m_drain_condition;
+    /// Indicates that messages have been pushed since the drain thread last woke up.
+    std::atomic<bool> m_drain_pending;
+    /// Indicates that the drain thread should stop. Needs #m_drain_mutex.
+    bool m_stop_drain_thread;
 };
 
 } // namespace MDL
@@ -536,6 +536,11 @@ mi::neuraylib::ITarget_code const* Mdl_llvm_backend::translate_link_unit(
     return m_backend.translate_link_unit(unwrap(lu), unwrap_and_clear(context));
 }
 
+void Mdl_llvm_backend::clear_df_lambda_profile()
+{
+    m_backend.get_jit_be()->clear_df_lambda_profile();
+}
+
 
 } // namespace MDL
 
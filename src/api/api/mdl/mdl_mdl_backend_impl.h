@@ -174,6 +174,8 @@ public:
         mi::neuraylib::ILink_unit const* lu,
         mi::neuraylib::IMdl_execution_context* context);
 
+    virtual void clear_df_lambda_profile();
+
 private:
     /// Get the internal backend.
     BACKENDS::Mdl_llvm_backend &get_backend() { return m_backend; };
@@ -243,6 +243,44 @@ mi::Sint32 Mdl_compiler_impl::load_module_from_string(
         unwrap_and_clear(context, default_context));
 }
 
+mi::Sint32 Mdl_compiler_impl::reload_module(
+    mi::neuraylib::ITransaction* transaction,
+    const char* module_name,
+    mi::neuraylib::IMdl_execution_context* context)
+{
+    if (!transaction || !module_name)
+        return -1;
+
+    NEURAY::Transaction_impl* transaction_impl
+        = static_cast<NEURAY::Transaction_impl*>(transaction);
+    DB::Transaction* db_transaction = transaction_impl->get_db_transaction();
+
+    MDL::Execution_context default_context;
+    return MDL::Mdl_module::reload_module(db_transaction, module_name, /*module_source*/ 0,
+        unwrap_and_clear(context, default_context));
+}
+
+mi::Sint32 Mdl_compiler_impl::reload_module_from_string(
+    mi::neuraylib::ITransaction* transaction,
+    const char* module_name,
+    const char* module_source,
+    mi::neuraylib::IMdl_execution_context* context)
+{
+    if (!transaction || !module_name || !module_source)
+        return -1;
+
+    NEURAY::Transaction_impl* transaction_impl
+        = static_cast<NEURAY::Transaction_impl*>(transaction);
+    DB::Transaction* db_transaction = transaction_impl->get_db_transaction();
+
+    mi::base::Handle<mi::neuraylib::IReader> reader(
+        NEURAY::Impexp_utilities::create_reader(module_source, strlen(module_source)));
+
+    MDL::Execution_context default_context;
+    return MDL::Mdl_module::reload_module(db_transaction, module_name, reader.get(),
+        unwrap_and_clear(context, default_context));
+}
+
 mi::Sint32 Mdl_compiler_impl::add_builtin_module(
     const char* module_name, const char* module_source)
 {
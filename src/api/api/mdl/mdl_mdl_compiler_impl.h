@@ -124,6 +124,17 @@ public:
         const char* module_source,
         mi::neuraylib::IMdl_execution_context* context);
 
+    mi::Sint32 reload_module(
+        mi::neuraylib::ITransaction* transaction,
+        const char* module_name,
+        mi::neuraylib::IMdl_execution_context* context);
+
+    mi::Sint32 reload_module_from_string(
+        mi::neuraylib::ITransaction* transaction,
+        const char* module_name,
+        const char* module_source,
+        mi::neuraylib::IMdl_execution_context* context);
+
     mi::Sint32 add_builtin_module( const char* module_name, const char* module_source);
 
     mi::Sint32 deprecated_export_module(
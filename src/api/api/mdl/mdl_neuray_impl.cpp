@@ -46,7 +46,9 @@
 #include <base/data/dblight/i_dblight.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <io/image/image/i_image.h>
+#include <io/scene/mdl_elements/i_mdl_elements_material_instance.h>
 #include <io/scene/mdl_elements/i_mdl_elements_utilities.h>
+#include <io/scene/mdl_elements/mdl_elements_detail.h>
 
 // API components
 #include "neuray_database_impl.h"
@@ -270,8 +272,17 @@ mi::Sint32 Neuray_impl::shutdown( bool blocking)
 
 #undef CHECK_RESULT
 
+    // memoized compiled materials refer to DB elements of this session
+    MDL::Mdl_material_instance::clear_compiled_material_cache();
+
+    // the content-hash index of shared resources refers to DB elements by name
+    MDL::DETAIL::Resource_dedup::clear();
+
     m_database->close();
 
+    // deliver pending messages before returning control to the application
+    m_logger->flush();
+
     m_status = SHUTDOWN;
 
     return result;
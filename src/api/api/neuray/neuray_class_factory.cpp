@@ -243,7 +243,7 @@ mi::Sint32 Class_factory::unregister_structure_decl( const char* structure_name)
 
     mi::base::Lock::Block block( &m_map_name_structure_decl_lock);
 
-    std::map<std::string, const mi::IStructure_decl*>::iterator it
+    Map_name_structure_decl::iterator it
         = m_map_name_structure_decl.find( structure_name);
     if( it == m_map_name_structure_decl.end())
         return -1;
@@ -258,7 +258,7 @@ const mi::IStructure_decl* Class_factory::get_structure_decl( const char* struct
 {
     mi::base::Lock::Block block( &m_map_name_structure_decl_lock);
 
-    std::map<std::string, const mi::IStructure_decl*>::const_iterator it
+    Map_name_structure_decl::const_iterator it
         = m_map_name_structure_decl.find( structure_name);
     if( it == m_map_name_structure_decl.end())
         return 0;
@@ -315,7 +315,7 @@ mi::Sint32 Class_factory::unregister_enum_decl( const char* enum_name)
 
     mi::base::Lock::Block block( &m_map_name_enum_decl_lock);
 
-    std::map<std::string, const mi::IEnum_decl*>::iterator it
+    Map_name_enum_decl::iterator it
         = m_map_name_enum_decl.find( enum_name);
     if( it == m_map_name_enum_decl.end())
         return -1;
@@ -330,7 +330,7 @@ const mi::IEnum_decl* Class_factory::get_enum_decl( const char* enum_name) const
 {
     mi::base::Lock::Block block( &m_map_name_enum_decl_lock);
 
-    std::map<std::string, const mi::IEnum_decl*>::const_iterator it
+    Map_name_enum_decl::const_iterator it
         = m_map_name_enum_decl.find( enum_name);
     if( it == m_map_name_enum_decl.end())
         return 0;
@@ -341,13 +341,13 @@ const mi::IEnum_decl* Class_factory::get_enum_decl( const char* enum_name) const
 
 void Class_factory::unregister_user_defined_classes()
 {
-    for( std::map<std::string, mi::neuraylib::IUser_class_factory*>::iterator it
+    for( Map_name_user_class_factory::iterator it
         = m_map_name_user_class_factory.begin(); it != m_map_name_user_class_factory.end(); ++it) {
         it->second->release();
         it->second = 0;
     }
     m_map_name_user_class_factory.clear();
-    for( std::map<mi::base::Uuid, mi::neuraylib::IUser_class_factory*>::iterator it
+    for( Map_uuid_user_class_factory::iterator it
         = m_map_uuid_user_class_factory.begin(); it != m_map_uuid_user_class_factory.end(); ++it) {
         it->second->release();
         it->second = 0;
@@ -359,7 +359,7 @@ void Class_factory::unregister_structure_decls()
 {
     mi::base::Lock::Block block( &m_map_name_structure_decl_lock);
 
-    for( std::map<std::string, const mi::IStructure_decl*>::iterator it
+    for( Map_name_structure_decl::iterator it
         = m_map_name_structure_decl.begin(); it != m_map_name_structure_decl.end(); ++it) {
         it->second->release();
         it->second = 0;
@@ -371,7 +371,7 @@ void Class_factory::unregister_enum_decls()
 {
     mi::base::Lock::Block block( &m_map_name_enum_decl_lock);
 
-    for( std::map<std::string, const mi::IEnum_decl*>::iterator it
+    for( Map_name_enum_decl::iterator it
         = m_map_name_enum_decl.begin(); it != m_map_name_enum_decl.end(); ++it) {
         it->second->release();
         it->second = 0;
@@ -381,7 +381,7 @@ void Class_factory::unregister_enum_decls()
 
 SERIAL::Class_id Class_factory::get_class_id( const char* class_name) const
 {
-    std::map<std::string, SERIAL::Class_id>::const_iterator it
+    Map_name_id::const_iterator it
         = m_map_name_id.find( class_name);
     if( it == m_map_name_id.end())
         return 0;
@@ -530,7 +530,7 @@ mi::base::IInterface* Class_factory::create_class_instance(
         return user_class.get();
     }
 
-    std::map<std::string, Db_element_factory>::const_iterator it
+    Map_name_db_element_factory::const_iterator it
         = m_map_name_db_element_factory.find( class_name);
 
     if( it == m_map_name_db_element_factory.end()) {
@@ -757,7 +757,7 @@ mi::base::IInterface* Class_factory::invoke_api_class_factory(
     SERIAL::Class_id class_id) const
 {
     // lookup API class factory by class ID
-    std::map<SERIAL::Class_id, Api_class_factory>::const_iterator it
+    Map_id_api_class_factory::const_iterator it
         = m_map_id_api_class_factory.find( class_id);
     if( it == m_map_id_api_class_factory.end())
         return 0;
@@ -774,7 +774,7 @@ mi::base::IInterface* Class_factory::invoke_api_or_user_class_factory(
     const mi::base::IInterface* argv[]) const
 {
     // lookup API class factory by class name
-    std::map<std::string, Api_class_factory>::const_iterator it_api
+    Map_name_api_class_factory::const_iterator it_api
         = m_map_name_api_class_factory.find( class_name);
     if( it_api != m_map_name_api_class_factory.end()) {
 
@@ -784,7 +784,7 @@ mi::base::IInterface* Class_factory::invoke_api_or_user_class_factory(
     }
 
     // lookup user class factory by class name
-    std::map<std::string, mi::neuraylib::IUser_class_factory*>::const_iterator it_user
+    Map_name_user_class_factory::const_iterator it_user
         = m_map_name_user_class_factory.find( class_name);
     if( it_user == m_map_name_user_class_factory.end())
         return 0;
@@ -801,7 +801,7 @@ DB::Element_base* Class_factory::invoke_db_element_factory(
     const mi::base::IInterface* argv[]) const
 {
     // lookup DB element factory
-    std::map<std::string, Db_element_factory>::const_iterator it
+    Map_name_db_element_factory::const_iterator it
         = m_map_name_db_element_factory.find( class_name);
     if( it == m_map_name_db_element_factory.end())
         return 0;
@@ -814,7 +814,7 @@ DB::Element_base* Class_factory::invoke_db_element_factory(
 mi::base::IInterface* Class_factory::invoke_user_class_factory( const mi::base::Uuid& uuid) const
 {
     // lookup user class factory by class UUID
-    std::map<mi::base::Uuid, mi::neuraylib::IUser_class_factory*>::const_iterator it
+    Map_uuid_user_class_factory::const_iterator it
         = m_map_uuid_user_class_factory.find( uuid);
     if( it == m_map_uuid_user_class_factory.end())
         return 0;
@@ -834,7 +834,7 @@ bool Class_factory::contains_blacklisted_type_names(
         return true;
 
     // descend into structures
-    std::map<std::string, const mi::IStructure_decl*>::const_iterator it_structure_decl
+    Map_name_structure_decl::const_iterator it_structure_decl
         = m_map_name_structure_decl.find( type_name);
     if( it_structure_decl != m_map_name_structure_decl.end()) {
         blacklist.push_back( type_name);
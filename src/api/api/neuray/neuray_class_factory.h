@@ -42,6 +42,8 @@
 #include <string>
 
 #include <boost/core/noncopyable.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 #include <base/data/serial/i_serial_classid.h>
 #include <base/data/db/i_db_tag.h>
 
@@ -632,45 +634,72 @@ private:
     bool contains_blacklisted_type_names(
         const mi::IStructure_decl* decl, std::vector<std::string>& blacklist);
 
+    /// Hash functor for UUIDs.
+    struct Uuid_hash
+    {
+        size_t operator()( const mi::base::Uuid& uuid) const
+        {
+            size_t seed = 0;
+            boost::hash_combine( seed, uuid.m_id1);
+            boost::hash_combine( seed, uuid.m_id2);
+            boost::hash_combine( seed, uuid.m_id3);
+            boost::hash_combine( seed, uuid.m_id4);
+            return seed;
+        }
+    };
+
+    // The maps below are hashed since they are queried for every API class instance creation.
+
+    typedef boost::unordered_map<std::string, SERIAL::Class_id> Map_name_id;
+    typedef boost::unordered_map<SERIAL::Class_id, Api_class_factory> Map_id_api_class_factory;
+    typedef boost::unordered_map<std::string, Api_class_factory> Map_name_api_class_factory;
+    typedef boost::unordered_map<std::string, Db_element_factory> Map_name_db_element_factory;
+    typedef boost::unordered_map<std::string, mi::neuraylib::IUser_class_factory*>
+        Map_name_user_class_factory;
+    typedef boost::unordered_map<mi::base::Uuid, mi::neuraylib::IUser_class_factory*, Uuid_hash>
+        Map_uuid_user_class_factory;
+    typedef boost::unordered_map<std::string, const mi::IStructure_decl*> Map_name_structure_decl;
+    typedef boost::unordered_map<std::string, const mi::IEnum_decl*> Map_name_enum_decl;
+
     /// Maps class names to class IDs.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<std::string, SERIAL::Class_id> m_map_name_id;
+    Map_name_id m_map_name_id;
 
     /// Maps class IDs to API class factories.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<SERIAL::Class_id, Api_class_factory> m_map_id_api_class_factory;
+    Map_id_api_class_factory m_map_id_api_class_factory;
 
     /// Maps class names to API class factories.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<std::string, Api_class_factory> m_map_name_api_class_factory;
+    Map_name_api_class_factory m_map_name_api_class_factory;
 
     /// Maps class names to DB element factories.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<std::string, Db_element_factory> m_map_name_db_element_factory;
+    Map_name_db_element_factory m_map_name_db_element_factory;
 
     /// Maps class names to user class factories.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<std::string, mi::neuraylib::IUser_class_factory*> m_map_name_user_class_factory;
+    Map_name_user_class_factory m_map_name_user_class_factory;
 
     /// Maps class UUIDs to user class factories.
     ///
     /// Not locked since it is modified only before startup.
-    std::map<mi::base::Uuid, mi::neuraylib::IUser_class_factory*> m_map_uuid_user_class_factory;
+    Map_uuid_user_class_factory m_map_uuid_user_class_factory;
 
     /// Maps class names to structure declarations.
     ///
     /// \note Any access needs to be protected by #m_map_name_structure_decl_lock.
-    std::map<std::string, const mi::IStructure_decl*> m_map_name_structure_decl;
+    Map_name_structure_decl m_map_name_structure_decl;
 
     /// Maps class names to enum declarations.
     ///
     /// \note Any access needs to be protected by #m_map_name_enum_decl_lock.
-    std::map<std::string, const mi::IEnum_decl*> m_map_name_enum_decl;
+    Map_name_enum_decl m_map_name_enum_decl;
 
     /// The lock that protects the map #m_map_name_structure_decl.
     mutable mi::base::Lock m_map_name_structure_decl_lock;
@@ -46,6 +46,50 @@ namespace MI {
 
 namespace NEURAY {
 
+void Db_element_registry::insert( const Db_element_impl_base* db_element)
+{
+    Shard& shard = m_shards[get_shard_index( db_element)];
+    mi::base::Lock::Block block( &shard.m_lock);
+    shard.m_elements.insert( db_element);
+}
+
+void Db_element_registry::erase( const Db_element_impl_base* db_element)
+{
+    Shard& shard = m_shards[get_shard_index( db_element)];
+    mi::base::Lock::Block block( &shard.m_lock);
+    shard.m_elements.erase( db_element);
+}
+
+bool Db_element_registry::empty() const
+{
+    for( size_t i = 0; i < s_shard_count; ++i) {
+        mi::base::Lock::Block block( &m_shards[i].m_lock);
+        if( !m_shards[i].m_elements.empty())
+            return false;
+    }
+    return true;
+}
+
+void Db_element_registry::get_tags( std::vector<DB::Tag>& tags) const
+{
+    for( size_t i = 0; i < s_shard_count; ++i) {
+        mi::base::Lock::Block block( &m_shards[i].m_lock);
+        boost::unordered_set<const Db_element_impl_base*>::const_iterator it
+            = m_shards[i].m_elements.begin();
+        boost::unordered_set<const Db_element_impl_base*>::const_iterator it_end
+            = m_shards[i].m_elements.end();
+        for( ; it != it_end; ++it)
+            tags.push_back( (*it)->get_tag());
+    }
+}
+
+size_t Db_element_registry::get_shard_index( const Db_element_impl_base* db_element)
+{
+    // the low bits are zero due to the alignment of heap allocations, mix in higher bits
+    size_t address = reinterpret_cast<size_t>( db_element);
+    return ((address >> 4) ^ (address >> 12)) % s_shard_count;
+}
+
 Db_element_tracker::Db_element_tracker()
   : m_initialized( false)
 {
@@ -76,7 +120,6 @@ void Db_element_tracker::remove_element( const Db_element_impl_base* db_element)
     //
     // Reference counting as usual is not possible since that would increase the reference count,
     // and the object would never go out of scope.
-    mi::base::Lock::Block block( &m_lock);
     m_elements.erase( db_element);
 }
 
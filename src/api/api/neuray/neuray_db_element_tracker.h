@@ -37,6 +37,10 @@
 
 #include <mi/base/lock.h>
 #include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/unordered_set.hpp>
 
 
 namespace MI { namespace HTTP { class Connection; } }
@@ -47,6 +51,51 @@ namespace NEURAY {
 
 class Db_element_impl_base;
 
+/// A set of DB elements that supports concurrent insertions and removals.
+///
+/// The set is split into a fixed number of shards, each with its own lock and hash set. The shard
+/// of a DB element is selected by its address, such that threads accessing and releasing different
+/// DB elements rarely contend for the same lock.
+class Db_element_registry : public boost::noncopyable
+{
+public:
+    /// Adds a DB element to the set.
+    void insert( const Db_element_impl_base* db_element);
+
+    /// Removes a DB element from the set.
+    void erase( const Db_element_impl_base* db_element);
+
+    /// Indicates whether the set is empty.
+    bool empty() const;
+
+    /// Returns the tags of all DB elements currently in the set.
+    ///
+    /// The DB elements are only dereferenced while their shard is locked. DB elements remove
+    /// themselves from the set before they are destroyed, hence they cannot be destroyed
+    /// concurrently.
+    void get_tags( std::vector<DB::Tag>& tags) const;
+
+private:
+    /// The number of shards.
+    static const size_t s_shard_count = 16;
+
+    /// Returns the shard index for a DB element.
+    static size_t get_shard_index( const Db_element_impl_base* db_element);
+
+    /// A shard of the set.
+    struct Shard
+    {
+        /// Lock for the set below.
+        mutable mi::base::Lock m_lock;
+
+        /// The DB elements of this shard.
+        boost::unordered_set<const Db_element_impl_base*> m_elements;
+    };
+
+    /// The shards.
+    Shard m_shards[s_shard_count];
+};
+
 /// The tracker can be used to monitor DB elements in use by the API. The constructor and
 /// destructor of Db_element_impl record these events with the tracker. The tracker installs a
 /// callback for the admin HTTP server to dump all DB elements currently in use by the API.
@@ -81,10 +130,7 @@ private:
     bool m_initialized;
 
     /// Contains the DB elements currently in use by the API.
-    std::set<const Db_element_impl_base*> m_elements;
-
-    /// Lock for the set above.
-    mi::base::Lock m_lock;
+    Db_element_registry m_elements;
 };
 
 } // namespace NEURAY
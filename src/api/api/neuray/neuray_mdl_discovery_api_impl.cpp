@@ -43,11 +43,17 @@
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/lib/path/i_path.h>
 #include <base/system/main/i_module_id.h>
+#include <mdl/compiler/compilercore/compilercore_thread_pool.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <io/scene/mdl_elements/i_mdl_elements_module.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 #include <boost/algorithm/string/replace.hpp>
 
 
@@ -422,105 +428,223 @@ bool Mdl_discovery_api_impl::check_ident_validity(const char* identifier) const
 }
 
 
-bool Mdl_discovery_api_impl::discover_recursive(mi::base::Handle<Mdl_package_info_impl> parent,
-    const char* search_path, mi::Size s_idx, const char* path, 
-    const std::vector<std::string>& invalid_dirs) const
+namespace {
+
+// Returns true if name ends with the given extension.
+bool has_extension(const std::string& name, const char* ext)
+{
+    const std::size_t l = strlen(ext);
+    return name.size() > l && name.compare(name.size() - l, l, ext) == 0;
+}
+
+// Returns true if cached data for a file system entry with the given modification time can be
+// reused. The time stamps have a granularity of one second, so entries which were modified in
+// the same second as the cached data was created might have changed afterwards.
+bool is_unchanged(double cached_mtime, double cached_scan_time, double mtime)
+{
+    return cached_mtime == mtime && cached_scan_time > mtime + 1.0;
+}
+
+// Scans a single directory, or returns the cached scan if the directory did not change.
+// Returns NULL if the path is not a readable directory.
+std::shared_ptr<const Mdl_discovery_directory_scan> scan_directory(
+    const std::string& path,
+    const std::shared_ptr<const Mdl_discovery_directory_scan>& cached)
 {
+    DISK::Stat stat;
+    if (!DISK::stat(path.c_str(), &stat) || !stat.m_is_dir)
+        return nullptr;
+
+    const double mtime = stat.m_modification_time.get_seconds();
+    if (cached && is_unchanged(cached->m_mtime, cached->m_scan_time, mtime))
+        return cached;
+
+    const double scan_time = double(std::time(nullptr));
+
     DISK::Directory dir;
-    if (!dir.open(path))
-        return false;
+    if (!dir.open(path.c_str()))
+        return nullptr;
 
-    std::string current_path(path);
-    std::string package_path = slash_to_colon(current_path.substr(strlen(search_path))) + "::";
+    std::shared_ptr<Mdl_discovery_directory_scan> scan(new Mdl_discovery_directory_scan());
+    scan->m_mtime = mtime;
+    scan->m_scan_time = scan_time;
 
     std::string entry = dir.read();
     while (!entry.empty())
     {
-        std::string resolved_path = HAL::Ospath::join(current_path, entry);
+        std::string resolved_path = HAL::Ospath::join(path, entry);
         if (DISK::is_directory(resolved_path.c_str()))
+            scan->m_directories.push_back(entry);
+        // Filter sym-links and other non-files
+        else if (DISK::is_file(resolved_path.c_str()))
         {
-            if (std::find(invalid_dirs.begin(), invalid_dirs.end(), 
-                resolved_path) != invalid_dirs.end())
-            {
-                // todo: add error message
-                entry = dir.read();
-                continue;
-            }
+            if (has_extension(entry, ".mdl"))
+                scan->m_modules.push_back(entry.substr(0, entry.size() - 4));
+            else if (has_extension(entry, ".mdr"))
+                scan->m_archives.push_back(entry.substr(0, entry.size() - 4));
+        }
+        entry = dir.read();
+    }
+    dir.close();
 
-            mi::base::Handle< Mdl_package_info_impl>
-                child_package(new Mdl_package_info_impl(entry.c_str(),
-                    search_path,
-                    resolved_path.c_str(),
-                    mi::Uint32(s_idx),
-                    (package_path + entry).c_str()));
+    return scan;
+}
 
-            mi::Sint32 idx = parent->check_package(child_package.get());
-            if (idx >= 0)
-            {
-                // Package exists already -> merge nodes 
-                const Mdl_package_info_impl* mg(parent->get_package(idx));
-                mg = parent->merge_packages(mg, child_package.get());
+} // end namespace
 
-                mi::base::Handle< Mdl_package_info_impl>
-                    merge_package(new Mdl_package_info_impl(*mg));
+void Mdl_discovery_api_impl::scan_directories(
+    const std::vector<std::string>& roots,
+    Directory_scans& scans) const
+{
+    Directory_scans cache;
+    {
+        mi::base::Lock::Block block(&m_cache_lock);
+        cache = m_directory_cache;
+    }
 
-                // Continue recursion with merged node
-                discover_recursive(merge_package,
-                    search_path, s_idx, resolved_path.c_str(), invalid_dirs);
-                parent->reset_package(merge_package.get(), idx);
-            }
-            else
+    // Breadth-first traversal with a shared work list. Scanning is dominated by file system
+    // latency (in particular on network shares), so directories are scanned concurrently.
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::string> pending;
+    std::unordered_set<std::string> queued;
+    mi::Size active = 0;
+
+    for (const std::string& root : roots)
+        if (queued.insert(root).second)
+            pending.push_back(root);
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            cond.wait(lock, [&]() { return !pending.empty() || active == 0; });
+            if (pending.empty())
+                return;
+
+            std::string path = pending.front();
+            pending.pop_front();
+            ++active;
+
+            Directory_scans::const_iterator it = cache.find(path);
+            lock.unlock();
+            std::shared_ptr<const Mdl_discovery_directory_scan> scan = scan_directory(
+                path,
+                it != cache.end() ? it->second
+                                  : std::shared_ptr<const Mdl_discovery_directory_scan>());
+            lock.lock();
+
+            --active;
+            if (scan)
             {
-                // No merge has happened -> continue with new node
-                discover_recursive(child_package,
-                    search_path, s_idx, resolved_path.c_str(), invalid_dirs);
-                parent->add_package(child_package.get());
+                scans[path] = scan;
+                for (const std::string& d : scan->m_directories)
+                {
+                    std::string child = HAL::Ospath::join(path, d);
+                    if (queued.insert(child).second)
+                        pending.push_back(child);
+                }
             }
+            cond.notify_all();
         }
-        else
+    };
+
+    // Up to 8 threads, more do not help on typical file systems
+    std::shared_ptr<mi::mdl::Thread_pool> pool(mi::mdl::Thread_pool::get());
+    mi::mdl::Thread_pool::Job_group group(*pool);
+
+    for (size_t t = 1, n = pool->get_num_threads(8, 8); t < n; ++t)
+        group.run(worker);
+    worker();
+    group.wait();
+
+    // Replace the cache, this also drops directories which do not exist anymore
+    mi::base::Lock::Block block(&m_cache_lock);
+    m_directory_cache = scans;
+}
+
+bool Mdl_discovery_api_impl::discover_recursive(mi::base::Handle<Mdl_package_info_impl> parent,
+    const char* search_path, mi::Size s_idx, const char* path, 
+    const std::vector<std::string>& invalid_dirs,
+    const Directory_scans& scans) const
+{
+    Directory_scans::const_iterator it = scans.find(path);
+    if (it == scans.end())
+        return false;
+    const Mdl_discovery_directory_scan& scan = *it->second;
+
+    std::string current_path(path);
+    std::string package_path = slash_to_colon(current_path.substr(strlen(search_path))) + "::";
+
+    for (const std::string& entry : scan.m_directories)
+    {
+        std::string resolved_path = HAL::Ospath::join(current_path, entry);
+        if (std::find(invalid_dirs.begin(), invalid_dirs.end(), 
+            resolved_path) != invalid_dirs.end())
         {
-            std::size_t found_mdl = resolved_path.rfind(".mdl");
-            // Filter sym-links and non-mdl files
-            if (!DISK::is_file(resolved_path.c_str()) || (found_mdl != resolved_path.length() - 4))
-            {
-                entry = dir.read();
-                continue;
-            }
+            // todo: add error message
+            continue;
+        }
 
-            if (std::find(invalid_dirs.begin(), invalid_dirs.end(), 
-                resolved_path.substr(0, resolved_path.length() - 4)) != invalid_dirs.end())
-            {
-                // todo: add error message
-                entry = dir.read();
-                continue;
-            }
+        mi::base::Handle< Mdl_package_info_impl>
+            child_package(new Mdl_package_info_impl(entry.c_str(),
+                search_path,
+                resolved_path.c_str(),
+                mi::Uint32(s_idx),
+                (package_path + entry).c_str()));
 
-            // Handle module from file
-            if (found_mdl != std::string::npos)
-            {
-                entry = entry.substr(0, entry.size() - 4);
+        mi::Sint32 idx = parent->check_package(child_package.get());
+        if (idx >= 0)
+        {
+            // Package exists already -> merge nodes 
+            const Mdl_package_info_impl* mg(parent->get_package(idx));
+            mg = parent->merge_packages(mg, child_package.get());
 
-                // Check if file name is valid for MDL
-                if (!check_ident_validity(entry.c_str()))
-                {
-                    entry = dir.read();
-                    continue; //ToDo: Add error message 
-                }
-                mi::base::Handle< Mdl_module_info_impl>
-                    module(new Mdl_module_info_impl(entry.c_str(),
-                        (package_path + entry).c_str(),
-                        resolved_path.c_str(),
-                        search_path,
-                        s_idx));
+            mi::base::Handle< Mdl_package_info_impl>
+                merge_package(new Mdl_package_info_impl(*mg));
 
-                mi::Sint32 res = parent->shadow_module(module.get());
-                if (res < 0)
-                    parent->add_module(module.get());
-            }
+            // Continue recursion with merged node
+            discover_recursive(merge_package,
+                search_path, s_idx, resolved_path.c_str(), invalid_dirs, scans);
+            parent->reset_package(merge_package.get(), idx);
+        }
+        else
+        {
+            // No merge has happened -> continue with new node
+            discover_recursive(child_package,
+                search_path, s_idx, resolved_path.c_str(), invalid_dirs, scans);
+            parent->add_package(child_package.get());
         }
-        entry = dir.read();
     }
-    dir.close();
+
+    // Handle modules from files
+    for (const std::string& entry : scan.m_modules)
+    {
+        std::string module_path = HAL::Ospath::join(current_path, entry);
+        if (std::find(invalid_dirs.begin(), invalid_dirs.end(), 
+            module_path) != invalid_dirs.end())
+        {
+            // todo: add error message
+            continue;
+        }
+
+        // Check if file name is valid for MDL
+        if (!check_ident_validity(entry.c_str()))
+            continue; //ToDo: Add error message 
+
+        std::string resolved_path = module_path + ".mdl";
+        mi::base::Handle< Mdl_module_info_impl>
+            module(new Mdl_module_info_impl(entry.c_str(),
+                (package_path + entry).c_str(),
+                resolved_path.c_str(),
+                search_path,
+                s_idx));
+
+        mi::Sint32 res = parent->shadow_module(module.get());
+        if (res < 0)
+            parent->add_module(module.get());
+    }
 
     return true;
 }
@@ -593,6 +717,9 @@ const mi::neuraylib::IMdl_discovery_result* Mdl_discovery_api_impl::discover() c
     mi::base::Handle<Mdl_package_info_impl> root_package(
         new Mdl_package_info_impl("", "", "", -1, ""));
 
+    // Normalize the search paths, entries which cannot be accessed are left empty
+    std::vector<std::string> paths(search_paths.size());
+    std::vector<std::string> roots;
     for (mi::Size i = 0; i < search_paths.size(); ++i)
     {
         std::string path = search_paths[i]; 
@@ -601,25 +728,28 @@ const mi::neuraylib::IMdl_discovery_result* Mdl_discovery_api_impl::discover() c
 
         if (!DISK::is_path_absolute(path))
             path = HAL::Ospath::join(DISK::get_cwd(), path);
-        path = HAL::Ospath::normpath_v2(path);
+        paths[i] = HAL::Ospath::normpath_v2(path);
+        roots.push_back(paths[i]);
+    }
 
-        // Collect all archives
-        DISK::Directory dir;
-        if (!dir.open(path.c_str()))
+    // Scan all search paths up front, the graph is then built from the scans
+    Directory_scans scans;
+    scan_directories(roots, scans);
+
+    for (mi::Size i = 0; i < paths.size(); ++i)
+    {
+        const std::string& path = paths[i];
+        if (path.empty())
             continue;
 
-        std::string entry = dir.read();
+        Directory_scans::const_iterator it = scans.find(path);
+        if (it == scans.end())
+            continue;
+
+        // Collect all archives
         std::map<std::string, bool> archives;
-        while (!entry.empty())
-        {
-            if(DISK::is_file(HAL::Ospath::join(path, entry).c_str()))
-            {
-                std::size_t found_mdr = entry.rfind(".mdr");
-                if (found_mdr != std::string::npos && found_mdr == entry.size() - 4)
-                    archives.insert(std::make_pair(entry.substr(0, found_mdr), true));  
-            }
-            entry = dir.read();
-        }
+        for (const std::string& archive : it->second->m_archives)
+            archives.insert(std::make_pair(archive, true));
 
         // Process archives
         std::vector<std::string> invalid_directies;
@@ -635,7 +765,8 @@ const mi::neuraylib::IMdl_discovery_result* Mdl_discovery_api_impl::discover() c
         }
 
         // Discover file system
-        discover_recursive(root_package, path.c_str(), i, path.c_str(), invalid_directies);
+        discover_recursive(
+            root_package, path.c_str(), i, path.c_str(), invalid_directies, scans);
     }
     // Sort graph nodes alphabetically
     root_package->sort_children();
@@ -773,29 +904,12 @@ bool Mdl_discovery_api_impl::create_archive_graph_recursive(
 }
 
 bool Mdl_discovery_api_impl::create_archive_graph(
-    mi::base::Handle<const mi::neuraylib::IManifest> m,
+    const std::vector<std::string>& module_list,
     mi::base::Handle<Mdl_package_info_impl> parent,
     const char* search_path, 
     mi::Size s_idx,
     const char* res_path) const
 {
-    // Read modules from archive
-    std::vector<std::string> module_list;
-    for (mi::Size i = 0; i < m->get_number_of_fields(); ++i)
-    {
-        const char* manifest_value = m->get_value(i);
-        if (manifest_value)
-        {
-            const char* manifest_key = m->get_key(i);
-            if (strcmp(manifest_key, "module") == 0)
-            {
-               std::string manifest_val(m->get_value(i));
-               if (manifest_val.size() > 0)
-                   module_list.push_back(manifest_val);
-            }
-        }
-    }
-
     for (mi::Size x=0; x < module_list.size(); ++x)
     {
         mi::Size p = 0;
@@ -815,16 +929,70 @@ bool Mdl_discovery_api_impl::create_archive_graph(
     return true;
 }
 
-bool Mdl_discovery_api_impl::discover_archive(mi::base::Handle<Mdl_package_info_impl> parent,
-    const char* search_path, mi::Size s_idx, const char* res_path) const
+bool Mdl_discovery_api_impl::get_archive_modules(
+    const char* res_path,
+    std::vector<std::string>& modules) const
 {
+    DISK::Stat stat;
+    if (!DISK::stat(res_path, &stat))
+        return false;
+    const double mtime = stat.m_modification_time.get_seconds();
+
+    {
+        mi::base::Lock::Block block(&m_cache_lock);
+        Archive_scans::const_iterator it = m_archive_cache.find(res_path);
+        if (it != m_archive_cache.end()) {
+            const Mdl_discovery_archive_scan& cached = *it->second;
+            if (cached.m_size == stat.m_size
+                && is_unchanged(cached.m_mtime, cached.m_scan_time, mtime)) {
+                modules = cached.m_modules;
+                return true;
+            }
+        }
+    }
+
+    std::shared_ptr<Mdl_discovery_archive_scan> scan(new Mdl_discovery_archive_scan());
+    scan->m_size = stat.m_size;
+    scan->m_mtime = mtime;
+    scan->m_scan_time = double(std::time(nullptr));
+
     mi::base::Handle<mi::neuraylib::IMdl_archive_api>archive_api(
         m_neuray->get_api_component<mi::neuraylib::IMdl_archive_api>());
     mi::base::Handle<const mi::neuraylib::IManifest>
         manifest(archive_api->get_manifest(res_path));
     if (!manifest)
         return false;
-    create_archive_graph(manifest, parent, search_path, s_idx, res_path);
+
+    // Read modules from archive
+    for (mi::Size i = 0; i < manifest->get_number_of_fields(); ++i)
+    {
+        const char* manifest_value = manifest->get_value(i);
+        if (manifest_value)
+        {
+            const char* manifest_key = manifest->get_key(i);
+            if (strcmp(manifest_key, "module") == 0)
+            {
+               std::string manifest_val(manifest_value);
+               if (manifest_val.size() > 0)
+                   scan->m_modules.push_back(manifest_val);
+            }
+        }
+    }
+
+    modules = scan->m_modules;
+
+    mi::base::Lock::Block block(&m_cache_lock);
+    m_archive_cache[res_path] = scan;
+    return true;
+}
+
+bool Mdl_discovery_api_impl::discover_archive(mi::base::Handle<Mdl_package_info_impl> parent,
+    const char* search_path, mi::Size s_idx, const char* res_path) const
+{
+    std::vector<std::string> module_list;
+    if (!get_archive_modules(res_path, module_list))
+        return false;
+    create_archive_graph(module_list, parent, search_path, s_idx, res_path);
     return true;
 }
 
@@ -837,6 +1005,11 @@ mi::Sint32 Mdl_discovery_api_impl::start()
 
 mi::Sint32 Mdl_discovery_api_impl::shutdown()
 {
+    {
+        mi::base::Lock::Block block(&m_cache_lock);
+        m_directory_cache.clear();
+        m_archive_cache.clear();
+    }
     m_path_module.reset();
     m_mdlc_module.reset();
     return 0;
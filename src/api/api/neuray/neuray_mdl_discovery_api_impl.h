@@ -39,8 +39,10 @@
 #include <mi/neuraylib/istring.h>
 #include <mi/base/handle.h>
 #include <mi/base/interface_implement.h>
+#include <mi/base/lock.h>
 #include <base/system/main/access_module.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -233,7 +235,39 @@ class Mdl_package_info_impl
 };
 
 
+/// The result of scanning a single directory of a search path, cached between discoveries.
+struct Mdl_discovery_directory_scan
+{
+    /// The modification time of the directory when it was scanned.
+    double m_mtime;
+    /// The time of the scan.
+    double m_scan_time;
+    /// The names of the sub-directories.
+    std::vector<std::string> m_directories;
+    /// The names of the .mdl files, without extension.
+    std::vector<std::string> m_modules;
+    /// The names of the .mdr files, without extension.
+    std::vector<std::string> m_archives;
+};
+
+/// The module list of an MDL archive, cached between discoveries.
+struct Mdl_discovery_archive_scan
+{
+    /// The size of the archive when its manifest was read.
+    mi::Sint64 m_size;
+    /// The modification time of the archive when its manifest was read.
+    double m_mtime;
+    /// The time the manifest was read.
+    double m_scan_time;
+    /// The modules listed in the manifest.
+    std::vector<std::string> m_modules;
+};
+
 /// This class implements features to discover MDL content.
+///
+/// Directory scans and archive manifests are cached and only re-read if the modification time
+/// of the directory (or the size and modification time of the archive) changed, so repeated
+/// discoveries only pay for the changed parts of the search paths.
 class Mdl_discovery_api_impl
     : public mi::base::Interface_implement< mi::neuraylib::IMdl_discovery_api>,
     public boost::noncopyable
@@ -261,10 +295,30 @@ class Mdl_discovery_api_impl
 
     private:
 
+        typedef std::unordered_map<
+            std::string, std::shared_ptr<const Mdl_discovery_directory_scan> > Directory_scans;
+        typedef std::unordered_map<
+            std::string, std::shared_ptr<const Mdl_discovery_archive_scan> > Archive_scans;
+
         /// Checks if a graph item name is a valid MDL identifier.
         bool check_ident_validity(const char* identifier) const;
 
-        bool create_archive_graph(mi::base::Handle<const mi::neuraylib::IManifest> m,
+        /// Scans the directory trees below the given roots in parallel, reusing the cached scans
+        /// of unchanged directories, and updates the cache.
+        ///
+        /// \param roots   The directories to scan recursively.
+        /// \param scans   Receives the scans of all directories found below the roots.
+        void scan_directories(
+            const std::vector<std::string>& roots,
+            Directory_scans& scans) const;
+
+        /// Returns the modules listed in the manifest of an archive, or \c false if the manifest
+        /// cannot be read. Uses the cached list if the archive did not change.
+        bool get_archive_modules(
+            const char* res_path,
+            std::vector<std::string>& modules) const;
+
+        bool create_archive_graph(const std::vector<std::string>& module_list,
             mi::base::Handle<Mdl_package_info_impl> parent,
             const char* search_path,
             mi::Size s_idx,
@@ -287,11 +341,19 @@ class Mdl_discovery_api_impl
             const char* search_path,
             mi::Size search_idx,
             const char* dir,
-            const std::vector<std::string>& invalid_dirs) const;
+            const std::vector<std::string>& invalid_dirs,
+            const Directory_scans& scans) const;
 
         mi::neuraylib::INeuray*                          m_neuray;
         MI::SYSTEM::Access_module<MI::MDLC::Mdlc_module> m_mdlc_module;
         MI::SYSTEM::Access_module<MI::PATH::Path_module> m_path_module;
+
+        /// The lock for the caches below.
+        mutable mi::base::Lock m_cache_lock;
+        /// The directory scans of the last discovery, keyed by directory.
+        mutable Directory_scans m_directory_cache;
+        /// The archive module lists, keyed by archive path.
+        mutable Archive_scans m_archive_cache;
 };
 
 /// This class implements the discover result.  
@@ -133,6 +133,30 @@ const char* Mdl_i18n_configuration_impl::get_system_keyword() const
     return system_keyword.c_str();
 }
 
+mi::Sint32 Mdl_i18n_configuration_impl::set_cache_directory( const char* directory)
+{
+    using namespace mi::neuraylib;
+    const INeuray::Status status = m_neuray_impl->get_status();
+    const bool valid_call = (status == INeuray::PRE_STARTING || status == INeuray::SHUTDOWN);
+
+    if (!valid_call)
+    {
+        /// This function can only be called before neuray has been started.
+        /// Or after neuray has been shutdown.
+        return -1;
+    }
+    ASSERT(M_I18N, m_i18n_module.is_module_initialized());
+    m_i18n_module->set_cache_directory(directory ? string(directory) : string());
+    return 0;
+}
+
+const char* Mdl_i18n_configuration_impl::get_cache_directory() const
+{
+    ASSERT(M_I18N, m_i18n_module.is_module_initialized());
+    const string & directory = m_i18n_module->get_cache_directory();
+    return directory.empty() ? NULL : directory.c_str();
+}
+
 mi::Sint32 Mdl_i18n_configuration_impl::start()
 {
     // Setup the module.
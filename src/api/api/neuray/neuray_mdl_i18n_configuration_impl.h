@@ -74,6 +74,10 @@ public:
 
     const char* get_system_keyword() const;
 
+    mi::Sint32 set_cache_directory(const char* directory);
+
+    const char* get_cache_directory() const;
+
     // internal methods
 
     /// Starts this API component.
@@ -47,6 +47,8 @@
 #include <mi/neuraylib/istring.h>
 #include <mi/neuraylib/iuser_class.h>
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include <base/data/db/i_db_access.h>
@@ -455,27 +457,59 @@ std::string map_old_mdl_api_class_names( const char* s)
     return s;
 }
 
+/// Checks whether \p pattern is of the form "^literal", i.e., matches exactly the names starting
+/// with "literal". If so, the literal is returned in \p prefix.
+bool get_literal_prefix( const char* pattern, std::string& prefix)
+{
+    if( pattern[0] != '^')
+        return false;
+    const char* literal = pattern + 1;
+    if( strpbrk( literal, ".[]()*+?{}|^$\\") != 0)
+        return false;
+    prefix = literal;
+    return true;
+}
+
+/// Checks whether \p name passes the name filter of list_elements().
+bool matches_name_filter(
+    const char* name, const std::regex* name_regex, const std::string* name_prefix)
+{
+    if( name_prefix && strncmp( name, name_prefix->c_str(), name_prefix->size()) != 0)
+        return false;
+    if( name_regex && !std::regex_search( name, *name_regex))
+        return false;
+    return true;
+}
+
 }
 
 mi::IArray* Transaction_impl::list_elements(
     const char* root_element, const char* name_pattern, const mi::IArray* type_names) const
 {
-    if( !root_element || !is_open())
-        return 0;
-    DB::Tag root_tag = m_db_transaction->name_to_tag( root_element);
-    if( !root_tag)
+    if( !is_open())
         return 0;
+    DB::Tag root_tag;
+    if( root_element) {
+        root_tag = m_db_transaction->name_to_tag( root_element);
+        if( !root_tag)
+            return 0;
+    }
+
+    // literal prefix patterns are handled without regular expression
+    std::string name_prefix;
+    bool has_name_prefix = name_pattern && get_literal_prefix( name_pattern, name_prefix);
 
     std::regex name_regex;
     try {
-        if( name_pattern)
+        if( name_pattern && !has_name_prefix)
             name_regex.assign( name_pattern, std::regex::extended);
     } catch( const std::regex_error& ) {
         return 0;
     }
 
     LOG::mod_log->vdebug( M_NEURAY_API, LOG::Mod_log::C_MISC, "ITransaction::list_elements()");
-    LOG::mod_log->vdebug( M_NEURAY_API, LOG::Mod_log::C_MISC, "  root_element:  %s", root_element);
+    LOG::mod_log->vdebug( M_NEURAY_API, LOG::Mod_log::C_MISC, "  root_element:  %s",
+        root_element ? root_element : "(none)");
     LOG::mod_log->vdebug( M_NEURAY_API, LOG::Mod_log::C_MISC, "  name_pattern:  %s", name_pattern);
 
     // convert type_names to set of SERIAL::Class_id
@@ -510,11 +544,22 @@ mi::IArray* Transaction_impl::list_elements(
     mi::IDynamic_array* result
         = m_class_factory->create_type_instance<mi::IDynamic_array>( 0, "String[]", 0, 0);
 
+    const std::regex* name_regex_ptr = name_pattern && !has_name_prefix ? &name_regex : 0;
+    const std::string* name_prefix_ptr = has_name_prefix ? &name_prefix : 0;
+
+    // without root element there is no graph to traverse, use the DB indexes instead
+    if( !root_tag) {
+        list_elements_indexed(
+            name_regex_ptr, name_prefix_ptr, type_names ? &class_ids : 0, result);
+        return result;
+    }
+
     // start DFS post-order graph traversal at root_tag
     std::set<DB::Tag> tags_seen;
     tags_seen.insert( root_tag); // not really needed if the graph is acyclic
     list_elements_internal(
-        root_tag, name_pattern ? &name_regex : 0, type_names ? &class_ids : 0, result, tags_seen);
+        root_tag, name_regex_ptr, name_prefix_ptr, type_names ? &class_ids : 0, result,
+        tags_seen);
 
     return result;
 }
@@ -637,7 +682,6 @@ void Transaction_impl::add_element( const Db_element_impl_base* db_element)
     //
     // Reference counting as usual is not possible since that would increase the reference count,
     // and the object would never go out of scope.
-    mi::base::Lock::Block block( &m_elements_lock);
     m_elements.insert( db_element);
 }
 
@@ -649,7 +693,6 @@ void Transaction_impl::remove_element( const Db_element_impl_base* db_element)
     //
     // Reference counting as usual is not possible since that would increase the reference count,
     // and the object would never go out of scope.
-    mi::base::Lock::Block block( &m_elements_lock);
     m_elements.erase( db_element);
 }
 
@@ -670,9 +713,10 @@ Expression_factory* Transaction_impl::get_expression_factory()
 
 void Transaction_impl::check_no_referenced_elements( const char* committed_or_aborted)
 {
-    mi::base::Lock::Block block( &m_elements_lock);
-    for( Elements::const_iterator it = m_elements.begin(); it != m_elements.end(); ++it) {
-        DB::Tag tag = (*it)->get_tag();
+    std::vector<DB::Tag> tags;
+    m_elements.get_tags( tags);
+    for( std::vector<DB::Tag>::const_iterator it = tags.begin(); it != tags.end(); ++it) {
+        DB::Tag tag = *it;
         const char* name = m_db_transaction->tag_to_name( tag);
         std::ostringstream s;
         if( name)
@@ -688,6 +732,7 @@ void Transaction_impl::check_no_referenced_elements( const char* committed_or_ab
 void Transaction_impl::list_elements_internal(
     DB::Tag tag,
     const std::regex* name_regex,
+    const std::string* name_prefix,
     const std::set<SERIAL::Class_id>* class_ids,
     mi::IDynamic_array* result,
     std::set<DB::Tag>& tags_seen) const
@@ -702,7 +747,7 @@ void Transaction_impl::list_elements_internal(
     for( DB::Tag_set::const_iterator it = references.begin(); it != references.end(); ++it)
         if( tags_seen.find( *it) == tags_seen.end()) {
             tags_seen.insert( *it);
-            list_elements_internal( *it, name_regex, class_ids, result, tags_seen);
+            list_elements_internal( *it, name_regex, name_prefix, class_ids, result, tags_seen);
         }
 
     // skip tag if it has the wrong class ID
@@ -717,8 +762,8 @@ void Transaction_impl::list_elements_internal(
     if( !name)
         return;
 
-    // skip tag if its name does not match the regular expression
-    if( name_regex && !std::regex_search( name, *name_regex))
+    // skip tag if its name does not match the prefix or the regular expression
+    if( !matches_name_filter( name, name_regex, name_prefix))
         return;
 
     // tag matches criteria, store its name in the result
@@ -728,6 +773,45 @@ void Transaction_impl::list_elements_internal(
     result->push_back( s.get());
 }
 
+void Transaction_impl::list_elements_indexed(
+    const std::regex* name_regex,
+    const std::string* name_prefix,
+    const std::set<SERIAL::Class_id>* class_ids,
+    mi::IDynamic_array* result) const
+{
+    // get candidates from the class ID index if there is a type filter, otherwise from the
+    // name index (which takes care of the prefix already)
+    std::vector<DB::Tag> tags;
+    if( class_ids) {
+        for( std::set<SERIAL::Class_id>::const_iterator it = class_ids->begin();
+             it != class_ids->end(); ++it)
+            m_db_transaction->get_tags_by_class_id( *it, tags);
+    } else
+        m_db_transaction->get_named_tags( name_prefix ? name_prefix->c_str() : 0, tags);
+
+    std::vector<std::string> names;
+    names.reserve( tags.size());
+    for( std::vector<DB::Tag>::const_iterator it = tags.begin(); it != tags.end(); ++it) {
+        const char* name = m_db_transaction->tag_to_name( *it);
+        if( !name || !matches_name_filter( name, name_regex, name_prefix))
+            continue;
+        names.push_back( name);
+    }
+
+    // report the elements ordered by name, the name index is already sorted
+    if( class_ids) {
+        std::sort( names.begin(), names.end());
+        names.erase( std::unique( names.begin(), names.end()), names.end());
+    }
+
+    for( std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        mi::base::Handle<mi::IString> s(
+            m_class_factory->create_type_instance<mi::IString>( 0, "String", 0, 0));
+        s->set_c_str( it->c_str());
+        result->push_back( s.get());
+    }
+}
+
 } // namespace NEURAY
 
 } // namespace MI
@@ -45,6 +45,7 @@
 #include <base/data/serial/i_serial_classid.h>
 
 #include "i_neuray_transaction.h"
+#include "neuray_db_element_tracker.h"
 
 namespace mi { class IDynamic_array; }
 
@@ -246,16 +247,33 @@ private:
     ///
     /// \param tag          The graph traversal starts here.
     /// \param name_regex   Only elements with matching name are reported (unless \c NULL).
+    /// \param name_prefix  Only elements with matching name prefix are reported (unless \c NULL).
     /// \param class_ids    Only elements with matching class ID are reported (unless \c NULL).
     /// \param[out] result  The found elements.
     /// \param tags_seen    Used to skip already handled graph nodes.
     void list_elements_internal(
         DB::Tag tag,
         const std::regex* name_regex,
+        const std::string* name_prefix,
         const std::set<SERIAL::Class_id>* class_ids,
         mi::IDynamic_array* result,
         std::set<DB::Tag>& tags_seen) const;
 
+    /// Implements list_elements() without root element.
+    ///
+    /// Instead of a graph traversal the method queries the class ID and name indexes of the
+    /// database. The elements are reported in the order of their names.
+    ///
+    /// \param name_regex   Only elements with matching name are reported (unless \c NULL).
+    /// \param name_prefix  Only elements with matching name prefix are reported (unless \c NULL).
+    /// \param class_ids    Only elements with matching class ID are reported (unless \c NULL).
+    /// \param[out] result  The found elements.
+    void list_elements_indexed(
+        const std::regex* name_regex,
+        const std::string* name_prefix,
+        const std::set<SERIAL::Class_id>* class_ids,
+        mi::IDynamic_array* result) const;
+
     /// The DB transaction used by this instance.
     DB::Transaction* m_db_transaction;
 
@@ -279,17 +297,12 @@ private:
     /// ID of the transaction (as string).
     mutable std::string m_id_as_string;
 
-    /// Lock for #m_elements.
-    mi::base::Lock m_elements_lock;
-
-    typedef std::set<const Db_element_impl_base*> Elements;
-
     /// Contains the DB elements currently in use by the API for this transaction.
     ///
-    /// Needs #m_elements_lock. Transactions are not multi-threading-safe anyway, but even the
-    /// release of a DB element manipulates the map, which is not necessarily perceived as "using
-    /// the transaction". So we are a bit more carefule here for this container.
-    Elements m_elements;
+    /// Transactions are not multi-threading-safe anyway, but even the release of a DB element
+    /// manipulates the set, which is not necessarily perceived as "using the transaction". So we
+    /// are a bit more careful here for this container, which handles concurrent updates itself.
+    Db_element_registry m_elements;
 };
 
 } // namespace NEURAY
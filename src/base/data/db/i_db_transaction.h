@@ -351,6 +351,24 @@ class Transaction : private STLEXT::Non_copyable
     virtual SERIAL::Class_id get_class_id(
 	Tag tag) = 0;
 
+    /// Get the tags of all named elements whose name starts with a given prefix. This is an
+    /// index lookup and does not access the elements themselves.
+    ///
+    /// \param prefix			The name prefix. NULL or the empty string match all names.
+    /// \param result			The matching tags are appended, ordered by name.
+    virtual void get_named_tags(
+	const char* prefix,
+	std::vector<Tag>& result) = 0;
+
+    /// Get the tags of all elements with a given class id. This is an index lookup and does not
+    /// access the elements themselves. Jobs are not included.
+    ///
+    /// \param class_id			The class id to lookup.
+    /// \param result			The matching tags are appended, ordered by tag.
+    virtual void get_tags_by_class_id(
+	SERIAL::Class_id class_id,
+	std::vector<Tag>& result) = 0;
+
     /// Get the unique id of a certain tag version. The result of a database lookup on a certain tag
     /// depends on the asking transaction and may return different versions for different
     /// transactions. For caching data derived from the tag, such a unique id uniquely identifies
@@ -129,6 +129,16 @@ class Transaction_wrapper : public Transaction
 
     SERIAL::Class_id get_class_id(Tag tag) { return m_transaction->get_class_id(tag); }
 
+    void get_named_tags(const char* prefix, std::vector<Tag>& result)
+    {
+        m_transaction->get_named_tags(prefix, result);
+    }
+
+    void get_tags_by_class_id(SERIAL::Class_id class_id, std::vector<Tag>& result)
+    {
+        m_transaction->get_tags_by_class_id(class_id, result);
+    }
+
     Tag_version get_tag_version(Tag tag) { return m_transaction->get_tag_version(tag); }
 
     Uint32 get_update_sequence_number() { return m_transaction->get_update_sequence_number(); }
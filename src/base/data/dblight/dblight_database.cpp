@@ -221,6 +221,22 @@ Uint32 Database_impl::get_tag_reference_count(DB::Tag tag)
     return m_reference_counts[tag];
 }
 
+void Database_impl::add_to_class_id_index(DB::Tag tag, SERIAL::Class_id class_id)
+{
+    m_class_ids[class_id].insert(tag);
+}
+
+void Database_impl::remove_from_class_id_index(DB::Tag tag, SERIAL::Class_id class_id)
+{
+    Class_id_index::iterator it = m_class_ids.find(class_id);
+    if (it == m_class_ids.end())
+        return;
+
+    it->second.erase(tag);
+    if (it->second.empty())
+        m_class_ids.erase(it);
+}
+
 void Database_impl::garbage_collection_internal()
 {
     mi::base::Lock::Block block(&m_lock);
@@ -238,12 +254,18 @@ void Database_impl::garbage_collection_internal()
             DB::Tag tag = *it;
 
             Tag_map::iterator it_info = m_tags.find(tag);
+            remove_from_class_id_index(tag, it_info->second->get_element()->get_class_id());
             it_info->second->unpin();
             m_tags.erase(it_info);
 
             Reverse_named_tag_map::iterator it_name = m_reverse_named_tags.find(tag);
-            m_named_tags.erase(it_name->second);
-            m_reverse_named_tags.erase(it_name);
+            if (it_name != m_reverse_named_tags.end()) {
+                // the name might have been reused for another tag in the meantime
+                Named_tag_map::iterator it_tag = m_named_tags.find(it_name->second);
+                if (it_tag != m_named_tags.end() && it_tag->second == tag)
+                    m_named_tags.erase(it_tag);
+                m_reverse_named_tags.erase(it_name);
+            }
 
             m_tags_flagged_for_removal.erase(tag); m_reference_counts.erase(tag);
             m_reference_count_zero.erase(tag);
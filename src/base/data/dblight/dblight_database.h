@@ -54,7 +54,8 @@ class Scope_impl;
 /// Map of tags to infos
 typedef std::map<DB::Tag, DB::Info*> Tag_map;
 
-/// Map of names (strings) to tags
+/// Map of names (strings) to tags. Since the map is ordered, all names with a common prefix form
+/// a contiguous range, i.e., this map also serves as prefix index.
 typedef std::map<std::string, DB::Tag> Named_tag_map;
 
 /// Map of tags to names (strings)
@@ -69,6 +70,9 @@ typedef std::map<DB::Tag, Uint32> Reference_count_map;
 /// Set of tags with reference count zero
 typedef std::set<DB::Tag> Reference_count_zero_set;
 
+/// Map of class IDs to the tags of all elements with that class ID
+typedef std::map<SERIAL::Class_id, DB::Tag_set> Class_id_index;
+
 /// The database class manages the whole database.
 class Database_impl : public DB::Database
 {
@@ -144,6 +148,12 @@ public:
     /// Returns the reference count of the tag.
     Uint32 get_tag_reference_count(DB::Tag tag);
 
+    /// Used by the transaction to add a tag to the class ID index. Needs #m_lock.
+    void add_to_class_id_index(DB::Tag tag, SERIAL::Class_id class_id);
+
+    /// Used by the transaction to remove a tag from the class ID index. Needs #m_lock.
+    void remove_from_class_id_index(DB::Tag tag, SERIAL::Class_id class_id);
+
     /// Used by the transaction during commit(). The caller must ensure that there is no open
     /// transaction.
     void garbage_collection_internal();
@@ -156,6 +166,8 @@ public:
     Reverse_named_tag_map& get_reverse_named_tag_map() { return m_reverse_named_tags; }
     /// Used by the transaction to track removal requests. Needs #m_lock.
     Flagged_for_removal_set& get_flagged_for_removal_set() { return m_tags_flagged_for_removal; }
+    /// Used by the transaction to access the class ID index. Needs #m_lock.
+    Class_id_index& get_class_id_index() { return m_class_ids; }
 
 
 private:
@@ -165,7 +177,7 @@ private:
     mi::base::Atom32 m_next_transaction_id;
 
 public:
-    /// The lock for the six containers below.
+    /// The lock for the seven containers below.
     mi::base::Lock m_lock;
 
 private:
@@ -181,6 +193,8 @@ private:
     Reference_count_map m_reference_counts;
     /// Holds the tags with reference count zero. Needs #m_lock.
     Reference_count_zero_set m_reference_count_zero;
+    /// Holds the tags of all elements per class ID. Needs #m_lock.
+    Class_id_index m_class_ids;
 
     /// The global scope is currently the only scope
     Scope_impl* m_global_scope;
@@ -118,6 +118,7 @@ DB::Tag Transaction_impl::store(
     info->store_references();
     m_database->get_tag_map()[tag] = info;
     m_database->increment_reference_count(tag);
+    m_database->add_to_class_id_index(tag, element->get_class_id());
 
     if (name) {
         m_database->get_named_tag_map()[name] = tag;
@@ -149,6 +150,8 @@ void Transaction_impl::store(
 
     Tag_map::iterator it = m_database->get_tag_map().find(tag);
     if (it != m_database->get_tag_map().end()) {
+         m_database->remove_from_class_id_index(
+             tag, it->second->get_element()->get_class_id());
          it->second->unpin();
          it->second = info;
          // leave self-reference as is
@@ -156,6 +159,7 @@ void Transaction_impl::store(
         m_database->get_tag_map()[tag] = info;
         m_database->increment_reference_count(tag);
     }
+    m_database->add_to_class_id_index(tag, element->get_class_id());
 
     if (name) {
          m_database->get_named_tag_map()[name] = tag;
@@ -282,6 +286,37 @@ DB::Tag Transaction_impl::name_to_tag(const char* name)
     return it->second;
 }
 
+void Transaction_impl::get_named_tags(const char* prefix, std::vector<DB::Tag>& result)
+{
+    if (!m_is_open)
+        return;
+
+    const std::string prefix_str = prefix ? prefix : "";
+
+    mi::base::Lock::Block block(&m_database->m_lock);
+    const Named_tag_map& named_tags = m_database->get_named_tag_map();
+    Named_tag_map::const_iterator it = named_tags.lower_bound(prefix_str);
+    for ( ; it != named_tags.end(); ++it) {
+        if (it->first.compare(0, prefix_str.size(), prefix_str) != 0)
+            break;
+        result.push_back(it->second);
+    }
+}
+
+void Transaction_impl::get_tags_by_class_id(
+    SERIAL::Class_id class_id, std::vector<DB::Tag>& result)
+{
+    if (!m_is_open)
+        return;
+
+    mi::base::Lock::Block block(&m_database->m_lock);
+    const Class_id_index& class_ids = m_database->get_class_id_index();
+    Class_id_index::const_iterator it = class_ids.find(class_id);
+    if (it == class_ids.end())
+        return;
+    result.insert(result.end(), it->second.begin(), it->second.end());
+}
+
 SERIAL::Class_id Transaction_impl::get_class_id(DB::Tag tag)
 {
     if (!m_is_open)
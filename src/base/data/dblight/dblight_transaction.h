@@ -139,6 +139,10 @@ public:
 
     SERIAL::Class_id get_class_id(DB::Tag tag);
 
+    void get_named_tags(const char* prefix, std::vector<DB::Tag>& result);
+
+    void get_tags_by_class_id(SERIAL::Class_id class_id, std::vector<DB::Tag>& result);
+
     DB::Tag_version get_tag_version(DB::Tag tag);
 
     Uint32 get_update_sequence_number();
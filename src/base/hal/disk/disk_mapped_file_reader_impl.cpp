@@ -0,0 +1,246 @@
+/***************************************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Source for an implementation of mi::neuraylib::IReader backed by a memory-mapped file.
+
+#include "pch.h"
+
+#include "disk_mapped_file_reader_impl.h"
+#include "disk.h"
+
+#include <cstdio>
+
+#ifdef WIN_NT
+#include <mi/base/miwindows.h>
+#include <base/util/string_utils/i_string_utils.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MI {
+
+namespace DISK {
+
+Mapped_file_buffer_impl::Mapped_file_buffer_impl()
+  : m_data( 0)
+  , m_size( 0)
+  , m_is_mapped( false)
+#ifdef WIN_NT
+  , m_mapping_handle( 0)
+#endif
+{
+}
+
+Mapped_file_buffer_impl::~Mapped_file_buffer_impl()
+{
+    unmap();
+}
+
+bool Mapped_file_buffer_impl::map( const char* path)
+{
+    unmap();
+
+    if( !path)
+        return false;
+
+#ifdef WIN_NT
+    std::wstring wpath( STRING::utf8_to_wchar( path));
+    HANDLE file = CreateFileW( wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if( file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if( GetFileType( file) != FILE_TYPE_DISK || !GetFileSizeEx( file, &size)
+        || size.QuadPart < static_cast<LONGLONG>( mapping_threshold)) {
+        CloseHandle( file);
+        return read( path);
+    }
+
+    // mapped files cannot be truncated on Windows, no need to check the size again
+    HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mapping ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    CloseHandle( file);
+    if( !data) {
+        if( mapping)
+            CloseHandle( mapping);
+        return read( path);
+    }
+    m_mapping_handle = mapping;
+    m_data = static_cast<const mi::Uint8*>( data);
+    m_size = static_cast<mi::Size>( size.QuadPart);
+    m_is_mapped = true;
+#else
+    int fd = ::open( path, O_RDONLY);
+    if( fd < 0)
+        return false;
+
+    struct stat st;
+    if( fstat( fd, &st) != 0 || !S_ISREG( st.st_mode)
+        || st.st_size < static_cast<off_t>( mapping_threshold)) {
+        ::close( fd);
+        return read( path);
+    }
+
+    size_t size = static_cast<size_t>( st.st_size);
+    void* data = mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if( data == MAP_FAILED) {
+        ::close( fd);
+        return read( path);
+    }
+
+    // accessing pages beyond the end of a file truncated in the meantime raises SIGBUS, do not
+    // hand out the mapping if the file is not at least as large as the mapping
+    struct stat st_mapped;
+    if( fstat( fd, &st_mapped) != 0 || st_mapped.st_size < st.st_size) {
+        munmap( data, size);
+        ::close( fd);
+        return read( path);
+    }
+
+    // the data is typically parsed front to back exactly once
+    madvise( data, size, MADV_SEQUENTIAL);
+    m_data = static_cast<const mi::Uint8*>( data);
+    m_size = static_cast<mi::Size>( size);
+    m_is_mapped = true;
+    // the mapping stays valid after closing the file descriptor
+    ::close( fd);
+#endif
+
+    m_path = path;
+    return true;
+}
+
+bool Mapped_file_buffer_impl::read( const char* path)
+{
+    FILE* file = DISK::fopen( path, "rb");
+    if( !file)
+        return false;
+
+    // the size of non-regular files is not known in advance
+    const size_t block_size = 64*1024;
+    size_t size = 0;
+    for( ;;) {
+        m_copy.resize( size + block_size);
+        size_t count = fread( &m_copy[size], 1, block_size, file);
+        size += count;
+        if( count < block_size)
+            break;
+    }
+    bool success = ferror( file) == 0;
+    fclose( file);
+
+    if( !success) {
+        std::vector<mi::Uint8>().swap( m_copy);
+        return false;
+    }
+
+    m_copy.resize( size);
+    m_data = size > 0 ? &m_copy[0] : 0;
+    m_size = size;
+    m_path = path;
+    return true;
+}
+
+void Mapped_file_buffer_impl::unmap()
+{
+    if( m_is_mapped) {
+#ifdef WIN_NT
+        UnmapViewOfFile( m_data);
+        CloseHandle( m_mapping_handle);
+        m_mapping_handle = 0;
+#else
+        munmap( const_cast<mi::Uint8*>( m_data), m_size);
+#endif
+    }
+    std::vector<mi::Uint8>().swap( m_copy);
+    m_data = 0;
+    m_size = 0;
+    m_is_mapped = false;
+    m_path.clear();
+}
+
+Mapped_file_reader_impl::Mapped_file_reader_impl()
+  : Memory_reader_impl( mi::base::make_handle( new Mapped_file_buffer_impl()).get())
+{
+    // the base class only knows the const IBuffer interface of the mapping
+    m_mapping = mi::base::make_handle_dup( static_cast<Mapped_file_buffer_impl*>(
+        const_cast<mi::neuraylib::IBuffer*>( m_buffer.get())));
+}
+
+bool Mapped_file_reader_impl::open( const char* path)
+{
+    m_position = 0;
+    return m_mapping->map( path);
+}
+
+const char* Mapped_file_reader_impl::get_path()
+{
+    return m_mapping->get_path();
+}
+
+bool Mapped_file_reader_impl::close()
+{
+    m_position = 0;
+    m_mapping->unmap();
+    return true;
+}
+
+Mapped_file_buffer_impl* Mapped_file_reader_impl::get_mapped_buffer() const
+{
+    m_mapping->retain();
+    return m_mapping.get();
+}
+
+bool Mapped_file_reader_impl::supports_lookahead() const
+{
+    return true;
+}
+
+mi::Sint64 Mapped_file_reader_impl::lookahead( mi::Sint64 size, const char** buffer) const
+{
+    if( !buffer || size < 0)
+        return -1;
+
+    mi::Size data_size = m_mapping->get_data_size();
+    if( m_position >= data_size) {
+        *buffer = 0;
+        return 0;
+    }
+
+    *buffer = reinterpret_cast<const char*>( m_mapping->get_data() + m_position);
+    return static_cast<mi::Sint64>( data_size - m_position);
+}
+
+} // namespace DISK
+
+} // namespace MI
@@ -0,0 +1,180 @@
+/***************************************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************************************/
+
+/// \file
+/// \brief Header for an implementation of mi::neuraylib::IReader backed by a memory-mapped file.
+
+#ifndef BASE_HAL_DISK_DISK_MAPPED_FILE_READER_IMPL_H
+#define BASE_HAL_DISK_DISK_MAPPED_FILE_READER_IMPL_H
+
+#include "disk_memory_reader_writer_impl.h"
+
+#include <string>
+#include <vector>
+#include <mi/base/interface_implement.h>
+#include <mi/neuraylib/ibuffer.h>
+
+#include <boost/core/noncopyable.hpp>
+
+namespace MI {
+
+namespace DISK {
+
+/// An implementation of mi::neuraylib::IBuffer that maps a file read-only into memory.
+///
+/// Only regular files of at least #mapping_threshold bytes are mapped. Smaller files, files that
+/// are not regular (pipes, devices), and files whose size changed while being mapped are read
+/// into memory instead.
+///
+/// \note On Unix, truncating a mapped file from another process raises SIGBUS on access to the
+///       lost pages. The size check after mapping only narrows that window. On Windows, mapped
+///       files cannot be truncated.
+///
+/// The data is immutable. Hence, the buffer can be shared between threads, e.g., by using one
+/// Memory_reader_impl per thread.
+class Mapped_file_buffer_impl
+  : public mi::base::Interface_implement<mi::neuraylib::IBuffer>, public boost::noncopyable
+{
+public:
+
+    /// Constructor. Creates an empty buffer.
+    Mapped_file_buffer_impl();
+
+    /// Destructor. Unmaps the file.
+    ~Mapped_file_buffer_impl();
+
+    // public API methods
+
+    const mi::Uint8* get_data() const { return m_data; }
+
+    mi::Size get_data_size() const { return m_size; }
+
+    // internal methods
+
+    /// Files smaller than this are read instead of mapped.
+    static const mi::Size mapping_threshold = 64*1024;
+
+    /// Maps or reads the file. Any previous data is released.
+    ///
+    /// \param path  The file to map.
+    /// \return      \c true on success, \c false on failure. Empty files are mapped successfully
+    ///              and result in an empty buffer.
+    bool map( const char* path);
+
+    /// Releases the mapping or the data read.
+    void unmap();
+
+    /// Returns the path of the mapped file.
+    const char* get_path() const { return m_path.c_str(); }
+
+    /// Indicates whether the file is mapped, or was read into memory.
+    bool is_mapped() const { return m_is_mapped; }
+
+private:
+
+    /// Reads the file into #m_copy.
+    ///
+    /// \param path  The file to read.
+    /// \return      \c true on success, \c false on failure
+    bool read( const char* path);
+
+    /// The start of the data, or \c NULL.
+    const mi::Uint8* m_data;
+
+    /// The size of the data.
+    mi::Size m_size;
+
+    /// Indicates whether #m_data is a mapping, otherwise it points into #m_copy.
+    bool m_is_mapped;
+
+    /// The file contents if the file is not mapped.
+    std::vector<mi::Uint8> m_copy;
+
+    /// The path of the mapped file.
+    std::string m_path;
+
+#ifdef WIN_NT
+    /// The file mapping object.
+    void* m_mapping_handle;
+#endif
+};
+
+/// This implementation of mi::neuraylib::IReader reads from a memory-mapped file.
+///
+/// In contrast to File_reader_impl, it does not buffer the data and supports lookahead of any
+/// size: lookahead() returns a view into the mapping that stays valid as long as the reader
+/// exists. Consumers that support lookahead can parse the data in place without copying it.
+///
+/// In contrast to Memory_reader_impl, lookahead is supported since the reader owns the data
+/// and the data is immutable. Only open() and close() invalidate the returned view.
+class Mapped_file_reader_impl : public Memory_reader_impl
+{
+public:
+
+    /// Constructor.
+    Mapped_file_reader_impl();
+
+    // internal methods
+
+    /// Opens and maps the file.
+    ///
+    /// \param path  The file to open.
+    /// \return      \c true on success, \c false on failure
+    bool open( const char* path);
+
+    /// Returns the path of the file.
+    const char* get_path();
+
+    /// Closes the file.
+    /// \return      \c true on success, \c false on failure
+    bool close();
+
+    /// Returns the underlying buffer, e.g., for sharing the mapping between threads.
+    Mapped_file_buffer_impl* get_mapped_buffer() const;
+
+    // public API methods
+
+    /// Returns \c true in this implementation.
+    bool supports_lookahead() const;
+
+    /// Returns a view into the data starting at the current position, without copying. The
+    /// view is valid until the reader is closed, reopened, or destroyed, and can be larger than
+    /// \p size.
+    mi::Sint64 lookahead( mi::Sint64 size, const char** buffer) const;
+
+private:
+
+    /// The mapping (same as the buffer of the base class).
+    mi::base::Handle<Mapped_file_buffer_impl> m_mapping;
+};
+
+} // namespace DISK
+
+} // namespace MI
+
+#endif // BASE_HAL_DISK_DISK_MAPPED_FILE_READER_IMPL_H
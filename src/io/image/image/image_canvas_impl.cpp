@@ -40,7 +40,7 @@
 #include <base/system/main/access_module.h>
 #include <base/lib/log/i_log_assert.h>
 #include <base/lib/log/i_log_logger.h>
-#include <base/hal/disk/disk_file_reader_writer_impl.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
 #include <base/hal/disk/disk_memory_reader_writer_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 
@@ -117,7 +117,7 @@ Canvas_impl::Canvas_impl(
         image_file2 = make_handle_dup( image_file);
         image_file = 0; // only use image_file2 below
     } else {
-        DISK::File_reader_impl reader;
+        DISK::Mapped_file_reader_impl reader;
         if( !reader.open( m_filename.c_str())) {
             LOG::mod_log->error( M_IMAGE, LOG::Mod_log::C_IO,
                 "Failed to open image file \"%s\".", m_filename.c_str());
@@ -669,7 +669,7 @@ mi::neuraylib::IReader* Canvas_impl::get_reader( std::string& filename_error_msg
 
         filename_error_msg = m_filename;
 
-        mi::base::Handle<DISK::File_reader_impl> reader( new DISK::File_reader_impl);
+        mi::base::Handle<DISK::Mapped_file_reader_impl> reader( new DISK::Mapped_file_reader_impl);
         if( !reader->open( m_filename.c_str())) {
             LOG::mod_log->error( M_IMAGE, LOG::Mod_log::C_IO,
                  "Failed to open image file \"%s\".", filename_error_msg.c_str());
@@ -42,7 +42,7 @@
 #include <base/system/main/access_module.h>
 #include <base/lib/log/i_log_assert.h>
 #include <base/lib/log/i_log_logger.h>
-#include <base/hal/disk/disk_file_reader_writer_impl.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
 #include <base/hal/disk/disk_memory_reader_writer_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 
@@ -99,7 +99,7 @@ Mipmap_impl::Mipmap_impl(
     m_last_created_level = 0;
     m_is_cubemap = false;
 
-    DISK::File_reader_impl reader;
+    DISK::Mapped_file_reader_impl reader;
     if( !reader.open( filename.c_str())) {
         LOG::mod_log->error( M_IMAGE, LOG::Mod_log::C_IO,
             "Failed to open image file \"%s\".", filename.c_str());
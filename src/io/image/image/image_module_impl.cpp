@@ -48,11 +48,13 @@
 #include <base/hal/disk/disk_memory_reader_writer_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/data/serial/i_serializer.h>
+#include <mdl/compiler/compilercore/compilercore_thread_pool.h>
 
 #include "image_canvas_impl.h"
 #include "image_tile_impl.h"
 #include "image_mipmap_impl.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <limits>
 
@@ -74,6 +76,108 @@ public:
 // Register the module.
 static SYSTEM::Module_registration<Image_module_impl> s_module( M_IMAGE, "IMAGE");
 
+namespace {
+
+/// The number of pixels processed as one work item by for_each_pixel_chunk().
+const mi::Size pixel_chunk_size = 64*1024;
+
+/// Invokes \p func( tile_index, first_pixel, pixel_count) for all chunks of \p nr_of_tiles tiles
+/// with \p nr_of_pixels pixels each.
+///
+/// Canvases are often imported as a single tile, therefore the tiles are split into chunks of
+/// #pixel_chunk_size pixels. The chunks are distributed over the shared thread pool, small
+/// canvases are processed on the calling thread. The chunks of a tile are processed in order of
+/// the tile index, hence \p func should fetch the tiles itself, see get_tile_by_index(). This
+/// way tiles are loaded lazily while other tiles are already processed.
+template <class F>
+void for_each_pixel_chunk( mi::Size nr_of_tiles, mi::Size nr_of_pixels, F func)
+{
+    mi::Size chunks_per_tile = (nr_of_pixels + pixel_chunk_size - 1) / pixel_chunk_size;
+    mi::Size nr_of_chunks = nr_of_tiles * chunks_per_tile;
+
+    std::shared_ptr<mi::mdl::Thread_pool> pool( mi::mdl::Thread_pool::get());
+    pool->parallel_for( nr_of_chunks, /*max_threads*/ 0, [&]( size_t chunk) {
+        mi::Size tile  = chunk / chunks_per_tile;
+        mi::Size first = (chunk % chunks_per_tile) * pixel_chunk_size;
+        func( tile, first, std::min( pixel_chunk_size, nr_of_pixels - first));
+    });
+}
+
+/// Returns the tile of \p canvas with the given index.
+///
+/// The tiles are numbered by layer, then by row, then by column. Thread-safe, the canvas
+/// serializes lazy loading of tiles.
+template <class C>
+auto get_tile_by_index( C* canvas, mi::Size index) -> decltype( canvas->get_tile( 0, 0, 0))
+{
+    mi::Uint32 nr_of_tiles_x = canvas->get_tiles_size_x();
+    mi::Uint32 nr_of_tiles_y = canvas->get_tiles_size_y();
+    mi::Uint32 x = mi::Uint32( index % nr_of_tiles_x);
+    mi::Uint32 y = mi::Uint32( (index / nr_of_tiles_x) % nr_of_tiles_y);
+    mi::Uint32 z = mi::Uint32( index / (mi::Size( nr_of_tiles_x) * nr_of_tiles_y));
+    return canvas->get_tile(
+        x * canvas->get_tile_resolution_x(), y * canvas->get_tile_resolution_y(), z);
+}
+
+/// Indicates whether adjust_gamma_8bit() supports the pixel type.
+bool supports_gamma_lut( Pixel_type pixel_type)
+{
+    return pixel_type == PT_RGB || pixel_type == PT_RGBA || pixel_type == PT_SINT32;
+}
+
+/// Performs a gamma correction for 8-bit RGB(A) pixel types via lookup tables.
+///
+/// The tables are computed with the generic code path (conversion to PT_COLOR, gamma correction,
+/// and conversion back) for all 256 values of each component. Hence, the result is identical to
+/// the generic code path, but avoids the conversions and the per-pixel calls to fast_pow().
+class Gamma_lut
+{
+public:
+    Gamma_lut( Pixel_type pixel_type, mi::Float32 exponent)
+      : m_components( get_components_per_pixel( pixel_type))
+    {
+        ASSERT( M_IMAGE, supports_gamma_lut( pixel_type));
+        std::vector<mi::Uint8> values( 256 * m_components);
+        for( mi::Uint32 v = 0; v < 256; ++v)
+            for( int c = 0; c < m_components; ++c)
+                values[v*m_components + c] = mi::Uint8( v);
+
+        std::vector<mi::Float32> buffer( 4*256);
+        convert( &values[0], &buffer[0], pixel_type, PT_COLOR, 256);
+        IMAGE::adjust_gamma( &buffer[0], 256, 4, exponent);
+        convert( &buffer[0], &values[0], PT_COLOR, pixel_type, 256);
+
+        for( mi::Uint32 v = 0; v < 256; ++v)
+            for( int c = 0; c < m_components; ++c)
+                m_table[c][v] = values[v*m_components + c];
+    }
+
+    /// Applies the tables to \p count pixels.
+    void apply( mi::Uint8* data, mi::Size count) const
+    {
+        if( m_components == 3) {
+            for( mi::Size i = 0; i < count; ++i, data += 3) {
+                data[0] = m_table[0][data[0]];
+                data[1] = m_table[1][data[1]];
+                data[2] = m_table[2][data[2]];
+            }
+        } else {
+            for( mi::Size i = 0; i < count; ++i, data += 4) {
+                data[0] = m_table[0][data[0]];
+                data[1] = m_table[1][data[1]];
+                data[2] = m_table[2][data[2]];
+                data[3] = m_table[3][data[3]];
+            }
+        }
+    }
+
+private:
+    int m_components;
+    mi::Uint8 m_table[4][256];
+};
+
+} // namespace
+
 Module_registration_entry* Image_module::get_instance()
 {
     return s_module.init_module( s_module.get_name());
@@ -434,17 +538,20 @@ mi::neuraylib::ICanvas* Image_module_impl::convert_canvas(
     mi::neuraylib::ICanvas* new_canvas = new Canvas_impl( new_pixel_type,
         canvas_width, canvas_height, tile_width, tile_height, nr_of_layers, is_cubemap, gamma);
 
-    for( mi::Uint32 z = 0; z < nr_of_layers; ++z)
-        for( mi::Uint32 y = 0; y < nr_of_tiles_y; ++y)
-            for( mi::Uint32 x = 0; x < nr_of_tiles_x; ++x) {
-                mi::base::Handle<const mi::neuraylib::ITile> old_tile(
-                    old_canvas->get_tile( x*tile_width, y*tile_height, z));
-                mi::base::Handle<mi::neuraylib::ITile> new_tile(
-                    new_canvas->get_tile( x*tile_width, y*tile_height, z));
-                const void* old_data = old_tile->get_data();
-                void* new_data = new_tile->get_data();
-                convert( old_data, new_data, old_pixel_type, new_pixel_type, nr_of_pixels);
-            }
+    mi::Size nr_of_tiles = mi::Size( nr_of_tiles_x) * nr_of_tiles_y * nr_of_layers;
+    mi::Uint32 old_bytes_per_pixel = get_bytes_per_pixel( old_pixel_type);
+    mi::Uint32 new_bytes_per_pixel = get_bytes_per_pixel( new_pixel_type);
+    for_each_pixel_chunk( nr_of_tiles, nr_of_pixels,
+        [&]( mi::Size tile, mi::Size first, mi::Size count) {
+            mi::base::Handle<const mi::neuraylib::ITile> old_tile(
+                get_tile_by_index( old_canvas, tile));
+            mi::base::Handle<mi::neuraylib::ITile> new_tile(
+                get_tile_by_index( new_canvas, tile));
+            const char* old_data = static_cast<const char*>( old_tile->get_data());
+            char* new_data = static_cast<char*>( new_tile->get_data());
+            convert( old_data + first * old_bytes_per_pixel,
+                new_data + first * new_bytes_per_pixel, old_pixel_type, new_pixel_type, count);
+        });
 
     return new_canvas;
 }
@@ -499,33 +606,45 @@ void Image_module_impl::adjust_gamma(
     mi::Uint32 nr_of_tiles_y = canvas->get_tiles_size_y();
     mi::Uint32 nr_of_layers  = canvas->get_layers_size();
     mi::Size   nr_of_pixels  = tile_width * tile_height;
+    mi::Size   nr_of_tiles   = mi::Size( nr_of_tiles_x) * nr_of_tiles_y * nr_of_layers;
+
+    mi::Uint32 bytes_per_pixel = get_bytes_per_pixel( pixel_type);
 
     if( pixel_type == PT_COLOR || pixel_type == PT_RGB_FP) {
 
         mi::Uint32 components = pixel_type == PT_COLOR ? 4 : 3;
-        for( mi::Uint32 z = 0; z < nr_of_layers; ++z)
-            for( mi::Uint32 y = 0; y < nr_of_tiles_y; ++y)
-                for( mi::Uint32 x = 0; x < nr_of_tiles_x; ++x) {
-                    mi::base::Handle<mi::neuraylib::ITile> tile(
-                        canvas->get_tile( x*tile_width, y*tile_height, z));
-                    mi::Float32* data = static_cast<mi::Float32*>( tile->get_data());
-                    IMAGE::adjust_gamma( data, nr_of_pixels, components, exponent);
-                }
+        for_each_pixel_chunk( nr_of_tiles, nr_of_pixels,
+            [&]( mi::Size tile, mi::Size first, mi::Size count) {
+                mi::base::Handle<mi::neuraylib::ITile> current_tile(
+                    get_tile_by_index( canvas, tile));
+                mi::Float32* data = static_cast<mi::Float32*>( current_tile->get_data());
+                IMAGE::adjust_gamma( data + first * components, count, components, exponent);
+            });
+
+    } else if( supports_gamma_lut( pixel_type)) {
+
+        const Gamma_lut lut( pixel_type, exponent);
+        for_each_pixel_chunk( nr_of_tiles, nr_of_pixels,
+            [&]( mi::Size tile, mi::Size first, mi::Size count) {
+                mi::base::Handle<mi::neuraylib::ITile> current_tile(
+                    get_tile_by_index( canvas, tile));
+                mi::Uint8* data = static_cast<mi::Uint8*>( current_tile->get_data());
+                lut.apply( data + first * bytes_per_pixel, count);
+            });
 
     } else {
 
-        mi::Float32* buffer = new mi::Float32[4*nr_of_pixels];
-        for( mi::Uint32 z = 0; z < nr_of_layers; ++z)
-            for( mi::Uint32 y = 0; y < nr_of_tiles_y; ++y)
-                for( mi::Uint32 x = 0; x < nr_of_tiles_x; ++x) {
-                    mi::base::Handle<mi::neuraylib::ITile> tile(
-                        canvas->get_tile( x*tile_width, y*tile_height, z));
-                    void* data = tile->get_data();
-                    convert( data, buffer, pixel_type, PT_COLOR, nr_of_pixels);
-                    IMAGE::adjust_gamma( buffer, nr_of_pixels, 4, exponent);
-                    convert( buffer, data, PT_COLOR, pixel_type, nr_of_pixels);
-                }
-        delete[] buffer;
+        for_each_pixel_chunk( nr_of_tiles, nr_of_pixels,
+            [&]( mi::Size tile, mi::Size first, mi::Size count) {
+                std::vector<mi::Float32> buffer( 4*count);
+                mi::base::Handle<mi::neuraylib::ITile> current_tile(
+                    get_tile_by_index( canvas, tile));
+                char* data
+                    = static_cast<char*>( current_tile->get_data()) + first * bytes_per_pixel;
+                convert( data, &buffer[0], pixel_type, PT_COLOR, count);
+                IMAGE::adjust_gamma( &buffer[0], count, 4, exponent);
+                convert( &buffer[0], data, PT_COLOR, pixel_type, count);
+            });
 
     }
 
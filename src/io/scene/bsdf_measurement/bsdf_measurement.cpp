@@ -30,6 +30,7 @@
 
 #include "i_bsdf_measurement.h"
 
+#include <cmath>
 #include <sstream>
 
 #include <mi/neuraylib/bsdf_isotropic_data.h>
@@ -38,6 +39,7 @@
 #include <base/system/main/access_module.h>
 #include <base/hal/disk/disk.h>
 #include <base/hal/disk/disk_file_reader_writer_impl.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/lib/config/config.h>
 #include <base/lib/log/i_log_logger.h>
@@ -50,6 +52,10 @@
 #include <io/scene/scene/i_scene_journal_types.h>
 #include <io/scene/mdl_elements/mdl_elements_detail.h>
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 namespace MI {
 
 namespace BSDFM {
@@ -59,6 +65,16 @@ static const char* magic_data = "MBSDF_DATA=\n";
 static const char* magic_reflection = "MBSDF_DATA_REFLECTION=\n";
 static const char* magic_transmission = "MBSDF_DATA_TRANSMISSION=\n";
 
+/// Indicates whether the filename has the extension ".mbsdf".
+static bool has_mbsdf_extension( const std::string& filename)
+{
+    std::string root, extension;
+    HAL::Ospath::splitext( filename, root, extension);
+    if( !extension.empty() && extension[0] == '.' )
+        extension = extension.substr( 1);
+    return extension == "mbsdf";
+}
+
 Bsdf_measurement::Bsdf_measurement()
 {
 }
@@ -68,6 +84,8 @@ Bsdf_measurement::Bsdf_measurement( const Bsdf_measurement& other)
 {
     m_reflection = other.m_reflection;
     m_transmission = other.m_transmission;
+    m_reflection_sampling_data = other.m_reflection_sampling_data;
+    m_transmission_sampling_data = other.m_transmission_sampling_data;
     m_original_filename = other.m_original_filename;
     m_resolved_filename = other.m_resolved_filename;
     m_resolved_archive_filename = other.m_resolved_archive_filename;
@@ -109,6 +127,8 @@ mi::Sint32 Bsdf_measurement::reset_file( const std::string& original_filename)
 
     m_reflection = reflection;
     m_transmission = transmission;
+    compute_sampling_data( m_reflection.get(), m_reflection_sampling_data);
+    compute_sampling_data( m_transmission.get(), m_transmission_sampling_data);
 
     m_original_filename = original_filename;
     m_resolved_filename = resolved_filename;
@@ -135,6 +155,8 @@ mi::Sint32 Bsdf_measurement::reset_reader( mi::neuraylib::IReader* reader)
 
     m_reflection = reflection;
     m_transmission = transmission;
+    compute_sampling_data( m_reflection.get(), m_reflection_sampling_data);
+    compute_sampling_data( m_transmission.get(), m_transmission_sampling_data);
 
     m_original_filename.clear();
     m_resolved_filename.clear();
@@ -153,15 +175,30 @@ mi::Sint32 Bsdf_measurement::reset_reader( mi::neuraylib::IReader* reader)
 
 mi::Sint32 Bsdf_measurement::reset_file_mdl(
     const std::string& resolved_filename, const std::string& mdl_file_path)
+{
+    DISK::Mapped_file_reader_impl reader;
+    if( !reader.open( resolved_filename.c_str()))
+        return -3;
+
+    return reset_file_mdl( &reader, resolved_filename, mdl_file_path);
+}
+
+mi::Sint32 Bsdf_measurement::reset_file_mdl(
+    mi::neuraylib::IReader* reader,
+    const std::string& resolved_filename,
+    const std::string& mdl_file_path)
 {
     mi::neuraylib::IBsdf_isotropic_data* reflection = 0;
     mi::neuraylib::IBsdf_isotropic_data* transmission = 0;
-    bool success = import_from_file( resolved_filename, reflection, transmission);
+    bool success = has_mbsdf_extension( resolved_filename)
+        && import_from_reader( reader, reflection, transmission);
     if( !success)
         return -3;
 
     m_reflection = reflection;
     m_transmission = transmission;
+    compute_sampling_data( m_reflection.get(), m_reflection_sampling_data);
+    compute_sampling_data( m_transmission.get(), m_transmission_sampling_data);
 
     m_original_filename.clear();
     m_resolved_filename = resolved_filename;
@@ -193,6 +230,8 @@ mi::Sint32 Bsdf_measurement::reset_archive_mdl(
 
     m_reflection = reflection;
     m_transmission = transmission;
+    compute_sampling_data( m_reflection.get(), m_reflection_sampling_data);
+    compute_sampling_data( m_transmission.get(), m_transmission_sampling_data);
 
     m_original_filename.clear();
     m_resolved_filename.clear();
@@ -210,6 +249,26 @@ mi::Sint32 Bsdf_measurement::reset_archive_mdl(
     return 0;
 }
 
+void Bsdf_measurement::reset_shared_mdl(
+    const Bsdf_measurement& other,
+    const std::string& resolved_filename,
+    const std::string& archive_filename,
+    const std::string& archive_membername,
+    const std::string& mdl_file_path)
+{
+    // the measured data is immutable, hence it can be shared
+    m_reflection = other.m_reflection;
+    m_transmission = other.m_transmission;
+    m_reflection_sampling_data = other.m_reflection_sampling_data;
+    m_transmission_sampling_data = other.m_transmission_sampling_data;
+
+    m_original_filename.clear();
+    m_resolved_filename = archive_filename.empty() ? resolved_filename : std::string();
+    m_resolved_archive_filename = archive_filename;
+    m_resolved_archive_membername = archive_membername;
+    m_mdl_file_path = mdl_file_path;
+}
+
 void Bsdf_measurement::set_reflection( const mi::neuraylib::IBsdf_isotropic_data* bsdf_data)
 {
     m_original_filename.clear();
@@ -218,6 +277,7 @@ void Bsdf_measurement::set_reflection( const mi::neuraylib::IBsdf_isotropic_data
     m_resolved_archive_membername.clear();
     m_mdl_file_path.clear();
     m_reflection = make_handle_dup( bsdf_data);
+    compute_sampling_data( m_reflection.get(), m_reflection_sampling_data);
 }
 
 const mi::base::IInterface* Bsdf_measurement::get_reflection() const
@@ -236,6 +296,7 @@ void Bsdf_measurement::set_transmission( const mi::neuraylib::IBsdf_isotropic_da
     m_resolved_archive_membername.clear();
     m_mdl_file_path.clear();
     m_transmission = make_handle_dup( bsdf_data);
+    compute_sampling_data( m_transmission.get(), m_transmission_sampling_data);
 }
 
 const mi::base::IInterface* Bsdf_measurement::get_transmission() const
@@ -283,6 +344,8 @@ const SERIAL::Serializable* Bsdf_measurement::serialize( SERIAL::Serializer* ser
 
     serialize_bsdf_data( serializer, m_reflection.get());
     serialize_bsdf_data( serializer, m_transmission.get());
+    serialize_sampling_data( serializer, m_reflection_sampling_data);
+    serialize_sampling_data( serializer, m_transmission_sampling_data);
 
     return this + 1;
 }
@@ -301,6 +364,8 @@ SERIAL::Serializable* Bsdf_measurement::deserialize( SERIAL::Deserializer* deser
 
     m_reflection = deserialize_bsdf_data( deserializer);
     m_transmission = deserialize_bsdf_data( deserializer); //-V656 PVS
+    deserialize_sampling_data( deserializer, m_reflection_sampling_data);
+    deserialize_sampling_data( deserializer, m_transmission_sampling_data);
 
     // Adjust m_original_filename and m_resolved_filename for this host.
     if( !m_original_filename.empty()) {
@@ -364,7 +429,11 @@ size_t Bsdf_measurement::get_size() const
         + dynamic_memory_consumption( m_resolved_filename)
         + dynamic_memory_consumption( m_resolved_archive_filename)
         + dynamic_memory_consumption( m_resolved_archive_membername)
-        + dynamic_memory_consumption( m_mdl_file_path);
+        + dynamic_memory_consumption( m_mdl_file_path)
+        + dynamic_memory_consumption( m_reflection_sampling_data.m_cdf)
+        + dynamic_memory_consumption( m_reflection_sampling_data.m_albedo)
+        + dynamic_memory_consumption( m_transmission_sampling_data.m_cdf)
+        + dynamic_memory_consumption( m_transmission_sampling_data.m_albedo);
 
     // For memory-based BSDF measurements we do not include the actual data here since it is not
     // clear whether it should be counted or not (data exclusively owned by us or not).
@@ -413,6 +482,126 @@ void Bsdf_measurement::get_scene_element_references( DB::Tag_set* result) const
 {
 }
 
+void Bsdf_measurement::compute_sampling_data(
+    const mi::neuraylib::IBsdf_isotropic_data* bsdf_data, Sampling_data& sampling_data)
+{
+    sampling_data.m_cdf.clear();
+    sampling_data.m_albedo.clear();
+    sampling_data.m_max_albedo = 0.0f;
+
+    if( !bsdf_data)
+        return;
+
+    mi::base::Handle<const mi::neuraylib::IBsdf_buffer> buffer( bsdf_data->get_bsdf_buffer());
+    if( !buffer)
+        return;
+
+    const mi::Uint32 res_theta = bsdf_data->get_resolution_theta();
+    const mi::Uint32 res_phi   = bsdf_data->get_resolution_phi();
+    const mi::Uint32 num_channels = bsdf_data->get_type() == mi::neuraylib::BSDF_SCALAR ? 1 : 3;
+    if( res_theta == 0 || res_phi == 0)
+        return;
+
+    // {1,3} * (index_theta_in * (res_phi * res_theta) + index_theta_out * res_phi + index_phi)
+    const mi::Float32* src_data = buffer->get_data();
+
+    // For each theta_in a two stage CDF is built: first to select theta_out, and second to select
+    // phi_out. The maximum component is used as "probability" in case of colored measurements.
+    const mi::Size cdf_theta_size = res_theta * res_theta;
+    sampling_data.m_cdf.resize( cdf_theta_size + cdf_theta_size * res_phi);
+    sampling_data.m_albedo.resize( res_theta);
+
+    mi::Float32* sample_data_theta = &sampling_data.m_cdf[0];
+    mi::Float32* sample_data_phi   = &sampling_data.m_cdf[0] + cdf_theta_size;
+
+    const mi::Float32 s_theta = static_cast<mi::Float32>( M_PI * 0.5) / res_theta; // step size
+    const mi::Float32 s_phi   = static_cast<mi::Float32>( M_PI) / res_phi;         // step size
+
+    mi::Float32 max_albedo = 0.0f;
+    for( mi::Uint32 t_in = 0; t_in < res_theta; ++t_in) {
+
+        mi::Float32 sum_theta = 0.0f;
+        mi::Float32 sintheta0_sqd = 0.0f;
+        for( mi::Uint32 t_out = 0; t_out < res_theta; ++t_out) {
+
+            const mi::Float32 sintheta1 = sinf( mi::Float32( t_out + 1) * s_theta);
+            const mi::Float32 sintheta1_sqd = sintheta1 * sintheta1;
+
+            // BSDFs are symmetric: f(w_in, w_out) = f(w_out, w_in), take the average of both
+            // measurements weighted by the area of the surface elements
+            const mi::Float32 mu = (sintheta1_sqd - sintheta0_sqd) * s_phi * 0.5f;
+            sintheta0_sqd = sintheta1_sqd;
+
+            // offset for both the thetas into the measurement data (select row in the volume)
+            const mi::Uint32 offset_phi  = (t_in  * res_theta + t_out) * res_phi;
+            const mi::Uint32 offset_phi2 = (t_out * res_theta + t_in)  * res_phi;
+
+            // build CDF for phi
+            mi::Float32 sum_phi = 0.0f;
+            for( mi::Uint32 p_out = 0; p_out < res_phi; ++p_out) {
+
+                const mi::Uint32 idx  = offset_phi  + p_out;
+                const mi::Uint32 idx2 = offset_phi2 + p_out;
+
+                mi::Float32 value = 0.0f;
+                if( num_channels == 3) {
+                    value = fmaxf( fmaxf( src_data[3*idx +0], src_data[3*idx +1]),
+                                   fmaxf( src_data[3*idx +2], 0.0f))
+                          + fmaxf( fmaxf( src_data[3*idx2+0], src_data[3*idx2+1]),
+                                   fmaxf( src_data[3*idx2+2], 0.0f));
+                } else
+                    value = fmaxf( src_data[idx], 0.0f) + fmaxf( src_data[idx2], 0.0f);
+
+                sum_phi += value * mu;
+                sample_data_phi[idx] = sum_phi;
+            }
+
+            // normalize CDF for phi, use a uniform CDF for rows without any energy
+            for( mi::Uint32 p_out = 0; p_out < res_phi; ++p_out) {
+                const mi::Uint32 idx = offset_phi + p_out;
+                sample_data_phi[idx] = sum_phi > 0.0f
+                    ? sample_data_phi[idx] / sum_phi
+                    : mi::Float32( p_out + 1) / mi::Float32( res_phi);
+            }
+
+            // build CDF for theta
+            sum_theta += sum_phi;
+            sample_data_theta[t_in * res_theta + t_out] = sum_theta;
+        }
+
+        if( sum_theta > max_albedo)
+            max_albedo = sum_theta;
+
+        sampling_data.m_albedo[t_in] = sum_theta;
+
+        // normalize CDF for theta, use a uniform CDF for incoming directions without any energy
+        for( mi::Uint32 t_out = 0; t_out < res_theta; ++t_out) {
+            const mi::Uint32 idx = t_in * res_theta + t_out;
+            sample_data_theta[idx] = sum_theta > 0.0f
+                ? sample_data_theta[idx] / sum_theta
+                : mi::Float32( t_out + 1) / mi::Float32( res_theta);
+        }
+    }
+
+    sampling_data.m_max_albedo = max_albedo;
+}
+
+void Bsdf_measurement::serialize_sampling_data(
+    SERIAL::Serializer* serializer, const Sampling_data& sampling_data)
+{
+    SERIAL::write( serializer, sampling_data.m_cdf);
+    SERIAL::write( serializer, sampling_data.m_albedo);
+    serializer->write( sampling_data.m_max_albedo);
+}
+
+void Bsdf_measurement::deserialize_sampling_data(
+    SERIAL::Deserializer* deserializer, Sampling_data& sampling_data)
+{
+    SERIAL::read( deserializer, &sampling_data.m_cdf);
+    SERIAL::read( deserializer, &sampling_data.m_albedo);
+    deserializer->read( &sampling_data.m_max_albedo);
+}
+
 std::string Bsdf_measurement::dump_data( const mi::neuraylib::IBsdf_isotropic_data* data)
 {
     if( data) {
@@ -600,15 +789,11 @@ bool import_from_file(
     mi::neuraylib::IBsdf_isotropic_data*& reflection,
     mi::neuraylib::IBsdf_isotropic_data*& transmission)
 {
-    DISK::File_reader_impl reader;
+    DISK::Mapped_file_reader_impl reader;
     if( !reader.open( filename.c_str()))
         return false;
 
-    std::string root, extension;
-    HAL::Ospath::splitext( filename, root, extension);
-    if( !extension.empty() && extension[0] == '.' )
-        extension = extension.substr( 1);
-    if( extension != "mbsdf")
+    if( !has_mbsdf_extension( filename))
         return false;
 
     return import_measurement_from_reader( &reader, reflection, transmission);
@@ -698,8 +883,24 @@ DB::Tag load_mdl_bsdf_measurement(
     if( tag)
         return tag;
 
+    // the same reader is used for hashing and loading, the file is read only once
+    DISK::Mapped_file_reader_impl reader;
+    bool reader_open = reader.open( resolved_filename.c_str());
+
+    MDL::DETAIL::Resource_dedup dedup( "bsdf_measurement", db_name, shared);
+    DB::Tag data_tag;
+    if( reader_open && dedup.add_reader( &reader))
+        data_tag = dedup.lookup_content( transaction);
+
     Bsdf_measurement* bsdfm = new Bsdf_measurement();
-    mi::Sint32 result = bsdfm->reset_file_mdl( resolved_filename, mdl_file_path);
+    mi::Sint32 result = 0;
+    if( data_tag) {
+        DB::Access<Bsdf_measurement> data( data_tag, transaction);
+        bsdfm->reset_shared_mdl( *data.get_ptr(), resolved_filename, "", "", mdl_file_path);
+    } else if( reader_open)
+        result = bsdfm->reset_file_mdl( &reader, resolved_filename, mdl_file_path);
+    else
+        result = bsdfm->reset_file_mdl( resolved_filename, mdl_file_path);
     ASSERT( M_BSDF_MEASUREMENT, result == 0 || result == -3);
     if( result == -3)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
@@ -708,6 +909,7 @@ DB::Tag load_mdl_bsdf_measurement(
 
     tag = transaction->store_for_reference_counting(
         bsdfm, db_name.c_str(), transaction->get_scope()->get_level());
+    dedup.insert( transaction, tag);
     return tag;
 }
 
@@ -731,9 +933,20 @@ DB::Tag load_mdl_bsdf_measurement(
     if( tag)
         return tag;
 
+    MDL::DETAIL::Resource_dedup dedup( "bsdf_measurement", db_name, shared);
+    DB::Tag data_tag;
+    if( dedup.add_reader( reader))
+        data_tag = dedup.lookup_content( transaction);
+
     Bsdf_measurement* bsdfm = new Bsdf_measurement();
-    mi::Sint32 result = bsdfm->reset_archive_mdl(
-        reader, archive_filename, archive_membername, mdl_file_path);
+    mi::Sint32 result = 0;
+    if( data_tag) {
+        DB::Access<Bsdf_measurement> data( data_tag, transaction);
+        bsdfm->reset_shared_mdl(
+            *data.get_ptr(), "", archive_filename, archive_membername, mdl_file_path);
+    } else
+        result = bsdfm->reset_archive_mdl(
+            reader, archive_filename, archive_membername, mdl_file_path);
     ASSERT( M_BSDF_MEASUREMENT, result == 0 || result == -3);
     if( result == -3)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
@@ -742,6 +955,7 @@ DB::Tag load_mdl_bsdf_measurement(
 
     tag = transaction->store_for_reference_counting(
         bsdfm, db_name.c_str(), transaction->get_scope()->get_level());
+    dedup.insert( transaction, tag);
     return tag;
 }
 
@@ -30,6 +30,7 @@
 #define IO_SCENE_BSDF_MEASUREMENT_I_BSDF_MEASUREMENT_H
 
 #include <mi/base/handle.h>
+#include <vector>
 #include <base/data/db/i_db_journal_type.h>
 #include <io/scene/scene/i_scene_scene_element.h>
 
@@ -44,6 +45,27 @@ namespace BSDFM {
 /// The class ID for the #Bsdf_measurement class.
 static const SERIAL::Class_id ID_BSDF_MEASUREMENT = 0x5f427364; // '_Bsd'
 
+/// Precomputed data for importance sampling of one part (reflection or transmission) of a BSDF
+/// measurement.
+///
+/// The data is computed once when the BSDF data is set, serialized with the DB element, and shared
+/// read-only by all consumers, e.g., the native runtime.
+struct Sampling_data
+{
+    Sampling_data() : m_max_albedo( 0.0f) { }
+
+    /// For each theta_in the CDF to select theta_out (res_theta * res_theta values), followed by
+    /// for each pair of theta_in and theta_out the CDF to select phi_out (res_theta * res_theta *
+    /// res_phi values). Empty if there is no BSDF data for this part.
+    std::vector<mi::Float32> m_cdf;
+
+    /// The albedo for each theta_in (res_theta values).
+    std::vector<mi::Float32> m_albedo;
+
+    /// The maximum of all albedo values.
+    mi::Float32 m_max_albedo;
+};
+
 class Bsdf_measurement : public SCENE::Scene_element<Bsdf_measurement, ID_BSDF_MEASUREMENT>
 {
 public:
@@ -103,6 +125,20 @@ public:
     Sint32 reset_file_mdl(
         const std::string& resolved_filename, const std::string& mdl_file_path);
 
+    /// Imports a BSDF measurement from an already opened file (used by MDL integration).
+    ///
+    /// \param reader                The reader for the BSDF measurement file.
+    /// \param resolved_filename     The resolved filename of the BSDF measurement.
+    /// \param mdl_file_path         The MDL file path.
+    /// \return
+    ///                              -  0: Success.
+    ///                              - -3: Invalid file format or invalid filename extension (only
+    ///                                    \c .mbsdf is supported).
+    Sint32 reset_file_mdl(
+        mi::neuraylib::IReader* reader,
+        const std::string& resolved_filename,
+        const std::string& mdl_file_path);
+
     /// Imports a BSDF measurement from an archive (used by MDL integration).
     ///
     /// \param reader                The reader for the BSDF measurement.
@@ -119,6 +155,18 @@ public:
         const std::string& archive_membername,
         const std::string& mdl_file_path);
 
+    /// Shares the data of a BSDF measurement with identical content (used by MDL integration).
+    ///
+    /// Only the measured data is taken from \p other. The filenames and the MDL file path are
+    /// set as by #reset_file_mdl() if \p archive_filename is empty, and as by
+    /// #reset_archive_mdl() otherwise.
+    void reset_shared_mdl(
+        const Bsdf_measurement& other,
+        const std::string& resolved_filename,
+        const std::string& archive_filename,
+        const std::string& archive_membername,
+        const std::string& mdl_file_path);
+
     const std::string& get_filename() const;
 
     const std::string& get_original_filename() const;
@@ -198,6 +246,14 @@ public:
     /// Returns the archive member name for archive-based BSDF measurements, and \c NULL otherwise.
     const std::string& get_archive_membername() const { return m_resolved_archive_membername; }
 
+    /// Returns the precomputed sampling data for the reflection (empty if there is none).
+    const Sampling_data& get_reflection_sampling_data() const
+    { return m_reflection_sampling_data; }
+
+    /// Returns the precomputed sampling data for the transmission (empty if there is none).
+    const Sampling_data& get_transmission_sampling_data() const
+    { return m_transmission_sampling_data; }
+
 private:
     /// Comments on DB::Element_base and DB::Element say that the copy constructor is needed.
     /// But the assignment operator is not implemented, although usually, they are implemented both
@@ -217,12 +273,30 @@ private:
     /// Used by the various reset_*() methods and dump().
     static std::string dump_data( const mi::neuraylib::IBsdf_isotropic_data* data);
 
+    /// Computes the sampling data for the given BSDF data (which can be \c NULL).
+    static void compute_sampling_data(
+        const mi::neuraylib::IBsdf_isotropic_data* bsdf_data, Sampling_data& sampling_data);
+
+    /// Serializes the sampling data.
+    static void serialize_sampling_data(
+        SERIAL::Serializer* serializer, const Sampling_data& sampling_data);
+
+    /// Deserializes the sampling data.
+    static void deserialize_sampling_data(
+        SERIAL::Deserializer* deserializer, Sampling_data& sampling_data);
+
     /// The BSDF data for the reflection.
     mi::base::Handle<const mi::neuraylib::IBsdf_isotropic_data> m_reflection;
 
     /// The BSDF data for the transmission.
     mi::base::Handle<const mi::neuraylib::IBsdf_isotropic_data> m_transmission;
 
+    /// The sampling data for the reflection.
+    Sampling_data m_reflection_sampling_data;
+
+    /// The sampling data for the transmission.
+    Sampling_data m_transmission_sampling_data;
+
     /// The file (or MDL file path) that contains the data of this DB element.
     ///
     /// Non-empty for file-based BSDF measurements.
@@ -165,6 +165,17 @@ private:
     std::vector<std::pair<mi::Sint32, mi::Sint32> > m_uvs;
 };
 
+namespace {
+
+/// Indicates whether \p mipmap is referenced by anybody else than the caller.
+bool is_shared( const IMAGE::IMipmap* mipmap)
+{
+    mipmap->retain();
+    return mipmap->release() > 1;
+}
+
+} // namespace
+
 Image::Image() : m_is_uvtile(false)
 {
     set_default_pink_dummy_mipmap();
@@ -213,6 +224,18 @@ mi::Sint32 Image::reset_reader( mi::neuraylib::IReader* reader, const char* imag
 
 mi::Sint32 Image::reset(
     const Image_set* image_set)
+{
+    return reset_internal( image_set, 0);
+}
+
+mi::Sint32 Image::reset_shared(
+    const Image_set* image_set, const Image& other)
+{
+    return reset_internal( image_set, &other);
+}
+
+mi::Sint32 Image::reset_internal(
+    const Image_set* image_set, const Image* other)
 {
     if( !image_set)
         return -1;
@@ -220,6 +243,8 @@ mi::Sint32 Image::reset(
     mi::Size number_of_tiles = image_set->get_length();
     if( number_of_tiles == 0)
         return -1;
+    if( other && number_of_tiles != other->m_uvtiles.size())
+        return -1;
 
     mi::Sint32 u=0, v=0;
     image_set->get_uv_mapping( 0, u, v);
@@ -246,6 +271,15 @@ mi::Sint32 Image::reset(
             result = -2;
             break;
         }
+        if( other) {
+            mi::Uint32 id = other->get_uvtile_id( u, v);
+            if( id >= other->m_uvtiles.size()) {
+                result = -1;
+                break;
+            }
+            temp_mipmaps[i] = other->m_uvtiles[id].m_mipmap;
+            continue;
+        }
         temp_mipmaps[i] = image_set->create_mipmap( i);
         if ( !temp_mipmaps[i].is_valid_interface())
         {
@@ -322,6 +356,14 @@ IMAGE::IMipmap* Image::get_mipmap()
     m_mdl_file_path.clear();
     m_resolved_archive_filename.clear();
 
+    // Copy-on-write: the mipmap might be shared with other DB elements, see reset_shared(). This
+    // holds for both sides, the element that loaded the mipmap and the elements sharing it.
+    if( is_shared( m_uvtiles[0].m_mipmap.get())) {
+        SYSTEM::Access_module<IMAGE::Image_module> image_module( false);
+        m_uvtiles[0].m_mipmap = image_module->copy_mipmap(
+            m_uvtiles[0].m_mipmap.get(), /*only_first_level*/ false);
+    }
+
     m_uvtiles[0].m_mipmap->retain();
     return m_uvtiles[0].m_mipmap.get();
 }
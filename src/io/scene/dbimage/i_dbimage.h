@@ -198,6 +198,24 @@ public:
     Sint32 reset(
         const Image_set* image_set);
 
+    /// Shares the mipmaps of an image with identical content (used by MDL integration).
+    ///
+    /// The filenames and the MDL file paths are taken from the image description as by #reset(),
+    /// but the mipmaps of \p other are used instead of importing the files again. The mipmaps
+    /// are copied before they are handed out for modification by #get_mipmap(). This also holds
+    /// for \p other, #get_mipmap() copies any mipmap that is referenced elsewhere.
+    ///
+    /// \param image_set             The image description to use.
+    /// \param other                 The image whose mipmaps are shared. It needs to have the same
+    ///                              uv-tiles as \p image_set.
+    /// \return
+    ///                              -  0: Success.
+    ///                              - -1: The image set is NULL or empty, or its uv-tiles do not
+    ///                                    match those of \p other.
+    ///                              - -2: The image set contains the same uv-tile twice.
+    Sint32 reset_shared(
+        const Image_set* image_set, const Image& other);
+
     /// Sets a memory-based mipmap.
     ///
     /// Actually, the mipmap might not be memory-based, but it will be treated as if it was a
@@ -406,6 +424,12 @@ private:
     /// or none. Let's make the assignment operator private for now.
     Image& operator=( const Image&);
 
+    /// Implements #reset() and #reset_shared().
+    ///
+    /// Imports the mipmaps from \p image_set if \p other is \c NULL, and shares those of
+    /// \p other otherwise.
+    Sint32 reset_internal( const Image_set* image_set, const Image* other);
+
     /// Sets a dummy mipmap with a 1x1 canvas with a pink pixel.
     ///
     /// Does not affect the stored filenames.
@@ -117,6 +117,25 @@ public:
         mi::neuraylib::Lightprofile_degree degree = mi::neuraylib::LIGHTPROFILE_HERMITE_BASE_1,
         mi::Uint32 flags = mi::neuraylib::LIGHTPROFILE_COUNTER_CLOCKWISE);
 
+    /// Imports a light profile from an already opened file (used by MDL integration).
+    ///
+    /// \param reader                The reader for the light profile file.
+    /// \param resolved_filename     The resolved filename of the light profile.
+    /// \param mdl_file_path         The MDL file path.
+    /// \param resolution_phi        See #reset_file().
+    /// \param resolution_theta      See #reset_file().
+    /// \param degree                See #reset_file().
+    /// \param flags                 See #reset_file().
+    /// \return                      See #reset_file() (-2 not possible here).
+    mi::Sint32 reset_file_mdl(
+        mi::neuraylib::IReader* reader,
+        const std::string& resolved_filename,
+        const std::string& mdl_file_path,
+        mi::Uint32 resolution_phi = 0,
+        mi::Uint32 resolution_theta = 0,
+        mi::neuraylib::Lightprofile_degree degree = mi::neuraylib::LIGHTPROFILE_HERMITE_BASE_1,
+        mi::Uint32 flags = mi::neuraylib::LIGHTPROFILE_COUNTER_CLOCKWISE);
+
     /// Imports a light profile from an archive (used by MDL integration).
     ///
     /// \param reader                The reader for the light profile.
@@ -138,6 +157,18 @@ public:
         mi::neuraylib::Lightprofile_degree degree = mi::neuraylib::LIGHTPROFILE_HERMITE_BASE_1,
         mi::Uint32 flags = mi::neuraylib::LIGHTPROFILE_COUNTER_CLOCKWISE);
 
+    /// Copies the data of a light profile with identical content (used by MDL integration).
+    ///
+    /// Only the data is taken from \p other. The filenames and the MDL file path are set as by
+    /// #reset_file_mdl() if \p archive_filename is empty, and as by #reset_archive_mdl()
+    /// otherwise.
+    void reset_shared_mdl(
+        const Lightprofile& other,
+        const std::string& resolved_filename,
+        const std::string& archive_filename,
+        const std::string& archive_membername,
+        const std::string& mdl_file_path);
+
     const std::string& get_filename() const;
 
     const std::string& get_original_filename() const;
@@ -196,6 +227,14 @@ public:
     /// Used to fold the MDL function df::lightprofile_maximum().
     mi::Float32 get_maximum() const { return get_candela_multiplier(); }
 
+    /// Returns the precomputed CDFs for importance sampling, or \c NULL for invalid light profiles.
+    ///
+    /// The data is defined on the grid cells: the first (res_theta-1) values are the CDF to select
+    /// theta, followed by (res_theta-1) CDFs of (res_phi-1) values each to select phi for a given
+    /// theta. It is computed once on import and shared read-only by all consumers, e.g., the native
+    /// runtime.
+    const mi::Float32* get_cdf_data() const { return m_cdf_data.empty() ? 0 : &m_cdf_data[0]; }
+
     /// Indicates whether this light profile contains valid light profile data.
     bool is_valid() const { return !m_data.empty(); }
 
@@ -227,6 +266,9 @@ private:
         mi::neuraylib::Lightprofile_degree degree = mi::neuraylib::LIGHTPROFILE_HERMITE_BASE_1,
         mi::Uint32 flags = mi::neuraylib::LIGHTPROFILE_COUNTER_CLOCKWISE);
 
+    /// Computes m_cdf_data from m_data.
+    void compute_cdf_data();
+
     /// Comments on DB::Element_base and DB::Element say that the copy constructor is needed.
     /// But the assignment operator is not implemented, although usually, they are implemented both
     /// or none. Let's make the assignment operator private for now.
@@ -275,6 +317,7 @@ private:
     // Computed data
     mi::Float32 m_candela_multiplier;
     mi::Float32 m_power;
+    std::vector<mi::Float32> m_cdf_data;
 };
 
 /// Exports the light profile to a file.
@@ -33,12 +33,14 @@
 #include <mi/math/function.h>
 #include <base/system/main/access_module.h>
 #include <base/hal/disk/disk_file_reader_writer_impl.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/lib/config/config.h>
 #include <base/lib/log/i_log_assert.h>
 #include <base/lib/log/i_log_logger.h>
 #include <base/lib/mem/i_mem_consumption.h>
 #include <base/lib/path/i_path.h>
+#include <base/data/db/i_db_access.h>
 #include <base/data/db/i_db_transaction.h>
 #include <base/data/serial/i_serializer.h>
 #include <base/util/registry/i_config_registry.h>
@@ -107,7 +109,7 @@ mi::Sint32 Lightprofile::reset_file(
         return -2;
 
     // create reader for resolved_filename
-    DISK::File_reader_impl reader;
+    DISK::Mapped_file_reader_impl reader;
     if( !reader.open( resolved_filename.c_str()))
         return -2;
 
@@ -155,12 +157,25 @@ mi::Sint32 Lightprofile::reset_file_mdl(
     mi::Uint32 flags)
 {
     // create reader for resolved_filename
-    DISK::File_reader_impl reader;
+    DISK::Mapped_file_reader_impl reader;
     if( !reader.open( resolved_filename.c_str()))
         return -2;
 
+    return reset_file_mdl(
+        &reader, resolved_filename, mdl_file_path, resolution_phi, resolution_theta, degree, flags);
+}
+
+mi::Sint32 Lightprofile::reset_file_mdl(
+    mi::neuraylib::IReader* reader,
+    const std::string& resolved_filename,
+    const std::string& mdl_file_path,
+    mi::Uint32 resolution_phi,
+    mi::Uint32 resolution_theta,
+    mi::neuraylib::Lightprofile_degree degree,
+    mi::Uint32 flags)
+{
     mi::Sint32 result = reset_file_shared(
-        &reader, resolved_filename, resolution_phi, resolution_theta, degree, flags);
+        reader, resolved_filename, resolution_phi, resolution_theta, degree, flags);
     if( result != 0)
         return result;
 
@@ -202,6 +217,33 @@ mi::Sint32 Lightprofile::reset_archive_mdl(
     return 0;
 }
 
+void Lightprofile::reset_shared_mdl(
+    const Lightprofile& other,
+    const std::string& resolved_filename,
+    const std::string& archive_filename,
+    const std::string& archive_membername,
+    const std::string& mdl_file_path)
+{
+    m_resolution_phi     = other.m_resolution_phi;
+    m_resolution_theta   = other.m_resolution_theta;
+    m_degree             = other.m_degree;
+    m_flags              = other.m_flags;
+    m_start_phi          = other.m_start_phi;
+    m_start_theta        = other.m_start_theta;
+    m_delta_phi          = other.m_delta_phi;
+    m_delta_theta        = other.m_delta_theta;
+    m_data               = other.m_data;
+    m_candela_multiplier = other.m_candela_multiplier;
+    m_power              = other.m_power;
+    m_cdf_data           = other.m_cdf_data;
+
+    m_original_filename.clear();
+    m_resolved_filename = archive_filename.empty() ? resolved_filename : std::string();
+    m_resolved_archive_filename = archive_filename;
+    m_resolved_archive_membername = archive_membername;
+    m_mdl_file_path = mdl_file_path;
+}
+
 mi::Sint32 Lightprofile::reset_file_shared(
     mi::neuraylib::IReader* reader,
     const std::string& filename,
@@ -282,9 +324,60 @@ mi::Sint32 Lightprofile::reset_file_shared(
     // grid cell
     m_power *= m_candela_multiplier * m_delta_phi * 0.25f;
 
+    compute_cdf_data();
+
     return 0;
 }
 
+void Lightprofile::compute_cdf_data()
+{
+    m_cdf_data.clear();
+    if( m_resolution_theta < 2 || m_resolution_phi < 2 || m_data.empty())
+        return;
+
+    // Sampling works on grid cells rather than on grid nodes (which are used for evaluation).
+    const mi::Size res_t = m_resolution_theta - 1;
+    const mi::Size res_p = m_resolution_phi - 1;
+    m_cdf_data.resize( res_t + res_t * res_p);
+
+    mi::Float32 sum_theta = 0.0f;
+    mi::Float32 cos_theta0 = cosf( m_start_theta);
+    for( mi::Size t = 0; t < res_t; ++t) {
+
+        // area of the grid cell
+        const mi::Float32 cos_theta1 = cosf( m_start_theta + mi::Float32( t+1) * m_delta_theta);
+        const mi::Float32 mu = cos_theta0 - cos_theta1;
+        cos_theta0 = cos_theta1;
+
+        // build CDF for phi (the value of a cell is the average of its corners, the factor 1/4 is
+        // omitted since the CDF is normalized anyway)
+        mi::Float32* cdf_data_phi = &m_cdf_data[res_t + t * res_p];
+        mi::Float32 sum_phi = 0.0f;
+        for( mi::Size p = 0; p < res_p; ++p) {
+            mi::Float32 value = m_data[p * m_resolution_theta + t]
+                              + m_data[p * m_resolution_theta + t + 1]
+                              + m_data[(p+1) * m_resolution_theta + t]
+                              + m_data[(p+1) * m_resolution_theta + t + 1];
+            sum_phi += value * mu;
+            cdf_data_phi[p] = sum_phi;
+        }
+
+        // normalize CDF for phi
+        for( mi::Size p = 0; p + 1 < res_p; ++p)
+            cdf_data_phi[p] = sum_phi ? (cdf_data_phi[p] / sum_phi) : 0.0f;
+        cdf_data_phi[res_p - 1] = 1.0f;
+
+        // build CDF for theta
+        sum_theta += sum_phi;
+        m_cdf_data[t] = sum_theta;
+    }
+
+    // normalize CDF for theta
+    for( mi::Size t = 0; t + 1 < res_t; ++t)
+        m_cdf_data[t] = sum_theta ? (m_cdf_data[t] / sum_theta) : m_cdf_data[t];
+    m_cdf_data[res_t - 1] = 1.0f;
+}
+
 const std::string& Lightprofile::get_filename() const
 {
     return m_resolved_filename;
@@ -417,6 +510,7 @@ const SERIAL::Serializable* Lightprofile::serialize( SERIAL::Serializer* seriali
     SERIAL::write( serializer, m_data);
     serializer->write( m_candela_multiplier);
     serializer->write( m_power);
+    SERIAL::write( serializer, m_cdf_data);
 
     return this + 1;
 }
@@ -446,6 +540,7 @@ SERIAL::Serializable* Lightprofile::deserialize( SERIAL::Deserializer* deseriali
     SERIAL::read( deserializer, &m_data);
     deserializer->read( &m_candela_multiplier);
     deserializer->read( &m_power);
+    SERIAL::read( deserializer, &m_cdf_data);
 
     // Adjust m_original_filename and m_resolved_filename for this host.
     if( !m_original_filename.empty()) {
@@ -519,7 +614,8 @@ size_t Lightprofile::get_size() const
         + dynamic_memory_consumption( m_resolved_archive_filename)
         + dynamic_memory_consumption( m_resolved_archive_membername)
         + dynamic_memory_consumption( m_mdl_file_path)
-        + dynamic_memory_consumption( m_data);
+        + dynamic_memory_consumption( m_data)
+        + dynamic_memory_consumption( m_cdf_data);
 }
 
 DB::Journal_type Lightprofile::get_journal_flags() const
@@ -668,8 +764,24 @@ DB::Tag load_mdl_lightprofile(
     if( tag)
         return tag;
 
+    // the same reader is used for hashing and loading, the file is read only once
+    DISK::Mapped_file_reader_impl reader;
+    bool reader_open = reader.open( resolved_filename.c_str());
+
+    MDL::DETAIL::Resource_dedup dedup( "lightprofile", db_name, shared);
+    DB::Tag data_tag;
+    if( reader_open && dedup.add_reader( &reader))
+        data_tag = dedup.lookup_content( transaction);
+
     Lightprofile* lp = new Lightprofile();
-    mi::Sint32 result = lp->reset_file_mdl( resolved_filename, mdl_file_path);
+    mi::Sint32 result = 0;
+    if( data_tag) {
+        DB::Access<Lightprofile> data( data_tag, transaction);
+        lp->reset_shared_mdl( *data.get_ptr(), resolved_filename, "", "", mdl_file_path);
+    } else if( reader_open)
+        result = lp->reset_file_mdl( &reader, resolved_filename, mdl_file_path);
+    else
+        result = lp->reset_file_mdl( resolved_filename, mdl_file_path);
     ASSERT( M_LIGHTPROFILE, result == 0 || result == -4);
     if( result == -4)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
@@ -678,6 +790,7 @@ DB::Tag load_mdl_lightprofile(
 
     tag = transaction->store_for_reference_counting(
         lp, db_name.c_str(), transaction->get_scope()->get_level());
+    dedup.insert( transaction, tag);
     return tag;
 }
 
@@ -701,9 +814,20 @@ DB::Tag load_mdl_lightprofile(
     if( tag)
         return tag;
 
+    MDL::DETAIL::Resource_dedup dedup( "lightprofile", db_name, shared);
+    DB::Tag data_tag;
+    if( dedup.add_reader( reader))
+        data_tag = dedup.lookup_content( transaction);
+
     Lightprofile* lp = new Lightprofile();
-    mi::Sint32 result = lp->reset_archive_mdl(
-        reader, archive_filename, archive_membername, mdl_file_path);
+    mi::Sint32 result = 0;
+    if( data_tag) {
+        DB::Access<Lightprofile> data( data_tag, transaction);
+        lp->reset_shared_mdl(
+            *data.get_ptr(), "", archive_filename, archive_membername, mdl_file_path);
+    } else
+        result = lp->reset_archive_mdl(
+            reader, archive_filename, archive_membername, mdl_file_path);
     ASSERT( M_LIGHTPROFILE, result == 0 || result == -4);
     if( result == -4)
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
@@ -712,6 +836,7 @@ DB::Tag load_mdl_lightprofile(
 
     tag = transaction->store_for_reference_counting(
         lp, db_name.c_str(), transaction->get_scope()->get_level());
+    dedup.insert( transaction, tag);
     return tag;
 }
 
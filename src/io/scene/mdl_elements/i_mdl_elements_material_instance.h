@@ -108,6 +108,13 @@ public:
 
     // internal methods
 
+    /// Drops all compiled materials memoized by #create_compiled_material().
+    ///
+    /// Compiled materials are memoized process-wide, keyed by the material definition, the
+    /// arguments, the compilation mode and unit settings, and the versions of all DB elements
+    /// reachable from the arguments. Needs to be called before the database is closed.
+    static void clear_compiled_material_cache();
+
     /// Indicates whether the material instance is immutable.
     bool is_immutable() const { return m_immutable; }
 
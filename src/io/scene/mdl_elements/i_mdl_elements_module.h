@@ -239,6 +239,50 @@ public:
         Execution_context* context);
 
 
+    /// Reloads a module that exists already in the DB (public).
+    ///
+    /// Compiles the module again, from file or from \p module_source, together with all modules in
+    /// the DB that import it directly or indirectly. The reload fails if one of the modules
+    /// importing it was not loaded from file, since its source is not available. The definitions
+    /// of each module are compared with their current DB elements by fingerprints of their DAG
+    /// representation, which include the fingerprints of all called definitions of the
+    /// recompiled modules. DB elements of unchanged definitions are kept, changed definitions are
+    /// replaced in place (keeping their tags), and new definitions get new DB elements.
+    /// Definitions cannot be removed by a reload; since the signature of a function is part of
+    /// its DB name, this includes signature changes of functions. The parameter names and types
+    /// of materials cannot change either, since existing material instances would no longer
+    /// match.
+    ///
+    /// All modules are compiled and compared before the first DB element is created or replaced,
+    /// including DB elements for resources and for newly imported modules, i.e., the DB is not
+    /// changed if compiling or comparing fails.
+    ///
+    /// \param transaction     The DB transaction to use.
+    /// \param module_name     The fully-qualified MDL module name (including package names, starts
+    ///                        with "::").
+    /// \param module_source   The new source code of the module, or \c NULL to reload the module
+    ///                        from file.
+    /// \param[inout] context  Execution context used to pass options to and store messages from
+    ///                        the MDL compiler.
+    /// \return
+    ///           -  1: Success (the module did not change, no DB element was replaced).
+    ///           -  0: Success (the module was reloaded).
+    ///           - -1: The module name \p module_name is invalid.
+    ///           - -2: Failed to find or to compile the module \p module_name or a module
+    ///                 importing it, or a module importing it was not loaded from file.
+    ///           - -3: The DB name for an imported module is already in use but is not an MDL
+    ///                 module, or the DB name for a new definition is already in use.
+    ///           - -4: Initialization of an imported module failed.
+    ///           - -5: There is no module \p module_name in the DB.
+    ///           - -6: A definition of the module or of a module importing it was removed, the
+    ///                 return type of a function changed, or the parameters of a material
+    ///                 changed.
+    static mi::Sint32 reload_module(
+        DB::Transaction* transaction,
+        const char* module_name,
+        mi::neuraylib::IReader* module_source,
+        Execution_context* context);
+
     /// Creates a value referencing a texture identified by an MDL file path.
     ///
     /// \param transaction   The transaction to be used.
@@ -37,6 +37,7 @@
 
 #include <mi/base/config.h>
 #include <mi/base/atom.h>
+#include <mi/base/lock.h>
 #include <mi/mdl/mdl_archiver.h>
 #include <mi/mdl/mdl_entity_resolver.h>
 #include <mi/mdl/mdl_mdl.h>
@@ -45,10 +46,14 @@
 #include <boost/core/ignore_unused.hpp>
 #include <base/system/main/access_module.h>
 #include <base/hal/disk/disk.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
 #include <base/hal/hal/i_hal_ospath.h>
+#include <base/lib/config/config.h>
 #include <base/lib/log/i_log_logger.h>
 #include <base/lib/path/i_path.h>
 #include <base/data/db/i_db_transaction.h>
+#include <base/util/registry/i_config_registry.h>
+#include <mdl/codegenerators/generator_code/generator_code_hash.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <io/scene/bsdf_measurement/i_bsdf_measurement.h>
 #include <io/scene/lightprofile/i_lightprofile.h>
@@ -510,6 +515,233 @@ std::string generate_unique_db_name( DB::Transaction* transaction, const char* p
 }
 
 
+// *********** Resource_dedup **********************************************************************
+
+namespace {
+
+/// Statistics of the content-hash index for shared MDL resources.
+struct Resource_dedup_statistics
+{
+    /// Number of bytes hashed so far.
+    mi::Uint64 m_bytes_hashed;
+    /// Number of lookups by content.
+    mi::Uint64 m_lookups;
+    /// Number of lookups by content that found an element with identical content.
+    mi::Uint64 m_hits;
+    /// Sum of the file sizes of these hits, i.e., the number of bytes that were not loaded.
+    mi::Uint64 m_bytes_saved;
+};
+
+/// The content-hash index for shared resources.
+struct Resource_dedup_index
+{
+    Resource_dedup_index() { memset( &m_statistics, 0, sizeof( m_statistics)); }
+
+    /// The lock for all members below.
+    mi::base::Lock m_lock;
+    /// Maps digests to the DB names of the elements with that content.
+    boost::unordered_map<std::string, std::string> m_content;
+    /// The statistics.
+    Resource_dedup_statistics m_statistics;
+};
+
+Resource_dedup_index g_resource_dedup_index;
+
+} // namespace
+
+Resource_dedup::Resource_dedup( const char* kind, const std::string& db_name, bool shared)
+  : m_kind( kind),
+    m_db_name( db_name),
+    m_hasher( 0),
+    m_size( 0)
+{
+    if( !shared)
+        return;
+
+    SYSTEM::Access_module<CONFIG::Config_module> config_module( false);
+    const CONFIG::Config_registry& registry = config_module->get_configuration();
+    bool flag = false;
+    registry.get_value( "mdl_resource_content_dedup", flag);
+    if( flag)
+        m_hasher = new mi::mdl::MD5_hasher();
+}
+
+Resource_dedup::~Resource_dedup()
+{
+    delete m_hasher;
+}
+
+bool Resource_dedup::add_file( const std::string& filename)
+{
+    if( !m_hasher)
+        return false;
+
+    DISK::Mapped_file_reader_impl reader;
+    if( !reader.open( filename.c_str())) {
+        delete m_hasher;
+        m_hasher = 0;
+        return false;
+    }
+
+    bool result = add_reader( &reader);
+    reader.close();
+    return result;
+}
+
+bool Resource_dedup::add_reader( mi::neuraylib::IReader* reader)
+{
+    if( !m_hasher)
+        return false;
+
+    if( !reader || !reader->supports_absolute_access()) {
+        delete m_hasher;
+        m_hasher = 0;
+        return false;
+    }
+
+    mi::Sint64 position = reader->tell_absolute();
+    mi::Sint64 remaining = reader->get_file_size() - position;
+
+    // hash the data in place if the reader supports it, e.g., for memory-mapped files
+    const char* data = 0;
+    if(    remaining > 0 && reader->supports_lookahead()
+        && reader->lookahead( remaining, &data) >= remaining && data) {
+        m_hasher->update( reinterpret_cast<const unsigned char*>( data), remaining);
+        m_size += remaining;
+        return true;
+    }
+
+    std::vector<char> buffer( 64*1024);
+    bool success = true;
+    while( true) {
+        mi::Sint64 count = reader->read( &buffer[0], buffer.size());
+        if( count < 0) {
+            success = false;
+            break;
+        }
+        if( count == 0)
+            break;
+        m_hasher->update( reinterpret_cast<const unsigned char*>( &buffer[0]), count);
+        m_size += count;
+    }
+
+    if( !reader->seek_absolute( position))
+        success = false;
+
+    if( !success) {
+        delete m_hasher;
+        m_hasher = 0;
+    }
+    return success;
+}
+
+void Resource_dedup::add_parameter( mi::Float32 value)
+{
+    if( m_hasher)
+        m_hasher->update( value);
+}
+
+void Resource_dedup::add_parameter( mi::Sint32 value)
+{
+    if( m_hasher)
+        m_hasher->update( value);
+}
+
+DB::Tag Resource_dedup::lookup_content( DB::Transaction* transaction)
+{
+    if( !m_hasher)
+        return DB::Tag();
+
+    const std::string& digest = get_digest();
+
+    Resource_dedup_index& index = g_resource_dedup_index;
+    std::string name;
+    {
+        mi::base::Lock::Block block( &index.m_lock);
+        ++index.m_statistics.m_lookups;
+        boost::unordered_map<std::string, std::string>::const_iterator it
+            = index.m_content.find( digest);
+        if( it == index.m_content.end())
+            return DB::Tag();
+        name = it->second;
+    }
+
+    // An element under our own name has been removed in the meantime (otherwise the regular
+    // lookup by name would have succeeded).
+    if( name == m_db_name)
+        return DB::Tag();
+
+    // The element might have been removed, or might not be visible in this scope.
+    DB::Tag tag = transaction->name_to_tag( name.c_str());
+    if( !tag)
+        return DB::Tag();
+
+    {
+        mi::base::Lock::Block block( &index.m_lock);
+        ++index.m_statistics.m_hits;
+        index.m_statistics.m_bytes_saved += m_size;
+    }
+
+    LOG::mod_log->debug( M_SCENE, LOG::Mod_log::C_IO,
+        "Sharing the data of \"%s\" for \"%s\" with identical content.",
+        name.c_str(), m_db_name.c_str());
+    return tag;
+}
+
+void Resource_dedup::insert( DB::Transaction* transaction, DB::Tag tag)
+{
+    if( !m_hasher || !tag)
+        return;
+
+    ASSERT( M_SCENE, m_db_name == transaction->tag_to_name( tag));
+    boost::ignore_unused( transaction);
+
+    const std::string& digest = get_digest();
+
+    Resource_dedup_index& index = g_resource_dedup_index;
+    mi::base::Lock::Block block( &index.m_lock);
+    index.m_content[digest] = m_db_name;
+}
+
+void Resource_dedup::clear()
+{
+    Resource_dedup_index& index = g_resource_dedup_index;
+    mi::base::Lock::Block block( &index.m_lock);
+
+    if( index.m_statistics.m_hits > 0)
+        LOG::mod_log->info( M_SCENE, LOG::Mod_log::C_IO,
+            "Content-hash deduplication of MDL resources: %" FMT_BIT64 "u of %" FMT_BIT64 "u "
+            "lookups shared the data of an existing element, %" FMT_BIT64 "u bytes saved, "
+            "%" FMT_BIT64 "u bytes hashed.",
+            index.m_statistics.m_hits,
+            index.m_statistics.m_lookups,
+            index.m_statistics.m_bytes_saved,
+            index.m_statistics.m_bytes_hashed);
+
+    index.m_content.clear();
+    memset( &index.m_statistics, 0, sizeof( index.m_statistics));
+}
+
+const std::string& Resource_dedup::get_digest()
+{
+    ASSERT( M_SCENE, m_hasher);
+
+    if( m_digest.empty()) {
+        unsigned char result[16];
+        m_hasher->final( result);
+        m_digest = m_kind;
+        m_digest.push_back( '\0');
+        m_digest.append( reinterpret_cast<const char*>( result), sizeof( result));
+
+        Resource_dedup_index& index = g_resource_dedup_index;
+        mi::base::Lock::Block block( &index.m_lock);
+        index.m_statistics.m_bytes_hashed += m_size;
+    }
+
+    return m_digest;
+}
+
+
 // *********** Type_binder *************************************************************************
 
 Type_binder::Type_binder( mi::mdl::IType_factory* type_factory)
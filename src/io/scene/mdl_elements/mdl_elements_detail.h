@@ -40,6 +40,7 @@
 #include <mi/mdl/mdl_entity_resolver.h>
 #include <mi/neuraylib/ireader.h>
 #include <string>
+#include <boost/core/noncopyable.hpp>
 #include <boost/unordered_map.hpp>
 #include <base/data/db/i_db_tag.h>
 #include <io/image/image/i_image.h>
@@ -48,6 +49,7 @@
 namespace mi { namespace mdl { 
     class IArchive_tool;
     class IMDL_resource_reader;
+    class MD5_hasher;
 } }
 
 namespace MI {
@@ -172,6 +174,95 @@ DB::Tag mdl_bsdf_measurement_to_tag(
 /// Generates a name that is unique in the DB (at least from the given transaction's point of view).
 std::string generate_unique_db_name( DB::Transaction* transaction, const char* prefix);
 
+/// Deduplicates the data of shared MDL resources by the content of their files.
+///
+/// Shared resources are stored in the DB under names derived from their resolved filenames. Hence,
+/// identical files under different paths, or in different archives, result in separate DB
+/// elements. If enabled via the debug option \c "mdl_resource_content_dedup" (default: off), the
+/// loaders hash the file contents and look up an existing DB element with identical content.
+/// Such a duplicate still gets its own DB element under its own name, with its own filenames and
+/// MDL file path, but shares the loaded data (pixels or measurements) of the existing element
+/// instead of loading the file again.
+///
+/// Typical usage, after the regular lookup by DB name failed:
+/// \code
+///     Resource_dedup dedup( "lightprofile", db_name, shared);
+///     DB::Tag data_tag;
+///     if( dedup.add_reader( reader))
+///         data_tag = dedup.lookup_content( transaction);
+///     // create the element, either from the data of data_tag (if valid) or from the reader
+///     tag = transaction->store_for_reference_counting( element, db_name.c_str(), ...);
+///     dedup.insert( transaction, tag);
+/// \endcode
+///
+/// All methods are no-ops if deduplication is disabled or the resource is not shared.
+class Resource_dedup : public boost::noncopyable
+{
+public:
+    /// Constructor.
+    ///
+    /// \param kind      The kind of resource, e.g., \c "texture". Only resources of the same kind
+    ///                  are deduplicated.
+    /// \param db_name   The DB name used for the resource.
+    /// \param shared    Indicates whether the resource is shared. Resources that are not shared
+    ///                  are never deduplicated.
+    Resource_dedup( const char* kind, const std::string& db_name, bool shared);
+
+    /// Destructor.
+    ~Resource_dedup();
+
+    /// Indicates whether deduplication is active for this resource.
+    bool is_active() const { return m_hasher != 0; }
+
+    /// Adds the contents of a file to the digest.
+    ///
+    /// \return   \c true in case of success, \c false if the file could not be read. Failures
+    ///           deactivate deduplication for this resource.
+    bool add_file( const std::string& filename);
+
+    /// Adds the remaining data of a reader to the digest. The reader position is restored, such
+    /// that the same reader can be used to load the resource afterwards.
+    ///
+    /// \return   \c true in case of success, \c false if the reader could not be read. Failures
+    ///           deactivate deduplication for this resource.
+    bool add_reader( mi::neuraylib::IReader* reader);
+
+    /// Adds a parameter that is not part of the file contents, e.g., gamma, to the digest.
+    void add_parameter( mi::Float32 value);
+
+    /// Adds a parameter that is not part of the file contents, e.g., uv-tile indices, to the
+    /// digest.
+    void add_parameter( mi::Sint32 value);
+
+    /// Returns a DB element with identical content whose data can be shared, or an invalid tag.
+    DB::Tag lookup_content( DB::Transaction* transaction);
+
+    /// Registers the element that has been stored for the resource.
+    ///
+    /// Reuses the digest computed by #lookup_content(), the contents are not hashed again.
+    void insert( DB::Transaction* transaction, DB::Tag tag);
+
+    /// Clears the content-hash index and logs its statistics.
+    ///
+    /// Must be called when the DB is closed since the index refers to DB elements by name.
+    static void clear();
+
+private:
+    /// Computes the digest (only once).
+    const std::string& get_digest();
+
+    /// The kind of resource.
+    std::string m_kind;
+    /// The DB name of the resource.
+    std::string m_db_name;
+    /// The hasher, or \c NULL if inactive.
+    mi::mdl::MD5_hasher* m_hasher;
+    /// The computed digest (prefixed with the kind), or empty if not yet computed.
+    std::string m_digest;
+    /// Number of bytes added to the hasher.
+    mi::Uint64 m_size;
+};
+
 /// Converts mi::mdl::IType_alias modifiers into MI::MDL::IType_alias modifiers.
 inline mi::Uint32 mdl_modifiers_to_int_modifiers( mi::Uint32 modifiers)
 {
@@ -32,6 +32,7 @@
 
 #include "i_mdl_elements_compiled_material.h"
 #include "i_mdl_elements_expression.h"
+#include "i_mdl_elements_function_definition.h"
 #include "i_mdl_elements_material_definition.h"
 #include "i_mdl_elements_module.h"
 #include "i_mdl_elements_type.h"
@@ -39,8 +40,15 @@
 #include "i_mdl_elements_value.h"
 #include "mdl_elements_utilities.h"
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
 #include <sstream>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 #include <mi/base/handle.h>
+#include <mi/base/lock.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/neuraylib/istring.h>
 #include <base/lib/log/i_log_logger.h>
@@ -223,6 +231,216 @@ void Mdl_material_instance::make_mutable(DB::Transaction* transaction) {
     m_immutable = false;
 }
 
+namespace {
+
+/// Key of the compiled material cache.
+///
+/// The arguments are not part of the key. They are compared for all entries with the same key.
+struct Compiled_material_cache_key
+{
+    DB::Tag m_definition_tag;
+    mi::Uint32 m_material_index;
+    bool m_class_compilation;
+    /// The values of all options of the execution context, see #encode_context_options().
+    std::string m_options;
+    /// The versions of the module, the definition, and all DB elements reachable from the
+    /// arguments, sorted.
+    std::vector<DB::Tag_version> m_versions;
+
+    bool operator<( const Compiled_material_cache_key& other) const
+    {
+        if( m_definition_tag != other.m_definition_tag)
+            return m_definition_tag < other.m_definition_tag;
+        if( m_material_index != other.m_material_index)
+            return m_material_index < other.m_material_index;
+        if( m_class_compilation != other.m_class_compilation)
+            return m_class_compilation < other.m_class_compilation;
+        if( m_options != other.m_options)
+            return m_options < other.m_options;
+        return m_versions < other.m_versions;
+    }
+};
+
+/// Entry of the compiled material cache.
+struct Compiled_material_cache_entry
+{
+    /// A private copy of the arguments of the material instance.
+    mi::base::Handle<const IExpression_list> m_arguments;
+    /// The compiled material. Never handed out, callers get copies.
+    boost::shared_ptr<const Mdl_compiled_material> m_compiled_material;
+    /// The messages reported by the compilation, replayed on cache hits.
+    std::vector<Message> m_messages;
+    /// The error messages reported by the compilation, replayed on cache hits.
+    std::vector<Message> m_error_messages;
+};
+
+/// Process-wide cache of compiled materials.
+///
+/// Entries are evicted in insertion order if the cache is full.
+class Compiled_material_cache
+{
+public:
+    Compiled_material_cache() : m_size( 0) { }
+
+    /// Returns a copy of the cached compiled material for \p key and \p arguments, or \c NULL.
+    ///
+    /// On success, the messages of the compilation are added to \p context.
+    Mdl_compiled_material* lookup(
+        const IExpression_factory* ef,
+        const Compiled_material_cache_key& key,
+        const IExpression_list* arguments,
+        Execution_context* context)
+    {
+        mi::base::Lock::Block block( &m_lock);
+
+        Map::const_iterator it = m_map.find( key);
+        if( it == m_map.end())
+            return 0;
+        for( size_t i = 0, n = it->second.size(); i < n; ++i) {
+            const Compiled_material_cache_entry& entry = it->second[i];
+            if( ef->compare( entry.m_arguments.get(), arguments) != 0)
+                continue;
+            for( size_t j = 0, m = entry.m_messages.size(); j < m; ++j)
+                context->add_message( entry.m_messages[j]);
+            for( size_t j = 0, m = entry.m_error_messages.size(); j < m; ++j)
+                context->add_error_message( entry.m_error_messages[j]);
+            return new Mdl_compiled_material( *entry.m_compiled_material);
+        }
+        return 0;
+    }
+
+    /// Stores a copy of \p compiled_material and the messages in \p context for \p key and
+    /// \p arguments.
+    void insert(
+        const IExpression_factory* ef,
+        const Compiled_material_cache_key& key,
+        const IExpression_list* arguments,
+        const Mdl_compiled_material* compiled_material,
+        const Execution_context* context)
+    {
+        Compiled_material_cache_entry entry;
+        entry.m_arguments = ef->clone(
+            arguments, /*transaction*/ nullptr, /*copy_immutable_calls*/ false);
+        entry.m_compiled_material.reset( new Mdl_compiled_material( *compiled_material));
+        for( mi::Size i = 0, n = context->get_messages_count(); i < n; ++i)
+            entry.m_messages.push_back( context->get_message( i));
+        for( mi::Size i = 0, n = context->get_error_messages_count(); i < n; ++i)
+            entry.m_error_messages.push_back( context->get_error_message( i));
+
+        mi::base::Lock::Block block( &m_lock);
+
+        while( m_size >= max_size && !m_insertion_order.empty()) {
+            Map::iterator it = m_map.find( m_insertion_order.front());
+            m_insertion_order.pop_front();
+            ASSERT( M_SCENE, it != m_map.end() && !it->second.empty());
+            it->second.erase( it->second.begin());
+            if( it->second.empty())
+                m_map.erase( it);
+            --m_size;
+        }
+
+        m_map[key].push_back( entry);
+        m_insertion_order.push_back( key);
+        ++m_size;
+    }
+
+    /// Removes all entries.
+    void clear()
+    {
+        mi::base::Lock::Block block( &m_lock);
+        m_map.clear();
+        m_insertion_order.clear();
+        m_size = 0;
+    }
+
+private:
+    typedef std::map<Compiled_material_cache_key, std::vector<Compiled_material_cache_entry> > Map;
+
+    /// The maximal number of cached compiled materials.
+    static const size_t max_size = 1024;
+
+    mi::base::Lock m_lock;
+    Map m_map;
+    /// One key per cached entry. The front refers to the oldest entry for that key.
+    std::deque<Compiled_material_cache_key> m_insertion_order;
+    size_t m_size;
+};
+
+Compiled_material_cache g_compiled_material_cache;
+
+/// Encodes the values of all options of \p context.
+///
+/// All options take part since the compilation result and its messages may depend on any of
+/// them. Floats are encoded by their bit patterns, which avoids NaN issues in the ordering.
+std::string encode_context_options( const Execution_context* context)
+{
+    std::ostringstream os;
+    for( mi::Size i = 0, n = context->get_option_count(); i < n; ++i) {
+
+        const char* name = context->get_option_name( i);
+        STLEXT::Any value;
+        context->get_option( name, value);
+
+        os << name << '=';
+        if( const mi::Float32* f = STLEXT::any_cast<mi::Float32>( &value)) {
+            mi::Uint32 bits;
+            memcpy( &bits, f, sizeof( bits));
+            os << bits;
+        } else if( const bool* b = STLEXT::any_cast<bool>( &value))
+            os << (*b ? '1' : '0');
+        else if( const std::string* str = STLEXT::any_cast<std::string>( &value))
+            os << str->size() << ':' << *str;
+        else
+            ASSERT( M_SCENE, !"unsupported type of an execution context option");
+        os << ';';
+    }
+    return os.str();
+}
+
+/// Collects the versions of all DB elements reachable from \p arguments.
+///
+/// Modules and definitions are recorded, but not traversed since they do not change the result
+/// beyond their own version.
+void collect_tag_versions(
+    DB::Transaction* transaction,
+    const IExpression_list* arguments,
+    std::vector<DB::Tag_version>& versions)
+{
+    DB::Tag_set visited;
+    DB::Tag_set pending;
+    collect_references( arguments, &pending);
+
+    while( !pending.empty()) {
+
+        DB::Tag tag = *pending.begin();
+        pending.erase( pending.begin());
+        if( !visited.insert( tag).second)
+            continue;
+
+        versions.push_back( transaction->get_tag_version( tag));
+
+        SERIAL::Class_id class_id = transaction->get_class_id( tag);
+        if(    class_id == ID_MDL_MODULE
+            || class_id == ID_MDL_MATERIAL_DEFINITION
+            || class_id == ID_MDL_FUNCTION_DEFINITION)
+            continue;
+
+        DB::Tag_set references;
+        DB::Access<DB::Element_base> element( tag, transaction);
+        element->get_references( &references);
+        for( DB::Tag_set::const_iterator it = references.begin(); it != references.end(); ++it)
+            if( visited.find( *it) == visited.end())
+                pending.insert( *it);
+    }
+}
+
+} // namespace
+
+void Mdl_material_instance::clear_compiled_material_cache()
+{
+    g_compiled_material_cache.clear();
+}
+
 Mdl_compiled_material* Mdl_material_instance::create_compiled_material(
     DB::Transaction* transaction,
     bool class_compilation,
@@ -230,13 +448,29 @@ Mdl_compiled_material* Mdl_material_instance::create_compiled_material(
 {
     context->clear_messages();
 
+    ASSERT(M_SCENE, m_module_tag.is_valid());
+
+    Compiled_material_cache_key key;
+    key.m_definition_tag = m_definition_tag;
+    key.m_material_index = m_material_index;
+    key.m_class_compilation = class_compilation;
+    key.m_options = encode_context_options( context);
+    key.m_versions.push_back( transaction->get_tag_version( m_module_tag));
+    key.m_versions.push_back( transaction->get_tag_version( m_definition_tag));
+    collect_tag_versions( transaction, m_arguments.get(), key.m_versions);
+    std::sort( key.m_versions.begin(), key.m_versions.end());
+
+    Mdl_compiled_material* cached
+        = g_compiled_material_cache.lookup( m_ef.get(), key, m_arguments.get(), context);
+    if( cached)
+        return cached;
+
     mi::base::Handle<const mi::mdl::IGenerated_code_dag::IMaterial_instance> instance(
         create_dag_material_instance( transaction, /*use_temporaries*/ true, class_compilation,
            context));
     if( !instance.is_valid_interface())
         return 0;
 
-    ASSERT(M_SCENE, m_module_tag.is_valid());
     DB::Access<Mdl_material_definition> material_definition( m_definition_tag, transaction);
     DB::Access<Mdl_module> module( m_module_tag, transaction);
     const char* module_filename = module->get_filename();
@@ -247,9 +481,12 @@ Mdl_compiled_material* Mdl_material_instance::create_compiled_material(
     mi::Float32 mdl_wavelength_min = context->get_option<mi::Float32>(MDL_CTX_OPTION_WAVELENGTH_MIN);
     mi::Float32 mdl_wavelength_max = context->get_option<mi::Float32>(MDL_CTX_OPTION_WAVELENGTH_MAX);
 
-    return new Mdl_compiled_material(
+    Mdl_compiled_material* compiled_material = new Mdl_compiled_material(
         transaction, instance.get(), module_filename, module_name,
         mdl_meters_per_scene_unit, mdl_wavelength_min, mdl_wavelength_max);
+    g_compiled_material_cache.insert(
+        m_ef.get(), key, m_arguments.get(), compiled_material, context);
+    return compiled_material;
 }
 
 namespace{
@@ -40,20 +40,29 @@
 #include "mdl_elements_detail.h"
 #include "mdl_elements_utilities.h"
 
+#include <algorithm>
+#include <map>
+#include <set>
 #include <sstream>
 #include <mi/mdl/mdl_code_generators.h>
+#include <mi/mdl/mdl_declarations.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/mdl/mdl_mdl.h>
 #include <mi/mdl/mdl_modules.h>
 #include <mi/mdl/mdl_definitions.h>
+#include <mi/mdl/mdl_names.h>
+#include <mi/mdl/mdl_printers.h>
+#include <mi/mdl/mdl_symbols.h>
 #include <mi/mdl/mdl_thread_context.h>
 #include <mi/neuraylib/istring.h>
 #include <base/system/main/access_module.h>
 #include <boost/core/ignore_unused.hpp>
+#include <boost/core/noncopyable.hpp>
 #include <base/lib/log/i_log_logger.h>
 #include <base/data/db/i_db_access.h>
 #include <base/data/db/i_db_transaction.h>
 #include <base/data/serial/i_serializer.h>
+#include <mdl/codegenerators/generator_code/generator_code_hash.h>
 #include <mdl/integration/mdlnr/i_mdlnr.h>
 #include <mdl/compiler/compilercore/compilercore_modules.h>
 #include <io/scene/scene/i_scene_journal_types.h>
@@ -1374,6 +1383,62 @@ mi::Sint32 Mdl_module::add_annotation(
     return 0;
 }
 
+namespace {
+
+/// Compiles the DAG representation of a module.
+///
+/// The resource literals of the DAG representation still need to be updated. The import entries of the module need to be restored.
+///
+/// \param transaction     The DB transaction to use.
+/// \param mdl             The IMDL instance.
+/// \param module          The module to compile.
+/// \param[inout] context  Execution context used to pass options to and store messages from
+///                        the compiler.
+/// \param[out] code_dag   The DAG representation of the module.
+/// \return
+///           -  0: Success.
+///           - -2: Failed to compile the module.
+mi::Sint32 compile_code_dag(
+    DB::Transaction* transaction,
+    mi::mdl::IMDL* mdl,
+    const mi::mdl::IModule* module,
+    Execution_context* context,
+    mi::base::Handle<mi::mdl::IGenerated_code_dag>& code_dag)
+{
+    mi::base::Handle<mi::mdl::ICode_generator_dag> generator_dag
+        = mi::base::make_handle( mdl->load_code_generator( "dag"))
+            .get_interface<mi::mdl::ICode_generator_dag>();
+
+    mi::mdl::Options& options = generator_dag->access_options();
+
+    // We support local entity usage inside MDL materials in neuray, but ...
+    options.set_option( MDL_CG_DAG_OPTION_NO_LOCAL_FUNC_CALLS, "false");
+    /// ... we need entries for those in the DB, hence generate them
+    options.set_option( MDL_CG_DAG_OPTION_INCLUDE_LOCAL_ENTITIES, "true");
+
+    const std::string internal_space =
+        context->get_option<std::string>(MDL_CTX_OPTION_INTERNAL_SPACE);
+    options.set_option(MDL_CG_OPTION_INTERNAL_SPACE, internal_space.c_str());
+
+    mi::base::Handle<mi::mdl::IGenerated_code> code( generator_dag->compile( module));
+    if( !code.is_valid_interface())
+        return -2;
+
+    const mi::mdl::Messages& code_messages = code->access_messages();
+    report_messages( code_messages, context);
+
+    // Treat error messages as compilation failures, e.g., "Call to unexported function '...' is
+    // not allowed in this context".
+    if( code_messages.get_error_message_count() > 0)
+        return -2;
+
+    ASSERT( M_SCENE, code->get_kind() == mi::mdl::IGenerated_code::CK_DAG);
+    code_dag = code->get_interface<mi::mdl::IGenerated_code_dag>();
+    return 0;
+}
+
+} // namespace
+
 mi::Sint32 Mdl_module::create_module_internal(
     DB::Transaction* transaction,
     mi::mdl::IMDL* mdl,
@@ -1409,21 +1474,6 @@ mi::Sint32 Mdl_module::create_module_internal(
     }
 
     // Compile the module.
-    mi::base::Handle<mi::mdl::ICode_generator_dag> generator_dag
-        = mi::base::make_handle( mdl->load_code_generator( "dag"))
-            .get_interface<mi::mdl::ICode_generator_dag>();
-
-    mi::mdl::Options& options = generator_dag->access_options();
-
-    // We support local entity usage inside MDL materials in neuray, but ...
-    options.set_option( MDL_CG_DAG_OPTION_NO_LOCAL_FUNC_CALLS, "false");
-    /// ... we need entries for those in the DB, hence generate them
-    options.set_option( MDL_CG_DAG_OPTION_INCLUDE_LOCAL_ENTITIES, "true");
-
-    const std::string internal_space =
-        context->get_option<std::string>(MDL_CTX_OPTION_INTERNAL_SPACE);
-    options.set_option(MDL_CG_OPTION_INTERNAL_SPACE, internal_space.c_str());
-
     Module_cache module_cache( transaction);
     if( !module->restore_import_entries( &module_cache)) {
         LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
@@ -1431,21 +1481,10 @@ mi::Sint32 Mdl_module::create_module_internal(
         return -4;
     }
     Drop_import_scope scope( module);
-    mi::base::Handle<mi::mdl::IGenerated_code> code( generator_dag->compile( module));
-    if( !code.is_valid_interface())
-        return -2;
-
-    const mi::mdl::Messages& code_messages = code->access_messages();
-    report_messages( code_messages, context);
-
-    // Treat error messages as compilation failures, e.g., "Call to unexported function '...' is
-    // not allowed in this context".
-    if( code_messages.get_error_message_count() > 0)
-        return -2;
-
-    ASSERT( M_SCENE, code->get_kind() == mi::mdl::IGenerated_code::CK_DAG);
-    mi::base::Handle<mi::mdl::IGenerated_code_dag> code_dag(
-        code->get_interface<mi::mdl::IGenerated_code_dag>());
+    mi::base::Handle<mi::mdl::IGenerated_code_dag> code_dag;
+    mi::Sint32 compile_result = compile_code_dag( transaction, mdl, module, context, code_dag);
+    if( compile_result < 0)
+        return compile_result;
 
     update_resource_literals( transaction, code_dag.get(), module_filename, module_name);
 
@@ -1557,6 +1596,748 @@ mi::Sint32 Mdl_module::create_module_internal(
     return 0;
 }
 
+namespace {
+
+/// Feeds everything written to it into an MD5 hasher.
+class Hashing_output_stream : public mi::base::Interface_implement<mi::mdl::IOutput_stream>
+{
+public:
+    Hashing_output_stream() : m_hasher( 0) { }
+    void set_hasher( mi::mdl::MD5_hasher* hasher) { m_hasher = hasher; }
+    void write_char( char c) { m_hasher->update( c); }
+    void write( const char* string) { m_hasher->update( string); }
+    void flush() { }
+private:
+    mi::mdl::MD5_hasher* m_hasher;
+};
+
+/// Maps DAG names of definitions to their fingerprints.
+typedef std::map<std::string, std::string> Fingerprint_map;
+
+/// Returns the digest of a hasher.
+std::string get_digest( mi::mdl::MD5_hasher& hasher)
+{
+    unsigned char digest[16];
+    hasher.final( digest);
+    return std::string( reinterpret_cast<const char*>( digest), sizeof( digest));
+}
+
+/// Adds a digest to a hasher.
+void add_digest( mi::mdl::MD5_hasher& hasher, const std::string& digest)
+{
+    hasher.update( reinterpret_cast<const unsigned char*>( digest.data()), digest.size());
+}
+
+/// Returns the simple name of a definition, e.g., "f" for "::pkg::mod::f(float)".
+std::string get_simple_name( const char* dag_name)
+{
+    std::string name( dag_name);
+    size_t paren = name.find( '(');
+    if( paren != std::string::npos)
+        name.erase( paren);
+    size_t colons = name.rfind( "::");
+    if( colons != std::string::npos)
+        name.erase( 0, colons + 2);
+    return name;
+}
+
+/// Computes fingerprints of the definitions of a module for reloading.
+///
+/// Function bodies are not part of the DAG representation, so functions are fingerprinted by
+/// their printed declarations. Materials are fingerprinted by their DAG representation. Both
+/// include the fingerprints of the called definitions of the same module and of the modules
+/// recompiled before. Declarations of types, constants, and annotations as well as imports may
+/// change the meaning of any definition, they are hashed into all fingerprints.
+class Definition_fingerprinter : public boost::noncopyable
+{
+public:
+    /// Constructor.
+    ///
+    /// \param mdl        The IMDL instance.
+    /// \param module     The module.
+    /// \param code_dag   The DAG representation of the module.
+    /// \param called     The fingerprints of the definitions of other modules.
+    Definition_fingerprinter(
+        mi::mdl::IMDL* mdl,
+        const mi::mdl::IModule* module,
+        const mi::mdl::IGenerated_code_dag* code_dag,
+        const Fingerprint_map& called)
+      : m_code_dag( code_dag),
+        m_called( called),
+        m_stream( new Hashing_output_stream()),
+        m_printer( mdl->create_printer( m_stream.get()))
+    {
+        // Functions and materials are grouped by their simple name, all other declarations
+        // contribute to the global digest.
+        std::map<std::string, mi::mdl::MD5_hasher> hashers;
+        mi::mdl::MD5_hasher global_hasher;
+        mi::mdl::MD5_hasher module_hasher;
+        for( int i = 0, n = module->get_declaration_count(); i < n; ++i) {
+            const mi::mdl::IDeclaration* decl = module->get_declaration( i);
+            mi::mdl::MD5_hasher* hasher = &global_hasher;
+            if( const mi::mdl::IDeclaration_function* decl_func
+                = mi::mdl::as<mi::mdl::IDeclaration_function>( decl))
+                hasher = &hashers[decl_func->get_name()->get_symbol()->get_name()];
+            else if( decl->get_kind() == mi::mdl::IDeclaration::DK_MODULE)
+                hasher = 0; // module annotations do not affect the definitions
+            if( hasher) {
+                m_stream->set_hasher( hasher);
+                m_printer->print( decl);
+            }
+            m_stream->set_hasher( &module_hasher);
+            m_printer->print( decl);
+        }
+        m_global_digest = get_digest( global_hasher);
+        m_module_digest = get_digest( module_hasher);
+        for( std::map<std::string, mi::mdl::MD5_hasher>::iterator it = hashers.begin();
+             it != hashers.end(); ++it)
+            m_declaration_digests[it->first] = get_digest( it->second);
+
+        mi::Uint32 function_count = code_dag->get_function_count();
+        for( mi::Uint32 i = 0; i < function_count; ++i)
+            m_function_indices[code_dag->get_function_name( i)] = i;
+        m_function_fingerprints.resize( function_count);
+        m_function_busy.resize( function_count, false);
+
+        mi::Uint32 material_count = code_dag->get_material_count();
+        for( mi::Uint32 i = 0; i < material_count; ++i)
+            m_material_indices[code_dag->get_material_name( i)] = i;
+        m_material_fingerprints.resize( material_count);
+        m_material_busy.resize( material_count, false);
+    }
+
+    /// Returns the digest of all declarations of the module.
+    const std::string& get_module_digest() const { return m_module_digest; }
+
+    /// Returns the digest of a type.
+    std::string get_type_digest( const mi::mdl::IType* type)
+    {
+        mi::mdl::MD5_hasher hasher;
+        print( hasher, type);
+        return get_digest( hasher);
+    }
+
+    /// Returns the fingerprint of a function.
+    const std::string& get_function_fingerprint( mi::Uint32 index)
+    {
+        std::string& fingerprint = m_function_fingerprints[index];
+        if( !fingerprint.empty())
+            return fingerprint;
+
+        m_function_busy[index] = true;
+
+        mi::mdl::MD5_hasher hasher;
+        hasher.update( 'F');
+        add_digest( hasher, m_global_digest);
+        const char* name = m_code_dag->get_function_name( index);
+        hasher.update( name);
+        std::map<std::string, std::string>::const_iterator it
+            = m_declaration_digests.find( get_simple_name( name));
+        if( it != m_declaration_digests.end())
+            add_digest( hasher, it->second);
+        hasher.update( mi::Uint32( m_code_dag->get_function_semantics( index)));
+        print( hasher, m_code_dag->get_function_return_type( index));
+
+        int reference_count = m_code_dag->get_function_references_count( index);
+        for( int i = 0; i < reference_count; ++i)
+            hash_callee( hasher, m_code_dag->get_function_reference( index, i));
+
+        m_function_busy[index] = false;
+        fingerprint = get_digest( hasher);
+        return fingerprint;
+    }
+
+    /// Returns the fingerprint of a material.
+    const std::string& get_material_fingerprint( mi::Uint32 index)
+    {
+        std::string& fingerprint = m_material_fingerprints[index];
+        if( !fingerprint.empty())
+            return fingerprint;
+
+        m_material_busy[index] = true;
+
+        mi::mdl::MD5_hasher hasher;
+        Node_map visited;
+        hasher.update( 'M');
+        add_digest( hasher, m_global_digest);
+        hasher.update( m_code_dag->get_material_name( index));
+        hasher.update( mi::Uint32( m_code_dag->get_material_exported( index)));
+
+        int parameter_count = m_code_dag->get_material_parameter_count( index);
+        hasher.update( mi::Sint32( parameter_count));
+        for( int p = 0; p < parameter_count; ++p) {
+            hasher.update( m_code_dag->get_material_parameter_name( index, p));
+            print( hasher, m_code_dag->get_material_parameter_type( index, p));
+            const mi::mdl::DAG_node* def = m_code_dag->get_material_parameter_default( index, p);
+            if( def)
+                hash_node( hasher, def, visited);
+            else
+                hasher.update( '-');
+            int annotation_count
+                = m_code_dag->get_material_parameter_annotation_count( index, p);
+            hasher.update( mi::Sint32( annotation_count));
+            for( int a = 0; a < annotation_count; ++a)
+                hash_node( hasher,
+                    m_code_dag->get_material_parameter_annotation( index, p, a), visited);
+        }
+
+        int annotation_count = m_code_dag->get_material_annotation_count( index);
+        hasher.update( mi::Sint32( annotation_count));
+        for( int a = 0; a < annotation_count; ++a)
+            hash_node( hasher, m_code_dag->get_material_annotation( index, a), visited);
+
+        int temporary_count = m_code_dag->get_material_temporary_count( index);
+        hasher.update( mi::Sint32( temporary_count));
+        for( int t = 0; t < temporary_count; ++t)
+            hash_node( hasher, m_code_dag->get_material_temporary( index, t), visited);
+
+        hash_node( hasher, m_code_dag->get_material_value( index), visited);
+
+        m_material_busy[index] = false;
+        fingerprint = get_digest( hasher);
+        return fingerprint;
+    }
+
+private:
+    typedef std::map<const mi::mdl::DAG_node*, mi::Uint32> Node_map;
+
+    /// Prints a type into a hasher.
+    void print( mi::mdl::MD5_hasher& hasher, const mi::mdl::IType* type)
+    {
+        m_stream->set_hasher( &hasher);
+        m_printer->print( type);
+    }
+
+    /// Prints a value into a hasher.
+    ///
+    /// Resource values are hashed without their tags, which are only assigned to the recompiled
+    /// module after the comparison.
+    void print( mi::mdl::MD5_hasher& hasher, const mi::mdl::IValue* value)
+    {
+        if( const mi::mdl::IValue_resource* resource
+                = mi::mdl::as<mi::mdl::IValue_resource>( value)) {
+            print( hasher, resource->get_type());
+            hasher.update( resource->get_string_value());
+            if( const mi::mdl::IValue_texture* texture
+                    = mi::mdl::as<mi::mdl::IValue_texture>( value))
+                hasher.update( mi::Uint32( texture->get_gamma_mode()));
+            return;
+        }
+
+        m_stream->set_hasher( &hasher);
+        m_printer->print( value);
+    }
+
+    /// Hashes a called definition, i.e., its name and its fingerprint if it is known.
+    void hash_callee( mi::mdl::MD5_hasher& hasher, const char* name)
+    {
+        hasher.update( name);
+
+        std::map<std::string, mi::Uint32>::const_iterator it = m_function_indices.find( name);
+        if( it != m_function_indices.end()) {
+            if( !m_function_busy[it->second])
+                add_digest( hasher, get_function_fingerprint( it->second));
+            return;
+        }
+        it = m_material_indices.find( name);
+        if( it != m_material_indices.end()) {
+            if( !m_material_busy[it->second])
+                add_digest( hasher, get_material_fingerprint( it->second));
+            return;
+        }
+        Fingerprint_map::const_iterator it_called = m_called.find( name);
+        if( it_called != m_called.end())
+            add_digest( hasher, it_called->second);
+    }
+
+    /// Hashes a DAG node. Shared nodes are hashed only once, later uses refer to the first one.
+    void hash_node(
+        mi::mdl::MD5_hasher& hasher, const mi::mdl::DAG_node* node, Node_map& visited)
+    {
+        Node_map::const_iterator it = visited.find( node);
+        if( it != visited.end()) {
+            hasher.update( 'R');
+            hasher.update( it->second);
+            return;
+        }
+        mi::Uint32 id = mi::Uint32( visited.size());
+        visited[node] = id;
+
+        switch( node->get_kind()) {
+            case mi::mdl::DAG_node::EK_CONSTANT: {
+                const mi::mdl::DAG_constant* constant
+                    = mi::mdl::as<mi::mdl::DAG_constant>( node);
+                hasher.update( 'C');
+                print( hasher, constant->get_type());
+                print( hasher, constant->get_value());
+                break;
+            }
+            case mi::mdl::DAG_node::EK_TEMPORARY: {
+                const mi::mdl::DAG_temporary* temporary
+                    = mi::mdl::as<mi::mdl::DAG_temporary>( node);
+                hasher.update( 'T');
+                hasher.update( mi::Sint32( temporary->get_index()));
+                break;
+            }
+            case mi::mdl::DAG_node::EK_PARAMETER: {
+                const mi::mdl::DAG_parameter* parameter
+                    = mi::mdl::as<mi::mdl::DAG_parameter>( node);
+                hasher.update( 'P');
+                hasher.update( mi::Sint32( parameter->get_index()));
+                break;
+            }
+            case mi::mdl::DAG_node::EK_CALL: {
+                const mi::mdl::DAG_call* call = mi::mdl::as<mi::mdl::DAG_call>( node);
+                hasher.update( 'K');
+                hash_callee( hasher, call->get_name());
+                int argument_count = call->get_argument_count();
+                hasher.update( mi::Sint32( argument_count));
+                for( int i = 0; i < argument_count; ++i) {
+                    hasher.update( call->get_parameter_name( i));
+                    hash_node( hasher, call->get_argument( i), visited);
+                }
+                break;
+            }
+        }
+    }
+
+    const mi::mdl::IGenerated_code_dag* m_code_dag;
+    const Fingerprint_map& m_called;
+    mi::base::Handle<Hashing_output_stream> m_stream;
+    mi::base::Handle<mi::mdl::IPrinter> m_printer;
+
+    std::string m_module_digest;
+    std::string m_global_digest;
+    std::map<std::string, std::string> m_declaration_digests;
+
+    std::map<std::string, mi::Uint32> m_function_indices;
+    std::vector<std::string> m_function_fingerprints;
+    std::vector<bool> m_function_busy;
+
+    std::map<std::string, mi::Uint32> m_material_indices;
+    std::vector<std::string> m_material_fingerprints;
+    std::vector<bool> m_material_busy;
+};
+
+/// How the DB element of a definition is updated by a reload.
+enum Definition_update {
+    DU_UNCHANGED, ///< The definition did not change.
+    DU_MOVED,     ///< Only the index of the definition in its module changed.
+    DU_CHANGED,   ///< The definition changed.
+    DU_NEW        ///< The definition is new.
+};
+
+/// The definitions of one kind of a reloaded module.
+struct Reloaded_definitions
+{
+    std::vector<std::string> m_db_names;
+    std::vector<DB::Tag> m_tags;
+    std::vector<Definition_update> m_updates;
+};
+
+/// A recompiled module.
+struct Reloaded_module
+{
+    DB::Tag m_tag;
+    mi::base::Handle<const mi::mdl::IModule> m_module;
+    mi::base::Handle<mi::mdl::IGenerated_code_dag> m_code_dag;
+    /// Invalid tags for imports without DB element, which are created after the comparison.
+    std::vector<DB::Tag> m_imports;
+    Reloaded_definitions m_functions;
+    Reloaded_definitions m_materials;
+    bool m_changed;
+};
+
+/// Indicates whether two materials have the same parameter names and types.
+bool equal_material_parameters(
+    Definition_fingerprinter& old_fingerprinter,
+    const mi::mdl::IGenerated_code_dag* old_code_dag,
+    mi::Uint32 old_index,
+    Definition_fingerprinter& new_fingerprinter,
+    const mi::mdl::IGenerated_code_dag* new_code_dag,
+    mi::Uint32 new_index)
+{
+    int count = old_code_dag->get_material_parameter_count( old_index);
+    if( new_code_dag->get_material_parameter_count( new_index) != count)
+        return false;
+
+    for( int i = 0; i < count; ++i) {
+        if( strcmp( old_code_dag->get_material_parameter_name( old_index, i),
+                new_code_dag->get_material_parameter_name( new_index, i)) != 0)
+            return false;
+        if( old_fingerprinter.get_type_digest(
+                old_code_dag->get_material_parameter_type( old_index, i))
+            != new_fingerprinter.get_type_digest(
+                new_code_dag->get_material_parameter_type( new_index, i)))
+            return false;
+    }
+    return true;
+}
+
+/// Appends the modules importing \p module_tag (directly or indirectly) and then the module
+/// itself to \p post_order.
+void collect_importing_modules(
+    DB::Tag module_tag,
+    const std::map<DB::Tag, std::vector<DB::Tag> >& importers,
+    std::set<DB::Tag>& visited,
+    std::vector<DB::Tag>& post_order)
+{
+    if( !visited.insert( module_tag).second)
+        return;
+
+    std::map<DB::Tag, std::vector<DB::Tag> >::const_iterator it = importers.find( module_tag);
+    if( it != importers.end())
+        for( size_t i = 0, n = it->second.size(); i < n; ++i)
+            collect_importing_modules( it->second[i], importers, visited, post_order);
+
+    post_order.push_back( module_tag);
+}
+
+/// Returns the module and all modules in the DB that import it, directly or indirectly, such
+/// that each module comes after the modules it imports.
+std::vector<DB::Tag> get_modules_to_reload( DB::Transaction* transaction, DB::Tag module_tag)
+{
+    std::vector<DB::Tag> module_tags;
+    transaction->get_tags_by_class_id( Mdl_module::id, module_tags);
+
+    std::map<DB::Tag, std::vector<DB::Tag> > importers;
+    for( size_t i = 0, n = module_tags.size(); i < n; ++i) {
+        DB::Access<Mdl_module> module( module_tags[i], transaction);
+        for( mi::Size j = 0, m = module->get_import_count(); j < m; ++j)
+            importers[module->get_import( j)].push_back( module_tags[i]);
+    }
+
+    // the reversed post-order of the importer graph is a topological order
+    std::set<DB::Tag> visited;
+    std::vector<DB::Tag> post_order;
+    collect_importing_modules( module_tag, importers, visited, post_order);
+    return std::vector<DB::Tag>( post_order.rbegin(), post_order.rend());
+}
+
+} // namespace
+
+mi::Sint32 Mdl_module::reload_module(
+    DB::Transaction* transaction,
+    const char* module_name,
+    mi::neuraylib::IReader* module_source,
+    Execution_context* context)
+{
+    ASSERT( M_SCENE, module_name);
+    ASSERT( M_SCENE, context);
+
+    context->clear_messages();
+
+    SYSTEM::Access_module<MDLC::Mdlc_module> mdlc_module( false);
+    mi::base::Handle<mi::mdl::IMDL> mdl( mdlc_module->get_mdl());
+
+    // Reject invalid module names and builtin modules.
+    if( !is_valid_module_name( module_name, mdl.get()) || mdl->is_builtin_module( module_name))
+        return -1;
+
+    std::string db_module_name = add_mdl_db_prefix( module_name);
+    DB::Tag db_module_tag = transaction->name_to_tag( db_module_name.c_str());
+    if( !db_module_tag)
+        return -5;
+    if( transaction->get_class_id( db_module_tag) != Mdl_module::id) {
+        LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+            "DB name for module \"%s\" already in use.", db_module_name.c_str());
+        return -3;
+    }
+
+    std::vector<DB::Tag> module_tags = get_modules_to_reload( transaction, db_module_tag);
+    ASSERT( M_SCENE, !module_tags.empty() && module_tags[0] == db_module_tag);
+
+    // Recompile and compare all modules before the first DB element is replaced. Recompiled
+    // modules are passed to the compiler via the module cache, such that the modules importing
+    // them are compiled against the new versions.
+    Module_cache::Override_map overrides;
+    Module_cache module_cache( transaction, &overrides);
+    mi::base::Handle<mi::mdl::IThread_context> ctx( mdl->create_thread_context());
+    ctx->access_options().set_option( MDL_OPTION_EXPERIMENTAL_FEATURES,
+        context->get_option<bool>( MDL_CTX_OPTION_EXPERIMENTAL) ? "true" : "false");
+
+    Fingerprint_map old_fingerprints;
+    Fingerprint_map new_fingerprints;
+    std::vector<Reloaded_module> reloaded;
+    reloaded.reserve( module_tags.size());
+
+    for( size_t m = 0, n = module_tags.size(); m < n; ++m) {
+        DB::Access<Mdl_module> old_module( module_tags[m], transaction);
+        std::string name = old_module->get_mdl_name();
+
+        // Hide the current version from the compiler.
+        overrides[name] = mi::base::Handle<const mi::mdl::IModule>();
+
+        mi::base::Handle<const mi::mdl::IModule> module;
+        if( m == 0 && module_source) {
+            Input_stream module_source_stream( module_source);
+            module = mdl->load_module_from_stream(
+                ctx.get(), &module_cache, name.c_str(), &module_source_stream);
+        } else if( old_module->get_filename()) {
+            module = mdl->load_module( ctx.get(), name.c_str(), &module_cache);
+        } else if( m == 0) {
+            LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
+                "Module \"%s\" was not loaded from file and can only be reloaded from a string.",
+                name.c_str());
+            return -2;
+        } else {
+            // Its current version was compiled against the old version of the reloaded module,
+            // keeping it would leave the DB inconsistent.
+            LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_IO,
+                "Cannot reload module \"%s\": the importing module \"%s\" was not loaded from "
+                "file and cannot be recompiled.", module_name, name.c_str());
+            return -2;
+        }
+        if( !module.is_valid_interface()) {
+            report_messages( ctx->access_messages(), context);
+            return -2;
+        }
+        report_messages( module->access_messages(), context);
+        if( !module->is_valid())
+            return -2;
+
+        Reloaded_module state;
+        state.m_tag = module_tags[m];
+        state.m_module = module;
+
+        if( !module->restore_import_entries( &module_cache)) {
+            LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                "Failed to restore imports of module \"%s\".", module->get_name());
+            return -4;
+        }
+        Drop_import_scope scope( module.get());
+        mi::Sint32 result = compile_code_dag(
+            transaction, mdl.get(), module.get(), context, state.m_code_dag);
+        if( result < 0)
+            return result;
+
+        // Collect tags of imported modules. DB elements for new imports are created later.
+        for( mi::Uint32 i = 0, count = module->get_import_count(); i < count; ++i) {
+            mi::base::Handle<const mi::mdl::IModule> import( module->get_import( i));
+            std::string db_import_name = add_mdl_db_prefix( import->get_name());
+            DB::Tag import_tag = transaction->name_to_tag( db_import_name.c_str());
+            if( import_tag && transaction->get_class_id( import_tag) != Mdl_module::id)
+                return -3;
+            state.m_imports.push_back( import_tag);
+        }
+
+        // Compare the definitions with the current ones.
+        mi::base::Handle<const mi::mdl::IModule> old_mdl_module( old_module->get_mdl_module());
+        mi::base::Handle<const mi::mdl::IGenerated_code_dag> old_code_dag(
+            old_module->get_code_dag());
+        ASSERT( M_SCENE, old_code_dag);
+        Definition_fingerprinter old_fingerprinter(
+            mdl.get(), old_mdl_module.get(), old_code_dag.get(), old_fingerprints);
+        Definition_fingerprinter new_fingerprinter(
+            mdl.get(), module.get(), state.m_code_dag.get(), new_fingerprints);
+        const mi::mdl::IGenerated_code_dag* code_dag = state.m_code_dag.get();
+
+        std::map<std::string, mi::Uint32> old_functions;
+        for( mi::Uint32 i = 0, count = old_code_dag->get_function_count(); i < count; ++i)
+            old_functions[old_code_dag->get_function_name( i)] = i;
+
+        mi::Uint32 function_count = code_dag->get_function_count();
+        for( mi::Uint32 i = 0; i < function_count; ++i) {
+            const char* function_name = code_dag->get_function_name( i);
+            std::string db_function_name = add_mdl_db_prefix( function_name);
+            const std::string& fingerprint = new_fingerprinter.get_function_fingerprint( i);
+            new_fingerprints[function_name] = fingerprint;
+
+            DB::Tag function_tag;
+            Definition_update update;
+            std::map<std::string, mi::Uint32>::iterator it = old_functions.find( function_name);
+            if( it == old_functions.end()) {
+                if( transaction->name_to_tag( db_function_name.c_str())) {
+                    LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                        "DB name for function definition \"%s\" already in use.",
+                        db_function_name.c_str());
+                    return -3;
+                }
+                function_tag = transaction->reserve_tag();
+                update = DU_NEW;
+            } else {
+                mi::Uint32 old_index = it->second;
+                old_functions.erase( it);
+                if( old_fingerprinter.get_type_digest(
+                        old_code_dag->get_function_return_type( old_index))
+                    != new_fingerprinter.get_type_digest(
+                        code_dag->get_function_return_type( i))) {
+                    LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                        "Cannot reload module \"%s\": the return type of \"%s\" changed.",
+                        name.c_str(), function_name);
+                    return -6;
+                }
+                const std::string& old_fingerprint
+                    = old_fingerprinter.get_function_fingerprint( old_index);
+                old_fingerprints[function_name] = old_fingerprint;
+                function_tag = old_module->get_function( old_index);
+                update = fingerprint != old_fingerprint ? DU_CHANGED
+                    : old_index != i ? DU_MOVED : DU_UNCHANGED;
+            }
+            state.m_functions.m_db_names.push_back( db_function_name);
+            state.m_functions.m_tags.push_back( function_tag);
+            state.m_functions.m_updates.push_back( update);
+        }
+
+        std::map<std::string, mi::Uint32> old_materials;
+        for( mi::Uint32 i = 0, count = old_code_dag->get_material_count(); i < count; ++i)
+            old_materials[old_code_dag->get_material_name( i)] = i;
+
+        mi::Uint32 material_count = code_dag->get_material_count();
+        for( mi::Uint32 i = 0; i < material_count; ++i) {
+            const char* material_name = code_dag->get_material_name( i);
+            std::string db_material_name = add_mdl_db_prefix( material_name);
+            const std::string& fingerprint = new_fingerprinter.get_material_fingerprint( i);
+            new_fingerprints[material_name] = fingerprint;
+
+            DB::Tag material_tag;
+            Definition_update update;
+            std::map<std::string, mi::Uint32>::iterator it = old_materials.find( material_name);
+            if( it == old_materials.end()) {
+                if( transaction->name_to_tag( db_material_name.c_str())) {
+                    LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                        "DB name for material definition \"%s\" already in use.",
+                        db_material_name.c_str());
+                    return -3;
+                }
+                material_tag = transaction->reserve_tag();
+                update = DU_NEW;
+            } else {
+                mi::Uint32 old_index = it->second;
+                old_materials.erase( it);
+                // Unlike for functions, the parameters are not part of the DB name. Material
+                // instances of the definition would no longer match its parameters.
+                if( !equal_material_parameters( old_fingerprinter, old_code_dag.get(), old_index,
+                        new_fingerprinter, code_dag, i)) {
+                    LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                        "Cannot reload module \"%s\": the parameters of \"%s\" changed.",
+                        name.c_str(), material_name);
+                    return -6;
+                }
+                const std::string& old_fingerprint
+                    = old_fingerprinter.get_material_fingerprint( old_index);
+                old_fingerprints[material_name] = old_fingerprint;
+                material_tag = old_module->get_material( old_index);
+                update = fingerprint != old_fingerprint ? DU_CHANGED
+                    : old_index != i ? DU_MOVED : DU_UNCHANGED;
+            }
+            state.m_materials.m_db_names.push_back( db_material_name);
+            state.m_materials.m_tags.push_back( material_tag);
+            state.m_materials.m_updates.push_back( update);
+        }
+
+        // The DB elements of removed definitions might still be referenced.
+        if( !old_functions.empty() || !old_materials.empty()) {
+            const std::string& removed = !old_functions.empty()
+                ? old_functions.begin()->first : old_materials.begin()->first;
+            LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                "Cannot reload module \"%s\": \"%s\" was removed or its signature changed.",
+                name.c_str(), removed.c_str());
+            return -6;
+        }
+
+        std::vector<DB::Tag> old_imports;
+        for( mi::Size i = 0, count = old_module->get_import_count(); i < count; ++i)
+            old_imports.push_back( old_module->get_import( i));
+
+        state.m_changed = old_imports != state.m_imports
+            || old_fingerprinter.get_module_digest() != new_fingerprinter.get_module_digest()
+            || std::count( state.m_functions.m_updates.begin(),
+                   state.m_functions.m_updates.end(), DU_UNCHANGED)
+                != std::ptrdiff_t( function_count)
+            || std::count( state.m_materials.m_updates.begin(),
+                   state.m_materials.m_updates.end(), DU_UNCHANGED)
+                != std::ptrdiff_t( material_count);
+
+        overrides[name] = module;
+        reloaded.push_back( state);
+    }
+
+    // Create DB elements for new imports. New imports only occur in changed modules.
+    for( size_t m = 0, n = reloaded.size(); m < n; ++m) {
+        Reloaded_module& state = reloaded[m];
+        for( size_t i = 0, count = state.m_imports.size(); i < count; ++i) {
+            if( state.m_imports[i])
+                continue;
+            mi::base::Handle<const mi::mdl::IModule> import(
+                state.m_module->get_import( mi::Uint32( i)));
+            std::string db_import_name = add_mdl_db_prefix( import->get_name());
+            DB::Tag import_tag = transaction->name_to_tag( db_import_name.c_str());
+            if( !import_tag && create_module_internal(
+                transaction, mdl.get(), import.get(), context, &import_tag) < 0) {
+                LOG::mod_log->error( M_SCENE, LOG::Mod_log::C_DATABASE,
+                    "Failed to initialize imported module \"%s\".", import->get_name());
+                return -4;
+            }
+            state.m_imports[i] = import_tag;
+        }
+    }
+
+    // Replace the DB elements of changed modules and definitions.
+    DB::Privacy_level privacy_level = transaction->get_scope()->get_level();
+    mi::Sint32 result = 1;
+
+    for( size_t m = 0, n = reloaded.size(); m < n; ++m) {
+        Reloaded_module& state = reloaded[m];
+        if( !state.m_changed)
+            continue;
+        result = 0;
+
+        const mi::mdl::IModule* module = state.m_module.get();
+        const char* name = module->get_name();
+        const char* filename = module->get_filename();
+        if( filename[0] == '\0')
+            filename = 0;
+        update_resource_literals( transaction, state.m_code_dag.get(), filename, name);
+
+        Mdl_module* db_module = new Mdl_module( transaction, mdl.get(), module,
+            state.m_code_dag.get(), state.m_imports, state.m_functions.m_tags,
+            state.m_materials.m_tags);
+
+        mi::Uint32 changed_count = 0;
+        mi::Uint32 new_count = 0;
+
+        for( mi::Uint32 i = 0, count = mi::Uint32( state.m_functions.m_tags.size());
+             i < count; ++i) {
+            Definition_update update = state.m_functions.m_updates[i];
+            if( update == DU_UNCHANGED)
+                continue;
+            Mdl_function_definition* db_function = new Mdl_function_definition( transaction,
+                state.m_tag, state.m_functions.m_tags[i], state.m_code_dag.get(), i, filename,
+                name);
+            transaction->store_for_reference_counting( state.m_functions.m_tags[i],
+                db_function, state.m_functions.m_db_names[i].c_str(), privacy_level,
+                update == DU_MOVED ? DB::JOURNAL_NONE : DB::JOURNAL_ALL);
+            changed_count += update == DU_CHANGED ? 1 : 0;
+            new_count     += update == DU_NEW     ? 1 : 0;
+        }
+
+        for( mi::Uint32 i = 0, count = mi::Uint32( state.m_materials.m_tags.size());
+             i < count; ++i) {
+            Definition_update update = state.m_materials.m_updates[i];
+            if( update == DU_UNCHANGED)
+                continue;
+            Mdl_material_definition* db_material = new Mdl_material_definition( transaction,
+                state.m_tag, state.m_materials.m_tags[i], state.m_code_dag.get(), i, filename,
+                name);
+            transaction->store_for_reference_counting( state.m_materials.m_tags[i],
+                db_material, state.m_materials.m_db_names[i].c_str(), privacy_level,
+                update == DU_MOVED ? DB::JOURNAL_NONE : DB::JOURNAL_ALL);
+            changed_count += update == DU_CHANGED ? 1 : 0;
+            new_count     += update == DU_NEW     ? 1 : 0;
+        }
+
+        std::string db_name = add_mdl_db_prefix( name);
+        transaction->store( state.m_tag, db_module, db_name.c_str(), privacy_level);
+
+        LOG::mod_log->info( M_SCENE, LOG::Mod_log::C_IO,
+            "Reloaded module \"%s\" (%u changed and %u new definitions).",
+            name, changed_count, new_count);
+    }
+
+    return result;
+}
+
 IValue_texture* Mdl_module::create_texture(
     DB::Transaction* transaction,
     const char* file_path,
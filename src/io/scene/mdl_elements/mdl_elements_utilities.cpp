@@ -4392,6 +4392,16 @@ Module_cache::~Module_cache()
 
 const mi::mdl::IModule* Module_cache::lookup( const char* module_name) const
 {
+    if( m_overrides) {
+        Override_map::const_iterator it = m_overrides->find( module_name);
+        if( it != m_overrides->end()) {
+            if( !it->second.is_valid_interface())
+                return 0;
+            it->second->retain();
+            return it->second.get();
+        }
+    }
+
     std::string db_name = add_mdl_db_prefix( module_name);
     DB::Tag tag = m_transaction->name_to_tag( db_name.c_str());
     if( !tag)
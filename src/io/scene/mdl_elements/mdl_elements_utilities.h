@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <map>
 #include <base/data/db/i_db_tag.h>
 #include <mi/mdl/mdl_code_generators.h>
 #include <mi/mdl/mdl_definitions.h>
@@ -525,15 +526,23 @@ private:
 class Module_cache : public mi::mdl::IModule_cache
 {
 public:
-   Module_cache( DB::Transaction* transaction) : m_transaction( transaction) { }
+   /// Maps MDL module names to modules that are used instead of their DB elements. Invalid
+   /// handles hide the DB element, i.e., the compiler loads such modules again.
+   typedef std::map<std::string, mi::base::Handle<const mi::mdl::IModule> > Override_map;
+
+   Module_cache( DB::Transaction* transaction, const Override_map* overrides = 0)
+     : m_transaction( transaction), m_overrides( overrides) { }
 
    virtual ~Module_cache();
 
    /// If the DB contains the MDL module \p module_name, return it, otherwise \c NULL.
+   ///
+   /// Modules in the override map take precedence over the DB.
    const mi::mdl::IModule* lookup( const char* module_name) const;
 
 private:
     DB::Transaction* m_transaction;
+    const Override_map* m_overrides;
 };
 
 
@@ -201,6 +201,32 @@ MI::DB::Tag load_mdl_texture(
     if( texture_tag)
         return texture_tag;
 
+    // Identical files (in particular uv-tile sets) under different paths share the mipmaps of
+    // the same image. The digest covers all tiles, their uv-coordinates, and the gamma value.
+    MDL::DETAIL::Resource_dedup dedup( "texture", db_texture_name, shared);
+    DB::Tag data_tag;
+    if( dedup.is_active()) {
+        bool success = true;
+        for( mi::Size i = 0; success && i < image_set->get_length(); ++i) {
+            mi::Sint32 u = 0, v = 0;
+            if( image_set->get_uv_mapping( i, u, v)) {
+                dedup.add_parameter( u);
+                dedup.add_parameter( v);
+            }
+            const char* filename
+                = image_set->is_mdl_archive() ? 0 : image_set->get_resolved_filename( i);
+            if( filename)
+                success = dedup.add_file( filename);
+            else {
+                mi::base::Handle<mi::neuraylib::IReader> reader( image_set->open_reader( i));
+                success = dedup.add_reader( reader.get());
+            }
+        }
+        dedup.add_parameter( gamma);
+        if( success)
+            data_tag = dedup.lookup_content( transaction);
+    }
+
     DB::Privacy_level privacy_level = transaction->get_scope()->get_level();
 
     std::string db_image_name = shared ? "MI_default_" : "";
@@ -211,7 +237,17 @@ MI::DB::Tag load_mdl_texture(
     DB::Tag image_tag = transaction->name_to_tag( db_image_name.c_str());
     if( !image_tag) {
         DBIMAGE::Image* image = new DBIMAGE::Image();
-        image->reset( image_set);
+        mi::Sint32 result = -1;
+        if( data_tag) {
+            DB::Access<Texture> data_texture( data_tag, transaction);
+            DB::Tag data_image_tag = data_texture->get_image();
+            if( data_image_tag) {
+                DB::Access<DBIMAGE::Image> data_image( data_image_tag, transaction);
+                result = image->reset_shared( image_set, *data_image.get_ptr());
+            }
+        }
+        if( result != 0)
+            image->reset( image_set);
         image_tag = transaction->store_for_reference_counting(
             image, db_image_name.c_str(), privacy_level);
     }
@@ -222,6 +258,7 @@ MI::DB::Tag load_mdl_texture(
 
     texture_tag = transaction->store_for_reference_counting(
         texture, db_texture_name.c_str(), privacy_level);
+    dedup.insert( transaction, texture_tag);
     return texture_tag;
 }
 
@@ -36,6 +36,7 @@
 #include <mdl/compiler/compilercore/compilercore_mdl.h>
 #include <mdl/compiler/compilercore/compilercore_visitor.h>
 #include <mdl/compiler/compilercore/compilercore_file_resolution.h>
+#include <mdl/compiler/compilercore/compilercore_trace.h>
 #include <mdl/codegenerators/generator_code/generator_code_hash.h>
 
 #include <cstring>
@@ -1623,6 +1624,8 @@ void Generated_code_dag::compile_local_material(
 // Compile the module.
 void Generated_code_dag::compile(IModule const *module)
 {
+    Trace_scope trace(TP_DAG_BUILD, module->get_name());
+
     m_current_material_index = 0;
 
     m_node_factory.enable_cse(true);
@@ -1695,6 +1698,11 @@ void Generated_code_dag::compile(IModule const *module)
     Node_list const &topo_list(dep_graph.get_module_entities(has_loops));
     MDL_ASSERT(!has_loops && "Dependency graph has loops");
 
+    // Note: the entities are compiled one after the other on purpose. Compiling them into
+    // thread local factories and merging the results would not reproduce the sequential DAG:
+    // the value, type and symbol tables are serialized as a whole, including all values
+    // created while folding, the node factory orders the arguments of symmetric operators by
+    // node ID, and the CSE table is shared by all functions up to the next material.
     for (Node_list::const_iterator it(topo_list.begin()), end(topo_list.end()); it != end; ++it) {
         Dependence_node const *n = *it;
 
@@ -2826,6 +2834,8 @@ Generated_code_dag::Error_code Generated_code_dag::Material_instance::initialize
     }
 #endif
 
+    Trace_scope trace(TP_INSTANCE_COMPILE, code_dag->get_material_name(m_material_index));
+
     int parameter_count = code_dag->get_material_parameter_count(m_material_index);
     if (argc < parameter_count)
         return EC_TOO_FEW_ARGUMENTS;
@@ -3838,17 +3848,14 @@ DAG_call *Generated_code_dag::Material_instance::move_ternary_down(DAG_call *ter
 // Calculate the hash values for this instance.
 void Generated_code_dag::Material_instance::calc_hashes()
 {
-    MD5_hasher md5_hasher;
-    Dag_hasher dag_hasher(md5_hasher);
-
-    DAG_ir_walker walker(get_allocator());
+    // the slots share large parts of their DAGs, so the digests are memoized across the slots
+    Dag_digester digester(get_allocator());
 
     for (int i = 0; i <= MS_LAST; ++i) {
-        walker.walk_instance_slot(this, Slot(i), &dag_hasher);
-
-        md5_hasher.final(m_slot_hashes[i].data());
+        m_slot_hashes[i] = digester.digest(DAG_ir_walker::get_instance_slot_node(this, Slot(i)));
     }
 
+    MD5_hasher md5_hasher;
     for (int i = 0; i <= MS_LAST; ++i) {
         md5_hasher.update(m_slot_hashes[i].data(), m_slot_hashes[i].size());
     }
@@ -38,6 +38,7 @@
 #include "mdl/compiler/compilercore/compilercore_streams.h"
 #include "mdl/compiler/compilercore/compilercore_array_ref.h"
 #include "mdl/compiler/compilercore/compilercore_file_resolution.h"
+#include "mdl/compiler/compilercore/compilercore_trace.h"
 
 #include <mdl/codegenerators/generator_code/generator_code_hash.h>
 
@@ -827,6 +828,8 @@ void Lambda_function::optimize(
     ICall_name_resolver const *name_resolver,
     ICall_evaluator           *call_evaluator)
 {
+    Trace_scope trace(TP_LAMBDA_OPTIMIZE);
+
     // Ignore no-inline annotations which are only necessary for the material converter
     bool old_ignore_noinline = m_node_factory.enable_ignore_noinline(true);
     ICall_evaluator *old_call_evaluator = m_node_factory.get_call_evaluator();
@@ -118,11 +118,10 @@ static DAG_node const *skip_temporary(DAG_node const *node)
     return node;
 }
 
-// Walk the IR nodes of an instance material slot, including temporaries.
-void DAG_ir_walker::walk_instance_slot(
+// Get the root IR node of an instance material slot.
+DAG_node *DAG_ir_walker::get_instance_slot_node(
     Generated_code_dag::Material_instance       *instance,
-    Generated_code_dag::Material_instance::Slot slot,
-    IDAG_ir_visitor                             *visitor)
+    Generated_code_dag::Material_instance::Slot slot)
 {
     struct Locator {
         char const *first_name;
@@ -249,6 +248,17 @@ void DAG_ir_walker::walk_instance_slot(
         // create a temporary Const node, so we can visit it.
         node = const_cast<DAG_constant *>(instance->create_temp_constant(v));
     }
+    return node;
+}
+
+// Walk the IR nodes of an instance material slot, including temporaries.
+void DAG_ir_walker::walk_instance_slot(
+    Generated_code_dag::Material_instance       *instance,
+    Generated_code_dag::Material_instance::Slot slot,
+    IDAG_ir_visitor                             *visitor)
+{
+    DAG_node *node = get_instance_slot_node(instance, slot);
+
     Memory_arena arena(m_alloc);
     Visited_node_set marker(
         0, Visited_node_set::hasher(), Visited_node_set::key_equal(), &arena);
@@ -610,6 +620,52 @@ void Dag_hasher::hash(IValue const *v) {
     }
 }
 
+// Constructor.
+Dag_digester::Dag_digester(IAllocator *alloc)
+: m_digests(0, Digest_map::hasher(), Digest_map::key_equal(), alloc)
+{
+}
+
+// Get the digest of a DAG IR node.
+DAG_hash const &Dag_digester::digest(DAG_node const *node)
+{
+    if (DAG_temporary const *tmp = as<DAG_temporary>(node))
+        return digest(tmp->get_expr());
+
+    Digest_map::const_iterator it = m_digests.find(node);
+    if (it != m_digests.end())
+        return it->second;
+
+    MD5_hasher md5_hasher;
+    Dag_hasher dag_hasher(md5_hasher);
+
+    DAG_node *n = const_cast<DAG_node *>(node);
+    switch (n->get_kind()) {
+    case DAG_node::EK_CONSTANT:
+        dag_hasher.visit(cast<DAG_constant>(n));
+        break;
+    case DAG_node::EK_CALL:
+        {
+            DAG_call *call = cast<DAG_call>(n);
+            dag_hasher.visit(call);
+            for (int i = 0, n_args = call->get_argument_count(); i < n_args; ++i) {
+                DAG_hash const &arg_digest = digest(call->get_argument(i));
+                md5_hasher.update(arg_digest.data(), arg_digest.size());
+            }
+        }
+        break;
+    case DAG_node::EK_PARAMETER:
+        dag_hasher.visit(cast<DAG_parameter>(n));
+        break;
+    case DAG_node::EK_TEMPORARY:
+        MDL_ASSERT(!"temporaries should have been skipped");
+        break;
+    }
+
+    DAG_hash result;
+    md5_hasher.final(result.data());
+    return m_digests.insert(Digest_map::value_type(node, result)).first->second;
+}
 
 } // mdl
 } // mi
@@ -104,6 +104,17 @@ public:
         Generated_code_dag::Material_instance::Slot slot,
         IDAG_ir_visitor                             *visitor);
 
+    /// Get the root IR node of an instance material slot.
+    ///
+    /// If the slot is folded into a constant of an enclosing struct, a temporary constant for
+    /// the slot value is created.
+    ///
+    /// \param instance   the instance
+    /// \param slot       the material slot
+    static DAG_node *get_instance_slot_node(
+        Generated_code_dag::Material_instance       *instance,
+        Generated_code_dag::Material_instance::Slot slot);
+
     /// Walk a DAG IR node.
     ///
     /// \param node       the DAG IR node that will be visited
@@ -172,6 +183,31 @@ private:
     MD5_hasher &m_hasher;
 };
 
+/// Helper class: computes structural digests of DAG IR nodes bottom-up.
+///
+/// The digest of a node is computed from the node itself (as hashed by Dag_hasher) and the
+/// digests of its arguments. Digests are memoized per node, so every node is hashed exactly
+/// once, even if it is shared by several roots like the slots of a material instance.
+/// Temporaries are transparent, i.e. they have the digest of their initializer.
+class Dag_digester {
+public:
+    /// Constructor.
+    ///
+    /// \param alloc  an allocator for the memoization table
+    explicit Dag_digester(IAllocator *alloc);
+
+    /// Get the digest of a DAG IR node.
+    ///
+    /// \param node  the node
+    DAG_hash const &digest(DAG_node const *node);
+
+private:
+    typedef ptr_hash_map<DAG_node const, DAG_hash>::Type Digest_map;
+
+    /// The memoized digests.
+    Digest_map m_digests;
+};
+
 } // mdl
 } // mi
 
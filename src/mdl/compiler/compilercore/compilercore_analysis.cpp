@@ -54,6 +54,7 @@
 #include "compilercore_assert.h"
 #include "compilercore_positions.h"
 #include "compilercore_file_resolution.h"
+#include "compilercore_trace.h"
 
 #ifdef WIN_NT
 #define strcasecmp(s1, s2) _stricmp(s1, s2)
@@ -3219,6 +3220,7 @@ Module const *NT_analysis::load_module_to_import(
         // to the current context.
         mi::base::Handle<Thread_context> ctx(m_compiler->create_thread_context());
         ctx->set_front_path(m_ctx.get_front_path());
+        ctx->set_module_load_coordinator(m_ctx.get_module_load_coordinator());
         imp_mod = m_compiler->compile_module(*ctx.get(), abs_name, &cache);
     }
     if (imp_mod == NULL) {
@@ -14457,6 +14459,8 @@ void NT_analysis::calc_state_usage()
 // Run the name and type analysis on this module.
 void NT_analysis::run()
 {
+    Trace_scope trace(TP_ANALYSIS, m_module.get_name());
+
     if (m_module.get_owner_archive_version() != NULL) {
         if (m_module.m_mdl_version > m_module.m_arc_mdl_version) {
             Position_impl zero(0, 0, 0, 0);
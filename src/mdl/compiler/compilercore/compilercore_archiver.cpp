@@ -29,6 +29,12 @@
 #include "pch.h"
 
 #include <base/lib/libzip/zip.h>
+#include <base/lib/zlib/zlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
 
 // defined in zipint.h
 extern "C" int zip_source_remove(zip_source_t *);
@@ -43,6 +49,7 @@ extern "C" zip_int64_t zip_source_supports(zip_source_t *src);
 #include "compilercore_manifest.h"
 #include "compilercore_file_resolution.h"
 #include "compilercore_wchar_support.h"
+#include "compilercore_thread_pool.h"
 
 namespace mi {
 namespace mdl {
@@ -343,6 +350,354 @@ private:
     mi::base::Handle<IMDL_resource_reader> m_reader;
 };
 
+/// Deflates archive entries on worker threads ahead of libzip writing them.
+///
+/// libzip compresses entries one at a time while writing the archive in zip_close(). Instead,
+/// the entries are deflated concurrently into memory and handed to libzip as already compressed
+/// sources, which it copies unchanged. The workers of the shared thread pool process the entries
+/// in archive order and stop running ahead once the buffered data exceeds a budget, so memory
+/// usage stays bounded. If the entry needed next was not picked up by a worker yet, the writer
+/// deflates it itself, so the archive is written even if all workers are busy elsewhere.
+class Deflate_pipeline {
+    /// A deflated entry.
+    struct Entry {
+        Entry(IAllocator *alloc, string const &file_name)
+        : file_name(file_name)
+        , data(alloc)
+        , size(0)
+        , comp_size(0)
+        , stored(false)
+        , crc(0)
+        , mtime(0)
+        , done(false)
+        , failed(false)
+        , released(false)
+        {
+            zip_error_init(&error);
+        }
+
+        string                       file_name;  ///< The source file.
+        vector<unsigned char>::Type  data;       ///< The raw deflate stream.
+        zip_uint64_t                 size;       ///< The uncompressed size.
+        zip_uint64_t                 comp_size;  ///< The compressed size.
+        bool                         stored;     ///< True, if data is stored uncompressed.
+        zip_uint32_t                 crc;        ///< The CRC of the uncompressed data.
+        time_t                       mtime;      ///< The modification time of the source.
+        zip_error_t                  error;      ///< The error if compression failed.
+        bool                         done;
+        bool                         failed;
+        bool                         released;
+    };
+
+    /// The state of a libzip source reading one entry.
+    struct Source {
+        Deflate_pipeline *pipeline;
+        size_t           index;
+        size_t           pos;
+    };
+
+public:
+    /// Constructor.
+    ///
+    /// \param alloc   the allocator
+    /// \param budget  the maximum number of compressed bytes buffered ahead
+    Deflate_pipeline(IAllocator *alloc, size_t budget)
+    : m_alloc(alloc)
+    , m_pool(Thread_pool::get())
+    , m_workers(*m_pool)
+    , m_entries(alloc)
+    , m_sources(alloc)
+    , m_budget(budget)
+    , m_buffered(0)
+    , m_first_pending(0)
+    , m_next(0)
+    , m_abort(false)
+    {
+    }
+
+    /// Destructor, waits for the workers.
+    ~Deflate_pipeline()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_abort = true;
+        }
+        m_cond.notify_all();
+        m_workers.wait();
+    }
+
+    /// Register a file to be deflated, must be called before start().
+    ///
+    /// \returns the index of the entry
+    size_t add(string const &file_name)
+    {
+        m_entries.push_back(Entry(m_alloc, file_name));
+        return m_entries.size() - 1;
+    }
+
+    /// Start the workers.
+    void start()
+    {
+        m_sources.resize(m_entries.size());
+
+        // the writer deflates entries, too, if no worker is available
+        size_t n = m_pool->get_num_threads(m_entries.size(), 0);
+        for (size_t i = 1; i < n; ++i)
+            m_workers.run([this]() { run(); });
+    }
+
+    /// Create a libzip source delivering the given deflated entry.
+    zip_source_t *create_source(zip_t *za, size_t index)
+    {
+        Source &src = m_sources[index];
+        src.pipeline = this;
+        src.index    = index;
+        src.pos      = 0;
+        return zip_source_function(za, callback, &src);
+    }
+
+private:
+    /// Worker thread main loop.
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            // the entry the writer waits for next may always be processed
+            m_cond.wait(lock, [this]() {
+                return m_abort || m_next >= m_entries.size() ||
+                    m_buffered < m_budget || m_next <= m_first_pending;
+            });
+            if (m_abort || m_next >= m_entries.size())
+                return;
+
+            Entry &e = m_entries[m_next++];
+            lock.unlock();
+            deflate_file(e);
+            lock.lock();
+
+            e.done = true;
+            m_buffered += e.data.size();
+            m_cond.notify_all();
+        }
+    }
+
+    /// Deflate one file.
+    static void deflate_file(Entry &e)
+    {
+        zip_source_t *src = zip_source_file_create(e.file_name.c_str(), 0, -1, &e.error);
+        if (src == NULL) {
+            e.failed = true;
+            return;
+        }
+
+        zip_stat_t st;
+        zip_stat_init(&st);
+        if (zip_source_stat(src, &st) < 0 || zip_source_open(src) < 0) {
+            e.error = *zip_source_error(src);
+            e.failed = true;
+            zip_source_free(src);
+            return;
+        }
+        e.mtime = (st.valid & ZIP_STAT_MTIME) != 0 ? st.mtime : time(NULL);
+
+        // same parameters libzip uses for ZIP_CM_DEFLATE, so the archive content is unchanged
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        int ret = deflateInit2(
+            &zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+        if (ret != Z_OK) {
+            // reported by the source callback when libzip opens this entry
+            zip_error_set(&e.error, ret == Z_MEM_ERROR ? ZIP_ER_MEMORY : ZIP_ER_ZLIB, ret);
+            e.failed = true;
+            zip_source_close(src);
+            zip_source_free(src);
+            return;
+        }
+        if ((st.valid & ZIP_STAT_SIZE) != 0)
+            e.data.reserve(size_t(deflateBound(&zs, uLong(st.size))));
+
+        size_t const chunk_size  = 64 * 1024;
+        size_t const store_limit = 8192;
+        unsigned char in[chunk_size];
+        uLong         crc = crc32(0L, Z_NULL, 0);
+        size_t        out_pos = 0;
+        int           flush = Z_NO_FLUSH;
+
+        do {
+            zip_int64_t n = zip_source_read(src, in, chunk_size);
+            if (n < 0) {
+                e.error = *zip_source_error(src);
+                e.failed = true;
+                break;
+            }
+            crc = crc32(crc, in, uInt(n));
+            e.size += zip_uint64_t(n);
+
+            flush = n == 0 ? Z_FINISH : Z_NO_FLUSH;
+            zs.next_in  = in;
+            zs.avail_in = uInt(n);
+            for (;;) {
+                if (out_pos == e.data.size())
+                    e.data.resize(e.data.size() + chunk_size);
+                zs.next_out  = &e.data[out_pos];
+                zs.avail_out = uInt(e.data.size() - out_pos);
+
+                ret = deflate(&zs, flush);
+                out_pos = e.data.size() - zs.avail_out;
+                if (ret == Z_STREAM_ERROR) {
+                    zip_error_set(&e.error, ZIP_ER_ZLIB, ret);
+                    e.failed = true;
+                    break;
+                }
+                if (ret == Z_STREAM_END || zs.avail_out != 0)
+                    break;
+            }
+        } while (!e.failed && flush != Z_FINISH);
+
+        deflateEnd(&zs);
+        zip_source_close(src);
+        zip_source_free(src);
+
+        e.data.resize(out_pos);
+        e.comp_size = out_pos;
+        e.crc = zip_uint32_t(crc);
+
+        // like libzip, store small files that do not shrink, these are still in the input buffer
+        if (!e.failed && e.comp_size >= e.size && e.comp_size < store_limit) {
+            e.data.assign(in, in + e.size);
+            e.comp_size = e.size;
+            e.stored = true;
+        }
+    }
+
+    /// Wait until the given entry is deflated. The writer consumes the entries in order, so
+    /// all previous entries are released.
+    Entry &wait(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (; m_first_pending < index; ++m_first_pending)
+            release_locked(m_entries[m_first_pending]);
+        m_cond.notify_all();
+
+        if (m_next == index && !m_abort) {
+            // not picked up by a worker yet, deflate it here
+            Entry &e = m_entries[m_next++];
+            lock.unlock();
+            deflate_file(e);
+            lock.lock();
+
+            e.done = true;
+            m_buffered += e.data.size();
+            m_cond.notify_all();
+        }
+        m_cond.wait(lock, [this, index]() { return m_entries[index].done || m_abort; });
+        return m_entries[index];
+    }
+
+    /// Release the data of the given entry, once written.
+    void release(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        release_locked(m_entries[index]);
+        if (m_first_pending == index)
+            ++m_first_pending;
+        m_cond.notify_all();
+    }
+
+    /// Release the data of the given entry, needs the lock.
+    void release_locked(Entry &e)
+    {
+        if (e.released || !e.done)
+            return;
+        m_buffered -= e.data.size();
+        vector<unsigned char>::Type(m_alloc).swap(e.data);
+        e.released = true;
+    }
+
+    /// The libzip source callback.
+    static zip_int64_t callback(
+        void             *env,
+        void             *data,
+        zip_uint64_t     len,
+        zip_source_cmd_t cmd)
+    {
+        Source           &src      = *reinterpret_cast<Source *>(env);
+        Deflate_pipeline &pipeline = *src.pipeline;
+
+        switch (cmd) {
+        case ZIP_SOURCE_OPEN:
+            {
+                Entry &e = pipeline.wait(src.index);
+                if (e.failed || !e.done)
+                    return -1;
+                src.pos = 0;
+                return 0;
+            }
+        case ZIP_SOURCE_READ:
+            {
+                Entry &e = pipeline.m_entries[src.index];
+                size_t n = e.data.size() - src.pos;
+                if (n > len)
+                    n = size_t(len);
+                if (n > 0)
+                    memcpy(data, &e.data[src.pos], n);
+                src.pos += n;
+                return zip_int64_t(n);
+            }
+        case ZIP_SOURCE_CLOSE:
+            pipeline.release(src.index);
+            return 0;
+        case ZIP_SOURCE_STAT:
+            {
+                Entry &e = pipeline.wait(src.index);
+                if (e.failed || !e.done)
+                    return -1;
+
+                zip_stat_t *st = ZIP_SOURCE_GET_ARGS(zip_stat_t, data, len, &e.error);
+                if (st == NULL)
+                    return -1;
+                zip_stat_init(st);
+                st->size        = e.size;
+                st->comp_size   = e.comp_size;
+                st->comp_method = e.stored ? ZIP_CM_STORE : ZIP_CM_DEFLATE;
+                st->crc         = e.crc;
+                st->mtime       = e.mtime;
+                st->valid      |= ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD |
+                    ZIP_STAT_CRC | ZIP_STAT_MTIME;
+                return sizeof(*st);
+            }
+        case ZIP_SOURCE_ERROR:
+            return zip_error_to_data(&pipeline.m_entries[src.index].error, data, len);
+        case ZIP_SOURCE_FREE:
+            // owned by the pipeline
+            return 0;
+        case ZIP_SOURCE_GET_COMPRESSION_FLAGS:
+            // "maximum compression" as set by libzip for Z_BEST_COMPRESSION
+            return 1;
+        case ZIP_SOURCE_SUPPORTS:
+            return ZIP_SOURCE_SUPPORTS_READABLE |
+                ZIP_SOURCE_MAKE_COMMAND_BITMASK(ZIP_SOURCE_GET_COMPRESSION_FLAGS);
+        default:
+            zip_error_set(&pipeline.m_entries[src.index].error, ZIP_ER_OPNOTSUPP, 0);
+            return -1;
+        }
+    }
+
+private:
+    IAllocator                   *m_alloc;
+    std::shared_ptr<Thread_pool> m_pool;
+    Thread_pool::Job_group       m_workers;
+    vector<Entry>::Type          m_entries;
+    vector<Source>::Type         m_sources;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cond;
+    size_t const                m_budget;
+    size_t                      m_buffered;
+    size_t                      m_first_pending;
+    size_t                      m_next;
+    bool                        m_abort;
+};
+
 /// Base class for Archive operators.
 class Archive_helper {
 protected:
@@ -618,11 +973,47 @@ public:
         char const *file_name);
 
 private:
+    /// The result of extracting one file.
+    enum Extract_status {
+        ES_PENDING,         ///< Not yet extracted.
+        ES_OK,              ///< Successfully extracted.
+        ES_ZIP_ERROR,       ///< Reading from the archive failed.
+        ES_CREATE_FAILED,   ///< The destination file could not be created.
+        ES_IO_ERROR,        ///< Writing the destination file failed.
+    };
+
+    /// A file to be extracted.
+    struct Extract_job {
+        Extract_job(IAllocator *alloc)
+        : index(0), path(alloc), full_path(alloc), status(ES_PENDING), zip_err(ZIP_ER_OK)
+        {
+        }
+
+        zip_int64_t    index;       ///< The index of the entry in the archive.
+        string         path;        ///< The path inside the archive.
+        string         full_path;   ///< The destination path.
+        Extract_status status;      ///< The result.
+        int            zip_err;     ///< The libzip error code if status is ES_ZIP_ERROR.
+    };
+
+    typedef vector<Extract_job>::Type Extract_job_vector;
+
     /// Make directories.
     void mkdir(string const &path);
 
+    /// Extract files until all jobs are claimed. Can be called from worker threads,
+    /// errors are only recorded in the jobs.
+    ///
+    /// \param za    the archive, must be used by the calling thread only
+    /// \param jobs  all jobs
+    /// \param next  the index of the next unclaimed job
+    static void extract_files(
+        zip_t               *za,
+        Extract_job_vector  &jobs,
+        std::atomic<size_t> &next);
+
     /// Copy data.
-    void copy_data(FILE *dst, zip_file_t *src);
+    static Extract_status copy_data(FILE *dst, zip_file_t *src, int &zip_err);
 
     /// Normalize separators to '/'.
     void normalize_separators(string &path);
@@ -1416,15 +1807,6 @@ private:
 // Compile all collected modules.
 bool Archive_builder::compile_modules()
 {
-    mi::base::Handle<mi::mdl::Thread_context> ctx(m_compiler->create_thread_context());
-
-    // archives are always build in STRICT mode
-    Options &opt = ctx->access_options();
-    opt.set_option(MDL::option_strict, "true");
-
-    // add the root path in front, to ensure that modules are first searched here
-    ctx->set_front_path(m_root_path.c_str());
-
     Dependency_map dep_map(0, Dependency_map::hasher(), Dependency_map::key_equal(), m_alloc);
 
     // prepare the set of all resources
@@ -1452,25 +1834,57 @@ bool Archive_builder::compile_modules()
         resources.insert(res);
     }
 
-    // set the resource restriction handler
+    // the resource restriction handler, read-only and shared by all contexts
     Archive_resource_restrictions rrh(*this, resources);
-    ctx->set_resource_restriction_handler(&rrh);
 
-    bool res = true;
+    // the modules are independent, so compile them in parallel, each with its own context
+    typedef vector<string>::Type                                  Name_vector;
+    typedef vector<mi::base::Handle<Thread_context> >::Type       Context_vector;
+    typedef vector<mi::base::Handle<mi::mdl::Module const> >::Type Module_vector;
+
+    Name_vector mod_names(m_alloc);
     for (String_list::const_iterator it(m_module_list.begin()), end(m_module_list.end());
         it != end;
         ++it)
     {
-        string const &entry = *it;
+        mod_names.push_back(convert_to_module_name(*it));
+    }
+
+    size_t n_modules = mod_names.size();
+    Context_vector ctxs(m_alloc);
+    Module_vector  mods(n_modules, mi::base::Handle<mi::mdl::Module const>(), m_alloc);
+
+    for (size_t i = 0; i < n_modules; ++i) {
+        mi::base::Handle<Thread_context> ctx(m_compiler->create_thread_context());
+
+        // archives are always build in STRICT mode
+        Options &opt = ctx->access_options();
+        opt.set_option(MDL::option_strict, "true");
+
+        // add the root path in front, to ensure that modules are first searched here
+        ctx->set_front_path(m_root_path.c_str());
+
+        ctx->set_resource_restriction_handler(&rrh);
+
+        ctxs.push_back(ctx);
+    }
+
+    Thread_pool::get()->parallel_for(n_modules, 0, [&](size_t i) {
+        mods[i] = mi::base::make_handle(
+            m_compiler->load_module(
+                ctxs[i].get(), mod_names[i].c_str(), /*module_cache=*/NULL));
+    });
 
-        string mod_name = convert_to_module_name(entry);
+    // report in module order
+    bool res = true;
+    for (size_t i = 0; i < n_modules; ++i) {
+        string const &mod_name = mod_names[i];
 
         fire_event(IArchive_tool_event::EV_COMPILING, mod_name.c_str());
 
-        mi::base::Handle<mi::mdl::Module const> mod(
-            m_compiler->load_module(ctx.get(), mod_name.c_str(), /*module_cache=*/NULL));
+        mi::base::Handle<mi::mdl::Module const> const &mod = mods[i];
 
-        mi::mdl::Messages const &msgs = ctx->access_messages();
+        mi::mdl::Messages const &msgs = ctxs[i]->access_messages();
         copy_messages(msgs);
 
         if (msgs.get_error_message_count() > 0) {
@@ -1605,6 +2019,29 @@ bool Archive_builder::create_zip_archive()
         }
     }
 
+    // all compressed entries are deflated in parallel before zip_close() writes them,
+    // register them in archive order
+    Deflate_pipeline pipeline(m_alloc, 256 * 1024 * 1024);
+
+    for (String_list::const_iterator it(m_module_list.begin()), end(m_module_list.end());
+        it != end;
+        ++it)
+    {
+        pipeline.add(join_path(m_root_path, *it));
+    }
+    for (String_list::const_iterator it(m_resource_list.begin()), end(m_resource_list.end());
+        it != end;
+        ++it)
+    {
+        string fname = join_path(m_root_path, *it);
+        if (should_be_compressed(fname))
+            pipeline.add(fname);
+    }
+    size_t pipeline_index = 0;
+
+    if (!m_has_error)
+        pipeline.start();
+
     // add modules
     if (!m_has_error) {
         for (String_list::const_iterator it(m_module_list.begin()), end(m_module_list.end());
@@ -1615,17 +2052,26 @@ bool Archive_builder::create_zip_archive()
 
             string fname = join_path(m_root_path, entry);
 
+            // check that the file exists
             zip_error_t err;
             zip_source_t *source = zip_source_file_create(fname.c_str(), 0, -1, &err);
             if (source == NULL) {
                 translate_zip_error(err);
                 break;
             }
+            zip_source_free(source);
+
+            source = pipeline.create_source(za, pipeline_index++);
+            if (source == NULL) {
+                translate_zip_error(za);
+                break;
+            }
 
             fire_event(IArchive_tool_event::EV_COMPRESSING, entry.c_str());
 
             zip_int64_t index = zip_file_add(za, entry.c_str(), source, ZIP_FL_ENC_UTF_8);
             if (index < 0) {
+                zip_source_free(source);
                 translate_zip_error(za);
                 break;
             }
@@ -1656,9 +2102,17 @@ bool Archive_builder::create_zip_archive()
             // do not compress resources by default
             zip_int32_t comp_method = ZIP_CM_STORE;
 
-            if (should_be_compressed(fname))
+            if (should_be_compressed(fname)) {
                 comp_method = ZIP_CM_DEFAULT;
 
+                zip_source_free(source);
+                source = pipeline.create_source(za, pipeline_index++);
+                if (source == NULL) {
+                    translate_zip_error(za);
+                    break;
+                }
+            }
+
             fire_event(
                 comp_method == ZIP_CM_STORE ?
                     IArchive_tool_event::EV_STORING :
@@ -1667,6 +2121,7 @@ bool Archive_builder::create_zip_archive()
 
             zip_int64_t index = zip_file_add(za, entry.c_str(), source, ZIP_FL_ENC_UTF_8);
             if (index < 0) {
+                zip_source_free(source);
                 translate_zip_error(zip_get_error(za)->zip_err);
                 break;
             }
@@ -1870,6 +2325,9 @@ void Archive_extractor::extract(
             return;
         }
 
+        // create all directories first, collecting the files
+        Extract_job_vector jobs(m_alloc);
+
         // ignore MANIFEST
         for (zip_int64_t i = 1; i < n; ++i) {
             char const *name = zip_get_name(za, i, ZIP_FL_ENC_UTF_8);
@@ -1899,33 +2357,111 @@ void Archive_extractor::extract(
             if (is_directory)
                 continue;
 
-            zip_file_t *zf = zip_fopen_index(za, i, ZIP_FL_UNCHANGED);
-            if (zf == NULL) {
-                translate_zip_error(za);
-                continue;
+            Extract_job job(m_alloc);
+            job.index     = i;
+            job.path      = path;
+            job.full_path = join_path(m_dest_path, path);
+            normalize_separators(job.full_path);
+
+            jobs.push_back(job);
+        }
+
+        // then extract the files in parallel, every worker needs its own archive handle
+        std::atomic<size_t> next(0);
+        auto worker = [&arc_name, &jobs, &next]() {
+            zip_error_t ze;
+            zip_error_init(&ze);
+
+            zip_source_t *src = zip_source_file_create(arc_name.c_str(), 0, -1, &ze);
+            if (src == NULL)
+                return;
+
+            Layered_zip_source layer(src);
+            zip_source_t *lsrc = layer.open(ze);
+            if (lsrc == 0) {
+                zip_source_free(src);
+                return;
+            }
+
+            zip_t *za = zip_open_from_source(lsrc, ZIP_RDONLY, &ze);
+            if (za == NULL) {
+                // the calling thread picks up the remaining jobs
+                zip_source_free(lsrc);
+                return;
             }
 
-            string full_path(join_path(m_dest_path, path));
-            normalize_separators(full_path);
+            extract_files(za, jobs, next);
+            zip_close(za);
+        };
 
-            FILE *f = fopen(full_path.c_str(), "wb");
-            if (f == NULL) {
-                zip_fclose(zf);
+        {
+            std::shared_ptr<Thread_pool> pool(Thread_pool::get());
+            Thread_pool::Job_group       group(*pool);
+
+            for (size_t i = 1, n = pool->get_num_threads(jobs.size(), 0); i < n; ++i)
+                group.run(worker);
+            extract_files(za, jobs, next);
+            group.wait();
+        }
+
+        // report in archive order
+        for (size_t i = 0, n = jobs.size(); i < n; ++i) {
+            Extract_job const &job = jobs[i];
+
+            switch (job.status) {
+            case ES_OK:
+                fire_event(IArchive_tool_event::EV_EXTRACTED, job.path.c_str());
+                break;
+            case ES_ZIP_ERROR:
+                translate_zip_error(job.zip_err);
+                break;
+            case ES_CREATE_FAILED:
                 error(
                     CREATE_FILE_FAILED,
-                    Error_params(get_allocator()).add(full_path.c_str()));
-                continue;
+                    Error_params(get_allocator()).add(job.full_path.c_str()));
+                break;
+            case ES_IO_ERROR:
+                error(
+                    IO_ERROR,
+                    Error_params(get_allocator()).add(m_archive_name.c_str()));
+                break;
+            case ES_PENDING:
+                MDL_ASSERT(!"extraction job not processed");
+                break;
             }
+        }
+    }
+    zip_close(za);
+}
 
-            copy_data(f, zf);
+// Extract files until all jobs are claimed.
+void Archive_extractor::extract_files(
+    zip_t               *za,
+    Extract_job_vector  &jobs,
+    std::atomic<size_t> &next)
+{
+    for (size_t i = next++, n = jobs.size(); i < n; i = next++) {
+        Extract_job &job = jobs[i];
 
-            fclose(f);
-            zip_fclose(zf);
+        zip_file_t *zf = zip_fopen_index(za, job.index, ZIP_FL_UNCHANGED);
+        if (zf == NULL) {
+            job.status  = ES_ZIP_ERROR;
+            job.zip_err = zip_get_error(za)->zip_err;
+            continue;
+        }
 
-            fire_event(IArchive_tool_event::EV_EXTRACTED, path.c_str());
+        FILE *f = fopen(job.full_path.c_str(), "wb");
+        if (f == NULL) {
+            zip_fclose(zf);
+            job.status = ES_CREATE_FAILED;
+            continue;
         }
+
+        job.status = copy_data(f, zf, job.zip_err);
+
+        fclose(f);
+        zip_fclose(zf);
     }
-    zip_close(za);
 }
 
 // Get the content of a file into a memory buffer.
@@ -1983,28 +2519,27 @@ void Archive_extractor::mkdir(string const &path)
 }
 
 // Copy data.
-void Archive_extractor::copy_data(FILE *dst, zip_file_t *src)
+Archive_extractor::Extract_status Archive_extractor::copy_data(
+    FILE       *dst,
+    zip_file_t *src,
+    int        &zip_err)
 {
-    char buf[1024];
+    char buf[64 * 1024];
 
     for (;;) {
-        zip_int64_t l = zip_fread(src, buf, 1024);
+        zip_int64_t l = zip_fread(src, buf, sizeof(buf));
         if (l == 0)
             break;
         if (l < 0) {
-            translate_zip_error(src);
-            break;
+            zip_err = zip_file_get_error(src)->zip_err;
+            return ES_ZIP_ERROR;
         }
         size_t w = fwrite(buf, 1, size_t(l), dst);
 
-        if (w != size_t(l)) {
-            error(
-                IO_ERROR,
-                Error_params(get_allocator()).add(m_archive_name.c_str())
-            );
-            break;
-        }
+        if (w != size_t(l))
+            return ES_IO_ERROR;
     }
+    return ES_OK;
 }
 
 // Normalize separators to '/'.
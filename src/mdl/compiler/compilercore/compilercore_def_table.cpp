@@ -1746,7 +1746,7 @@ void Definition_table::clear()
 {
     m_curr_scope         = NULL;
     m_next_definition_id = 0;
-    m_arena.drop(NULL);
+    m_arena.reset();
     m_type_scopes.clear();
     m_definitions.clear();
 
@@ -53,6 +53,7 @@
 #include "compilercore_tools.h"
 #include "compilercore_archiver.h"
 #include "compilercore_comparator.h"
+#include "compilercore_trace.h"
 #include "compilercore_mdl.h"
 
 #include "mdl_module.h"
@@ -372,6 +373,7 @@ MDL::MDL(IAllocator *alloc)
 , m_builtin_modules_created(false)
 , m_predefined_types_build(false)
 , m_jitted_code(NULL)
+, m_thread_pool(Thread_pool::get())
 {
     create_options();
     create_builtin_semantics();
@@ -994,7 +996,11 @@ Module *MDL::load_module(
     parser.set_imdl(get_allocator(), this);
 
     parser.set_module(module, get_compiler_bool_option(ctx, option_experimental_features, false));
-    parser.Parse();
+
+    {
+        Trace_scope trace(TP_PARSE, module_name);
+        parser.Parse();
+    }
 
     mi::base::Handle<IArchive_input_stream> ias(s->get_interface<IArchive_input_stream>());
     if (ias.is_valid_interface()) {
@@ -1125,8 +1131,17 @@ Module const *MDL::compile_module(
         return std_mod;
     }
 
+    IModule_load_coordinator *coordinator = NULL;
     if (module_cache != NULL) {
         Module const *cached_mod = impl_cast<Module>(module_cache->lookup(mname.c_str()));
+        if (cached_mod == NULL) {
+            coordinator = ctx.get_module_load_coordinator();
+            if (coordinator != NULL && !coordinator->begin_load(mname.c_str())) {
+                // loaded by another thread meanwhile
+                coordinator = NULL;
+                cached_mod = impl_cast<Module>(module_cache->lookup(mname.c_str()));
+            }
+        }
         if (cached_mod != NULL) {
             if (!cached_mod->is_analyzed()) {
                 // We found a not analyzed module. This can only happen if we
@@ -1141,16 +1156,16 @@ Module const *MDL::compile_module(
 
     mi::base::Handle<IInput_stream> input(resolver.open(mname.c_str()));
 
-    if (! input) {
+    Module *mod = NULL;
+    if (input) {
+        // any error is handled by load_module()
+        mod = load_module(module_cache, &ctx, mname.c_str(), input.get(), Module::MF_STANDARD);
+    } else {
         // FIXME: add an error ??
-        return NULL;
-    }
-    Module *mod = load_module(module_cache, &ctx, mname.c_str(), input.get(), Module::MF_STANDARD);
-    if (mod == NULL) {
-        // any error was already handled by load_module() above
-        return NULL;
     }
 
+    if (coordinator != NULL)
+        coordinator->end_load(mname.c_str(), mod);
     return mod;
 }
 
@@ -33,6 +33,8 @@
 #include <mi/base/lock.h>
 #include <mi/mdl/mdl_mdl.h>
 
+#include <memory>
+
 #include "compilercore_allocator.h"
 #include "compilercore_memory_arena.h"
 #include "compilercore_factories.h"
@@ -41,6 +43,7 @@
 #include "compilercore_printers.h"
 #include "compilercore_cstring_hash.h"
 #include "compilercore_thread_context.h"
+#include "compilercore_thread_pool.h"
 
 namespace mi {
 namespace mdl {
@@ -676,6 +679,9 @@ private:
 
     /// The Jitted code singleton if any.
     Jitted_code *m_jitted_code;
+
+    /// Keeps the shared worker pool alive as long as the compiler exists.
+    std::shared_ptr<Thread_pool> m_thread_pool;
 };
 
 /// Implementation of the factory function mi_mdl_factory().
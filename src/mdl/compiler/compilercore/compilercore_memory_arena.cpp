@@ -28,7 +28,11 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <mutex>
+#include <vector>
 #include <mi/base/iallocator.h>
 #include <mi/base/handle.h>
 #include <mi/mdl/mdl_iowned.h>
@@ -87,24 +91,315 @@ static inline size_t start_offset(unsigned char *p, size_t a)
     return (0 - adr) & (a-1);
 }
 
+namespace {
+
+/// The default limit of the chunk pool of one thread in bytes.
+size_t const DEFAULT_POOL_LIMIT = 1024 * 1024;
+
+/// The limit of the chunk pool of one thread in bytes.
+std::atomic<size_t> g_pool_limit(DEFAULT_POOL_LIMIT);
+
+// Process wide counters, see Memory_arena_global_statistics.
+std::atomic<unsigned long long> g_arenas(0);
+std::atomic<unsigned long long> g_chunks_new(0);
+std::atomic<unsigned long long> g_chunks_reused(0);
+std::atomic<unsigned long long> g_pooled_bytes(0);
+std::atomic<unsigned long long> g_high_water_sum(0);
+std::atomic<unsigned long long> g_high_water_max(0);
+std::atomic<unsigned long long> g_high_water[Memory_arena_global_statistics::HIGH_WATER_BUCKETS];
+
+}  // anonymous
+
+/// The chunk pool of one thread.
+///
+/// Chunks are kept per allocator and size class. Only the owning thread takes and puts chunks,
+/// but flush_chunk_pools() may empty a pool from any thread, hence the (uncontended) lock.
+class Memory_arena_chunk_pool
+{
+    typedef Memory_arena::Header Header;
+
+public:
+    enum { NUM_SIZE_CLASSES = Memory_arena::NUM_SIZE_CLASSES };
+
+    /// Get the size class of a chunk size, -1 if chunks of this size are not pooled.
+    static int get_size_class(size_t size)
+    {
+        for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            if (size == size_t(Memory_arena::CHUNK_SIZE) << i)
+                return i;
+        }
+        return -1;
+    }
+
+    /// Get the pool of the current thread, NULL if pooling is disabled.
+    static Memory_arena_chunk_pool *get_thread_pool();
+
+    /// Constructor.
+    Memory_arena_chunk_pool() : m_bytes(0) {}
+
+    /// Destructor, frees all chunks.
+    ~Memory_arena_chunk_pool() { flush(NULL); }
+
+    /// Take a chunk of the given size class, NULL if there is none.
+    Header *get(IAllocator *alloc, int size_class)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        for (size_t i = 0, n = m_entries.size(); i < n; ++i) {
+            Entry &e = m_entries[i];
+            if (e.alloc != alloc)
+                continue;
+
+            Header *h = e.chunks[size_class];
+            if (h != NULL) {
+                e.chunks[size_class] = h->next;
+                m_bytes -= h->chunk_size;
+                g_pooled_bytes -= h->chunk_size;
+            }
+            return h;
+        }
+        return NULL;
+    }
+
+    /// Put a chunk of the given size class into the pool.
+    ///
+    /// \return false if the pool is full
+    bool put(IAllocator *alloc, Header *h, int size_class)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if (m_bytes + h->chunk_size > g_pool_limit.load(std::memory_order_relaxed))
+            return false;
+
+        Entry *e = NULL;
+        for (size_t i = 0, n = m_entries.size(); i < n; ++i) {
+            if (m_entries[i].alloc == alloc) {
+                e = &m_entries[i];
+                break;
+            }
+        }
+        if (e == NULL) {
+            Entry entry;
+            entry.alloc = alloc;
+            std::fill_n(entry.chunks, size_t(NUM_SIZE_CLASSES), (Header *)NULL);
+            alloc->retain();
+            m_entries.push_back(entry);
+            e = &m_entries.back();
+        }
+
+        h->next = e->chunks[size_class];
+        e->chunks[size_class] = h;
+        m_bytes += h->chunk_size;
+        g_pooled_bytes += h->chunk_size;
+        return true;
+    }
+
+    /// Free all chunks of the given allocator, NULL frees all chunks.
+    void flush(IAllocator *alloc)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        for (size_t i = m_entries.size(); i > 0; --i) {
+            Entry &e = m_entries[i - 1];
+            if (alloc != NULL && e.alloc != alloc)
+                continue;
+
+            for (int c = 0; c < NUM_SIZE_CLASSES; ++c) {
+                for (Header *h = e.chunks[c], *q; h != NULL; h = q) {
+                    q = h->next;
+                    m_bytes -= h->chunk_size;
+                    g_pooled_bytes -= h->chunk_size;
+                    e.alloc->free(h);
+                }
+            }
+            e.alloc->release();
+            m_entries.erase(m_entries.begin() + (i - 1));
+        }
+    }
+
+private:
+    /// The pooled chunks of one allocator.
+    struct Entry {
+        IAllocator *alloc;                      ///< The allocator, retained.
+        Header     *chunks[NUM_SIZE_CLASSES];   ///< Chunk lists per size class.
+    };
+
+    /// The lock.
+    std::mutex m_lock;
+
+    /// The entries, usually just one.
+    std::vector<Entry> m_entries;
+
+    /// Number of pooled bytes.
+    size_t m_bytes;
+};
+
+namespace {
+
+/// The pools of all threads, so they can be flushed.
+struct Pool_registry {
+    std::mutex                              lock;
+    std::vector<Memory_arena_chunk_pool *>  pools;
+
+    static Pool_registry &get()
+    {
+        static Pool_registry registry;
+        return registry;
+    }
+};
+
+/// Owns the pool of a thread and frees its chunks when the thread exits.
+struct Thread_pool_holder {
+    Memory_arena_chunk_pool pool;
+
+    Thread_pool_holder()
+    {
+        Pool_registry &registry = Pool_registry::get();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.pools.push_back(&pool);
+    }
+
+    ~Thread_pool_holder();
+};
+
+thread_local Thread_pool_holder t_pool_holder;
+
+/// Set once the pool of the thread is gone, arenas destroyed later free their chunks.
+thread_local bool t_pool_destroyed = false;
+
+Thread_pool_holder::~Thread_pool_holder()
+{
+    t_pool_destroyed = true;
+
+    Pool_registry &registry = Pool_registry::get();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.pools.erase(
+        std::remove(registry.pools.begin(), registry.pools.end(), &pool),
+        registry.pools.end());
+}
+
+}  // anonymous
+
+// Get the pool of the current thread, NULL if pooling is disabled.
+Memory_arena_chunk_pool *Memory_arena_chunk_pool::get_thread_pool()
+{
+    if (t_pool_destroyed || g_pool_limit.load(std::memory_order_relaxed) == 0)
+        return NULL;
+    return &t_pool_holder.pool;
+}
+
 Memory_arena::Memory_arena(IAllocator *alloc, size_t chunk_size)
 : m_alloc(alloc, mi::base::DUP_INTERFACE)
 , m_chunk_size(chunk_size)
 , m_chunks(NULL)
+, m_free(NULL)
 , m_next(NULL)
 , m_curr_size(0)
+, m_chunk_bytes(0)
+, m_num_chunks(0)
+, m_high_water(0)
+, m_chunks_new(0)
+, m_chunks_reused(0)
 {
     MDL_ASSERT(alloc && chunk_size > 16);
 }
-/// Destructs the memory arena and frees ALL memory.
+/// Destructs the memory arena and releases ALL memory.
 Memory_arena::~Memory_arena()
 {
-    for (Header *p = m_chunks, *q; p != NULL; p = q) {
+    Memory_arena_statistics stats;
+    get_statistics(stats);
+
+    release_chunks(m_chunks);
+    release_chunks(m_free);
+    m_chunks = NULL;
+    m_free   = NULL;
+
+    // fold the statistics of this arena into the process wide ones
+    ++g_arenas;
+    g_chunks_new     += stats.chunks_new;
+    g_chunks_reused  += stats.chunks_reused;
+    g_high_water_sum += stats.high_water;
+
+    unsigned long long max = g_high_water_max.load(std::memory_order_relaxed);
+    while (stats.high_water > max &&
+        !g_high_water_max.compare_exchange_weak(max, stats.high_water))
+    {
+    }
+
+    size_t bucket = 0;
+    while (bucket < Memory_arena_global_statistics::HIGH_WATER_BUCKETS - 1 &&
+        stats.high_water >= (size_t(CHUNK_SIZE) << bucket))
+    {
+        ++bucket;
+    }
+    ++g_high_water[bucket];
+}
+
+// Get a chunk of at least min_size bytes, NULL if out of memory.
+Memory_arena::Header *Memory_arena::get_chunk(size_t min_size)
+{
+    // chunks kept by reset() first
+    for (Header **p = &m_free; *p != NULL; p = &(*p)->next) {
+        Header *h = *p;
+        if (h->chunk_size >= min_size) {
+            *p = h->next;
+            ++m_chunks_reused;
+            return h;
+        }
+    }
+
+    // arenas with the default chunk size switch to larger size classes as they grow
+    size_t size = m_chunk_size;
+    if (size == CHUNK_SIZE) {
+        size_t size_class = m_num_chunks / CHUNKS_PER_CLASS;
+        if (size_class >= NUM_SIZE_CLASSES)
+            size_class = NUM_SIZE_CLASSES - 1;
+        size <<= size_class;
+    }
+    if (size < min_size) {
+        // oversized request, round up to a size class if possible
+        size = min_size;
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            if (size <= (size_t(CHUNK_SIZE) << i)) {
+                size = size_t(CHUNK_SIZE) << i;
+                break;
+            }
+        }
+    }
+
+    int size_class = Memory_arena_chunk_pool::get_size_class(size);
+    if (size_class >= 0) {
+        if (Memory_arena_chunk_pool *pool = Memory_arena_chunk_pool::get_thread_pool()) {
+            if (Header *h = pool->get(m_alloc.get(), size_class)) {
+                ++m_chunks_reused;
+                return h;
+            }
+        }
+    }
+
+    Header *h = (Header *)m_alloc->malloc(size);
+    if (h != NULL) {
+        h->chunk_size = size;
+        ++m_chunks_new;
+    }
+    return h;
+}
+
+// Release a chunk list to the chunk pool or the allocator.
+void Memory_arena::release_chunks(Header *chunks)
+{
+    Memory_arena_chunk_pool *pool = NULL;
+    if (chunks != NULL)
+        pool = Memory_arena_chunk_pool::get_thread_pool();
+
+    for (Header *p = chunks, *q; p != NULL; p = q) {
         q = p->next;
 
+        int size_class = Memory_arena_chunk_pool::get_size_class(p->chunk_size);
+        if (pool != NULL && size_class >= 0 && pool->put(m_alloc.get(), p, size_class))
+            continue;
         m_alloc->free((void *)p);
     }
-    m_chunks = NULL;
 }
 
 /// Allocates size bytes from the memory area.
@@ -116,27 +411,23 @@ void *Memory_arena::allocate(size_t o_size, size_t o_align)
     size_t size = o_size + ofs;
 
     if (size > m_curr_size) {
-        // allocate a new chunk
+        // get a new chunk
         size_t load_ofs = align(((Header *)0)->load - (Byte *)0, a);
 
-        size_t chunk_size = m_chunk_size;
-        if (o_size + (a-1) > chunk_size - load_ofs)
-            chunk_size = o_size + (a-1) + load_ofs;
-
-        Header *h = (Header *)m_alloc->malloc(chunk_size);
-        // printf("Allocated chunk %p\n", h);
+        Header *h = get_chunk(o_size + (a-1) + load_ofs);
         if (h == NULL)
             return NULL;
         h->next       = m_chunks;
-        h->chunk_size = chunk_size;
         m_chunks      = h;
+        m_chunk_bytes += h->chunk_size;
+        ++m_num_chunks;
 
         m_next = align(h->load, a);
         ofs    = 0;
         size   = o_size;
 
         size_t lost = m_next - (Byte *)h;
-        m_curr_size = chunk_size - lost;
+        m_curr_size = h->chunk_size - lost;
     }
 
     void *res = m_next + ofs;
@@ -144,6 +435,7 @@ void *Memory_arena::allocate(size_t o_size, size_t o_align)
 
     MDL_ASSERT(m_curr_size >= size);
     m_curr_size -= size;
+    update_high_water();
 
     MDL_ASSERT((((Byte *)res - (Byte *)0) & (a - 1)) == 0);
     return res;
@@ -154,34 +446,44 @@ void Memory_arena::drop(void *obj)
 {
     if (obj == NULL) {
         // drop the whole
-        for (Header *p = m_chunks; p != NULL; p = m_chunks) {
-            m_chunks = p->next;
-            m_alloc->free(p);
-        }
-        m_next      = NULL;
-        m_curr_size = 0;
+        release_chunks(m_chunks);
+        release_chunks(m_free);
+        m_chunks      = NULL;
+        m_free        = NULL;
+        m_next        = NULL;
+        m_curr_size   = 0;
+        m_chunk_bytes = 0;
+        m_num_chunks  = 0;
         return;
     }
 
     // check current chunk first
-    if (m_chunks->load <= obj && obj <= m_next) {
+    if (m_chunks != NULL && m_chunks->load <= obj && obj <= m_next) {
         m_next = (Byte *)obj;
         m_curr_size = (char *)m_chunks + m_chunks->chunk_size - (char *)obj;
     } else {
         // try to find the old chunk
-        Header *stop = NULL;
-        do {
-            stop = m_chunks->next;
-        } while (stop != NULL &&
-                (stop->load > obj || ((char *)stop + stop->chunk_size) <= obj));
+        Header *stop = m_chunks;
+        while (stop != NULL) {
+            stop = stop->next;
+            if (stop != NULL &&
+                stop->load <= obj && obj < (Byte *)stop + stop->chunk_size)
+            {
+                break;
+            }
+        }
 
         // drop chunks until old one is reached
         if (stop != NULL) {
-            Header *p = m_chunks;
+            Header *dropped = m_chunks, *last = NULL;
             do {
-                m_chunks = p->next;
-                m_alloc->free(p);
+                last = m_chunks;
+                m_chunks = last->next;
+                m_chunk_bytes -= last->chunk_size;
+                --m_num_chunks;
             } while (m_chunks != stop);
+            last->next = NULL;
+            release_chunks(dropped);
 
             // now we could drop it in the current chunk
             m_next = (Byte *)obj;
@@ -192,9 +494,28 @@ void Memory_arena::drop(void *obj)
     }
 }
 
+// Drop all objects from the arena but keep its chunks.
+void Memory_arena::reset()
+{
+    if (m_chunks != NULL) {
+        Header *last = m_chunks;
+        while (last->next != NULL)
+            last = last->next;
+        last->next = m_free;
+        m_free     = m_chunks;
+    }
+    m_chunks      = NULL;
+    m_next        = NULL;
+    m_curr_size   = 0;
+    m_chunk_bytes = 0;
+    m_num_chunks  = 0;
+}
+
 // Check if an object lies in this memory arena.
 bool Memory_arena::contains(void const *obj) const
 {
+    if (m_chunks == NULL)
+        return false;
     if (m_chunks->load <= obj && obj < m_next) {
         return true;
     } else {
@@ -211,9 +532,9 @@ bool Memory_arena::contains(void const *obj) const
 // Return the size of the allocated memory arena chunks.
 size_t Memory_arena::get_chunks_size() const
 {
-    size_t size = 0;
+    size_t size = m_chunk_bytes;
 
-    for (Header const *h = m_chunks; h != NULL; h = h->next) {
+    for (Header const *h = m_free; h != NULL; h = h->next) {
         size += h->chunk_size;
     }
     return size;
@@ -222,11 +543,56 @@ size_t Memory_arena::get_chunks_size() const
 // Swap this memory arena content with another.
 void Memory_arena::swap(Memory_arena &other)
 {
-    std::swap(m_alloc,      other.m_alloc);
-    std::swap(m_chunk_size, other.m_chunk_size);
-    std::swap(m_chunks,     other.m_chunks);
-    std::swap(m_next,       other.m_next);
-    std::swap(m_curr_size,  other.m_curr_size);
+    std::swap(m_alloc,         other.m_alloc);
+    std::swap(m_chunk_size,    other.m_chunk_size);
+    std::swap(m_chunks,        other.m_chunks);
+    std::swap(m_free,          other.m_free);
+    std::swap(m_next,          other.m_next);
+    std::swap(m_curr_size,     other.m_curr_size);
+    std::swap(m_chunk_bytes,   other.m_chunk_bytes);
+    std::swap(m_num_chunks,    other.m_num_chunks);
+    std::swap(m_high_water,    other.m_high_water);
+    std::swap(m_chunks_new,    other.m_chunks_new);
+    std::swap(m_chunks_reused, other.m_chunks_reused);
+}
+
+// Get the statistics of this arena.
+void Memory_arena::get_statistics(Memory_arena_statistics &stats) const
+{
+    stats.used          = m_chunk_bytes - m_curr_size;
+    stats.high_water    = m_high_water;
+    stats.chunk_bytes   = get_chunks_size();
+    stats.chunks_new    = m_chunks_new;
+    stats.chunks_reused = m_chunks_reused;
+}
+
+// Get the statistics of all arenas destroyed so far and the current pool usage.
+void Memory_arena::get_global_statistics(Memory_arena_global_statistics &stats)
+{
+    stats.arenas         = g_arenas;
+    stats.chunks_new     = g_chunks_new;
+    stats.chunks_reused  = g_chunks_reused;
+    stats.pooled_bytes   = g_pooled_bytes;
+    stats.high_water_sum = g_high_water_sum;
+    stats.high_water_max = g_high_water_max;
+    for (size_t i = 0; i < Memory_arena_global_statistics::HIGH_WATER_BUCKETS; ++i)
+        stats.high_water[i] = g_high_water[i];
+}
+
+// Set the maximum number of bytes the chunk pool of one thread may hold.
+void Memory_arena::set_chunk_pool_limit(size_t limit)
+{
+    g_pool_limit = limit;
+}
+
+// Return all pooled chunks of the given allocator to it.
+void Memory_arena::flush_chunk_pools(IAllocator *alloc)
+{
+    Pool_registry &registry = Pool_registry::get();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for (size_t i = 0, n = registry.pools.size(); i < n; ++i)
+        registry.pools[i]->flush(alloc);
 }
 
 // Put a C-string into the memory arena.
@@ -45,7 +45,41 @@
 namespace mi {
 namespace mdl {
 
+/// Statistics of one memory arena.
+struct Memory_arena_statistics {
+    size_t used;            ///< Bytes of the chunks in use, without the free tail of the last one.
+    size_t high_water;      ///< Maximum of used over the lifetime of the arena.
+    size_t chunk_bytes;     ///< Bytes of all chunks held, including those kept by reset().
+    size_t chunks_new;      ///< Number of chunks allocated from the allocator.
+    size_t chunks_reused;   ///< Number of chunks taken from the chunk pool or kept by reset().
+};
+
+/// Process wide statistics of all memory arenas and chunk pools.
+struct Memory_arena_global_statistics {
+    enum { HIGH_WATER_BUCKETS = 10 };
+
+    unsigned long long arenas;          ///< Number of destroyed arenas.
+    unsigned long long chunks_new;      ///< Chunks allocated from allocators.
+    unsigned long long chunks_reused;   ///< Chunks reused from a pool or after reset().
+    unsigned long long pooled_bytes;    ///< Bytes currently held in the per-thread chunk pools.
+    unsigned long long high_water_sum;  ///< Sum of the high-water marks of destroyed arenas.
+    unsigned long long high_water_max;  ///< Largest high-water mark of a destroyed arena.
+
+    /// Histogram of the high-water marks of destroyed arenas: bucket i counts the arenas
+    /// whose high-water mark was below 4 KiB << i, the last bucket counts all others.
+    unsigned long long high_water[HIGH_WATER_BUCKETS];
+};
+
 /// Implementation of the memory arena.
+///
+/// Arena memory is allocated in chunks. Chunks of the standard size classes (4 KiB to 64 KiB)
+/// are not returned to the allocator when an arena releases them, but put into a chunk pool
+/// of the releasing thread, from which the next arena created on that thread with the same
+/// allocator takes its chunks. Arenas growing beyond a few chunks switch to larger size classes.
+///
+/// Pooling is enabled by default with a limit of 1 MiB per thread, see set_chunk_pool_limit().
+/// A pool retains the allocators of its chunks and returns the chunks to them only when its
+/// thread exits or flush_chunk_pools() is called, which the MDLC module does on shutdown.
 class Memory_arena
 {
     typedef unsigned char Byte;
@@ -58,9 +92,13 @@ class Memory_arena
     };
 
     enum sizes {
-        CHUNK_SIZE = 4096   ///< The default size of the arena memory chunks.
+        CHUNK_SIZE = 4096,          ///< The default size of the arena memory chunks.
+        NUM_SIZE_CLASSES = 5,       ///< Number of chunk size classes, CHUNK_SIZE << i.
+        CHUNKS_PER_CLASS = 4        ///< Chunks in use before switching to the next class.
     };
 
+    friend class Memory_arena_chunk_pool;
+
 public:
     /// Constructs a new memory arena.
     ///
@@ -68,7 +106,7 @@ public:
     /// \param chunk_size  the size of the memory chunks allocated from alloc
     explicit Memory_arena(IAllocator *alloc, size_t chunk_size = CHUNK_SIZE);
 
-    /// Destructs the memory arena and frees ALL memory.
+    /// Destructs the memory arena and releases ALL memory.
     ~Memory_arena();
 
 private:
@@ -94,6 +132,12 @@ public:
     /// \param obj  the address of the object to drop, NULL drops the whole memory arena
     void drop(void *obj);
 
+    /// Drop all objects from the arena but keep its chunks for the following allocations.
+    ///
+    /// Use this instead of drop(NULL) if the arena is filled again soon, for instance for
+    /// the next compilation.
+    void reset();
+
     /// Check if an object lies in this memory arena.
     ///
     /// \param obj  the address of an object
@@ -108,6 +152,39 @@ public:
     /// Swap this memory arena content with another.
     void swap(Memory_arena &other);
 
+    /// Get the statistics of this arena.
+    void get_statistics(Memory_arena_statistics &stats) const;
+
+    /// Get the statistics of all arenas destroyed so far and the current pool usage.
+    static void get_global_statistics(Memory_arena_global_statistics &stats);
+
+    /// Set the maximum number of bytes the chunk pool of one thread may hold.
+    ///
+    /// \param limit  the limit in bytes, 0 disables pooling
+    static void set_chunk_pool_limit(size_t limit);
+
+    /// Return all pooled chunks of the given allocator to it.
+    ///
+    /// Must be called before an allocator that is not reference counted is destroyed.
+    ///
+    /// \param alloc  the allocator, NULL flushes the pools of all allocators
+    static void flush_chunk_pools(IAllocator *alloc);
+
+private:
+    /// Get a chunk of at least min_size bytes, NULL if out of memory.
+    Header *get_chunk(size_t min_size);
+
+    /// Release a chunk list to the chunk pool or the allocator.
+    void release_chunks(Header *chunks);
+
+    /// Update the high-water mark.
+    void update_high_water()
+    {
+        size_t used = m_chunk_bytes - m_curr_size;
+        if (used > m_high_water)
+            m_high_water = used;
+    }
+
 private:
 
     /// The allocator.
@@ -119,11 +196,29 @@ private:
     /// The chunk list.
     Header *m_chunks;
 
+    /// Chunks kept by reset().
+    Header *m_free;
+
     /// Pointer to the next free memory.
     Byte *m_next;
 
     /// size of the current chunk
     size_t m_curr_size;
+
+    /// Sum of the sizes of the chunks in m_chunks.
+    size_t m_chunk_bytes;
+
+    /// Number of chunks in m_chunks.
+    size_t m_num_chunks;
+
+    /// Maximum of used memory.
+    size_t m_high_water;
+
+    /// Number of chunks allocated from the allocator.
+    size_t m_chunks_new;
+
+    /// Number of chunks reused.
+    size_t m_chunks_reused;
 };
 
 
@@ -370,7 +370,8 @@ void Messages_impl::set_fname(size_t id, char const *s)
 // Drop all messages.
 void Messages_impl::clear()
 {
-    m_msg_arena.drop(NULL);
+    // keep the chunks, the messages of the next compilation will need them
+    m_msg_arena.reset();
     m_msgs.clear();
     m_err.clear();
     m_filenames.clear();
@@ -41,6 +41,7 @@
 #include "compilercore_call_graph.h"
 #include "compilercore_allocator.h"
 #include "compilercore_tools.h"
+#include "compilercore_trace.h"
 
 namespace mi {
 namespace mdl {
@@ -182,6 +183,8 @@ void Optimizer::run(
         return;
     }
 
+    Trace_scope trace(TP_OPTIMIZER, module.get_name());
+
     Optimizer opt(compiler, module, nt_ana, stmt_info_data, opt_level);
 
     opt.remove_unused_functions();
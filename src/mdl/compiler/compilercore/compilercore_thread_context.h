@@ -60,6 +60,30 @@ public:
         char const    *res) = 0;
 };
 
+/// Interface for coordinating concurrent compilations of the same module.
+///
+/// If a coordinator is set on a thread context, the compiler announces every module it is
+/// about to compile from source, so a compilation of the same module running concurrently on
+/// another thread can wait for the result instead of compiling the module again. The
+/// coordinator is expected to make loaded modules available through the module cache passed
+/// to the compiler.
+class IModule_load_coordinator {
+public:
+    /// Called before a module not found in the module cache is compiled.
+    ///
+    /// \param absname  the absolute name of the module
+    ///
+    /// \return true if the caller should compile the module, false if it was loaded
+    ///         concurrently meanwhile and is now available in the module cache
+    virtual bool begin_load(char const *absname) = 0;
+
+    /// Called after the compilation announced by begin_load() is finished.
+    ///
+    /// \param absname  the absolute name of the module
+    /// \param mod      the compiled module or NULL if compilation failed
+    virtual void end_load(char const *absname, IModule const *mod) = 0;
+};
+
 /// Implementation of the IThread_context interface.
 class Thread_context : public Allocator_interface_implement<IThread_context>
 {
@@ -159,6 +183,18 @@ public:
         return m_repl_file_name.empty() ? NULL : m_repl_file_name.c_str();
     }
 
+    /// Get the module load coordinator if any.
+    IModule_load_coordinator *get_module_load_coordinator() const {
+        return m_load_coordinator;
+    }
+
+    /// Set the module load coordinator.
+    ///
+    /// \param coordinator  the coordinator, inherited by the contexts used to load imports
+    void set_module_load_coordinator(IModule_load_coordinator *coordinator) {
+        m_load_coordinator = coordinator;
+    }
+
 private:
     /// Constructor.
     ///
@@ -190,6 +226,9 @@ private:
 
     /// Module replacement: file name
     string m_repl_file_name;
+
+    /// The module load coordinator if any.
+    IModule_load_coordinator *m_load_coordinator;
 };
 
 }  // mdl
@@ -0,0 +1,229 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "compilercore_thread_pool.h"
+
+namespace mi {
+namespace mdl {
+
+/// The jobs of one group.
+struct Thread_pool::Group_state {
+    /// Constructor.
+    Group_state()
+    : m_pending()
+    , m_running(0)
+    {
+    }
+
+    /// Protects the group.
+    std::mutex m_mutex;
+
+    /// Signals finished jobs.
+    std::condition_variable m_cond;
+
+    /// The jobs not yet started.
+    std::deque<std::function<void()> > m_pending;
+
+    /// The number of jobs currently executed by workers.
+    size_t m_running;
+};
+
+namespace {
+
+/// Protects g_pool.
+std::mutex g_pool_mutex;
+
+/// The shared pool if it is alive.
+std::weak_ptr<Thread_pool> g_pool;
+
+}  // anonymous
+
+// Get the shared pool of this process, create it if necessary.
+std::shared_ptr<Thread_pool> Thread_pool::get()
+{
+    std::lock_guard<std::mutex> lock(g_pool_mutex);
+
+    std::shared_ptr<Thread_pool> pool(g_pool.lock());
+    if (!pool) {
+        // the thread waiting for a group works, too
+        unsigned n = std::thread::hardware_concurrency();
+        pool = std::make_shared<Thread_pool>(n > 1 ? n - 1 : 1);
+        g_pool = pool;
+    }
+    return pool;
+}
+
+// Constructor.
+Thread_pool::Thread_pool(size_t num_workers)
+: m_queue()
+, m_workers()
+, m_stop(false)
+{
+    m_workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i)
+        m_workers.push_back(std::thread(&Thread_pool::run_worker, this));
+}
+
+// Destructor, stops the workers.
+Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (size_t i = 0, n = m_workers.size(); i < n; ++i)
+        m_workers[i].join();
+}
+
+// Get the number of threads parallel_for() would use for the given loop.
+size_t Thread_pool::get_num_threads(size_t n, size_t max_threads) const
+{
+    size_t n_threads = std::min(n, m_workers.size() + 1);
+    if (max_threads > 0 && n_threads > max_threads)
+        n_threads = max_threads;
+    return n_threads;
+}
+
+// Call body(i) for all i in [0, n).
+void Thread_pool::parallel_for(
+    size_t                             n,
+    size_t                             max_threads,
+    std::function<void(size_t)> const &body)
+{
+    size_t n_threads = get_num_threads(n, max_threads);
+    if (n_threads <= 1) {
+        for (size_t i = 0; i < n; ++i)
+            body(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::function<void()> loop([&next, n, &body]() {
+        for (size_t i = next++; i < n; i = next++)
+            body(i);
+    });
+
+    Job_group group(*this);
+    for (size_t i = 1; i < n_threads; ++i)
+        group.run(loop);
+    loop();
+    group.wait();
+}
+
+// Enqueue one job of a group for the workers.
+void Thread_pool::enqueue(std::shared_ptr<Group_state> const &state)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(state);
+    }
+    m_cond.notify_one();
+}
+
+// The worker thread main loop.
+void Thread_pool::run_worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cond.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_stop)
+            return;
+
+        std::shared_ptr<Group_state> state(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> group_lock(state->m_mutex);
+            if (!state->m_pending.empty()) {
+                // otherwise the job was already executed by the waiting thread
+                job.swap(state->m_pending.front());
+                state->m_pending.pop_front();
+                ++state->m_running;
+            }
+        }
+        if (job) {
+            job();
+
+            std::lock_guard<std::mutex> group_lock(state->m_mutex);
+            --state->m_running;
+            state->m_cond.notify_all();
+        }
+
+        lock.lock();
+    }
+}
+
+// Constructor.
+Thread_pool::Job_group::Job_group(Thread_pool &pool)
+: m_pool(pool)
+, m_state(std::make_shared<Group_state>())
+{
+}
+
+// Destructor, waits for all jobs of the group.
+Thread_pool::Job_group::~Job_group()
+{
+    wait();
+}
+
+// Submit a job.
+void Thread_pool::Job_group::run(std::function<void()> const &job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_mutex);
+        m_state->m_pending.push_back(job);
+    }
+    m_pool.enqueue(m_state);
+}
+
+// Wait until all submitted jobs are finished.
+void Thread_pool::Job_group::wait()
+{
+    std::unique_lock<std::mutex> lock(m_state->m_mutex);
+    while (!m_state->m_pending.empty()) {
+        std::function<void()> job;
+        job.swap(m_state->m_pending.front());
+        m_state->m_pending.pop_front();
+
+        lock.unlock();
+        job();
+        lock.lock();
+    }
+    m_state->m_cond.wait(lock, [this]() { return m_state->m_running == 0; });
+}
+
+}  // mdl
+}  // mi
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef MDL_COMPILERCORE_THREAD_POOL_H
+#define MDL_COMPILERCORE_THREAD_POOL_H 1
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "compilercore_cc_conf.h"
+
+namespace mi {
+namespace mdl {
+
+/// A pool of worker threads shared by all parallel code paths of the MDL SDK.
+///
+/// There is at most one pool per process, it is created on first use by get() and lives as
+/// long as a reference to it is held (the MDL compiler holds one). Jobs are submitted in groups.
+/// Waiting for a group executes its not yet started jobs on the waiting thread, hence parallel
+/// code can be nested (a job may wait for a group of its own) and the total number of threads
+/// is bounded by the pool size plus the number of threads waiting for groups.
+class Thread_pool {
+    struct Group_state;
+public:
+    /// A group of jobs that can be waited for.
+    ///
+    /// The group must not be used concurrently from different threads.
+    class Job_group {
+    public:
+        /// Constructor.
+        ///
+        /// \param pool  the pool executing the jobs
+        explicit Job_group(Thread_pool &pool);
+
+        /// Destructor, waits for all jobs of the group.
+        ~Job_group();
+
+        /// Submit a job.
+        ///
+        /// \param job  the job, it may be executed on any worker or on the thread calling wait()
+        void run(std::function<void()> const &job);
+
+        /// Wait until all submitted jobs are finished.
+        ///
+        /// Jobs not yet picked up by a worker are executed on the calling thread.
+        void wait();
+
+    private:
+        // non copyable
+        Job_group(Job_group const &) MDL_DELETED_FUNCTION;
+        Job_group &operator=(Job_group const &) MDL_DELETED_FUNCTION;
+
+    private:
+        /// The pool.
+        Thread_pool &m_pool;
+
+        /// The state shared with the workers.
+        std::shared_ptr<Group_state> m_state;
+    };
+
+    /// Get the shared pool of this process, create it if necessary.
+    static std::shared_ptr<Thread_pool> get();
+
+    /// Constructor.
+    ///
+    /// \param num_workers  the number of worker threads
+    explicit Thread_pool(size_t num_workers);
+
+    /// Destructor, stops the workers.
+    ///
+    /// \note Must not be called from a worker thread of this pool.
+    ~Thread_pool();
+
+    /// Get the number of worker threads.
+    size_t get_num_workers() const { return m_workers.size(); }
+
+    /// Call \p body(i) for all i in [0, n).
+    ///
+    /// The iterations are distributed over the calling thread and the workers, small loops run
+    /// on the calling thread only.
+    ///
+    /// \param n            the number of iterations
+    /// \param max_threads  the maximum number of threads executing the loop including the
+    ///                     calling thread, 0 for no limit beyond the pool size
+    /// \param body         the loop body, called concurrently for different iterations
+    void parallel_for(size_t n, size_t max_threads, std::function<void(size_t)> const &body);
+
+    /// Get the number of threads parallel_for() would use for the given loop.
+    ///
+    /// \param n            the number of iterations
+    /// \param max_threads  the maximum number of threads including the calling thread, 0 for
+    ///                     no limit beyond the pool size
+    size_t get_num_threads(size_t n, size_t max_threads) const;
+
+private:
+    // non copyable
+    Thread_pool(Thread_pool const &) MDL_DELETED_FUNCTION;
+    Thread_pool &operator=(Thread_pool const &) MDL_DELETED_FUNCTION;
+
+    /// Enqueue one job of a group for the workers.
+    void enqueue(std::shared_ptr<Group_state> const &state);
+
+    /// The worker thread main loop.
+    void run_worker();
+
+private:
+    /// Protects the queue.
+    std::mutex m_mutex;
+
+    /// Signals new jobs and stop requests to the workers.
+    std::condition_variable m_cond;
+
+    /// One entry for every submitted job, the job itself is taken from the group.
+    std::deque<std::shared_ptr<Group_state> > m_queue;
+
+    /// The workers.
+    std::vector<std::thread> m_workers;
+
+    /// Set to stop the workers.
+    bool m_stop;
+};
+
+}  // mdl
+}  // mi
+
+#endif
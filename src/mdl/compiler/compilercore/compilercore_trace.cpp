@@ -0,0 +1,572 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "pch.h"
+
+#include "compilercore_trace.h"
+#include "compilercore_memory_arena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mi {
+namespace mdl {
+
+namespace {
+
+/// Get the current time in seconds.
+double get_current_time()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// A recorded scope.
+struct Trace_event {
+    /// The start time in seconds.
+    double      start;
+
+    /// The duration in seconds.
+    double      duration;
+
+    /// The ID of the recording thread.
+    unsigned    tid;
+
+    /// The phase.
+    Trace_phase phase;
+
+    /// The (truncated) detail string.
+    char        detail[64];
+};
+
+/// The event ring buffer of one thread.
+struct Thread_buffer {
+    /// Constructor.
+    explicit Thread_buffer(size_t size)
+    : events(size)
+    , next(0)
+    , count(0)
+    , tid(0)
+    {
+    }
+
+    /// Protects the events against concurrent export.
+    std::mutex               lock;
+
+    /// The ring buffer.
+    std::vector<Trace_event> events;
+
+    /// The next write position.
+    size_t                   next;
+
+    /// The number of valid events.
+    size_t                   count;
+
+    /// The ID of the owning thread.
+    unsigned                 tid;
+};
+
+/// The counters of one phase, times are in nanoseconds.
+struct Phase_counter {
+    std::atomic<unsigned long long> count;
+    std::atomic<unsigned long long> total_ns;
+    std::atomic<unsigned long long> max_ns;
+};
+
+/// The process wide state of the recorder.
+class Trace_registry {
+public:
+    /// Get the registry.
+    static Trace_registry &get()
+    {
+        static Trace_registry registry;
+        return registry;
+    }
+
+    /// Acquire an event buffer for the current thread.
+    Thread_buffer *acquire()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        Thread_buffer *buffer = NULL;
+        if (!m_free.empty()) {
+            // reuse the buffer of a finished thread, its events are kept
+            buffer = m_free.back();
+            m_free.pop_back();
+        } else {
+            m_buffers.push_back(std::unique_ptr<Thread_buffer>(new Thread_buffer(m_buffer_size)));
+            buffer = m_buffers.back().get();
+        }
+        std::lock_guard<std::mutex> buffer_guard(buffer->lock);
+        buffer->tid = ++m_next_tid;
+        return buffer;
+    }
+
+    /// Return the buffer of a finished thread.
+    void release(Thread_buffer *buffer)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_free.push_back(buffer);
+    }
+
+    /// Set the capacity of new buffers.
+    void set_buffer_size(size_t size)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_buffer_size = size;
+    }
+
+    /// Update the counters of a phase.
+    void count(Trace_phase phase, double duration)
+    {
+        Phase_counter &c = m_counters[phase];
+
+        unsigned long long ns = duration > 0.0 ? (unsigned long long)(duration * 1.0e9) : 0;
+
+        c.count.fetch_add(1, std::memory_order_relaxed);
+        c.total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+        unsigned long long max = c.max_ns.load(std::memory_order_relaxed);
+        while (ns > max && !c.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// Get the counters of a phase.
+    void get_statistics(Trace_phase phase, Trace_phase_statistics &stats) const
+    {
+        Phase_counter const &c = m_counters[phase];
+
+        stats.count      = c.count.load(std::memory_order_relaxed);
+        stats.total_time = c.total_ns.load(std::memory_order_relaxed) * 1.0e-9;
+        stats.max_time   = c.max_ns.load(std::memory_order_relaxed) * 1.0e-9;
+    }
+
+    /// Copy all recorded events.
+    void collect(std::vector<Trace_event> &events)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        for (size_t i = 0, n = m_buffers.size(); i < n; ++i) {
+            Thread_buffer &buffer = *m_buffers[i];
+            std::lock_guard<std::mutex> buffer_guard(buffer.lock);
+
+            size_t size  = buffer.events.size();
+            size_t first = (buffer.next + size - buffer.count) % (size == 0 ? 1 : size);
+            for (size_t k = 0; k < buffer.count; ++k)
+                events.push_back(buffer.events[(first + k) % size]);
+        }
+    }
+
+    /// Drop all events and reset the counters.
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        for (size_t i = 0, n = m_buffers.size(); i < n; ++i) {
+            Thread_buffer &buffer = *m_buffers[i];
+            std::lock_guard<std::mutex> buffer_guard(buffer.lock);
+
+            buffer.next  = 0;
+            buffer.count = 0;
+        }
+        for (size_t i = 0; i <= TP_LAST; ++i) {
+            m_counters[i].count.store(0, std::memory_order_relaxed);
+            m_counters[i].total_ns.store(0, std::memory_order_relaxed);
+            m_counters[i].max_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Get the time all event timestamps are relative to.
+    double get_origin() const { return m_origin; }
+
+private:
+    /// Constructor.
+    Trace_registry()
+    : m_buffer_size(16 * 1024)
+    , m_next_tid(0)
+    , m_origin(get_current_time())
+    {
+        for (size_t i = 0; i <= TP_LAST; ++i) {
+            m_counters[i].count.store(0, std::memory_order_relaxed);
+            m_counters[i].total_ns.store(0, std::memory_order_relaxed);
+            m_counters[i].max_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    /// Protects the buffer lists.
+    std::mutex                                  m_lock;
+
+    /// All buffers ever created.
+    std::vector<std::unique_ptr<Thread_buffer>> m_buffers;
+
+    /// The buffers of finished threads.
+    std::vector<Thread_buffer *>                m_free;
+
+    /// The capacity of new buffers.
+    size_t                                      m_buffer_size;
+
+    /// The last assigned thread ID.
+    unsigned                                    m_next_tid;
+
+    /// The time origin.
+    double                                      m_origin;
+
+    /// The per-phase counters.
+    Phase_counter                               m_counters[TP_LAST + 1];
+};
+
+/// Owns the event buffer of a thread and returns it when the thread ends.
+struct Thread_buffer_holder {
+    Thread_buffer_holder() : buffer(NULL) {}
+
+    ~Thread_buffer_holder()
+    {
+        if (buffer != NULL)
+            Trace_registry::get().release(buffer);
+    }
+
+    Thread_buffer *buffer;
+};
+
+thread_local Thread_buffer_holder t_buffer;
+
+/// The number of active scopes per phase of the current thread.
+thread_local unsigned t_depth[TP_LAST + 1];
+
+/// Append a JSON string literal.
+void append_json_string(std::string &json, char const *s)
+{
+    json += '"';
+    for (; *s != '\0'; ++s) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+        case '"':  json += "\\\""; break;
+        case '\\': json += "\\\\"; break;
+        case '\n': json += "\\n";  break;
+        case '\r': json += "\\r";  break;
+        case '\t': json += "\\t";  break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+                json += buf;
+            } else {
+                json += char(c);
+            }
+            break;
+        }
+    }
+    json += '"';
+}
+
+/// Write a text to a file.
+///
+/// The text is written to a temporary file first, which is renamed afterwards, so a
+/// concurrent reader (for instance a metrics scraper) never sees a partial file.
+bool write_file(char const *file_name, std::string const &text)
+{
+    std::string tmp_name(file_name);
+    tmp_name += ".tmp";
+
+    FILE *f = fopen(tmp_name.c_str(), "wb");
+    if (f == NULL)
+        return false;
+
+    bool res = fwrite(text.c_str(), 1, text.size(), f) == text.size();
+    if (fclose(f) != 0)
+        res = false;
+    if (res) {
+#ifdef MI_PLATFORM_WINDOWS
+        // rename() does not replace existing files on Windows
+        remove(file_name);
+#endif
+        res = rename(tmp_name.c_str(), file_name) == 0;
+    }
+    if (!res)
+        remove(tmp_name.c_str());
+    return res;
+}
+
+/// Orders events by start time, enclosing scopes first.
+bool event_less(Trace_event const &a, Trace_event const &b)
+{
+    if (a.start != b.start)
+        return a.start < b.start;
+    if (a.duration != b.duration)
+        return a.duration > b.duration;
+    return a.tid < b.tid;
+}
+
+}  // anonymous
+
+std::atomic<unsigned> Trace::s_mode(Trace::TM_OFF);
+
+// Set the recording mode.
+void Trace::set_mode(unsigned mode)
+{
+    // create the registry now, so the time origin is not inside the first scope
+    Trace_registry::get();
+
+    s_mode.store(mode & (TM_COUNTERS | TM_EVENTS), std::memory_order_relaxed);
+}
+
+// Set the capacity of the event ring buffer of every thread.
+void Trace::set_buffer_size(size_t num_events)
+{
+    Trace_registry::get().set_buffer_size(num_events);
+}
+
+// Get the name of a phase.
+char const *Trace::get_phase_name(Trace_phase phase)
+{
+    switch (phase) {
+    case TP_PARSE:            return "parse";
+    case TP_ANALYSIS:         return "analysis";
+    case TP_OPTIMIZER:        return "optimizer";
+    case TP_DAG_BUILD:        return "dag_build";
+    case TP_INSTANCE_COMPILE: return "instance_compile";
+    case TP_LAMBDA_OPTIMIZE:  return "lambda_optimize";
+    case TP_LLVM_IR_GEN:      return "llvm_ir_gen";
+    case TP_LLVM_PASSES:      return "llvm_passes";
+    case TP_PTX_EMIT:         return "ptx_emit";
+    }
+    return "<unknown>";
+}
+
+// Get the aggregated statistics of a phase.
+void Trace::get_statistics(Trace_phase phase, Trace_phase_statistics &stats)
+{
+    Trace_registry::get().get_statistics(phase, stats);
+}
+
+// Drop all recorded events and reset the counters.
+void Trace::reset()
+{
+    Trace_registry::get().reset();
+}
+
+// Export the recorded events in the Chrome trace event format.
+void Trace::export_chrome_trace(std::string &json)
+{
+    Trace_registry &registry = Trace_registry::get();
+
+    std::vector<Trace_event> events;
+    registry.collect(events);
+    std::stable_sort(events.begin(), events.end(), event_less);
+
+    double origin = registry.get_origin();
+
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0, n = events.size(); i < n; ++i) {
+        Trace_event const &ev = events[i];
+
+        char buf[128];
+        snprintf(
+            buf, sizeof(buf),
+            "%s\n{\"name\":\"%s\",\"cat\":\"mdl\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":1,\"tid\":%u",
+            i > 0 ? "," : "",
+            get_phase_name(ev.phase),
+            (ev.start - origin) * 1.0e6,
+            ev.duration * 1.0e6,
+            ev.tid);
+        json += buf;
+
+        if (ev.detail[0] != '\0') {
+            json += ",\"args\":{\"detail\":";
+            append_json_string(json, ev.detail);
+            json += '}';
+        }
+        json += '}';
+    }
+    json += "\n]}\n";
+}
+
+// Write the recorded events in the Chrome trace event format to a file.
+bool Trace::write_chrome_trace(char const *file_name)
+{
+    std::string json;
+    export_chrome_trace(json);
+    return write_file(file_name, json);
+}
+
+// Export the per-phase counters in the Prometheus text exposition format.
+void Trace::export_counters(std::string &text)
+{
+    static char const * const metrics[][3] = {
+        { "mdl_phase_calls_total",   "counter", "Number of completed MDL compiler phases." },
+        { "mdl_phase_seconds_total", "counter", "Time spent in MDL compiler phases." },
+        { "mdl_phase_seconds_max",   "gauge",   "Longest single run of MDL compiler phases." },
+    };
+
+    Trace_phase_statistics stats[TP_LAST + 1];
+    for (size_t i = 0; i <= TP_LAST; ++i)
+        get_statistics(Trace_phase(i), stats[i]);
+
+    for (size_t m = 0; m < 3; ++m) {
+        text += "# HELP ";
+        text += metrics[m][0];
+        text += ' ';
+        text += metrics[m][2];
+        text += "\n# TYPE ";
+        text += metrics[m][0];
+        text += ' ';
+        text += metrics[m][1];
+        text += '\n';
+
+        for (size_t i = 0; i <= TP_LAST; ++i) {
+            char buf[128];
+            switch (m) {
+            case 0:
+                snprintf(buf, sizeof(buf), "%s{phase=\"%s\"} %llu\n",
+                    metrics[m][0], get_phase_name(Trace_phase(i)), stats[i].count);
+                break;
+            case 1:
+                snprintf(buf, sizeof(buf), "%s{phase=\"%s\"} %.9f\n",
+                    metrics[m][0], get_phase_name(Trace_phase(i)), stats[i].total_time);
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "%s{phase=\"%s\"} %.9f\n",
+                    metrics[m][0], get_phase_name(Trace_phase(i)), stats[i].max_time);
+                break;
+            }
+            text += buf;
+        }
+    }
+
+    // memory arena usage, helps sizing the arena chunk pools
+    Memory_arena_global_statistics arena_stats;
+    Memory_arena::get_global_statistics(arena_stats);
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "# HELP mdl_arena_chunks_total Number of memory arena chunks by origin.\n"
+        "# TYPE mdl_arena_chunks_total counter\n"
+        "mdl_arena_chunks_total{origin=\"new\"} %llu\n"
+        "mdl_arena_chunks_total{origin=\"reused\"} %llu\n",
+        arena_stats.chunks_new, arena_stats.chunks_reused);
+    text += buf;
+    snprintf(buf, sizeof(buf),
+        "# HELP mdl_arena_pooled_bytes Bytes held by the memory arena chunk pools.\n"
+        "# TYPE mdl_arena_pooled_bytes gauge\n"
+        "mdl_arena_pooled_bytes %llu\n",
+        arena_stats.pooled_bytes);
+    text += buf;
+
+    snprintf(buf, sizeof(buf),
+        "# HELP mdl_arena_high_water_bytes_max Largest high-water mark of a memory arena.\n"
+        "# TYPE mdl_arena_high_water_bytes_max gauge\n"
+        "mdl_arena_high_water_bytes_max %llu\n",
+        arena_stats.high_water_max);
+    text += buf;
+
+    text += "# HELP mdl_arena_high_water_bytes High-water marks of destroyed memory arenas.\n"
+        "# TYPE mdl_arena_high_water_bytes histogram\n";
+    unsigned long long cumulative = 0;
+    for (size_t i = 0; i < Memory_arena_global_statistics::HIGH_WATER_BUCKETS; ++i) {
+        cumulative += arena_stats.high_water[i];
+        if (i + 1 < Memory_arena_global_statistics::HIGH_WATER_BUCKETS) {
+            snprintf(buf, sizeof(buf), "mdl_arena_high_water_bytes_bucket{le=\"%llu\"} %llu\n",
+                4096ull << i, cumulative);
+        } else {
+            snprintf(buf, sizeof(buf), "mdl_arena_high_water_bytes_bucket{le=\"+Inf\"} %llu\n",
+                cumulative);
+        }
+        text += buf;
+    }
+    snprintf(buf, sizeof(buf),
+        "mdl_arena_high_water_bytes_sum %llu\n"
+        "mdl_arena_high_water_bytes_count %llu\n",
+        arena_stats.high_water_sum, arena_stats.arenas);
+    text += buf;
+}
+
+// Write the per-phase counters in the Prometheus text exposition format to a file.
+bool Trace::write_counters(char const *file_name)
+{
+    std::string text;
+    export_counters(text);
+    return write_file(file_name, text);
+}
+
+// Enter a scope.
+double Trace::enter(Trace_phase phase)
+{
+    ++t_depth[phase];
+    return get_current_time();
+}
+
+// Record a finished scope.
+void Trace::record(Trace_phase phase, char const *detail, double start)
+{
+    double   duration = get_current_time() - start;
+    unsigned mode     = get_mode();
+
+    Trace_registry &registry = Trace_registry::get();
+
+    // count only the outermost scope of a phase, nested ones are already included
+    if (--t_depth[phase] == 0 && (mode & TM_COUNTERS))
+        registry.count(phase, duration);
+
+    if (mode & TM_EVENTS) {
+        Thread_buffer *buffer = t_buffer.buffer;
+        if (buffer == NULL)
+            buffer = t_buffer.buffer = registry.acquire();
+
+        std::lock_guard<std::mutex> guard(buffer->lock);
+
+        size_t size = buffer->events.size();
+        if (size == 0)
+            return;
+
+        Trace_event &ev = buffer->events[buffer->next];
+        ev.start    = start;
+        ev.duration = duration;
+        ev.tid      = buffer->tid;
+        ev.phase    = phase;
+        if (detail != NULL) {
+            strncpy(ev.detail, detail, sizeof(ev.detail) - 1);
+            ev.detail[sizeof(ev.detail) - 1] = '\0';
+        } else {
+            ev.detail[0] = '\0';
+        }
+
+        buffer->next = (buffer->next + 1) % size;
+        if (buffer->count < size)
+            ++buffer->count;
+    }
+}
+
+}  // mdl
+}  // mi
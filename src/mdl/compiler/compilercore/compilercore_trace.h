@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#ifndef MDL_COMPILERCORE_TRACE_H
+#define MDL_COMPILERCORE_TRACE_H 1
+
+#include <atomic>
+#include <string>
+
+#include "compilercore_cc_conf.h"
+
+namespace mi {
+namespace mdl {
+
+/// The instrumented phases of loading and translating MDL materials.
+enum Trace_phase {
+    TP_PARSE,               ///< Parsing a module.
+    TP_ANALYSIS,            ///< Name and type analysis of a module.
+    TP_OPTIMIZER,           ///< The AST optimizer.
+    TP_DAG_BUILD,           ///< Building the DAG representation of a module.
+    TP_INSTANCE_COMPILE,    ///< Compiling a material instance.
+    TP_LAMBDA_OPTIMIZE,     ///< Optimizing a lambda function.
+    TP_LLVM_IR_GEN,         ///< Generating LLVM IR.
+    TP_LLVM_PASSES,         ///< Running the LLVM optimization passes.
+    TP_PTX_EMIT,            ///< Emitting PTX code.
+    TP_LAST = TP_PTX_EMIT
+};
+
+/// Aggregated statistics of one phase.
+struct Trace_phase_statistics {
+    unsigned long long count;       ///< Number of completed scopes.
+    double             total_time;  ///< Accumulated time in seconds.
+    double             max_time;    ///< Longest single scope in seconds.
+};
+
+/// Process wide recorder of the time spent in the phases of the MDL compiler.
+///
+/// Two levels of recording are supported: the per-phase counters are cheap enough to be
+/// enabled in production and can be scraped at any time, the events additionally record every
+/// scope into a ring buffer per thread, which can be exported as a Chrome trace (also readable
+/// by Perfetto). Scopes on the same thread nest, so the trace shows the phase hierarchy.
+///
+/// The counters measure inclusive time: a phase includes the time of other phases nested
+/// inside it, but only the outermost scope of a phase on a thread is counted.
+class Trace {
+    friend class Trace_scope;
+public:
+    /// Recording modes, may be combined.
+    enum Mode {
+        TM_OFF      = 0,        ///< Nothing is recorded.
+        TM_COUNTERS = 1 << 0,   ///< Per-phase counters are aggregated.
+        TM_EVENTS   = 1 << 1,   ///< Every scope is recorded as an event.
+    };
+
+    /// Set the recording mode.
+    ///
+    /// \param mode  a combination of Mode flags
+    static void set_mode(unsigned mode);
+
+    /// Get the recording mode.
+    static unsigned get_mode() { return s_mode.load(std::memory_order_relaxed); }
+
+    /// Set the capacity of the event ring buffer of every thread.
+    ///
+    /// \param num_events  the number of events kept per thread, older events are overwritten
+    ///
+    /// \note Affects only threads recording their first event after this call.
+    static void set_buffer_size(size_t num_events);
+
+    /// Get the name of a phase.
+    static char const *get_phase_name(Trace_phase phase);
+
+    /// Get the aggregated statistics of a phase.
+    static void get_statistics(Trace_phase phase, Trace_phase_statistics &stats);
+
+    /// Drop all recorded events and reset the counters.
+    static void reset();
+
+    /// Export the recorded events in the Chrome trace event format.
+    ///
+    /// \param json  the JSON document will be appended here
+    static void export_chrome_trace(std::string &json);
+
+    /// Write the recorded events in the Chrome trace event format to a file.
+    ///
+    /// \param file_name  the name of the file
+    ///
+    /// \return true on success
+    static bool write_chrome_trace(char const *file_name);
+
+    /// Export the per-phase counters in the Prometheus text exposition format.
+    ///
+    /// \param text  the counters will be appended here
+    static void export_counters(std::string &text);
+
+    /// Write the per-phase counters in the Prometheus text exposition format to a file.
+    ///
+    /// \param file_name  the name of the file, replaced atomically
+    ///
+    /// \return true on success
+    static bool write_counters(char const *file_name);
+
+private:
+    /// Enter a scope.
+    ///
+    /// \param phase  the phase of the scope
+    ///
+    /// \return the start time of the scope
+    static double enter(Trace_phase phase);
+
+    /// Record a finished scope.
+    ///
+    /// \param phase   the phase of the scope
+    /// \param detail  an optional detail string, will be truncated, may be NULL
+    /// \param start   the start time of the scope
+    static void record(Trace_phase phase, char const *detail, double start);
+
+private:
+    /// The current mode.
+    static std::atomic<unsigned> s_mode;
+};
+
+/// Records the lifetime of an object as a scope of the given phase.
+///
+/// If tracing is disabled, this costs a single atomic load.
+class Trace_scope {
+public:
+    /// Constructor.
+    ///
+    /// \param phase   the phase of the scope
+    /// \param detail  an optional detail string (for instance the module name) that must be
+    ///                valid for the lifetime of the scope, may be NULL
+    explicit Trace_scope(Trace_phase phase, char const *detail = NULL)
+    : m_phase(phase)
+    , m_detail(detail)
+    , m_start(Trace::get_mode() != Trace::TM_OFF ? Trace::enter(phase) : -1.0)
+    {
+    }
+
+    /// Destructor.
+    ~Trace_scope()
+    {
+        if (m_start >= 0.0)
+            Trace::record(m_phase, m_detail, m_start);
+    }
+
+private:
+    // non copyable
+    Trace_scope(Trace_scope const &) MDL_DELETED_FUNCTION;
+    Trace_scope &operator=(Trace_scope const &) MDL_DELETED_FUNCTION;
+
+private:
+    /// The phase of this scope.
+    Trace_phase m_phase;
+
+    /// The detail string if any.
+    char const  *m_detail;
+
+    /// The start time or a negative value if tracing is disabled.
+    double      m_start;
+};
+
+}  // mdl
+}  // mi
+
+#endif
@@ -27,18 +27,25 @@
  *****************************************************************************/
 #include "pch.h"
 #include "i18n_db.h"
+#include "i18n_table.h"
 using namespace MI::MDL::I18N;
 using MI::MDL::I18N::Database;
 
 #include <vector>
 #include <clocale>
+#include <cstdio>
 #include <map>
+#include <memory>
 #include <set>
+#ifndef MI_PLATFORM_WINDOWS
+#include <sys/stat.h>
+#endif
 #include <base/lib/tinyxml2/tinyxml2.h>
 #include <base/system/main/access_module.h>
 #include <base/lib/path/i_path.h>
 #include <base/hal/hal/i_hal_ospath.h>
 #include <base/hal/disk/disk.h>
+#include <base/hal/hal/hal.h>
 #include <base/lib/log/i_log_assert.h>
 #include <base/util/string_utils/i_string_utils.h>
 #include <base/lib/log/i_log_logger.h>
@@ -321,22 +328,6 @@ public:
     }
 };
 
-class Dictionary : public std::map<std::string, std::string>
-{
-public:
-    bool translate(const std::string & source, std::string & target) const;
-};
-
-class Context_dictionaries : public std::map<Qualified_name, Dictionary>
-{
-public:
-    bool translate(
-        const std::string & context
-        , const std::string & source
-        , std::string & target
-    ) const;
-};
-
 namespace helper
 {
 class File
@@ -368,6 +359,92 @@ public:
     {
         return m_archive_filename;
     }
+    /// Get the stamp identifying the current version of the file, i.e. of the archive
+    /// containing it.
+    bool get_stamp(Translation_table_stamp & stamp) const
+    {
+        const char * filename = is_archive() ? m_archive_filename.c_str() : m_filename.c_str();
+        DISK::Stat st;
+        if (!DISK::stat(filename, &st))
+        {
+            return false;
+        }
+        stamp.m_size = mi::Uint64(st.m_size);
+        stamp.m_mtime = st.m_modification_time.get_seconds();
+        stamp.m_mtime_nsec = 0;
+
+        // DISK::stat() has a resolution of one second, which misses edits of the same size
+        // within that second
+#if defined(MI_PLATFORM_MACOSX)
+        struct stat nst;
+        if (::stat(filename, &nst) == 0)
+        {
+            stamp.m_mtime_nsec = mi::Uint32(nst.st_mtimespec.tv_nsec);
+        }
+#elif !defined(MI_PLATFORM_WINDOWS)
+        struct stat nst;
+        if (::stat(filename, &nst) == 0)
+        {
+            stamp.m_mtime_nsec = mi::Uint32(nst.st_mtim.tv_nsec);
+        }
+#endif
+        return true;
+    }
+    /// Get the file name of the compiled translation table in the cache directory.
+    ///
+    /// Tables are never cached next to the XLIFF file: search paths may be shared or packed
+    /// into archives.
+    ///
+    /// \param cache_directory  the cache directory, empty if caching is disabled
+    ///
+    /// \return the empty string if there is no cache directory
+    string get_cache_filename(const string & cache_directory) const
+    {
+        if (cache_directory.empty())
+        {
+            return string();
+        }
+
+        // FNV-1a of the full name, stable across runs
+        string name(is_archive() ? m_archive_filename + ":" + m_filename : m_filename);
+        mi::Uint64 h = 0xcbf29ce484222325ull;
+        for (char c : name)
+        {
+            h = (h ^ mi::Uint8(c)) * 0x100000001b3ull;
+        }
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%016llx.bin", static_cast<unsigned long long>(h));
+
+        return HAL::Ospath::join(cache_directory, buffer);
+    }
+    /// The default per-user directory for compiled translation tables.
+    ///
+    /// Other users must not be able to plant tables, hence no shared temp directory is used.
+    ///
+    /// \return the empty string if there is no suitable directory
+    static string get_default_cache_directory()
+    {
+#ifndef MI_PLATFORM_WINDOWS
+        string base(HAL::get_env("XDG_CACHE_HOME"));
+        if (base.empty() || !DISK::is_path_absolute(base.c_str()))
+        {
+            string home(HAL::get_env("HOME"));
+            if (home.empty())
+            {
+                return string();
+            }
+            base = HAL::Ospath::join(home, ".cache");
+        }
+        return HAL::Ospath::join(base, "mdl_i18n");
+#else
+        string base(HAL::get_userdata_dir());
+        if (base == ".")
+        {
+            return string();
+        }
+        return HAL::Ospath::join(base, "mdl_i18n_cache");
+#endif
+    }
     bool exist() const
     {
         if (is_archive())
@@ -758,71 +835,119 @@ public:
     {}
     virtual Sint32 translate(Mdl_translator_module::Translation_unit & sentence) = 0;
     virtual Sint32 cleanup() = 0;
+    virtual void set_cache_directory(const string & directory) = 0;
+    virtual const string & get_cache_directory() const = 0;
 };
 
 class Flexible_database_impl : public MI::MDL::I18N::Database_impl
 {
-    class Translation_db : public XLIFF_loader
+    /// Collects the translation units of an XLIFF file.
+    class Translation_compiler : public XLIFF_loader
     {
     private:
-        Dictionary m_global_dictionary;
-        Context_dictionaries m_context_dictionaries;
+        Translation_table_builder m_builder;
         Qualified_name m_qualified_name;
     public:
-        Translation_db()
-        {}
-        Translation_db(const Qualified_name & qualified_name)
+        Translation_compiler(const Qualified_name & qualified_name)
             : m_qualified_name(qualified_name)
         {}
+        const Translation_table_builder & get_builder() const
+        {
+            return m_builder;
+        }
         // From XLIFF_loader
         void add_trans_unit(const string & source, const string & target) override
         {
-            m_global_dictionary[source] = target;
+            m_builder.add("", source, target);
         }
         // From XLIFF_loader
         void add_trans_unit(
             const string & context, const string & source, const string & target) override
         {
             // Prepend the qualified name to the relative context
-            string context_key = m_qualified_name + "::" + context;
+            m_builder.add(m_qualified_name + "::" + context, source, target);
+        }
+    };
 
-            // Since we prepend the context, no need to do the test
-            //if(has_beginning(context, m_qualified_name))
-            if(1)
+    /// The translations of one module or package, in the compiled binary format.
+    class Translation_db
+    {
+    private:
+        std::shared_ptr<Translation_table> m_table;
+        Qualified_name m_qualified_name;
+    public:
+        Translation_db()
+        {}
+        Translation_db(const Qualified_name & qualified_name)
+            : m_table(new Translation_table)
+            , m_qualified_name(qualified_name)
+        {}
+
+        /// Map the compiled table of the given XLIFF file, compiling it if it is not cached
+        /// or out of date.
+        ///
+        /// \param file             the XLIFF file
+        /// \param cache_directory  the directory of the compiled tables, empty to not cache them
+        bool load_file(const helper::File & file, const string & cache_directory)
+        {
+            // Without a stamp, a cached table cannot be validated
+            Translation_table_stamp stamp;
+            string cache_filename;
+            if (file.get_stamp(stamp))
             {
-                m_context_dictionaries[context_key][source] = target;
+                cache_filename = file.get_cache_filename(cache_directory);
             }
-            else
+            if (!cache_filename.empty() && m_table->map(cache_filename, stamp))
+            {
+                return true;
+            }
+
+            Translation_compiler compiler(m_qualified_name);
+            if (!compiler.load_file(file))
+            {
+                return false;
+            }
+
+            vector<mi::Uint8> data;
+            if (!compiler.get_builder().serialize(stamp, data))
             {
-                if (!m_filename.empty())
-                {
-                    ::MI::LOG::mod_log->error(
-                        M_I18N
-                        , MI::LOG::ILogger::C_PLUGIN
-                        , "Error in file: %s"
-                        , m_filename.c_str()
-                    );
-                }
                 ::MI::LOG::mod_log->error(
                     M_I18N
                     , MI::LOG::ILogger::C_PLUGIN
-                    , "Ignoring translation of: %s. Context does not match package: %s"
-                    , context.c_str()
-                    , m_qualified_name.c_str()
+                    , "Failed to compile translation table for: %s"
+                    , file.get_filename().c_str()
                 );
+                return false;
             }
+
+            // Write the cache file, failures only cost a recompile next time
+            if (!cache_filename.empty())
+            {
+                string cache_directory(HAL::Ospath::dirname(cache_filename));
+                if (!DISK::is_directory(cache_directory.c_str()))
+                {
+                    DISK::mkdir(cache_directory.c_str(), 0700);
+                }
+                Translation_table::write(cache_filename, data);
+            }
+            return m_table->assign(data);
         }
 
         bool translate(Mdl_translator_module::Translation_unit & sentence) const
         {
+            if (!m_table)
+            {
+                return false;
+            }
+
             // Try with context
             string translation;
-            bool translated = m_context_dictionaries.translate(
+            bool translated = m_table->translate(
                 sentence.get_context(), sentence.get_source(), translation);
             if (!translated)
             {
                 // Try without context
-                translated = m_global_dictionary.translate(sentence.get_source(), translation);
+                translated = m_table->translate("", sentence.get_source(), translation);
             }
             if (translated)
             {
@@ -832,19 +957,24 @@ class Flexible_database_impl : public MI::MDL::I18N::Database_impl
         }
     };
 
-    typedef map<helper::Module, Translation_db> Module_map;
-    typedef map<helper::Package, Translation_db> Package_map;
+    // Translations are kept per locale, so switching back to a locale does not reload them
+    typedef std::pair<string, helper::Module> Module_key;
+    typedef std::pair<string, helper::Package> Package_key;
+    typedef map<Module_key, Translation_db> Module_map;
+    typedef map<Package_key, Translation_db> Package_map;
     Module_map m_module_dictionaries;
     Package_map m_package_dictionaries;
-    set<helper::Module> m_initialized_modules;
-    set<helper::Package> m_initialized_packages;
+    set<Module_key> m_initialized_modules;
+    set<Package_key> m_initialized_packages;
+    string m_cache_directory = helper::File::get_default_cache_directory();
 
 private:
     void init_db(const helper::Module & module, const string & locale)
     {
         // if not init
         // Look for XLIFF files corresponding to the given module and locale
-        if (m_initialized_modules.find(module) == m_initialized_modules.end())
+        Module_key key(locale, module);
+        if (m_initialized_modules.find(key) == m_initialized_modules.end())
         {
             File_module_iterator it(module, locale);
 
@@ -853,13 +983,13 @@ private:
             {
                 if (file.exist())
                 {
-                    m_module_dictionaries[module] = Translation_db(module);
-                    m_module_dictionaries[module].load_file(file);
+                    m_module_dictionaries[key] = Translation_db(module);
+                    m_module_dictionaries[key].load_file(file, m_cache_directory);
                     break;
                 }
             }
 
-            m_initialized_modules.insert(module);
+            m_initialized_modules.insert(key);
         }
     }
 
@@ -867,7 +997,8 @@ private:
     {
         // if not init
         // Look for XLIFF files corresponding to the given package and locale
-        if (m_initialized_packages.find(package) == m_initialized_packages.end())
+        Package_key key(locale, package);
+        if (m_initialized_packages.find(key) == m_initialized_packages.end())
         {
             File_package_iterator it(package, locale);
 
@@ -876,12 +1007,12 @@ private:
             {
                 if (file.exist())
                 {
-                    m_package_dictionaries[package] = Translation_db(package);
-                    m_package_dictionaries[package].load_file(file);
+                    m_package_dictionaries[key] = Translation_db(package);
+                    m_package_dictionaries[key].load_file(file, m_cache_directory);
                     break;
                 }
             }
-            m_initialized_packages.insert(package);
+            m_initialized_packages.insert(key);
         }
     }
 
@@ -892,7 +1023,7 @@ private:
         string locale(sentence.get_locale());
         init_db(module, locale);
 
-        Module_map::const_iterator it(m_module_dictionaries.find(module));
+        Module_map::const_iterator it(m_module_dictionaries.find(Module_key(locale, module)));
         if (it != m_module_dictionaries.end())
         {
             return it->second.translate(sentence);
@@ -907,7 +1038,7 @@ private:
         string locale(sentence.get_locale());
         init_db(package, locale);
 
-        Package_map::const_iterator it(m_package_dictionaries.find(package));
+        Package_map::const_iterator it(m_package_dictionaries.find(Package_key(locale, package)));
         if (it != m_package_dictionaries.end())
         {
             return it->second.translate(sentence);
@@ -962,35 +1093,17 @@ public:
         m_initialized_packages.clear();
         return 0;
     }
-};
 
-bool Dictionary::translate(const string & source, string & target) const
-{
-    Dictionary::const_iterator it = find(source);
-    if (it != end())
+    void set_cache_directory(const string & directory) override
     {
-        target = it->second;
-        return true;
+        m_cache_directory = directory;
     }
-    return false;
-}
 
-bool Context_dictionaries::translate(
-    const string & context
-    , const string & source
-    , string & target
-) const
-{
-    bool translated = false;
-    // Find dictionary
-    Context_dictionaries::const_iterator it = find(context);
-    if (it != end())
+    const string & get_cache_directory() const override
     {
-        // Use context dictionary to translate
-        translated = it->second.translate(source, target);
+        return m_cache_directory;
     }
-    return translated;
-}
+};
 
 Database::Database()
 {
@@ -1012,3 +1125,13 @@ Sint32 Database::cleanup()
     Mdl_search_path::get().cleanup();
     return m_translation_db->cleanup();
 }
+
+void Database::set_cache_directory(const string & directory)
+{
+    m_translation_db->set_cache_directory(directory);
+}
+
+const string & Database::get_cache_directory() const
+{
+    return m_translation_db->get_cache_directory();
+}
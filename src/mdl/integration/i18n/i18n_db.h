@@ -60,6 +60,14 @@ public:
     ///
     mi::Sint32 cleanup();
 
+    /// Set the directory for compiled translation tables.
+    ///
+    /// \param directory  The directory, or the empty string to not cache compiled tables.
+    void set_cache_directory(const std::string & directory);
+
+    /// Get the directory for compiled translation tables, empty if they are not cached.
+    const std::string & get_cache_directory() const;
+
 private:
     Database_impl * m_translation_db;
 };
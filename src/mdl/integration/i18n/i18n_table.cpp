@@ -0,0 +1,487 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+#include "pch.h"
+#include "i18n_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <thread>
+#ifdef MI_PLATFORM_WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <base/hal/disk/disk.h>
+#include <base/hal/disk/i_disk_file.h>
+#include <base/hal/disk/disk_mapped_file_reader_impl.h>
+
+using std::string;
+using std::vector;
+using mi::Uint8;
+using mi::Uint32;
+using mi::Uint64;
+using mi::Float64;
+
+namespace MI {
+namespace MDL {
+namespace I18N {
+
+/// The file header, followed by the displacement of each bucket, the entries indexed by the
+/// perfect hash, and the string pool.
+struct Translation_table::Header
+{
+    char m_magic[8];
+    Uint32 m_byte_order;
+    Uint32 m_version;
+    Uint32 m_num_entries;
+    Uint32 m_num_buckets;
+    Uint32 m_strings_size;
+    Uint32 m_source_mtime_nsec;
+    Uint64 m_source_size;
+    Float64 m_source_mtime;
+    Uint64 m_checksum;      ///< Over the header up to this field and all data following it.
+};
+
+/// An entry of the table. The key is stored as "context\0source".
+struct Translation_table::Entry
+{
+    Uint32 m_key_offset;
+    Uint32 m_key_length;
+    Uint32 m_target_offset;
+    Uint32 m_target_length;
+};
+
+namespace {
+
+const char TABLE_MAGIC[8] = { 'M', 'D', 'L', 'I', '1', '8', 'N', '\0' };
+const Uint32 TABLE_BYTE_ORDER = 0x01020304u;
+const Uint32 TABLE_VERSION = 3;
+
+/// Average number of keys per bucket of the perfect hash.
+const Uint32 KEYS_PER_BUCKET = 4;
+
+/// Maximum number of displacements tried per bucket.
+const Uint32 MAX_DISPLACEMENT = 1u << 20;
+
+/// FNV-1a over the given bytes.
+inline Uint64 hash_bytes(Uint64 h, const char * data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= Uint8(data[i]);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/// Hash a key with the given seed, the key is "context\0source".
+Uint64 hash_key(const char * context, size_t context_size,
+    const char * source, size_t source_size, Uint32 seed)
+{
+    Uint64 h = 0xcbf29ce484222325ull ^ (Uint64(seed) * 0x9e3779b97f4a7c15ull);
+    h = hash_bytes(h, context, context_size);
+    h = hash_bytes(h, "", 1);
+    h = hash_bytes(h, source, source_size);
+
+    // final mix, FNV alone distributes poorly in the low bits
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+Uint64 hash_key(const string & key, Uint32 seed)
+{
+    size_t context_size = strlen(key.c_str());
+    return hash_key(key.c_str(), context_size,
+        key.c_str() + context_size + 1, key.size() - context_size - 1, seed);
+}
+
+/// Return a temporary file name next to the given file that is unique across processes.
+string get_temporary_filename(const string & filename)
+{
+#ifdef MI_PLATFORM_WINDOWS
+    Uint64 pid = Uint64(_getpid());
+#else
+    Uint64 pid = Uint64(getpid());
+#endif
+    std::random_device device;
+    Uint64 random = (Uint64(device()) << 32) ^ Uint64(device())
+        ^ Uint64(std::chrono::steady_clock::now().time_since_epoch().count())
+        ^ Uint64(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), ".%llu.%016llx.tmp",
+        static_cast<unsigned long long>(pid), static_cast<unsigned long long>(random));
+    return filename + buffer;
+}
+
+} // namespace
+
+void Translation_table_builder::add(
+    const string & context, const string & source, const string & target)
+{
+    string key(context);
+    key += '\0';
+    key += source;
+    m_units[key] = target;
+}
+
+bool Translation_table_builder::serialize(
+    const Translation_table_stamp & stamp, vector<Uint8> & data) const
+{
+    typedef Translation_table::Header Header;
+    typedef Translation_table::Entry Entry;
+
+    vector<const std::pair<const string, string> *> units;
+    units.reserve(m_units.size());
+    for (const auto & unit : m_units)
+    {
+        units.push_back(&unit);
+    }
+
+    Uint32 num_entries = Uint32(units.size());
+    Uint32 num_buckets = num_entries == 0 ? 0 : (num_entries + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+
+    // Distribute the keys into buckets, then place the largest buckets first: for each bucket,
+    // search the displacement that maps all its keys to free slots.
+    vector<vector<Uint32>> buckets(num_buckets);
+    for (Uint32 i = 0; i < num_entries; ++i)
+    {
+        buckets[hash_key(units[i]->first, 0) % num_buckets].push_back(i);
+    }
+
+    vector<Uint32> order(num_buckets);
+    for (Uint32 b = 0; b < num_buckets; ++b)
+    {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](Uint32 a, Uint32 b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    const Uint32 FREE = ~0u;
+    vector<Uint32> displacements(num_buckets, 0);
+    vector<Uint32> slots(num_entries, FREE);
+    vector<Uint32> bucket_slots;
+
+    for (Uint32 b : order)
+    {
+        const vector<Uint32> & keys = buckets[b];
+        if (keys.empty())
+        {
+            break;
+        }
+
+        Uint32 d = 1;
+        for (; d < MAX_DISPLACEMENT; ++d)
+        {
+            bucket_slots.clear();
+            bool ok = true;
+            for (Uint32 k : keys)
+            {
+                Uint32 slot = Uint32(hash_key(units[k]->first, d) % num_entries);
+                if (slots[slot] != FREE
+                    || std::find(bucket_slots.begin(), bucket_slots.end(), slot)
+                        != bucket_slots.end())
+                {
+                    ok = false;
+                    break;
+                }
+                bucket_slots.push_back(slot);
+            }
+            if (ok)
+            {
+                break;
+            }
+        }
+        if (d == MAX_DISPLACEMENT)
+        {
+            return false;
+        }
+
+        displacements[b] = d;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            slots[bucket_slots[i]] = keys[i];
+        }
+    }
+
+    // Build the string pool, every string is zero terminated.
+    vector<Entry> entries(num_entries);
+    string strings;
+    for (Uint32 s = 0; s < num_entries; ++s)
+    {
+        const std::pair<const string, string> & unit = *units[slots[s]];
+        Entry & e = entries[s];
+
+        e.m_key_offset = Uint32(strings.size());
+        e.m_key_length = Uint32(unit.first.size());
+        strings.append(unit.first);
+        strings += '\0';
+
+        e.m_target_offset = Uint32(strings.size());
+        e.m_target_length = Uint32(unit.second.size());
+        strings.append(unit.second);
+        strings += '\0';
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header.m_byte_order = TABLE_BYTE_ORDER;
+    header.m_version = TABLE_VERSION;
+    header.m_num_entries = num_entries;
+    header.m_num_buckets = num_buckets;
+    header.m_strings_size = Uint32(strings.size());
+    header.m_source_size = stamp.m_size;
+    header.m_source_mtime = stamp.m_mtime;
+    header.m_source_mtime_nsec = stamp.m_mtime_nsec;
+
+    size_t displacements_size = num_buckets * sizeof(Uint32);
+    size_t entries_size = num_entries * sizeof(Entry);
+
+    data.resize(sizeof(Header) + displacements_size + entries_size + strings.size());
+    Uint8 * p = data.data();
+    memcpy(p, &header, sizeof(Header));
+    p += sizeof(Header);
+    if (displacements_size > 0)
+    {
+        memcpy(p, displacements.data(), displacements_size);
+    }
+    p += displacements_size;
+    if (entries_size > 0)
+    {
+        memcpy(p, entries.data(), entries_size);
+    }
+    p += entries_size;
+    if (!strings.empty())
+    {
+        memcpy(p, strings.data(), strings.size());
+    }
+
+    Uint64 checksum = Translation_table::compute_checksum(data.data(), data.size());
+    memcpy(data.data() + offsetof(Header, m_checksum), &checksum, sizeof(checksum));
+    return true;
+}
+
+Translation_table::Translation_table()
+    : m_header(NULL)
+    , m_displacements(NULL)
+    , m_entries(NULL)
+    , m_strings(NULL)
+{}
+
+Translation_table::~Translation_table()
+{}
+
+void Translation_table::clear()
+{
+    m_header = NULL;
+    m_displacements = NULL;
+    m_entries = NULL;
+    m_strings = NULL;
+    m_mapping.reset();
+    vector<Uint8>().swap(m_buffer);
+}
+
+bool Translation_table::setup(
+    const Uint8 * data, size_t size, const Translation_table_stamp * stamp)
+{
+    if (size < sizeof(Header))
+    {
+        return false;
+    }
+    const Header * header = reinterpret_cast<const Header *>(data);
+    if (memcmp(header->m_magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0
+        || header->m_byte_order != TABLE_BYTE_ORDER
+        || header->m_version != TABLE_VERSION)
+    {
+        return false;
+    }
+    if (stamp != NULL
+        && (header->m_source_size != stamp->m_size
+            || header->m_source_mtime != stamp->m_mtime
+            || header->m_source_mtime_nsec != stamp->m_mtime_nsec))
+    {
+        return false;
+    }
+    if ((header->m_num_entries == 0) != (header->m_num_buckets == 0))
+    {
+        return false;
+    }
+
+    Uint64 expected = Uint64(sizeof(Header))
+        + Uint64(header->m_num_buckets) * sizeof(Uint32)
+        + Uint64(header->m_num_entries) * sizeof(Entry)
+        + header->m_strings_size;
+    if (expected != size)
+    {
+        return false;
+    }
+
+    // reject torn or otherwise corrupt tables of the right size
+    if (header->m_checksum != compute_checksum(data, size))
+    {
+        return false;
+    }
+
+    m_header = header;
+    m_displacements = reinterpret_cast<const Uint32 *>(data + sizeof(Header));
+    m_entries = reinterpret_cast<const Entry *>(m_displacements + header->m_num_buckets);
+    m_strings = reinterpret_cast<const char *>(m_entries + header->m_num_entries);
+    return true;
+}
+
+Uint64 Translation_table::compute_checksum(const Uint8 * data, size_t size)
+{
+    const char * p = reinterpret_cast<const char *>(data);
+    Uint64 h = 0xcbf29ce484222325ull;
+    h = hash_bytes(h, p, offsetof(Header, m_checksum));
+    h = hash_bytes(h, p + sizeof(Header), size - sizeof(Header));
+    return h;
+}
+
+bool Translation_table::map(const string & filename, const Translation_table_stamp & stamp)
+{
+    clear();
+
+    mi::base::Handle<DISK::Mapped_file_buffer_impl> mapping(new DISK::Mapped_file_buffer_impl());
+    if (!mapping->map(filename.c_str()))
+    {
+        return false;
+    }
+    if (!setup(mapping->get_data(), size_t(mapping->get_data_size()), &stamp))
+    {
+        return false;
+    }
+    m_mapping = mapping;
+    return true;
+}
+
+bool Translation_table::assign(vector<Uint8> & data)
+{
+    clear();
+
+    m_buffer.swap(data);
+    if (!setup(m_buffer.data(), m_buffer.size(), NULL))
+    {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool Translation_table::translate(
+    const string & context
+    , const string & source
+    , string & target
+) const
+{
+    if (m_header == NULL || m_header->m_num_entries == 0)
+    {
+        return false;
+    }
+
+    const char * c = context.c_str();
+    const char * s = source.c_str();
+    size_t c_size = context.size();
+    size_t s_size = source.size();
+
+    Uint32 bucket = Uint32(hash_key(c, c_size, s, s_size, 0) % m_header->m_num_buckets);
+    Uint32 d = m_displacements[bucket];
+    if (d == 0)
+    {
+        // empty bucket
+        return false;
+    }
+    const Entry & e = m_entries[hash_key(c, c_size, s, s_size, d) % m_header->m_num_entries];
+
+    Uint32 strings_size = m_header->m_strings_size;
+    if (Uint64(e.m_key_offset) + e.m_key_length >= strings_size
+        || Uint64(e.m_target_offset) + e.m_target_length >= strings_size)
+    {
+        // corrupt entry
+        return false;
+    }
+
+    const char * key = m_strings + e.m_key_offset;
+    if (e.m_key_length != c_size + 1 + s_size
+        || memcmp(key, c, c_size) != 0
+        || key[c_size] != '\0'
+        || memcmp(key + c_size + 1, s, s_size) != 0)
+    {
+        return false;
+    }
+
+    target.assign(m_strings + e.m_target_offset, e.m_target_length);
+    return true;
+}
+
+bool Translation_table::write(const string & filename, const vector<Uint8> & data)
+{
+    // unique across processes, the table is renamed into place once complete
+    string tmp_filename(get_temporary_filename(filename));
+    if (DISK::is_file(tmp_filename.c_str()))
+    {
+        return false;
+    }
+
+    DISK::File file;
+    if (!file.open(tmp_filename, DISK::IFile::M_WRITE))
+    {
+        return false;
+    }
+    bool ok = file.write(reinterpret_cast<const char *>(data.data()), data.size())
+        == mi::Sint64(data.size());
+    ok = file.close() && ok;
+
+    if (ok)
+    {
+        ok = DISK::rename(tmp_filename.c_str(), filename.c_str());
+        if (!ok && DISK::is_file(filename.c_str()))
+        {
+            // outdated table, not replaced by rename on all platforms
+            DISK::file_remove(filename.c_str());
+            ok = DISK::rename(tmp_filename.c_str(), filename.c_str());
+        }
+    }
+    if (!ok)
+    {
+        DISK::file_remove(tmp_filename.c_str());
+    }
+    return ok;
+}
+
+} // namespace I18N
+} // namespace MDL
+} // namespace MI
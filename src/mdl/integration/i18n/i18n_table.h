@@ -0,0 +1,166 @@
+/******************************************************************************
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+ /// \file
+ /// \brief Compiled binary translation tables.
+ ///
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mi/base/types.h>
+#include <mi/base/handle.h>
+
+namespace MI {
+namespace DISK { class Mapped_file_buffer_impl; }
+namespace MDL {
+namespace I18N {
+
+/// Identifies the XLIFF file a table was compiled from.
+///
+/// A cached table is only used if it was compiled from a source with the same stamp.
+struct Translation_table_stamp
+{
+    Translation_table_stamp()
+        : m_size(0)
+        , m_mtime(0.0)
+        , m_mtime_nsec(0)
+    {}
+
+    mi::Uint64 m_size;      ///< Size of the XLIFF file or of the archive containing it.
+    mi::Float64 m_mtime;    ///< Modification time of the XLIFF file or of the archive.
+    mi::Uint32 m_mtime_nsec;///< Nanoseconds of the modification time, if known, 0 otherwise.
+};
+
+/// Collects translation units and serializes them into a binary translation table.
+class Translation_table_builder
+{
+public:
+    /// Add a translation unit.
+    ///
+    /// \param context  The fully qualified context, or the empty string for the global context
+    /// \param source   The source string
+    /// \param target   The translated string
+    void add(const std::string & context, const std::string & source, const std::string & target);
+
+    /// Serialize the collected units.
+    ///
+    /// \param stamp  The stamp of the XLIFF file
+    /// \param data   Receives the binary table
+    ///
+    /// \return false if no perfect hash could be found
+    bool serialize(const Translation_table_stamp & stamp, std::vector<mi::Uint8> & data) const;
+
+private:
+    /// Maps "context\0source" to the target string.
+    std::map<std::string, std::string> m_units;
+};
+
+/// A read-only translation table in the binary format written by Translation_table_builder.
+///
+/// The table is used in place, either from a memory-mapped cache file or from a buffer. Lookups
+/// use a minimal perfect hash on context and source, so they touch only a few cache lines of the
+/// table and do not need to build any index when the table is loaded.
+class Translation_table
+{
+public:
+    Translation_table();
+    ~Translation_table();
+
+    /// Map a compiled table from a file.
+    ///
+    /// \param filename  The cache file
+    /// \param stamp     The stamp of the XLIFF file the table must have been compiled from
+    ///
+    /// \return false if the file does not exist, is invalid or out of date
+    bool map(const std::string & filename, const Translation_table_stamp & stamp);
+
+    /// Use a compiled table from a buffer, taking ownership of the data.
+    ///
+    /// \return false if the data is invalid
+    bool assign(std::vector<mi::Uint8> & data);
+
+    /// Translate a source string.
+    ///
+    /// \param context  The fully qualified context, or the empty string for the global context
+    /// \param source   The source string
+    /// \param target   Receives the translation
+    ///
+    /// \return true if a translation was found
+    bool translate(
+        const std::string & context
+        , const std::string & source
+        , std::string & target
+    ) const;
+
+    /// Write a compiled table to a cache file.
+    ///
+    /// The data is written to a temporary file with a name unique across processes first and
+    /// then renamed, so concurrent readers never map a partially written table. Tables also
+    /// carry a checksum that is verified when they are mapped.
+    ///
+    /// \param filename  The cache file
+    /// \param data      The compiled table
+    ///
+    /// \return false if the file could not be written
+    static bool write(const std::string & filename, const std::vector<mi::Uint8> & data);
+
+private:
+    Translation_table(const Translation_table &);
+    Translation_table & operator=(const Translation_table &);
+
+    /// Check the header and set up the pointers into the data.
+    bool setup(const mi::Uint8 * data, size_t size, const Translation_table_stamp * stamp);
+
+    /// Release the table data.
+    void clear();
+
+    /// Compute the checksum of a table, the size must have been checked against the header.
+    static mi::Uint64 compute_checksum(const mi::Uint8 * data, size_t size);
+
+private:
+    friend class Translation_table_builder;
+
+    struct Header;
+    struct Entry;
+
+    /// The mapping, if the table was mapped from a file.
+    mi::base::Handle<DISK::Mapped_file_buffer_impl> m_mapping;
+
+    /// The table data, if the table was compiled in memory.
+    std::vector<mi::Uint8> m_buffer;
+
+    const Header * m_header;
+    const mi::Uint32 * m_displacements;
+    const Entry * m_entries;
+    const char * m_strings;
+};
+
+} // namespace I18N
+} // namespace MDL
+} // namespace MI
@@ -148,6 +148,18 @@ mi::Sint32 Mdl_translator_impl::cleanup_database()
     return m_database->cleanup();
 }
 
+void Mdl_translator_impl::set_cache_directory(const string & directory)
+{
+    ASSERT(M_I18N, m_database != NULL);
+    m_database->set_cache_directory(directory);
+}
+
+const string & Mdl_translator_impl::get_cache_directory() const
+{
+    ASSERT(M_I18N, m_database != NULL);
+    return m_database->get_cache_directory();
+}
+
 void Mdl_translator_module::Translation_unit::set_module_name(const char * module_name)
 {
     if (module_name)
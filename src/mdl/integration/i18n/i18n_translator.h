@@ -122,6 +122,20 @@ public:
     ///
     mi::Sint32 cleanup_database();
 
+    /// Specifies the directory for the compiled binary translation tables.
+    ///
+    /// \param directory
+    ///     The directory to cache compiled tables in, or the empty string to disable the cache.
+    ///
+    void set_cache_directory(const std::string & directory);
+
+    /// Get the directory for the compiled binary translation tables.
+    ///
+    /// \return
+    ///     The directory, the empty string if compiled tables are not cached.
+    ///
+    const std::string & get_cache_directory() const;
+
 private:
     Database * m_database = NULL;
     std::string m_locale;
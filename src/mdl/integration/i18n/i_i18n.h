@@ -195,6 +195,23 @@ public:
     ///     - -1: Unknown error
     ///
     virtual mi::Sint32 cleanup_database() = 0;
+
+    /// Specifies the directory for the compiled binary translation tables.
+    ///
+    /// \param directory
+    ///     The directory to cache compiled tables in, created if needed.
+    ///     An empty string disables the cache: XLIFF files are then compiled in memory
+    ///     each time they are loaded.
+    ///
+    virtual void set_cache_directory(const std::string & directory) = 0;
+
+    /// Get the directory for the compiled binary translation tables.
+    ///
+    /// \return
+    ///     The directory, by default a per-user cache directory.
+    ///     The empty string if compiled tables are not cached.
+    ///
+    virtual const std::string & get_cache_directory() const = 0;
 };
 
 } // namespace I18N
@@ -31,6 +31,8 @@
 
 #include <base/system/main/i_module.h>
 
+#include <string>
+
 namespace mi {
     namespace mdl {
         class ICode_cache;
@@ -119,6 +121,15 @@ public:
     ///
     /// \note supports only [0-9], [0-9]+, and -? regex so far
     virtual bool utf8_match(char const *file_mask, char const *file_name) const = 0;
+
+    /// Export the MDL compiler phase and memory arena counters.
+    ///
+    /// The phase counters are aggregated only if the "mdl_trace" configuration value enables
+    /// them, the memory arena statistics (chunk reuse, pooled bytes, and the high-water marks of
+    /// the destroyed arenas) are always available.
+    ///
+    /// \param text  the counters are appended here in the Prometheus text exposition format
+    virtual void export_trace_counters(std::string &text) const = 0;
 };
 
 } // namespace MDLC
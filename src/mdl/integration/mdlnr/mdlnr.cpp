@@ -28,6 +28,7 @@
 
 #include "pch.h"
 
+#include <chrono>
 #include <map>
 
 #include <mi/base/ilogger.h>
@@ -50,7 +51,9 @@
 #include <mdl/compiler/compilercore/compilercore_fatal.h>
 #include <mdl/compiler/compilercore/compilercore_debug_tools.h>
 #include <mdl/compiler/compilercore/compilercore_mdl.h>
+#include <mdl/compiler/compilercore/compilercore_memory_arena.h>
 #include <mdl/compiler/compilercore/compilercore_file_utils.h>
+#include <mdl/compiler/compilercore/compilercore_trace.h>
 
 namespace MI {
 namespace MDLC {
@@ -413,6 +416,8 @@ Mdlc_module_impl::Mdlc_module_impl()
   , m_used_with_mdl_sdk(false) /*arbitrary*/
   , m_used_with_mdl_sdk_set(false)
   , m_code_cache(0)
+  , m_trace_counters_interval(0)
+  , m_trace_counters_stop(false)
 {
 }
 
@@ -420,6 +425,7 @@ Mdlc_module_impl::Mdlc_module_impl()
 static mi::mdl::dbg::DebugMallocAllocator *g_dbg_allocator = NULL;
 
 static void flush_dbg_allocator() {
+    mi::mdl::Memory_arena::flush_chunk_pools(g_dbg_allocator);
     delete g_dbg_allocator;
     g_dbg_allocator = NULL;
 }
@@ -464,6 +470,33 @@ bool Mdlc_module_impl::init()
         // neuray always runs in "relaxed" mode for compatibility with old releases
         options.set_option(mi::mdl::MDL::option_strict, "false");
 
+        // phase tracing: 1 aggregates per-phase counters, 2 records events, 3 both
+        int trace_mode = 0;
+        if (registry.get_value("mdl_trace", trace_mode)) {
+            int trace_buffer_size = 0;
+            if (registry.get_value("mdl_trace_buffer_size", trace_buffer_size)
+                    && trace_buffer_size >= 0)
+                mi::mdl::Trace::set_buffer_size(size_t(trace_buffer_size));
+            mi::mdl::Trace::set_mode(unsigned(trace_mode));
+        }
+        registry.get_value("mdl_trace_file", m_trace_file);
+
+        // the counters are written on exit and, if an interval is given, periodically, so
+        // they can be scraped while the process runs
+        registry.get_value("mdl_trace_counters_file", m_trace_counters_file);
+        if (!m_trace_counters_file.empty()
+                && registry.get_value("mdl_trace_counters_interval", m_trace_counters_interval)
+                && m_trace_counters_interval > 0) {
+            m_trace_counters_stop = false;
+            m_trace_counters_thread =
+                std::thread(&Mdlc_module_impl::trace_counters_writer, this);
+        }
+
+        // per-thread limit of pooled memory arena chunks in bytes, 0 disables pooling
+        int arena_pool_size = 0;
+        if (registry.get_value("mdl_arena_pool_size", arena_pool_size) && arena_pool_size >= 0)
+            mi::mdl::Memory_arena::set_chunk_pool_limit(size_t(arena_pool_size));
+
 
         // 1MB cache size by default
         size_t cache_size = 1*1024*1024;
@@ -476,6 +509,27 @@ bool Mdlc_module_impl::init()
 
 void Mdlc_module_impl::exit()
 {
+    if (!m_trace_file.empty()) {
+        if (!mi::mdl::Trace::write_chrome_trace(m_trace_file.c_str()))
+            LOG::mod_log->warning(
+                M_MDLC, LOG::ILogger::C_IO,
+                "Failed to write MDL trace to \"%s\".", m_trace_file.c_str());
+        m_trace_file.clear();
+    }
+
+    if (m_trace_counters_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_trace_counters_mutex);
+            m_trace_counters_stop = true;
+        }
+        m_trace_counters_condition.notify_one();
+        m_trace_counters_thread.join();
+    }
+    if (!m_trace_counters_file.empty()) {
+        write_trace_counters();
+        m_trace_counters_file.clear();
+    }
+
     if(m_mdl) {
         m_mdl->release();
 
@@ -484,6 +538,9 @@ void Mdlc_module_impl::exit()
             m_code_cache = NULL;
         }
     }
+
+    // the allocator might not survive this module, return the pooled arena chunks
+    mi::mdl::Memory_arena::flush_chunk_pools(m_allocator.get());
 }
 
 mi::mdl::IMDL *Mdlc_module_impl::get_mdl() const
@@ -570,6 +627,33 @@ bool Mdlc_module_impl::utf8_match(char const *file_mask, char const *file_name)
     return mi::mdl::utf8_match(file_mask, file_name);
 }
 
+void Mdlc_module_impl::export_trace_counters(std::string &text) const
+{
+    mi::mdl::Trace::export_counters(text);
+}
+
+void Mdlc_module_impl::write_trace_counters()
+{
+    if (!mi::mdl::Trace::write_counters(m_trace_counters_file.c_str()))
+        LOG::mod_log->warning(
+            M_MDLC, LOG::ILogger::C_IO,
+            "Failed to write MDL trace counters to \"%s\".", m_trace_counters_file.c_str());
+}
+
+void Mdlc_module_impl::trace_counters_writer()
+{
+    std::unique_lock<std::mutex> lock(m_trace_counters_mutex);
+    while (!m_trace_counters_condition.wait_for(
+        lock,
+        std::chrono::seconds(m_trace_counters_interval),
+        [this] { return m_trace_counters_stop; }))
+    {
+        lock.unlock();
+        write_trace_counters();
+        lock.lock();
+    }
+}
+
 } // namespace MDLC
 
 } // namespace MI
@@ -33,6 +33,11 @@
 
 #include <mi/base/handle.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
 namespace mi { namespace base { class IAllocator; } }
 
 namespace MI {
@@ -80,8 +85,16 @@ public:
 
     bool utf8_match(char const *file_mask, char const *file_name) const;
 
+    void export_trace_counters(std::string &text) const;
+
 private:
 
+    /// Write the trace counters to #m_trace_counters_file.
+    void write_trace_counters();
+
+    /// Body of the thread writing the trace counters periodically.
+    void trace_counters_writer();
+
     /// Pointer to the MDL interface.
     mi::mdl::IMDL *m_mdl;
 
@@ -96,6 +109,27 @@ private:
 
     /// The code cache used for JIT-generated source code.
     mi::mdl::ICode_cache *m_code_cache;
+
+    /// If non-empty, the recorded trace events are written to this file on exit.
+    std::string m_trace_file;
+
+    /// If non-empty, the trace counters are written to this file periodically and on exit.
+    std::string m_trace_counters_file;
+
+    /// The interval of the periodic counter writes in seconds, 0 writes only on exit.
+    int m_trace_counters_interval;
+
+    /// The thread writing the trace counters periodically.
+    std::thread m_trace_counters_thread;
+
+    /// Protects #m_trace_counters_stop.
+    std::mutex m_trace_counters_mutex;
+
+    /// Signaled when #m_trace_counters_stop is set.
+    std::condition_variable m_trace_counters_condition;
+
+    /// Set on exit to stop #m_trace_counters_thread.
+    bool m_trace_counters_stop;
 };
 
 } // namespace MDLC
@@ -35,6 +35,7 @@
 #include "mdl/compiler/compilercore/compilercore_errors.h"
 #include "mdl/compiler/compilercore/compilercore_mdl.h"
 #include "mdl/compiler/compilercore/compilercore_tools.h"
+#include "mdl/compiler/compilercore/compilercore_trace.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_tools.h"
 #include "mdl/codegenerators/generator_code/generator_code_hash.h"
 
@@ -75,6 +76,18 @@ Code_generator_jit::Code_generator_jit(
         MDL_JIT_OPTION_OPT_LEVEL,
         "2",
         "The optimization level of the JIT code generator");
+    m_options.add_option(
+        MDL_JIT_OPTION_OPT_PIPELINE,
+        "default",
+        "The optimization pipeline of the JIT code generator (default, preview or final)");
+    m_options.add_option(
+        MDL_JIT_OPTION_COLLECT_TIMING,
+        "false",
+        "Collect timing statistics of the JIT optimization passes");
+    m_options.add_option(
+        MDL_JIT_OPTION_DF_LAMBDA_PROFILE,
+        "off",
+        "Profile the expression lambdas of distribution functions (off, record or use)");
     m_options.add_option(
         MDL_JIT_OPTION_FAST_MATH,
         "true",
@@ -213,6 +226,7 @@ IGenerated_code_lambda_function *Code_generator_jit::compile_into_environment(
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // copy the string constant table.
         for (size_t i = 0, n = code_gen.get_string_constant_count(); i < n; ++i) {
@@ -374,6 +388,7 @@ IGenerated_code_lambda_function *Code_generator_jit::compile_into_const_function
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -461,6 +476,7 @@ IGenerated_code_lambda_function *Code_generator_jit::compile_into_switch_functio
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -549,6 +565,7 @@ IGenerated_code_executable *Code_generator_jit::compile_into_switch_function_for
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -630,6 +647,7 @@ IGenerated_code_lambda_function *Code_generator_jit::compile_into_generic_functi
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -804,6 +822,7 @@ IGenerated_code_executable *Code_generator_jit::compile_distribution_function_cp
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -894,6 +913,7 @@ IGenerated_code_executable *Code_generator_jit::compile_distribution_function_gp
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         if (code_gen.get_captured_arguments_llvm_type() != NULL) {
@@ -964,6 +984,7 @@ IGenerated_code_executable *Code_generator_jit::compile_into_ptx(
         hasher.update(num_texture_results),
         hasher.update(m_options.get_string_option(MDL_CG_OPTION_INTERNAL_SPACE));
         hasher.update(m_options.get_int_option(MDL_JIT_OPTION_OPT_LEVEL));
+        hasher.update(m_options.get_string_option(MDL_JIT_OPTION_OPT_PIPELINE));
         hasher.update(m_options.get_bool_option(MDL_JIT_OPTION_FAST_MATH));
         hasher.update(m_options.get_bool_option(MDL_JIT_OPTION_DISABLE_EXCEPTIONS));
         hasher.update(m_options.get_bool_option(MDL_JIT_OPTION_ENABLE_RO_SEGMENT));
@@ -1063,6 +1084,7 @@ IGenerated_code_executable *Code_generator_jit::compile_into_ptx(
 
         // copy the render state usage
         code->set_render_state_usage(code_gen.get_render_state_usage());
+        code->set_timing_report(code_gen.get_timing_report());
 
         // create the argument block layout if any arguments are captured
         mi::base::Handle<Generated_code_value_layout> layout;
@@ -1175,7 +1197,11 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
     Allocator_builder builder(alloc);
 
     // now finalize the module
-    llvm::Module *module = unit->finalize_module();
+    llvm::Module *module = NULL;
+    {
+        Trace_scope trace(TP_LLVM_IR_GEN);
+        module = unit->finalize_module();
+    }
     mi::base::Handle<IGenerated_code_executable> code_obj(unit.get_code_object());
 
     if (module == NULL) {
@@ -1198,6 +1224,7 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
 
         // copy the render state usage
         code->set_render_state_usage(unit->get_render_state_usage());
+        code->set_timing_report(unit->get_timing_report());
 
         // add all argument block layouts
         for (size_t i = 0, num = unit.get_arg_block_layout_count(); i < num; ++i)
@@ -1228,6 +1255,7 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
 
         // copy the render state usage
         code->set_render_state_usage(unit->get_render_state_usage());
+        code->set_timing_report(unit->get_timing_report());
 
         // add all argument block layouts
         for (size_t i = 0, num = unit.get_arg_block_layout_count(); i < num; ++i) {
@@ -1247,6 +1275,12 @@ IGenerated_code_executable *Code_generator_jit::compile_unit(
     return code_obj.get();
 }
 
+// Discard the expression lambda use counts recorded so far.
+void Code_generator_jit::clear_df_lambda_profile()
+{
+    m_jitted_code->get_df_lambda_profile().clear();
+}
+
 // Calculate the state mapping mode from options.
 unsigned Code_generator_jit::get_state_mapping() const
 {
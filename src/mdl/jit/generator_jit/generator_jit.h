@@ -529,6 +529,9 @@ public:
     IGenerated_code_executable *compile_unit(
         ILink_unit const *unit) MDL_FINAL;
 
+    /// Discard the expression lambda use counts recorded so far.
+    void clear_df_lambda_profile() MDL_FINAL;
+
 private:
     /// Calculate the state mapping mode from options.
     unsigned get_state_mapping() const;
@@ -615,6 +615,7 @@ Generated_code_jit::Generated_code_jit(
 , m_ptx_code(alloc)
 , m_render_state_usage(-1)
 , m_mappend_strings(alloc)
+, m_timing_report(alloc)
 {
 }
 
@@ -716,6 +717,12 @@ void Generated_code_jit::add_mapped_string(char const *s, size_t id)
     m_mappend_strings[id] = string(s, get_allocator());
 }
 
+// Get the timing report of the optimizer if timing collection was enabled.
+char const *Generated_code_jit::get_timing_report() const
+{
+    return m_timing_report.c_str();
+}
+
 // Compile a whole module into LLVM-IR.
 void Generated_code_jit::compile_module_to_llvm(
     IModule const      *module,
@@ -754,6 +761,7 @@ void Generated_code_jit::compile_module_to_llvm(
     }
 
     m_render_state_usage = llvm_generator.get_render_state_usage();
+    m_timing_report      = llvm_generator.get_timing_report();
 }
 
 // Compile a whole module into PTX.
@@ -798,6 +806,7 @@ void Generated_code_jit::compile_module_to_ptx(
     }
 
     m_render_state_usage = llvm_generator.get_render_state_usage();
+    m_timing_report      = llvm_generator.get_timing_report();
 }
 
 // --------------------------------- Generated_code_source ----------------------------------
@@ -814,6 +823,7 @@ Generated_code_source::Generated_code_source(
 , m_ro_segment(alloc)
 , m_captured_arguments_layouts(alloc)
 , m_mappend_strings(alloc)
+, m_timing_report(alloc)
 {
 }
 
@@ -908,6 +918,18 @@ void Generated_code_source::add_mapped_string(char const *s, size_t id)
     m_mappend_strings[id] = string(s, get_allocator());
 }
 
+// Get the timing report of the optimizer if timing collection was enabled.
+char const *Generated_code_source::get_timing_report() const
+{
+    return m_timing_report.c_str();
+}
+
+// Set the timing report of the optimizer.
+void Generated_code_source::set_timing_report(char const *report)
+{
+    m_timing_report = report;
+}
+
 // Constructor.
 Generated_code_source::Source_res_manag::Source_res_manag(
     IAllocator              *alloc,
@@ -1005,6 +1027,7 @@ Generated_code_lambda_function::Generated_code_lambda_function(
     IGenerated_code_executable::SU_ALL_UNIFORM_MASK)
 , m_captured_arguments_layouts(get_allocator())
 , m_mappend_strings(get_allocator())
+, m_timing_report(get_allocator())
 {
 }
 
@@ -1374,6 +1397,43 @@ bool Generated_code_lambda_function::run_generic(
     return false;
 }
 
+// Run the function on the current transaction for a packet of lanes.
+bool Generated_code_lambda_function::run_generic_packet(
+    size_t                       index,
+    size_t                       count,
+    void                         *results,
+    size_t                       result_stride,
+    Shading_state_material const *states,
+    size_t                       state_stride,
+    void                         *tex_data,
+    void const                   *cap_args)
+{
+    if (!m_aborted && index < m_jitted_funcs.size()) {
+        LLVM_code_generator::Exc_state exc(m_exc_handler, m_aborted);
+        Res_data_pair pair(m_res_data, tex_data);
+
+        // one exception frame for the whole packet, an abort skips the remaining lanes
+        if (setjmp(exc.env) == 0) {
+            Gen_func *gen_func = reinterpret_cast<Gen_func *>(m_jitted_funcs[index]);
+            // the state layout depends on the code generation options (derivatives),
+            // so step through the states by the given stride instead of the array type
+            char       *lane_result = static_cast<char *>(results);
+            char const *lane_state  = reinterpret_cast<char const *>(states);
+            for (size_t i = 0; i < count;
+                    ++i, lane_result += result_stride, lane_state += state_stride) {
+                gen_func(
+                    lane_result,
+                    reinterpret_cast<Shading_state_material const *>(lane_state),
+                    pair,
+                    exc,
+                    cap_args);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 // Run the init function on the current transaction.
 bool Generated_code_lambda_function::run_init(
     size_t                 index,
@@ -1442,6 +1502,18 @@ void Generated_code_lambda_function::add_mapped_string(char const *s, size_t id)
     m_mappend_strings[id] = string(s, get_allocator());
 }
 
+// Get the timing report of the optimizer if timing collection was enabled.
+char const *Generated_code_lambda_function::get_timing_report() const
+{
+    return m_timing_report.c_str();
+}
+
+// Set the timing report of the optimizer.
+void Generated_code_lambda_function::set_timing_report(char const *report)
+{
+    m_timing_report = report;
+}
+
 // Set the entry point the the JIT compiled function.
 void Generated_code_lambda_function::add_entry_point(void *address)
 {
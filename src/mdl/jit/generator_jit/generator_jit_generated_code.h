@@ -256,6 +256,11 @@ public:
     /// \note that the id 0 is ALWAYS mapped to the empty string ""
     char const *get_string_constant(size_t id) const MDL_FINAL;
 
+    /// Get the timing report of the optimizer if timing collection was enabled.
+    ///
+    /// \returns the report or the empty string if no timing data was collected
+    char const *get_timing_report() const MDL_FINAL;
+
     // non-interface methods
 
     /// Compile a whole MDL module into LLVM-IR.
@@ -326,6 +331,9 @@ private:
 
     /// The mapped strings
     Mappend_string_vector m_mappend_strings;
+
+    /// The timing report of the optimizer if any.
+    string m_timing_report;
 };
 
 /// The implementation of a source code, used for PTX or LLVM-IR.
@@ -445,6 +453,11 @@ public:
     /// \note that the id 0 is ALWAYS mapped to the empty string ""
     char const *get_string_constant(size_t id) const MDL_FINAL;
 
+    /// Get the timing report of the optimizer if timing collection was enabled.
+    ///
+    /// \returns the report or the empty string if no timing data was collected
+    char const *get_timing_report() const MDL_FINAL;
+
     // -------------------- non-interface methods --------------------
 
     /// Write access to the source code.
@@ -476,6 +489,11 @@ public:
     /// \param id  the assigned id for this constant
     void add_mapped_string(char const *s, size_t id);
 
+    /// Set the timing report of the optimizer.
+    ///
+    /// \param report  the report
+    void set_timing_report(char const *report);
+
 private:
     /// Constructor.
     ///
@@ -521,6 +539,9 @@ private:
 
     /// The mapped strings
     Mappend_string_vector m_mappend_strings;
+
+    /// The timing report of the optimizer if any.
+    string m_timing_report;
 };
 
 /// The implementation of a compiled lambda function.
@@ -737,6 +758,11 @@ public:
     /// \note that the id 0 is ALWAYS mapped to the empty string ""
     char const *get_string_constant(size_t id) const MDL_FINAL;
 
+    /// Get the timing report of the optimizer if timing collection was enabled.
+    ///
+    /// \returns the report or the empty string if no timing data was collected
+    char const *get_timing_report() const MDL_FINAL;
+
     // ------------------- own methods -------------------
 
     /// Write access to the messages.
@@ -914,6 +940,28 @@ public:
         void                         *tex_data,
         void const                   *cap_args) MDL_FINAL;
 
+    /// Run a compiled function on the CPU for a packet of lanes.
+    ///
+    /// \param[in]    index          the index of the function to execute
+    /// \param[in]    count          the number of lanes in the packet
+    /// \param[inout] results        the per-lane data, \p result_stride bytes apart
+    /// \param[in]    result_stride  the distance in bytes between the data of two lanes
+    /// \param[in]    states         the core states, one per lane, \p state_stride bytes apart
+    /// \param[in]    state_stride   the distance in bytes between the states of two lanes
+    /// \param[in]    tex_data       extra thread data for the texture handler
+    /// \param[in]    cap_args       the captured arguments block shared by all lanes
+    ///
+    /// \returns false if execution was aborted by runtime error, true otherwise
+    bool run_generic_packet(
+        size_t                       index,
+        size_t                       count,
+        void                         *results,
+        size_t                       result_stride,
+        Shading_state_material const *states,
+        size_t                       state_stride,
+        void                         *tex_data,
+        void const                   *cap_args) MDL_FINAL;
+
 
     /// Run a compiled init function on the CPU. This may modify the texture results buffer
     /// of the given state.
@@ -977,6 +1025,11 @@ public:
     /// \param id  the assigned id for this constant
     void add_mapped_string(char const *s, size_t id);
 
+    /// Set the timing report of the optimizer.
+    ///
+    /// \param report  the report
+    void set_timing_report(char const *report);
+
 private:
     /// Register a new non-texture resource tag.
     ///
@@ -1247,6 +1300,9 @@ private:
 
     /// The mapped strings
     Mappend_string_vector m_mappend_strings;
+
+    /// The timing report of the optimizer if any.
+    string m_timing_report;
 };
 
 
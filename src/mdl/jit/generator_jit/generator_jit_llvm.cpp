@@ -59,10 +59,15 @@
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/MutexGuard.h>
 #include <llvm/Support/PrettyStackTrace.h>
+#include <llvm/Support/RWMutex.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/IPO.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#include <llvm/Transforms/Scalar.h>
 #include <llvm/DIBuilder.h>
 #include <llvm/Linker.h>
 #include <llvm/PassManager.h>
@@ -75,6 +80,7 @@
 #include "mdl/compiler/compilercore/compilercore_cc_conf.h"
 #include "mdl/compiler/compilercore/compilercore_errors.h"
 #include "mdl/compiler/compilercore/compilercore_tools.h"
+#include "mdl/compiler/compilercore/compilercore_trace.h"
 #include "mdl/compiler/compilercore/compilercore_visitor.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_derivatives.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_lambda_function.h"
@@ -180,6 +186,7 @@ Jitted_code::Jitted_code(mi::mdl::IAllocator *alloc)
 : Base(alloc)
 , m_llvm_context(NULL)
 , m_execution_engine(NULL)
+, m_df_lambda_profile(alloc)
 {
     llvm::TargetOptions target_options;
 
@@ -297,6 +304,121 @@ void Jitted_code::init_llvm()
     m_first_time_init = false;
 }
 
+// jitted code increments the counters as plain 64-bit integers
+static_assert(
+    sizeof(Df_lambda_profile::Counter) == sizeof(mi::Uint64),
+    "profile counters must have the layout of 64-bit integers");
+
+// Constructor.
+Df_lambda_profile::Df_lambda_profile(IAllocator *alloc)
+: m_lock()
+, m_counters(Counter_map::key_compare(), alloc)
+, m_ages(alloc)
+, m_references(alloc)
+{
+}
+
+// Get the counter of an expression lambda, creating it if necessary.
+Df_lambda_profile::Counter *Df_lambda_profile::get_counter(
+    DAG_hash const     &df_hash,
+    DAG_hash const     &lambda_hash,
+    llvm::Module const *owner)
+{
+    Key key;
+    key.df_hash     = df_hash;
+    key.lambda_hash = lambda_hash;
+
+    mi::base::Lock::Block block(&m_lock);
+
+    Entry *e = NULL;
+    Counter_map::iterator it = m_counters.find(key);
+    if (it != m_counters.end()) {
+        e = &it->second;
+    } else {
+        if (m_counters.size() >= max_counters && !drop_oldest_unreferenced())
+            return NULL;
+        // the counter is not copyable, construct it in place
+        e = &m_counters[key];
+        e->age = m_ages.insert(m_ages.end(), key);
+    }
+
+    Reference ref;
+    ref.owner = owner;
+    ref.key   = key;
+    m_references.push_back(ref);
+    ++e->users;
+
+    return &e->count;
+}
+
+// Release all counters referenced by the given LLVM module.
+void Df_lambda_profile::release(llvm::Module const *owner)
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    for (Reference_list::iterator it(m_references.begin()), end(m_references.end()); it != end;) {
+        if (it->owner != owner) {
+            ++it;
+            continue;
+        }
+        Counter_map::iterator c_it = m_counters.find(it->key);
+        MDL_ASSERT(c_it != m_counters.end() && c_it->second.users > 0);
+        --c_it->second.users;
+        it = m_references.erase(it);
+    }
+}
+
+// Discard all recorded counts.
+void Df_lambda_profile::clear()
+{
+    mi::base::Lock::Block block(&m_lock);
+
+    for (Counter_map::iterator it(m_counters.begin()), end(m_counters.end()); it != end;) {
+        Entry &e = it->second;
+        if (e.users > 0) {
+            // still incremented by jitted code
+            e.count.store(0, std::memory_order_relaxed);
+            ++it;
+        } else {
+            m_ages.erase(e.age);
+            m_counters.erase(it++);
+        }
+    }
+}
+
+// Drop the oldest counter that is not referenced by any module, needs the lock.
+bool Df_lambda_profile::drop_oldest_unreferenced()
+{
+    for (Key_list::iterator it(m_ages.begin()), end(m_ages.end()); it != end; ++it) {
+        Counter_map::iterator c_it = m_counters.find(*it);
+        MDL_ASSERT(c_it != m_counters.end());
+        if (c_it->second.users == 0) {
+            m_counters.erase(c_it);
+            m_ages.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Look up the recorded count of an expression lambda.
+bool Df_lambda_profile::lookup(
+    DAG_hash const &df_hash,
+    DAG_hash const &lambda_hash,
+    mi::Uint64     &count) const
+{
+    Key key;
+    key.df_hash     = df_hash;
+    key.lambda_hash = lambda_hash;
+
+    mi::base::Lock::Block block(&m_lock);
+    Counter_map::const_iterator it = m_counters.find(key);
+    if (it == m_counters.end())
+        return false;
+    count = it->second.count.load(std::memory_order_relaxed);
+    return true;
+}
+
 // Get the only instance.
 Jitted_code *Jitted_code::get_instance(IAllocator *alloc)
 {
@@ -338,6 +460,8 @@ void Jitted_code::add_llvm_module(llvm::Module *llvm_module)
 // Helper: remove this module from the execution engine and delete it.
 void Jitted_code::delete_llvm_module(llvm::Module *llvm_module)
 {
+    m_df_lambda_profile.release(llvm_module);
+
     m_execution_engine->removeModule(llvm_module);
 
     llvm::MutexGuard guard(m_execution_engine->lock);
@@ -347,9 +471,16 @@ void Jitted_code::delete_llvm_module(llvm::Module *llvm_module)
     delete llvm_module;
 }
 
+// The pass timers of LLVM are process global and every pass manager run reads the global
+// llvm::TimePassesIsEnabled flag. Hence timed optimizer runs take this lock exclusively, all
+// other pass manager runs take it shared.
+static llvm::ManagedStatic<llvm::sys::RWMutex> g_pass_timing_lock;
+
 // JIT compile the given LLVM function.
 void *Jitted_code::jit_compile(llvm::Function *func)
 {
+    // the JIT runs the code generator passes
+    llvm::sys::ScopedReader guard(*g_pass_timing_lock);
     return m_execution_engine->getPointerToFunction(func);
 }
 
@@ -924,6 +1055,12 @@ LLVM_code_generator::LLVM_code_generator(
 , m_captured_args_mdl_types(get_allocator())
 , m_captured_args_type(NULL)
 , m_opt_level(unsigned(options.get_int_option(MDL_JIT_OPTION_OPT_LEVEL)))
+, m_opt_pipeline(parse_opt_pipeline(options.get_string_option(MDL_JIT_OPTION_OPT_PIPELINE)))
+, m_collect_timing(options.get_bool_option(MDL_JIT_OPTION_COLLECT_TIMING))
+, m_func_opt_time(0.0)
+, m_func_opt_count(0)
+, m_func_opt_times(get_allocator())
+, m_timing_report(get_allocator())
 , m_jit_dbg_mode(JDBG_NONE)
 , m_num_texture_spaces(num_texture_spaces)
 , m_num_texture_results(num_texture_results)
@@ -948,6 +1085,8 @@ LLVM_code_generator::LLVM_code_generator(
 , m_link_libdevice(ptx_mode && options.get_bool_option(MDL_JIT_OPTION_LINK_LIBDEVICE))
 , m_incremental(incremental)
 , m_texruntime_with_derivs(options.get_bool_option(MDL_JIT_OPTION_TEX_RUNTIME_WITH_DERIVATIVES))
+, m_df_lambda_profile_mode(parse_df_lambda_profile_mode(
+    options.get_string_option(MDL_JIT_OPTION_DF_LAMBDA_PROFILE)))
 , m_deriv_infos(NULL)
 , m_cur_func_deriv_info(NULL)
 , m_tex_calls_mode(parse_call_mode(
@@ -956,10 +1095,12 @@ LLVM_code_generator::LLVM_code_generator(
 , m_dist_func_state(DFSTATE_NONE)
 , m_dist_func_lambda_map(0, Dist_func_lambda_map::hasher(), Dist_func_lambda_map::key_equal(),
     get_allocator())
+, m_df_instance_map(0, Df_instance_map::hasher(), Df_instance_map::key_equal(), get_allocator())
 , m_lambda_results_struct_type(NULL)
 , m_lambda_result_indices(get_allocator())
 , m_texture_results_struct_type(NULL)
 , m_texture_result_indices(get_allocator())
+, m_df_lambda_counters(get_allocator())
 , m_float3_struct_type(NULL)
 , m_type_bsdf_sample_func(NULL)
 , m_type_bsdf_sample_data(NULL)
@@ -998,6 +1139,12 @@ LLVM_code_generator::LLVM_code_generator(
     memset(m_tex_lookup_functions, 0, sizeof(m_tex_lookup_functions));
     memset(m_optix_cps,            0, sizeof(m_optix_cps));
 
+    // the preview and final pipelines imply their optimization level
+    if (m_opt_pipeline == OPT_PIPELINE_PREVIEW)
+        m_opt_level = 0;
+    else if (m_opt_pipeline == OPT_PIPELINE_FINAL)
+        m_opt_level = 3;
+
     char const *s;
 
     s = getenv("MI_MDL_JIT_OPTLEVEL");
@@ -1023,6 +1170,12 @@ LLVM_code_generator::LLVM_code_generator(
             m_reciprocal_math = true;
     }
 
+    // the generated code increments the profile counters at their addresses in this process,
+    // hence they can only be recorded by native code
+    if (m_df_lambda_profile_mode == DFPM_RECORD &&
+            (ptx_mode || tm_mode != Type_mapper::TM_NATIVE_X86))
+        m_df_lambda_profile_mode = DFPM_OFF;
+
     if (ptx_mode) {
         // Optimization level 3+ activates argument promotion. This is bad, because the NVPTX
         // backend cannot handle aggregate types passed by value. Hence limit the level to
@@ -1244,11 +1397,133 @@ static void AddDeleteUnusedLibDeviceExtension(
 // Optimize an LLVM function.
 bool LLVM_code_generator::optimize(llvm::Function *func)
 {
-    return m_func_pass_manager->run(*func);
+    Trace_scope trace(TP_LLVM_PASSES);
+
+    llvm::sys::ScopedReader guard(*g_pass_timing_lock);
+    if (!m_collect_timing)
+        return m_func_pass_manager->run(*func);
+
+    double start = llvm::TimeRecord::getCurrentTime(/*Start=*/true).getWallTime();
+    bool res = m_func_pass_manager->run(*func);
+    double time = llvm::TimeRecord::getCurrentTime(/*Start=*/false).getWallTime() - start;
+    m_func_opt_time += time;
+    ++m_func_opt_count;
+
+    llvm::StringRef name = func->getName();
+    m_func_opt_times.push_back(
+        Function_timing(string(name.data(), name.size(), get_allocator()), time));
+    return res;
 }
 
+namespace {
+
+/// Enables the LLVM pass timers for the lifetime of this object.
+///
+/// The previous state is restored, otherwise all later optimizer runs of the process would be
+/// timed and LLVM would print a pass report at exit.
+class Pass_timing_scope {
+public:
+    /// Constructor.
+    Pass_timing_scope()
+    : m_was_enabled(llvm::TimePassesIsEnabled)
+    {
+        llvm::TimePassesIsEnabled = true;
+    }
+
+    /// Destructor.
+    ~Pass_timing_scope()
+    {
+        llvm::TimePassesIsEnabled = m_was_enabled;
+    }
+
+private:
+    /// The previous state.
+    bool m_was_enabled;
+};
+
+/// Orders function timings by decreasing time.
+struct Function_timing_greater {
+    bool operator()(
+        LLVM_code_generator::Function_timing const &a,
+        LLVM_code_generator::Function_timing const &b) const
+    {
+        return a.second > b.second;
+    }
+};
+
+}  // anonymous
+
 // Optimize LLVM code.
 bool LLVM_code_generator::optimize(llvm::Module *module)
+{
+    Trace_scope trace(TP_LLVM_PASSES);
+
+    m_timing_report.clear();
+    if (!m_collect_timing) {
+        llvm::sys::ScopedReader guard(*g_pass_timing_lock);
+        return run_module_passes(module);
+    }
+
+    // the timing scope must end before the lock is released
+    llvm::sys::ScopedWriter guard(*g_pass_timing_lock);
+    Pass_timing_scope timing_scope;
+    {
+        // drop whatever was recorded outside of this run
+        llvm::raw_null_ostream null_os;
+        llvm::TimerGroup::printAll(null_os);
+    }
+
+    double start = llvm::TimeRecord::getCurrentTime(/*Start=*/true).getWallTime();
+    bool res = run_module_passes(module);
+    double module_time =
+        llvm::TimeRecord::getCurrentTime(/*Start=*/false).getWallTime() - start;
+
+    char const *pipeline = "default";
+    switch (m_opt_pipeline) {
+    case OPT_PIPELINE_DEFAULT: pipeline = "default"; break;
+    case OPT_PIPELINE_PREVIEW: pipeline = "preview"; break;
+    case OPT_PIPELINE_FINAL:   pipeline = "final";   break;
+    }
+
+    char buf[256];
+    snprintf(
+        buf, sizeof(buf),
+        "pipeline: %s, optimization level: %u\n"
+        "function passes: %.6f s for %u functions\n"
+        "module passes: %.6f s\n",
+        pipeline, m_opt_level,
+        m_func_opt_time, unsigned(m_func_opt_count),
+        module_time);
+    buf[sizeof(buf) - 1] = '\0';
+    m_timing_report = buf;
+
+    // per function times, most expensive first
+    std::stable_sort(
+        m_func_opt_times.begin(), m_func_opt_times.end(), Function_timing_greater());
+    for (size_t i = 0, n = m_func_opt_times.size(); i < n; ++i) {
+        Function_timing const &timing = m_func_opt_times[i];
+        snprintf(buf, sizeof(buf), "  %.6f s  ", timing.second);
+        buf[sizeof(buf) - 1] = '\0';
+        m_timing_report.append(buf);
+        m_timing_report.append(timing.first);
+        m_timing_report.append("\n");
+    }
+
+    std::string pass_report;
+    {
+        llvm::raw_string_ostream os(pass_report);
+        llvm::TimerGroup::printAll(os);
+    }
+    m_timing_report.append(pass_report.c_str(), pass_report.size());
+
+    m_func_opt_time  = 0.0;
+    m_func_opt_count = 0;
+    m_func_opt_times.clear();
+    return res;
+}
+
+// Run the module passes of the selected optimization pipeline.
+bool LLVM_code_generator::run_module_passes(llvm::Module *module)
 {
     if (m_ptx_mode) {
         llvm::PassManager    mpm;
@@ -1285,7 +1560,15 @@ bool LLVM_code_generator::optimize(llvm::Module *module)
     // TODO: in PTX mode we don't use the C-library, but libdevice, this probably must
     // be registered somewhere, or libcall simplification can happen
 
-    if (m_opt_level > 1)
+    if (m_opt_pipeline == OPT_PIPELINE_FINAL) {
+        // use the inline threshold of -O3
+        builder.Inliner = llvm::createFunctionInliningPass(275);
+        if (!m_ptx_mode) {
+            // the NVPTX backend does not profit from vector code
+            builder.LoopVectorize = true;
+            builder.SLPVectorize  = true;
+        }
+    } else if (m_opt_level > 1)
         builder.Inliner = llvm::createFunctionInliningPass();
     else
         builder.Inliner = llvm::createAlwaysInlinerPass();
@@ -1302,7 +1585,23 @@ bool LLVM_code_generator::optimize(llvm::Module *module)
 
     llvm::PassManager mpm;
     mpm.add(new llvm::DataLayout(*get_target_layout_data()));
+
+    // Without the target transform info the vectorizers see a target without vector
+    // registers and do nothing. The JIT selects the host CPU and its features, so do the same.
+    llvm::OwningPtr<llvm::TargetMachine> target_machine;
+    if (!m_ptx_mode) {
+        llvm::SmallVector<std::string, 1> attrs;
+        target_machine.reset(llvm::EngineBuilder(NULL).selectTarget(
+            llvm::Triple(module->getTargetTriple()), "", "", attrs));
+        if (target_machine)
+            target_machine->addAnalysisPasses(mpm);
+    }
+
     builder.populateModulePassManager(mpm);
+    if (m_opt_pipeline == OPT_PIPELINE_PREVIEW) {
+        // optimization level 0 does not remove the functions that were inlined
+        mpm.add(llvm::createGlobalDCEPass());
+    }
     return mpm.run(*module);
 }
 
@@ -1449,6 +1748,9 @@ bool LLVM_code_generator::is_passed_by_reference(mi::mdl::IType const *type) con
 // Drop an LLVM module and clear the layout cache.
 void LLVM_code_generator::drop_llvm_module(llvm::Module *module)
 {
+    // the module might reference expression lambda profile counters
+    if (m_jitted_code.is_valid_interface())
+        m_jitted_code->get_df_lambda_profile().release(module);
     delete module;
 }
 
@@ -1519,6 +1821,8 @@ void LLVM_code_generator::create_resource_tables(Lambda_function const &lambda)
 llvm::Module *LLVM_code_generator::compile_module(
     mi::mdl::IModule const *module)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN, module->get_name());
+
     LLVM_code_generator::MDL_module_scope scope(*this, module);
 
     create_module(module->get_name(), module->get_filename());
@@ -1615,6 +1919,8 @@ llvm::Function *LLVM_code_generator::compile_environment_lambda(
     Lambda_function const     &lambda,
     ICall_name_resolver const *resolver)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN, lambda.get_name());
+
     IAllocator *alloc = m_arena.get_allocator();
 
     reset_lambda_state();
@@ -1692,6 +1998,8 @@ llvm::Function  *LLVM_code_generator::compile_const_lambda(
     Float4_struct const        object_to_world[4],
     int                        object_id)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN, lambda.get_name());
+
     IAllocator *alloc = m_arena.get_allocator();
 
     reset_lambda_state();
@@ -1789,6 +2097,8 @@ llvm::Function *LLVM_code_generator::compile_switch_lambda(
     Lambda_function const     &lambda,
     ICall_name_resolver const *resolver)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN, lambda.get_name());
+
     reset_lambda_state();
 
     // switch functions return a bool
@@ -1963,6 +2273,8 @@ llvm::Function *LLVM_code_generator::compile_generic_lambda(
     ICall_name_resolver const *resolver,
     ILambda_call_transformer  *transformer)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN, lambda.get_name());
+
     IAllocator *alloc = m_arena.get_allocator();
 
     // we need to pass a DAG builder here. We could use a temporary object, but for now
@@ -7677,6 +7989,9 @@ void LLVM_code_generator::create_module(char const *mod_name, char const *mod_fn
     // clear the render state usage
     m_render_state_usage = 0;
 
+    // instantiated DFs cannot be shared across modules
+    m_df_instance_map.clear();
+
     // creates a new llvm module
     llvm::Module *llvm_module = m_module = new llvm::Module(mod_name, m_llvm_context);
 
@@ -7720,9 +8035,16 @@ void LLVM_code_generator::create_module(char const *mod_name, char const *mod_fn
     m_func_pass_manager.reset(new llvm::FunctionPassManager(m_module));
     m_func_pass_manager->add(new llvm::DataLayout(*get_target_layout_data()));
 
-    llvm::PassManagerBuilder builder;
-    builder.OptLevel = m_opt_level;
-    builder.populateFunctionPassManager(*m_func_pass_manager);
+    if (m_opt_pipeline == OPT_PIPELINE_PREVIEW) {
+        // only cheap cleanups, enough to get rid of the local variable allocas
+        m_func_pass_manager->add(llvm::createSROAPass());
+        m_func_pass_manager->add(llvm::createEarlyCSEPass());
+        m_func_pass_manager->add(llvm::createCFGSimplificationPass());
+    } else {
+        llvm::PassManagerBuilder builder;
+        builder.OptLevel = m_opt_level;
+        builder.populateFunctionPassManager(*m_func_pass_manager);
+    }
     m_func_pass_manager->doInitialization();
 }
 
@@ -7848,6 +8170,8 @@ void LLVM_code_generator::ptx_compile(
     llvm::Module *module,
     string       &code)
 {
+    Trace_scope trace(TP_PTX_EMIT);
+
     char mcpu[16];
     char features[16];
     {
@@ -7915,6 +8239,7 @@ void LLVM_code_generator::ptx_compile(
 
     target_machine->addPassesToEmitFile(pm, *Out, llvm::TargetMachine::CGFT_AssemblyFile);
 
+    llvm::sys::ScopedReader guard(*g_pass_timing_lock);
     pm.run(*module);
     }
 
@@ -8632,6 +8957,27 @@ Function_context::Tex_lookup_call_mode LLVM_code_generator::parse_call_mode(char
     return Function_context::TLCM_VTABLE;
 }
 
+// Parse an optimization pipeline option.
+LLVM_code_generator::Opt_pipeline LLVM_code_generator::parse_opt_pipeline(char const *name)
+{
+    if (strcmp(name, "preview") == 0)
+        return OPT_PIPELINE_PREVIEW;
+    if (strcmp(name, "final") == 0)
+        return OPT_PIPELINE_FINAL;
+    return OPT_PIPELINE_DEFAULT;
+}
+
+// Parse an expression lambda profile mode option.
+LLVM_code_generator::Df_lambda_profile_mode LLVM_code_generator::parse_df_lambda_profile_mode(
+    char const *name)
+{
+    if (strcmp(name, "record") == 0)
+        return DFPM_RECORD;
+    if (strcmp(name, "use") == 0)
+        return DFPM_USE;
+    return DFPM_OFF;
+}
+
 } // mdl
 } // mi
 
@@ -29,6 +29,7 @@
 #ifndef MDL_GENERATOR_JIT_LLVM_H
 #define MDL_GENERATOR_JIT_LLVM_H 1
 
+#include <atomic>
 #include <csetjmp>
 
 #include <mi/base/atom.h>
@@ -87,6 +88,117 @@ class Distribution_function;
 class MDL;
 class MDL_runtime_creator;
 
+///
+/// Records how often native code of distribution functions needs the results of their
+/// expression lambdas, see MDL_JIT_OPTION_DF_LAMBDA_PROFILE.
+///
+/// Counters are identified by the hash of the main DF and the hash of the expression lambda,
+/// so the data of a native run can be used by any later translation of the same material,
+/// including translations for other targets.
+///
+/// Jitted code increments its counters at fixed addresses, so a counter is kept as long as an
+/// LLVM module referencing it exists. The number of counters is bounded: once the limit is
+/// reached, the oldest counters not referenced by any module are dropped.
+///
+class Df_lambda_profile
+{
+public:
+    /// The type of a counter, incremented by jitted code.
+    typedef std::atomic<mi::Uint64> Counter;
+
+    /// The maximum number of counters.
+    static size_t const max_counters = 64 * 1024;
+
+    /// Constructor.
+    ///
+    /// \param alloc  the allocator
+    explicit Df_lambda_profile(IAllocator *alloc);
+
+    /// Get the counter of an expression lambda, creating it if necessary.
+    ///
+    /// \param df_hash      the hash of the main DF
+    /// \param lambda_hash  the hash of the expression lambda
+    /// \param owner        the LLVM module whose code will increment the counter
+    ///
+    /// \return the counter, valid until #release() is called for \p owner, or NULL if the
+    ///         limit is reached and all counters are referenced
+    Counter *get_counter(
+        DAG_hash const     &df_hash,
+        DAG_hash const     &lambda_hash,
+        llvm::Module const *owner);
+
+    /// Release all counters referenced by the given LLVM module, called when it is deleted.
+    ///
+    /// The recorded counts are kept.
+    ///
+    /// \param owner  the LLVM module
+    void release(llvm::Module const *owner);
+
+    /// Discard all recorded counts.
+    ///
+    /// Counters referenced by existing modules are reset to zero, all others are dropped.
+    void clear();
+
+    /// Look up the recorded count of an expression lambda.
+    ///
+    /// \param df_hash      the hash of the main DF
+    /// \param lambda_hash  the hash of the expression lambda
+    /// \param count        the recorded count
+    ///
+    /// \return false, if no code counting this expression lambda was ever generated
+    bool lookup(DAG_hash const &df_hash, DAG_hash const &lambda_hash, mi::Uint64 &count) const;
+
+private:
+    /// Identifies an expression lambda of a DF.
+    struct Key {
+        DAG_hash df_hash;
+        DAG_hash lambda_hash;
+
+        bool operator<(Key const &other) const {
+            if (df_hash != other.df_hash)
+                return df_hash < other.df_hash;
+            return lambda_hash < other.lambda_hash;
+        }
+    };
+
+    typedef list<Key>::Type Key_list;
+
+    /// A counter, zero-initialized on insertion.
+    struct Entry {
+        Counter            count;
+        size_t             users;   ///< The number of modules referencing the counter.
+        Key_list::iterator age;     ///< The position in the insertion order.
+
+        Entry() : count(0), users(0), age() {}
+    };
+
+    /// A reference of a module to a counter.
+    struct Reference {
+        llvm::Module const *owner;
+        Key                key;
+    };
+
+    typedef map<Key, Entry>::Type        Counter_map;
+    typedef list<Reference>::Type        Reference_list;
+
+    /// Drop the oldest counter that is not referenced by any module, needs the lock.
+    ///
+    /// \return false if all counters are referenced
+    bool drop_oldest_unreferenced();
+
+    /// The lock protecting the map, the insertion order and the references, not the counters.
+    mutable mi::base::Lock m_lock;
+
+    /// The counters. Map nodes never move, so counter addresses are stable.
+    Counter_map m_counters;
+
+    /// The keys of all counters, oldest first.
+    Key_list m_ages;
+
+    /// The references of all existing modules to counters.
+    Reference_list m_references;
+};
+
 /// The Jitted code interface holds jitted code.
 class IJitted_code : public
     mi::base::Interface_declare<0x933809eb,0x0449,0x4c29,0xaf,0x04,0xc4,0x90,0x1e,0xaa,0xd3,0x3e>
@@ -137,6 +249,9 @@ public:
     /// Get the layout data for the current JITer target.
     llvm::DataLayout const *get_layout_data() const;
 
+    /// Get the expression lambda profile of distribution functions.
+    Df_lambda_profile &get_df_lambda_profile() { return m_df_lambda_profile; }
+
 private:
     /// Constructor.
     ///
@@ -171,6 +286,9 @@ private:
 
     /// The global ExecutionEngine.
     llvm::ExecutionEngine *m_execution_engine;
+
+    /// The expression lambda profile, outlives all jitted code incrementing its counters.
+    Df_lambda_profile m_df_lambda_profile;
 };
 
 ///
@@ -827,6 +945,10 @@ public:
     typedef vector<mi::mdl::IType const *>::Type Type_vector;
     typedef vector<llvm::Function *>::Type Function_vector;
 
+    /// The name of an optimized function and the wall clock time spent on it.
+    typedef std::pair<string, double> Function_timing;
+    typedef vector<Function_timing>::Type Function_timing_vector;
+
     ///
     /// Debug modes for the generated JIT code.
     ///
@@ -842,6 +964,24 @@ public:
                                   pause on function enter (to connect the debugger). */
     }; // can be or'ed
 
+    ///
+    /// Optimization pipelines of the JIT code generator.
+    ///
+    enum Opt_pipeline {
+        OPT_PIPELINE_DEFAULT = 0,  ///< Use the pipeline selected by the optimization level.
+        OPT_PIPELINE_PREVIEW = 1,  ///< Fast compilation, only cheap cleanup passes.
+        OPT_PIPELINE_FINAL   = 2,  ///< Slow compilation, aggressive inlining and vectorization.
+    };
+
+    ///
+    /// Modes of the expression lambda profile of distribution functions.
+    ///
+    enum Df_lambda_profile_mode {
+        DFPM_OFF    = 0,  ///< Select precalculated expression lambdas by static costs.
+        DFPM_RECORD = 1,  ///< Count the uses of expression lambdas in native code.
+        DFPM_USE    = 2,  ///< Select precalculated expression lambdas by recorded counts.
+    };
+
     /// The coordinate space encoding, must match the definitions in state.mdl.
     enum coordinate_space {
         coordinate_internal,
@@ -1097,6 +1237,11 @@ public:
     /// Returns true if fast-math is enabled.
     bool is_fast_math_enabled() const { return m_fast_math; }
 
+    /// Get the timing report of the optimizer if timing collection was enabled.
+    ///
+    /// \returns the report or the empty string if no timing data was collected
+    char const *get_timing_report() const { return m_timing_report.c_str(); }
+
     /// Return true if finite-math is enabled.
     bool is_finite_math_enabled() const { return m_finite_math; }
 
@@ -2048,6 +2193,34 @@ private:
     llvm::Function *instantiate_ternary_df(
         DAG_call const *dag_call);
 
+    /// Compute the structural key of a DF instantiation in the current state.
+    ///
+    /// Two instantiations with the same key generate identical code, so materials of a link unit
+    /// using the same DF graph with the same data layout can share the instantiated functions.
+    ///
+    /// \param key   the key will be appended here
+    /// \param node  the DF node to instantiate
+    ///
+    /// \returns false, if the instantiation depends on data specific to the current
+    ///          distribution function and cannot be shared
+    bool append_df_instance_key(string &key, DAG_node const *node);
+
+    /// Append the structural key of a DAG node used by a DF instantiation.
+    bool append_df_node_key(string &key, DAG_node const *node);
+
+    /// Append the structural key of how a precalculated lambda is accessed by a DF
+    /// instantiation, see translate_precalculated_lambda().
+    bool append_df_lambda_key(string &key, size_t lambda_index);
+
+    /// Append the structural key of a constant used by a DF instantiation.
+    bool append_df_value_key(string &key, IValue const *value);
+
+    /// Append the structural key of a type used by a DF instantiation.
+    void append_df_type_key(string &key, IType const *type);
+
+    /// Append the layout of a lambda or texture results struct type.
+    void append_df_struct_key(string &key, llvm::StructType *type);
+
 
     /// Translate the current distribution function to LLVM IR.
     ///
@@ -2613,6 +2786,23 @@ private:
     /// \param name  a valid call mode name
     static Function_context::Tex_lookup_call_mode parse_call_mode(char const *name);
 
+    /// Parse an optimization pipeline option.
+    ///
+    /// \param name  a valid optimization pipeline name
+    static Opt_pipeline parse_opt_pipeline(char const *name);
+
+    /// Parse an expression lambda profile mode option.
+    ///
+    /// \param name  a valid expression lambda profile mode name
+    static Df_lambda_profile_mode parse_df_lambda_profile_mode(char const *name);
+
+    /// Run the module passes of the selected optimization pipeline.
+    ///
+    /// \param module  The LLVM module to optimize.
+    ///
+    /// \return true if module was modified, false otherwise
+    bool run_module_passes(llvm::Module *module);
+
 private:
     /// The memory arena used to allocate context data on.
     mi::mdl::Memory_arena m_arena;
@@ -2848,6 +3038,24 @@ private:
     /// Optimization level.
     unsigned m_opt_level;
 
+    /// The selected optimization pipeline.
+    Opt_pipeline m_opt_pipeline;
+
+    /// If true, timing statistics of the optimizer are collected.
+    bool m_collect_timing;
+
+    /// Accumulated wall clock time spent in the function pass manager.
+    double m_func_opt_time;
+
+    /// Number of functions run through the function pass manager.
+    size_t m_func_opt_count;
+
+    /// Wall clock time spent in the function pass manager per function.
+    Function_timing_vector m_func_opt_times;
+
+    /// The timing report of the last module optimization if timing collection is enabled.
+    string m_timing_report;
+
     /// The debug mode.
     Jit_debug_mode m_jit_dbg_mode;
 
@@ -2914,6 +3122,9 @@ private:
     /// If true, the texture lookup functions with derivatives will be used.
     bool m_texruntime_with_derivs;
 
+    /// The mode of the expression lambda profile of distribution functions.
+    Df_lambda_profile_mode m_df_lambda_profile_mode;
+
     /// If non-null, the derivative analysis information.
     Derivative_infos const *m_deriv_infos;
 
@@ -2936,6 +3147,12 @@ private:
     /// Map from ILambda_function objects to LLVM functions used for distribution functions.
     Dist_func_lambda_map m_dist_func_lambda_map;
 
+    typedef hash_map<string, llvm::Function *, string_hash<string> >::Type Df_instance_map;
+
+    /// Map from structural keys of instantiated DFs to their functions in the current module,
+    /// shared by all distribution functions compiled into the module.
+    Df_instance_map m_df_instance_map;
+
     /// A structure type for storing the results of all lambda functions.
     llvm::StructType *m_lambda_results_struct_type;
 
@@ -2950,6 +3167,10 @@ private:
     /// For expression lambdas without a texture result entry the array contains -1.
     mi::mdl::vector<int>::Type m_texture_result_indices;
 
+    /// Array which maps expression lambda indices to their profile counters while recording,
+    /// NULL for constant expression lambdas. Empty, if the profile is not recorded.
+    mi::mdl::vector<Df_lambda_profile::Counter *>::Type m_df_lambda_counters;
+
     /// A float3 struct type used in libbsdf.
     llvm::StructType *m_float3_struct_type;
 
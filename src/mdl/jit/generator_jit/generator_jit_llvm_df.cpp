@@ -36,6 +36,7 @@
 #include <llvm/Linker.h>
 
 #include "mdl/compiler/compilercore/compilercore_errors.h"
+#include "mdl/compiler/compilercore/compilercore_trace.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_lambda_function.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_tools.h"
 #include "mdl/codegenerators/generator_dag/generator_dag_walker.h"
@@ -65,21 +66,24 @@ struct Lambda_result_slot
     unsigned        size;
 
     /// The costs used for sorting.
-    int             sort_cost;
+    double          sort_cost;
 
     /// The constructor.
+    ///
+    /// \param weight  the relative frequency of uses of the result, 1 if unknown
     Lambda_result_slot(
         size_t expr_lambda_index,
         llvm::Type *llvm_ret_type,
         int cost,
-        unsigned size)
+        unsigned size,
+        double weight)
     : expr_lambda_index(expr_lambda_index)
     , llvm_ret_type(llvm_ret_type)
     , cost(cost)
     , size(size)
     {
-        // when sorting, prefer high cost per byte
-        sort_cost = cost * 16 / std::max(size, 1u);
+        // when sorting, prefer high (used) cost per byte
+        sort_cost = cost * weight * 16.0 / std::max(size, 1u);
     }
 };
 
@@ -249,6 +253,7 @@ public:
         llvm::StructType *float3_struct_type,
         unsigned num_texture_results,
         Distribution_function const &dist_func,
+        Df_lambda_profile const *profile,
         mi::mdl::vector<int>::Type &lambda_result_indices,
         mi::mdl::vector<int>::Type &texture_result_indices,
         llvm::SmallVector<unsigned, 8> &lambda_result_exprs_init,
@@ -261,6 +266,7 @@ public:
       , m_float3_struct_type(float3_struct_type)
       , m_num_texture_results(num_texture_results)
       , m_dist_func(dist_func)
+      , m_profile(profile)
       , m_lambda_result_indices(lambda_result_indices)
       , m_texture_result_indices(texture_result_indices)
       , m_lambda_infos(alloc)
@@ -291,6 +297,10 @@ public:
         size_t geometry_normal_index = m_dist_func.get_special_lambda_function_index(
             IDistribution_function::SK_MATERIAL_GEOMETRY_NORMAL);
 
+        // with a complete profile, weight the costs by the recorded uses
+        mi::mdl::vector<mi::Uint64>::Type use_counts(m_alloc);
+        bool use_profile = m_profile != NULL && lookup_use_counts(use_counts);
+
         // first collect information about all non-constant expression lambdas
         for (size_t i = 0; i < expr_lambda_count; ++i) {
             mi::base::Handle<mi::mdl::ILambda_function> expr_lambda(m_dist_func.get_expr_lambda(i));
@@ -327,7 +337,8 @@ public:
 
             // we want to materialize the result, so register a slot
             m_lambda_slots.push_back(Lambda_result_slot(
-                i, lambda_ret_type, cost, res_alloc_size));
+                i, lambda_ret_type, cost, res_alloc_size,
+                use_profile ? double(use_counts[i]) : 1.0));
             cur.lambda_slot_index = m_lambda_slots.size() - 1;
 
             // set local costs and add to the total ones
@@ -362,6 +373,10 @@ public:
             if (m_texture_result_indices[expr_index] != -1)
                 continue;
 
+            // never used after the init function? -> only calculate it as a dependency
+            if (use_profile && use_counts[expr_index] == 0)
+                continue;
+
             Lambda_info &lambda_info = m_lambda_infos[expr_index];
             Lambda_info::Index_set &deps = lambda_info.dep_expr_indices;
 
@@ -442,6 +457,28 @@ public:
     }
 
 private:
+    /// Look up the recorded uses of all non-constant expression lambdas.
+    ///
+    /// \param use_counts  receives the counts, indexed by expression lambda
+    ///
+    /// \returns false, if the profile does not contain all expression lambdas
+    bool lookup_use_counts(mi::mdl::vector<mi::Uint64>::Type &use_counts) const
+    {
+        mi::base::Handle<ILambda_function> main_df(m_dist_func.get_main_df());
+        DAG_hash const *df_hash = main_df->get_hash();
+
+        size_t expr_lambda_count = m_dist_func.get_expr_lambda_count();
+        use_counts.resize(expr_lambda_count, 0);
+        for (size_t i = 0; i < expr_lambda_count; ++i) {
+            mi::base::Handle<ILambda_function> expr_lambda(m_dist_func.get_expr_lambda(i));
+            if (is<DAG_constant>(expr_lambda->get_body()))
+                continue;
+            if (!m_profile->lookup(*df_hash, *expr_lambda->get_hash(), use_counts[i]))
+                return false;
+        }
+        return true;
+    }
+
     /// Helper structure collecting information about expression lambdas and their dependencies.
     struct Lambda_info {
         typedef set<unsigned>::Type Index_set;
@@ -628,6 +665,9 @@ private:
     /// The distribution function.
     Distribution_function const &m_dist_func;
 
+    /// The expression lambda profile to use, if any.
+    Df_lambda_profile const *m_profile;
+
     /// Array which maps expression lambda indices to lambda result indices.
     /// For expression lambdas without a lambda result entry the array contains -1.
     mi::mdl::vector<int>::Type &m_lambda_result_indices;
@@ -991,6 +1031,8 @@ llvm::Module *LLVM_code_generator::compile_distribution_function(
     ICall_name_resolver const   *resolver,
     Function_vector             &llvm_funcs)
 {
+    Trace_scope trace(TP_LLVM_IR_GEN);
+
     m_dist_func = &dist_func;
 
     IAllocator *alloc = m_arena.get_allocator();
@@ -1036,6 +1078,7 @@ llvm::Module *LLVM_code_generator::compile_distribution_function(
         m_float3_struct_type,
         m_num_texture_results,
         *m_dist_func,
+        m_df_lambda_profile_mode == DFPM_USE ? &m_jitted_code->get_df_lambda_profile() : NULL,
         m_lambda_result_indices,
         m_texture_result_indices,
         lambda_result_exprs_init,
@@ -1115,6 +1158,23 @@ llvm::Module *LLVM_code_generator::compile_distribution_function(
     // the BSDF API functions create the lambda results they use, so no lambda results parameter
     m_lambda_force_no_lambda_results = true;
 
+    // when recording the profile, the sample, evaluate and pdf functions count the uses of the
+    // expression lambda results
+    if (m_df_lambda_profile_mode == DFPM_RECORD) {
+        Df_lambda_profile &profile = m_jitted_code->get_df_lambda_profile();
+        DAG_hash const *df_hash = root_lambda->get_hash();
+
+        m_df_lambda_counters.resize(expr_lambda_count, NULL);
+        for (size_t i = 0; i < expr_lambda_count; ++i) {
+            mi::base::Handle<ILambda_function> expr_lambda(m_dist_func->get_expr_lambda(i));
+            if (is<DAG_constant>(expr_lambda->get_body()))
+                continue;
+            // NULL if the profile is full, this lambda is not counted then
+            m_df_lambda_counters[i] = profile.get_counter(
+                *df_hash, *expr_lambda->get_hash(), m_module);
+        }
+    }
+
     llvm::Twine base_name(root_lambda->get_name());
     Function_instance inst(get_allocator(), root_lambda);
 
@@ -1167,6 +1227,7 @@ llvm::Module *LLVM_code_generator::compile_distribution_function(
 
     // reset some fields
     m_deriv_infos = NULL;
+    m_df_lambda_counters.clear();
     m_dist_func_lambda_map.clear();
     m_dist_func = NULL;
 
@@ -2102,6 +2163,21 @@ Expression_result LLVM_code_generator::translate_precalculated_lambda(
 
     Expression_result res;
 
+    // count the use when recording the profile, independent of where the result comes from
+    if (!m_df_lambda_counters.empty() && m_df_lambda_counters[lambda_index] != NULL &&
+            (m_dist_func_state == DFSTATE_SAMPLE ||
+             m_dist_func_state == DFSTATE_EVALUATE ||
+             m_dist_func_state == DFSTATE_PDF)) {
+        llvm::IntegerType *int64_type = llvm::Type::getInt64Ty(m_llvm_context);
+        llvm::Constant *counter = llvm::ConstantExpr::getIntToPtr(
+            llvm::ConstantInt::get(
+                int64_type, uint64_t(reinterpret_cast<size_t>(m_df_lambda_counters[lambda_index]))),
+            int64_type->getPointerTo());
+        ctx->CreateAtomicRMW(
+            llvm::AtomicRMWInst::Add, counter, llvm::ConstantInt::get(int64_type, 1),
+            llvm::Monotonic);
+    }
+
     // translate constants directly
     if (DAG_constant const *c = as<DAG_constant>(expr_lambda->get_body())) {
         res = translate_value(ctx, c->get_value());
@@ -2617,6 +2693,236 @@ void LLVM_code_generator::handle_df_array_parameter(
     MDL_ASSERT(!"Unsupported array parameter type");
 }
 
+// Compute the structural key of a DF instantiation in the current state.
+bool LLVM_code_generator::append_df_instance_key(string &key, DAG_node const *node)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "S%d", int(m_dist_func_state));
+    key.append(buf);
+
+    // the libbsdf code may access these special lambdas
+    static IDistribution_function::Special_kind const special_kinds[] = {
+        IDistribution_function::SK_MATERIAL_IOR,
+        IDistribution_function::SK_MATERIAL_THIN_WALLED,
+        IDistribution_function::SK_MATERIAL_VOLUME_ABSORPTION
+    };
+    for (size_t i = 0, n = dimension_of(special_kinds); i < n; ++i) {
+        size_t index = m_dist_func->get_special_lambda_function_index(special_kinds[i]);
+        if (index == ~0) {
+            key.append('-');
+        } else if (!append_df_lambda_key(key, index)) {
+            return false;
+        }
+    }
+    return append_df_node_key(key, node);
+}
+
+// Append the structural key of a DAG node used by a DF instantiation.
+bool LLVM_code_generator::append_df_node_key(string &key, DAG_node const *node)
+{
+    switch (node->get_kind()) {
+    case DAG_node::EK_CONSTANT:
+        key.append('K');
+        return append_df_value_key(key, cast<DAG_constant>(node)->get_value());
+
+    case DAG_node::EK_TEMPORARY:
+        return append_df_node_key(key, cast<DAG_temporary>(node)->get_expr());
+
+    case DAG_node::EK_CALL:
+        {
+            DAG_call const *call = cast<DAG_call>(node);
+            if (call->get_semantic() == IDefinition::DS_INTRINSIC_DAG_CALL_LAMBDA) {
+                key.append('L');
+                return append_df_lambda_key(key, strtoul(call->get_name(), NULL, 10));
+            }
+
+            // the signature determines the semantics and the parameters
+            key.append('C');
+            key.append(call->get_name());
+            key.append('(');
+            for (int i = 0, n = call->get_argument_count(); i < n; ++i) {
+                if (i > 0)
+                    key.append(',');
+                if (!append_df_node_key(key, call->get_argument(i)))
+                    return false;
+            }
+            key.append(')');
+            return true;
+        }
+
+    case DAG_node::EK_PARAMETER:
+        // parameters are always accessed via lambdas
+        break;
+    }
+    return false;
+}
+
+// Append the structural key of how a precalculated lambda is accessed by a DF instantiation.
+bool LLVM_code_generator::append_df_lambda_key(string &key, size_t lambda_index)
+{
+    mi::base::Handle<mi::mdl::ILambda_function> expr_lambda(
+        m_dist_func->get_expr_lambda(lambda_index));
+
+    char buf[32];
+    if (DAG_constant const *c = as<DAG_constant>(expr_lambda->get_body())) {
+        key.append('c');
+        return append_df_value_key(key, c->get_value());
+    }
+
+    // counted uses must increment the counters of the current distribution function
+    if (!m_df_lambda_counters.empty() && m_df_lambda_counters[lambda_index] != NULL) {
+        snprintf(buf, sizeof(buf), "p%p", static_cast<void *>(m_df_lambda_counters[lambda_index]));
+        key.append(buf);
+    }
+
+    if (m_texture_result_indices[lambda_index] != -1) {
+        snprintf(buf, sizeof(buf), "t%d", m_texture_result_indices[lambda_index]);
+        key.append(buf);
+        append_df_struct_key(key, m_texture_results_struct_type);
+        return true;
+    } else if (m_lambda_result_indices[lambda_index] != -1) {
+        snprintf(buf, sizeof(buf), "r%d", m_lambda_result_indices[lambda_index]);
+        key.append(buf);
+        append_df_struct_key(key, m_lambda_results_struct_type);
+        return true;
+    }
+
+    // calculated on demand by a function of the current distribution function
+    return false;
+}
+
+// Append the structural key of a constant used by a DF instantiation.
+bool LLVM_code_generator::append_df_value_key(string &key, IValue const *value)
+{
+    char buf[32];
+    switch (value->get_kind()) {
+    case IValue::VK_BOOL:
+        key.append(cast<IValue_bool>(value)->get_value() ? "b1" : "b0");
+        return true;
+    case IValue::VK_INT:
+        snprintf(buf, sizeof(buf), "i%d", cast<IValue_int>(value)->get_value());
+        key.append(buf);
+        return true;
+    case IValue::VK_ENUM:
+        append_df_type_key(key, value->get_type());
+        snprintf(buf, sizeof(buf), "e%d", cast<IValue_enum>(value)->get_value());
+        key.append(buf);
+        return true;
+    case IValue::VK_FLOAT:
+        {
+            // compare bit patterns, not values
+            float f = cast<IValue_float>(value)->get_value();
+            unsigned bits;
+            memcpy(&bits, &f, sizeof(bits));
+            snprintf(buf, sizeof(buf), "f%x", bits);
+            key.append(buf);
+            return true;
+        }
+    case IValue::VK_DOUBLE:
+        {
+            double d = cast<IValue_double>(value)->get_value();
+            unsigned long long bits;
+            memcpy(&bits, &d, sizeof(bits));
+            snprintf(buf, sizeof(buf), "d%llx", bits);
+            key.append(buf);
+            return true;
+        }
+    case IValue::VK_STRING:
+        {
+            char const *str = cast<IValue_string>(value)->get_value();
+            snprintf(buf, sizeof(buf), "s%u:", unsigned(strlen(str)));
+            key.append(buf);
+            key.append(str);
+            return true;
+        }
+    case IValue::VK_VECTOR:
+    case IValue::VK_MATRIX:
+    case IValue::VK_ARRAY:
+    case IValue::VK_RGB_COLOR:
+    case IValue::VK_STRUCT:
+        {
+            IValue_compound const *comp = cast<IValue_compound>(value);
+            append_df_type_key(key, value->get_type());
+            key.append('{');
+            for (int i = 0, n = comp->get_component_count(); i < n; ++i) {
+                if (i > 0)
+                    key.append(',');
+                if (!append_df_value_key(key, comp->get_value(i)))
+                    return false;
+            }
+            key.append('}');
+            return true;
+        }
+    case IValue::VK_INVALID_REF:
+        key.append('n');
+        append_df_type_key(key, value->get_type());
+        return true;
+    case IValue::VK_BAD:
+    case IValue::VK_TEXTURE:
+    case IValue::VK_LIGHT_PROFILE:
+    case IValue::VK_BSDF_MEASUREMENT:
+        // resources are mapped to indices of the current resource tables
+        break;
+    }
+    return false;
+}
+
+// Append the structural key of a type used by a DF instantiation.
+void LLVM_code_generator::append_df_type_key(string &key, IType const *type)
+{
+    type = type->skip_type_alias();
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "T%d", int(type->get_kind()));
+    key.append(buf);
+
+    switch (type->get_kind()) {
+    case IType::TK_ENUM:
+        key.append(cast<IType_enum>(type)->get_symbol()->get_name());
+        break;
+    case IType::TK_STRUCT:
+        key.append(cast<IType_struct>(type)->get_symbol()->get_name());
+        break;
+    case IType::TK_VECTOR:
+    case IType::TK_MATRIX:
+        {
+            IType_compound const *comp = cast<IType_compound>(type);
+            snprintf(buf, sizeof(buf), "x%d", comp->get_compound_size());
+            key.append(buf);
+            append_df_type_key(key, comp->get_compound_type(0));
+            break;
+        }
+    case IType::TK_ARRAY:
+        {
+            IType_array const *arr = cast<IType_array>(type);
+            if (arr->is_immediate_sized()) {
+                snprintf(buf, sizeof(buf), "[%d]", arr->get_size());
+                key.append(buf);
+            } else {
+                key.append("[]");
+            }
+            append_df_type_key(key, arr->get_element_type());
+            break;
+        }
+    default:
+        break;
+    }
+}
+
+// Append the layout of a lambda or texture results struct type.
+void LLVM_code_generator::append_df_struct_key(string &key, llvm::StructType *type)
+{
+    // apart from named structs, LLVM types are unique, and the named element types are
+    // shared by all distribution functions of the module
+    char buf[32];
+    key.append('<');
+    for (unsigned i = 0, n = type->getNumElements(); i < n; ++i) {
+        snprintf(buf, sizeof(buf), "%p;", (void *)type->getElementType(i));
+        key.append(buf);
+    }
+    key.append('>');
+}
+
 /// Recursively instantiate a ternary operator of type BSDF.
 llvm::Function *LLVM_code_generator::instantiate_ternary_df(
     DAG_call const *dag_call)
@@ -2797,10 +3103,24 @@ llvm::Function *LLVM_code_generator::instantiate_df(
     }
 
     DAG_call const *dag_call = cast<DAG_call>(node);
-    
+
+    // materials of a link unit often use the same DF graphs, differing only in their arguments:
+    // reuse an identical instantiation if possible
+    string key(get_allocator());
+    bool shareable = append_df_instance_key(key, dag_call);
+    if (shareable) {
+        Df_instance_map::const_iterator it = m_df_instance_map.find(key);
+        if (it != m_df_instance_map.end())
+            return it->second;
+    }
+
     IDefinition::Semantics sema = dag_call->get_semantic();
-    if (sema == operator_to_semantic(IExpression::OK_TERNARY))
-        return instantiate_ternary_df(dag_call);
+    if (sema == operator_to_semantic(IExpression::OK_TERNARY)) {
+        llvm::Function *ternary_func = instantiate_ternary_df(dag_call);
+        if (shareable && ternary_func != NULL)
+            m_df_instance_map[key] = ternary_func;
+        return ternary_func;
+    }
 
     IType::Kind kind = dag_call->get_type()->get_kind();
     df_lib_func = get_libbsdf_function(sema, kind);
@@ -2949,8 +3269,10 @@ llvm::Function *LLVM_code_generator::instantiate_df(
     }
 
     // optimize function to improve inlining
-    m_func_pass_manager->run(*bsdf_func);
+    optimize(bsdf_func);
 
+    if (shareable)
+        m_df_instance_map[key] = bsdf_func;
     return bsdf_func;
 }
 
@@ -0,0 +1,320 @@
+/******************************************************************************
+ * Copyright (c) 2017-2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+/// \file
+/// \brief  Microbenchmarks for the spectral conversions of the MDL runtime.
+///
+/// Each batched kernel is measured against a loop over its scalar counterpart on identical
+/// input. The results are printed as a table and optionally written as JSON in the format of
+/// the MDL SDK benchmark suite (suite "spectral", corpus "micro").
+///
+/// Usage: mdl_spectral_benchmark [--warm <n>] [--json <file>]
+
+#include "pch.h"
+
+#include <mdl/runtime/spectral/i_spectral.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace mi::mdl::spectral;
+
+namespace {
+
+/// Number of elements processed by one kernel call.
+unsigned const BATCH_SIZE = 4096;
+
+/// Number of kernel calls per measured run.
+unsigned const REPETITIONS = 64;
+
+/// Defeats dead code elimination of the benchmarked calls.
+volatile float g_sink;
+
+/// Returns a deterministic pseudo-random number in [0, 1).
+float random_float(unsigned &seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return float(seed >> 8) * (1.0f / 16777216.0f);
+}
+
+/// Input data shared by all spectral benchmarks.
+struct Spectral_input {
+    std::vector<float> lambdas;   ///< BATCH_SIZE wavelengths
+    std::vector<float> spectra;   ///< BATCH_SIZE spectra with SPECTRAL_XYZ_RES samples each
+    std::vector<float> colors;    ///< BATCH_SIZE color triples in [0, 1)
+    std::vector<float> kelvin;    ///< BATCH_SIZE temperatures
+
+    Spectral_input()
+    : lambdas(BATCH_SIZE)
+    , spectra(BATCH_SIZE * SPECTRAL_XYZ_RES)
+    , colors(BATCH_SIZE * 3)
+    , kelvin(BATCH_SIZE)
+    {
+        unsigned seed = 1;
+        for (unsigned i = 0; i < BATCH_SIZE; ++i) {
+            lambdas[i] = SPECTRAL_XYZ_LAMBDA_MIN
+                + random_float(seed) * (SPECTRAL_XYZ_LAMBDA_MAX - SPECTRAL_XYZ_LAMBDA_MIN);
+            kelvin[i] = 1000.0f + random_float(seed) * 11000.0f;
+        }
+        for (size_t i = 0; i < spectra.size(); ++i)
+            spectra[i] = random_float(seed);
+        for (size_t i = 0; i < colors.size(); ++i)
+            colors[i] = random_float(seed);
+    }
+};
+
+/// The measurements of one kernel.
+struct Result {
+    char const          *name;  ///< The name of the kernel.
+    double              cold;   ///< Time of the first run in seconds.
+    std::vector<double> warm;   ///< Times of the following runs in seconds.
+
+    /// Returns the median of the warm runs, or the cold run if there are none.
+    double median() const
+    {
+        if (warm.empty())
+            return cold;
+        std::vector<double> sorted(warm);
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        return (n & 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+};
+
+/// Runs the benchmarks and collects their results.
+class Spectral_benchmark {
+public:
+    /// Constructor.
+    ///
+    /// \param num_warm  the number of warm runs per kernel
+    explicit Spectral_benchmark(unsigned num_warm) : m_num_warm(num_warm) {}
+
+    /// Measures the given kernel, one cold and m_num_warm warm runs.
+    template<typename F>
+    void run(char const *name, F kernel)
+    {
+        Result res;
+        res.name = name;
+        res.cold = 0.0;
+        for (unsigned run = 0; run <= m_num_warm; ++run) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (unsigned r = 0; r < REPETITIONS; ++r)
+                kernel();
+            double t = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            if (run == 0)
+                res.cold = t;
+            else
+                res.warm.push_back(t);
+        }
+        m_results.push_back(res);
+    }
+
+    /// Prints one line per kernel.
+    void print_summary() const
+    {
+        printf("%-32s %12s %12s %14s\n", "name", "cold [ms]", "warm [ms]", "elements/s");
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            Result const &res = m_results[i];
+            double t = res.median();
+            printf("%-32s %12.3f %12.3f %14.4g\n",
+                res.name, res.cold * 1000.0, t * 1000.0, t > 0.0 ? get_items() / t : 0.0);
+        }
+    }
+
+    /// Writes the results in the JSON format of the MDL SDK benchmark suite.
+    ///
+    /// \return true on success
+    bool write_json(char const *file_name) const
+    {
+        FILE *f = fopen(file_name, "w");
+        if (f == NULL)
+            return false;
+
+        fprintf(f, "{\n  \"schema\": 1,\n  \"config\": {\n    \"warm_runs\": \"%u\"\n  },\n"
+            "  \"results\": [", m_num_warm);
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            Result const &res = m_results[i];
+            double t = res.median();
+            fprintf(f, "%s\n    {\"suite\": \"spectral\", \"corpus\": \"micro\", \"name\": \"%s\""
+                ", \"cold_s\": %.9g",
+                i == 0 ? "" : ",", res.name, res.cold);
+            if (!res.warm.empty()) {
+                fprintf(f, ", \"warm\": {\"runs\": %u, \"min_s\": %.9g, \"median_s\": %.9g"
+                    ", \"max_s\": %.9g}",
+                    unsigned(res.warm.size()),
+                    *std::min_element(res.warm.begin(), res.warm.end()),
+                    t,
+                    *std::max_element(res.warm.begin(), res.warm.end()));
+            }
+            fprintf(f, ", \"items\": %.9g, \"unit\": \"elements\"", get_items());
+            if (t > 0.0)
+                fprintf(f, ", \"throughput_per_s\": %.9g", get_items() / t);
+            fprintf(f, "}");
+        }
+        fprintf(f, "\n  ]\n}\n");
+        return fclose(f) == 0;
+    }
+
+private:
+    /// Returns the number of elements processed per run.
+    static double get_items() { return double(BATCH_SIZE) * REPETITIONS; }
+
+    unsigned            m_num_warm;
+    std::vector<Result> m_results;
+};
+
+/// Runs all spectral kernels.
+void run_spectral_benchmarks(Spectral_benchmark &bench)
+{
+    Spectral_input in;
+    std::vector<float> out(BATCH_SIZE * SPECTRAL_XYZ_RES);
+    float const *table = in.spectra.data();
+    unsigned const n = BATCH_SIZE;
+
+    bench.run("get_values_lerp/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            out[i] = get_value_lerp(
+                table, SPECTRAL_XYZ_RES,
+                SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX, in.lambdas[i]);
+        g_sink = out[n - 1];
+    });
+    bench.run("get_values_lerp/batch", [&]() {
+        get_values_lerp(
+            out.data(), table, SPECTRAL_XYZ_RES,
+            SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX, in.lambdas.data(), n);
+        g_sink = out[n - 1];
+    });
+
+    bench.run("spectrum_to_XYZ/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            spectrum_to_XYZ(
+                &out[3 * i], &in.spectra[i * SPECTRAL_XYZ_RES], SPECTRAL_XYZ_RES,
+                SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX);
+        g_sink = out[3 * n - 1];
+    });
+    bench.run("spectrum_to_XYZ/batch", [&]() {
+        spectrum_to_XYZ_batch(
+            out.data(), in.spectra.data(), n, SPECTRAL_XYZ_RES,
+            SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX);
+        g_sink = out[3 * n - 1];
+    });
+
+    // resample to a typical spectral rendering resolution
+    unsigned const num_resampled = 32;
+    bench.run("spectrum_resample/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            spectrum_resample(
+                &out[i * num_resampled], num_resampled,
+                SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX,
+                &in.spectra[i * SPECTRAL_XYZ_RES], SPECTRAL_XYZ_RES,
+                SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX);
+        g_sink = out[n * num_resampled - 1];
+    });
+    bench.run("spectrum_resample/batch", [&]() {
+        spectrum_resample_batch(
+            out.data(), num_resampled, SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX,
+            in.spectra.data(), SPECTRAL_XYZ_RES, SPECTRAL_XYZ_LAMBDA_MIN, SPECTRAL_XYZ_LAMBDA_MAX,
+            n);
+        g_sink = out[n * num_resampled - 1];
+    });
+
+    bench.run("convert_XYZ_to_cs/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            convert_XYZ_to_cs(&out[3 * i], &in.colors[3 * i], CS_sRGB);
+        g_sink = out[3 * n - 1];
+    });
+    bench.run("convert_XYZ_to_cs/batch", [&]() {
+        convert_XYZ_to_cs_batch(out.data(), in.colors.data(), n, CS_sRGB);
+        g_sink = out[3 * n - 1];
+    });
+
+    bench.run("convert_cs_to_XYZ/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            convert_cs_to_XYZ(&out[3 * i], &in.colors[3 * i], CS_sRGB);
+        g_sink = out[3 * n - 1];
+    });
+    bench.run("convert_cs_to_XYZ/batch", [&]() {
+        convert_cs_to_XYZ_batch(out.data(), in.colors.data(), n, CS_sRGB);
+        g_sink = out[3 * n - 1];
+    });
+
+    bench.run("cs_refl_to_spectrum/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            cs_refl_to_spectrum(&out[i * SPECTRAL_XYZ_RES], &in.colors[3 * i], CS_sRGB);
+        g_sink = out[n * SPECTRAL_XYZ_RES - 1];
+    });
+    bench.run("cs_refl_to_spectrum/batch", [&]() {
+        cs_refl_to_spectrum_batch(out.data(), in.colors.data(), n, CS_sRGB);
+        g_sink = out[n * SPECTRAL_XYZ_RES - 1];
+    });
+
+    bench.run("mdl_blackbody/scalar", [&]() {
+        for (unsigned i = 0; i < n; ++i)
+            mdl_blackbody(&out[3 * i], in.kelvin[i]);
+        g_sink = out[3 * n - 1];
+    });
+    bench.run("mdl_blackbody/batch", [&]() {
+        mdl_blackbody_batch(out.data(), in.kelvin.data(), n);
+        g_sink = out[3 * n - 1];
+    });
+}
+
+}  // anonymous
+
+int main(int argc, char *argv[])
+{
+    unsigned   num_warm  = 5;
+    char const *json_file = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--warm") == 0 && i + 1 < argc) {
+            num_warm = unsigned(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_file = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--warm <n>] [--json <file>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Spectral_benchmark bench(num_warm);
+    run_spectral_benchmarks(bench);
+    bench.print_summary();
+
+    if (json_file != NULL && !bench.write_json(json_file)) {
+        fprintf(stderr, "Failed to write \"%s\".\n", json_file);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -52,6 +52,16 @@ float get_value_lerp(
      float lambda_max,
      float lambda);
 
+// batched variant of get_value_lerp, looks up num_lambda wavelengths at once
+void get_values_lerp(
+     float *values,
+     const float *table_values,
+     unsigned int num_values,
+     float lambda_min,
+     float lambda_max,
+     const float *lambda,
+     unsigned int num_lambda);
+
 // convert a spectrum to XYZ, transforming radiometric to photometric quantities
 // (i.e. if spectral intensities are absolute in W / (m^2 * nm), luminance output is lum / m^2,
 // if it is radiance in W / (m^2 * nm * sr) output is cd / m^2)
@@ -59,6 +69,11 @@ void spectrum_to_XYZ(
     float XYZ[3], const float *spectrum, unsigned int num_values, 
     float lambda_min, float lambda_max);
 
+// batched variant of spectrum_to_XYZ for num_spectra spectra with identical sampling,
+// spectra are stored consecutively (num_values each), XYZ receives num_spectra triples
+void spectrum_to_XYZ_batch(
+    float *XYZ, const float *spectra, unsigned int num_spectra, unsigned int num_values,
+    float lambda_min, float lambda_max);
 
 // compute CIE XYZ Y-component (== luminance)
 float spectrum_to_Y(
@@ -79,13 +94,20 @@ void spectrum_resample(
     const float *source, unsigned int source_num_values, float source_lambda_min, 
     float source_lambda_max);
 
+// batched variant of spectrum_resample for num_spectra spectra with identical sampling,
+// spectra are stored consecutively in source (source_num_values each) and target
+// (target_num_values each)
+void spectrum_resample_batch(
+    float *target, unsigned int target_num_values, float target_lambda_min, float target_lambda_max,
+    const float *source, unsigned int source_num_values, float source_lambda_min,
+    float source_lambda_max, unsigned int num_spectra);
+
 // change number of point samples, use arbitrarily placed input samples
 //!! TODO: add some kind of oversampling to avoid aliasing
 void spectrum_resample_input(
     float *target, unsigned int target_num_values, float target_lambda_min, float target_lambda_max,
     const float *source, const float *lambda_source, unsigned int source_num_values);
 
-#if 0
 // create blackbody spectrum according to Planck's law
 void create_blackbody_spectrum(
     float *spectrum,
@@ -93,11 +115,13 @@ void create_blackbody_spectrum(
     float lambda_min,
     float lambda_max,
     float temperature); // [K]
-#endif
 
 /// The MDL blackbody function implementation.
 void mdl_blackbody(float sRGB[3], float kelvin);
 
+/// Batched variant of mdl_blackbody, sRGB receives num triples.
+void mdl_blackbody_batch(float *sRGB, const float *kelvin, unsigned int num);
+
 
 /// known color spaces
 enum Color_space_id {
@@ -115,6 +139,12 @@ void convert_XYZ_to_cs(float target[3], const float source[3], const Color_space
 void convert_cs_to_XYZ(float target[3], const float source[3], const Color_space_id source_id);
 float convert_cs_to_Y(const float source[3], const Color_space_id source_id);
 
+// batched variants of the conversions above for num consecutive triples (target may be source)
+void convert_XYZ_to_cs_batch(
+    float *target, const float *source, unsigned int num, const Color_space_id target_id);
+void convert_cs_to_XYZ_batch(
+    float *target, const float *source, unsigned int num, const Color_space_id source_id);
+
 // convert a reflectivity spectrum to a reflectivity color in a color space such that
 // the result is identical for direct illumination (assuming the white point of the color space as
 // illuminant)
@@ -137,6 +167,15 @@ void cs_refl_to_spectrum(
                                 // (sRGB-only, result lacks smoothness)
     bool ignore_scale = false); // don't do scaling such that the result is <= 1
 
+// batched variant of cs_refl_to_spectrum for num_colors color triples,
+// values receives num_colors consecutive spectra of SPECTRAL_XYZ_RES samples each
+void cs_refl_to_spectrum_batch(
+    float *values,
+    const float *colors,
+    unsigned int num_colors,
+    Color_space_id cs,
+    bool aggressive = false,
+    bool ignore_scale = false);
 
 
 
@@ -40,11 +40,52 @@
 #include <cstring>
 #include <cmath>
 #include <algorithm>
+#include <vector>
 
 namespace mi {
 namespace mdl {
 namespace spectral {
 
+// compute the two samples and the interpolation weight for a linear lookup
+static inline void get_lerp_pos(
+    unsigned int *const b0,
+    unsigned int *const b1,
+    float *const f1,
+    const unsigned int num_values,
+    const float lambda_min,
+    const float lambda_max,
+    const float lambda)
+{
+    const float f = (lambda - lambda_min) / (lambda_max - lambda_min) * (float)(num_values - 1);
+    unsigned int i0 = (unsigned int)(std::max(floorf(f), 0.0f));
+    if (i0 >= num_values)
+        i0 = num_values - 1;
+
+    *b0 = i0;
+    *b1 = (i0 == num_values - 1) ? i0 : i0 + 1;
+    *f1 = f - (float)i0;
+}
+
+// dot product using four independent partial sums: this breaks the serial dependency of the
+// accumulation, so the compiler can map the loop onto vector registers without relaxed
+// floating point semantics
+static inline float dot4(const float *const a, const float *const b, const unsigned int n)
+{
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i]     * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    float sum = (s0 + s1) + (s2 + s3);
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
 // get value from a spectrum using linear interpolation
 float get_value_lerp(
      const float * const table_values,
@@ -55,16 +96,62 @@ float get_value_lerp(
 {
     MDL_ASSERT(num_values > 1);
 
-    const float f = (lambda - lambda_min) / (lambda_max - lambda_min) * (float)(num_values - 1);
-    unsigned int b0 = (unsigned int)(std::max(floorf(f), 0.0f));
-    if (b0 >= num_values)
-        b0 = num_values - 1;
-    const unsigned int b1 = (b0 == num_values - 1) ? b0 : b0 + 1;
+    unsigned int b0, b1;
+    float f1;
+    get_lerp_pos(&b0, &b1, &f1, num_values, lambda_min, lambda_max, lambda);
 
-    const float f1 = f - (float)b0;
     return table_values[b0] * (1.0f - f1) + table_values[b1] * f1;
 }
 
+void get_values_lerp(
+     float * const values,
+     const float * const table_values,
+     const unsigned int num_values,
+     const float lambda_min,
+     const float lambda_max,
+     const float * const lambda,
+     const unsigned int num_lambda)
+{
+    MDL_ASSERT(num_values > 1);
+
+    for (unsigned int i = 0; i < num_lambda; ++i)
+    {
+        unsigned int b0, b1;
+        float f1;
+        get_lerp_pos(&b0, &b1, &f1, num_values, lambda_min, lambda_max, lambda[i]);
+
+        values[i] = table_values[b0] * (1.0f - f1) + table_values[b1] * f1;
+    }
+}
+
+// compute the linear map from a spectrum with the given sampling to XYZ, i.e. the color matching
+// functions folded onto the interpolation weights of the spectrum samples
+static void get_XYZ_weights(
+    float *const w_X, float *const w_Y, float *const w_Z,
+    const unsigned int num_values, const float lambda_min, const float lambda_max)
+{
+    memset(w_X, 0, num_values * sizeof(float));
+    memset(w_Y, 0, num_values * sizeof(float));
+    memset(w_Z, 0, num_values * sizeof(float));
+
+    for (unsigned int i = 0; i < SPECTRAL_XYZ_RES; ++i)
+    {
+        const float lambda = SPECTRAL_XYZ_LAMBDA_MIN + (float)i * SPECTRAL_XYZ_LAMBDA_STEP;
+
+        unsigned int b0, b1;
+        float f1;
+        get_lerp_pos(&b0, &b1, &f1, num_values, lambda_min, lambda_max, lambda);
+
+        const float f0 = 1.0f - f1;
+        w_X[b0] += SPECTRAL_XYZ1931_X[i] * f0;
+        w_X[b1] += SPECTRAL_XYZ1931_X[i] * f1;
+        w_Y[b0] += SPECTRAL_XYZ1931_Y[i] * f0;
+        w_Y[b1] += SPECTRAL_XYZ1931_Y[i] * f1;
+        w_Z[b0] += SPECTRAL_XYZ1931_Z[i] * f0;
+        w_Z[b1] += SPECTRAL_XYZ1931_Z[i] * f1;
+    }
+}
+
 
 
 void spectrum_to_XYZ(
@@ -91,6 +178,32 @@ void spectrum_to_XYZ(
     XYZ[2] *= scale;
 }
 
+void spectrum_to_XYZ_batch(
+    float *const XYZ, const float *const spectra, const unsigned int num_spectra,
+    const unsigned int num_values, const float lambda_min, const float lambda_max)
+{
+    MDL_ASSERT(num_values > 1);
+    if (num_spectra == 0)
+        return;
+
+    // the weights only depend on the sampling, so the per-spectrum work reduces to three
+    // dot products over contiguous memory
+    std::vector<float> weights(3 * num_values);
+    float *const w_X = &weights[0];
+    float *const w_Y = w_X + num_values;
+    float *const w_Z = w_Y + num_values;
+    get_XYZ_weights(w_X, w_Y, w_Z, num_values, lambda_min, lambda_max);
+
+    const float scale = (float)(683.002) * SPECTRAL_XYZ_LAMBDA_STEP;
+    for (unsigned int i = 0; i < num_spectra; ++i)
+    {
+        const float *const spectrum = spectra + size_t(i) * num_values;
+        XYZ[3 * i + 0] = dot4(w_X, spectrum, num_values) * scale;
+        XYZ[3 * i + 1] = dot4(w_Y, spectrum, num_values) * scale;
+        XYZ[3 * i + 2] = dot4(w_Z, spectrum, num_values) * scale;
+    }
+}
+
 float spectrum_to_Y(
     const float *spectrum, const unsigned int num_values, 
     const float lambda_min, const float lambda_max)
@@ -139,6 +252,37 @@ void spectrum_resample(
     }
 }
 
+void spectrum_resample_batch(
+    float *const target, const unsigned int target_num_values,
+    const float target_lambda_min, const float target_lambda_max,
+    const float *const source, const unsigned int source_num_values,
+    const float source_lambda_min, const float source_lambda_max,
+    const unsigned int num_spectra)
+{
+    MDL_ASSERT(target_num_values > 1);
+    MDL_ASSERT(source_num_values > 1);
+
+    // the lookup positions only depend on the sampling, compute them once per batch
+    std::vector<unsigned int> b0(target_num_values), b1(target_num_values);
+    std::vector<float> f1(target_num_values);
+    const float step = (target_lambda_max - target_lambda_min) / (float)(target_num_values - 1);
+    for (unsigned int i = 0; i < target_num_values; ++i)
+    {
+        const float lambda = target_lambda_min + (float)i * step;
+        get_lerp_pos(
+            &b0[i], &b1[i], &f1[i],
+            source_num_values, source_lambda_min, source_lambda_max, lambda);
+    }
+
+    for (unsigned int s = 0; s < num_spectra; ++s)
+    {
+        const float *const src = source + size_t(s) * source_num_values;
+        float *const dst = target + size_t(s) * target_num_values;
+        for (unsigned int i = 0; i < target_num_values; ++i)
+            dst[i] = src[b0[i]] * (1.0f - f1[i]) + src[b1[i]] * f1[i];
+    }
+}
+
 // helper for function below
 static float get_value_incremental(
     const float * const table_lambda,
@@ -180,9 +324,9 @@ void spectrum_resample_input(
     }
 }
 
-//  blackbody emitter, compute intensity at specific wavelength (in nm)
-//  and temperature (in Kelvin) using Planck's law 
-static float blackbody(const float lambda, const float temperature)
+//  blackbody emitter, compute the temperature independent factors of Planck's law at a specific
+//  wavelength (in nm), such that the intensity is f / (exp(e / temperature) - 1)
+static void blackbody_factors(float *const f, float *const e, const float lambda)
 {
     const float c = 2.9979e14f; // speed of light (um / s)
     const float h = 6.626e-22f; // Planck constant (scaled to um^2)
@@ -191,12 +335,40 @@ static float blackbody(const float lambda, const float temperature)
     // nm -> um
     const float x = lambda * 1e-3f;
 
-    const float f = 2.0f * h * c * c / (x * x * x * x * x);
+    *f = 2.0f * h * c * c / (x * x * x * x * x);
+    *e = h * c / (x * k);
+}
+
+//  blackbody emitter, compute intensity at specific wavelength (in nm)
+//  and temperature (in Kelvin) using Planck's law 
+static float blackbody(const float lambda, const float temperature)
+{
+    float f, e;
+    blackbody_factors(&f, &e, lambda);
 
-    return f / (expf(h * c / (x * k * temperature)) - 1.0f);
+    return f / (expf(e / temperature) - 1.0f);
+}
+
+// the factors of Planck's law at the sample positions of the color matching functions
+struct Blackbody_table
+{
+    float f[SPECTRAL_XYZ_RES];
+    float e[SPECTRAL_XYZ_RES];
+
+    Blackbody_table()
+    {
+        for (unsigned int i = 0; i < SPECTRAL_XYZ_RES; ++i)
+            blackbody_factors(
+                &f[i], &e[i], SPECTRAL_XYZ_LAMBDA_MIN + (float)i * SPECTRAL_XYZ_LAMBDA_STEP);
+    }
+};
+
+static const Blackbody_table &get_blackbody_table()
+{
+    static const Blackbody_table table;
+    return table;
 }
 
-#if 0
 void create_blackbody_spectrum(
     float * const spectrum,
     const unsigned int num_lambda,
@@ -213,7 +385,6 @@ void create_blackbody_spectrum(
 	spectrum[i] = blackbody(lambda, temperature);
     }
 }
-#endif
 
 static float const tf_xyz_to_srgb[] = {
      3.240600f, -1.537200f, -0.498600f,
@@ -290,7 +461,7 @@ const float *get_cs_to_XYZ(const Color_space_id cs)
 void convert_XYZ_to_cs(float target[3], const float source[3], const Color_space_id cs)
 {
     const float *const m = get_XYZ_to_cs(cs);
-    if (!cs)
+    if (!m)
     {
         target[0] = source[0];
         target[1] = source[1];
@@ -331,24 +502,61 @@ void convert_cs_to_XYZ(float target[3], const float source[3], const Color_space
 
 
 
-/// The MDL blackbody function implementation.
-void mdl_blackbody(float sRGB[3], float kelvin)
+// apply a color space transformation matrix to num consecutive triples
+static void convert_batch(
+    float *const target, const float *const source, const unsigned int num, const float *const m)
+{
+    if (!m)
+    {
+        if (target != source)
+            memmove(target, source, size_t(num) * 3 * sizeof(float));
+        return;
+    }
+
+    for (unsigned int i = 0; i < num; ++i)
+    {
+        const float s0 = source[3 * i + 0];
+        const float s1 = source[3 * i + 1];
+        const float s2 = source[3 * i + 2];
+        target[3 * i + 0] = s0 * m[0] + s1 * m[1] + s2 * m[2];
+        target[3 * i + 1] = s0 * m[3] + s1 * m[4] + s2 * m[5];
+        target[3 * i + 2] = s0 * m[6] + s1 * m[7] + s2 * m[8];
+    }
+}
+
+void convert_XYZ_to_cs_batch(
+    float *const target, const float *const source, const unsigned int num,
+    const Color_space_id cs)
+{
+    convert_batch(target, source, num, get_XYZ_to_cs(cs));
+}
+
+void convert_cs_to_XYZ_batch(
+    float *const target, const float *const source, const unsigned int num,
+    const Color_space_id cs)
+{
+    convert_batch(target, source, num, get_cs_to_XYZ(cs));
+}
+
+// blackbody color for a single temperature, using the tabulated factors of Planck's law
+// (note that the results differ from the former per-sample evaluation of Planck's law in the
+// last bits, since the factors are rounded separately and the products are summed in a
+// different order)
+static void blackbody_to_sRGB(float sRGB[3], float kelvin, const Blackbody_table &table)
 {
     const float threshold = 500.0f;
     if (kelvin < threshold)
         kelvin = threshold;
 
-    float XYZ[3] = {0.0f, 0.0f, 0.0f};
     // code currently operates on full resolution of our tabulated color matching functions
+    float values[SPECTRAL_XYZ_RES];
     for (unsigned int i = 0; i < SPECTRAL_XYZ_RES; ++i)
-    {
-        const float lambda = SPECTRAL_XYZ_LAMBDA_MIN + (float)i * SPECTRAL_XYZ_LAMBDA_STEP;
-        const float f = blackbody(lambda, kelvin);
+        values[i] = table.f[i] / (expf(table.e[i] / kelvin) - 1.0f);
 
-        XYZ[0] += SPECTRAL_XYZ1931_X[i] * f;
-        XYZ[1] += SPECTRAL_XYZ1931_Y[i] * f;
-        XYZ[2] += SPECTRAL_XYZ1931_Z[i] * f;
-    }
+    float XYZ[3];
+    XYZ[0] = dot4(SPECTRAL_XYZ1931_X, values, SPECTRAL_XYZ_RES);
+    XYZ[1] = dot4(SPECTRAL_XYZ1931_Y, values, SPECTRAL_XYZ_RES);
+    XYZ[2] = dot4(SPECTRAL_XYZ1931_Z, values, SPECTRAL_XYZ_RES);
 
     XYZ[0] /= XYZ[1];
     XYZ[2] /= XYZ[1];
@@ -361,6 +569,19 @@ void mdl_blackbody(float sRGB[3], float kelvin)
     sRGB[2] = std::max(sRGB[2], 0.0f);
 }
 
+/// The MDL blackbody function implementation.
+void mdl_blackbody(float sRGB[3], const float kelvin)
+{
+    blackbody_to_sRGB(sRGB, kelvin, get_blackbody_table());
+}
+
+void mdl_blackbody_batch(float *const sRGB, const float *const kelvin, const unsigned int num)
+{
+    const Blackbody_table &table = get_blackbody_table();
+    for (unsigned int i = 0; i < num; ++i)
+        blackbody_to_sRGB(sRGB + 3 * i, kelvin[i], table);
+}
+
 
 float convert_cs_to_Y(const float source[3], const Color_space_id cs)
 {
@@ -489,53 +710,88 @@ static void cs_refl_to_spectrum_smits(
 }
 
 
-void cs_refl_to_spectrum(
-    float values[SPECTRAL_XYZ_RES],
-    const float color[3],
-    const Color_space_id cs,
-    const bool aggressive,
-    const bool ignore_scale)
+// row stride of the re-laid-out chroma grid spectra, padded to a multiple of four floats
+static const unsigned int CHROMA_SPECTRUM_STRIDE = (SPECTRAL_XYZ_RES + 3) & ~3u;
+
+// a chromaticity grid with its spectra prepared for the color to spectrum conversion:
+// the interleaved maximum reflectivities are split off and the spectra are divided by the
+// spectrum of the white point once, so a conversion only blends contiguous rows
+struct Chroma_grid
 {
-    if (aggressive && (cs == CS_sRGB))
+    const Chroma_grid_info *info;
+    const Chroma_cell *cells;
+    float illum_cs; // illuminant in color space (is 'white' in that color space, so only scalar)
+    std::vector<float> max_refl;
+    std::vector<float> spectra;
+
+    Chroma_grid(
+        const Chroma_grid_info *const grid_info,
+        const Chroma_cell *const grid_cells,
+        const float *const grid_spectra,
+        const float grid_illum_cs)
+    : info(grid_info)
+    , cells(grid_cells)
+    , illum_cs(grid_illum_cs)
+    , max_refl(grid_info->num_spectra / (SPECTRAL_XYZ_RES + 1))
+    , spectra(max_refl.size() * CHROMA_SPECTRUM_STRIDE, 0.0f)
     {
-        cs_refl_to_spectrum_smits(values, color, cs);
-        return;
+        // note: num_spectra is the size of the spectral data array, including the maxima
+        const float *illum = &grid_spectra[info->white_idx * (SPECTRAL_XYZ_RES + 1) + 1];
+
+        for (unsigned int i = 0, n = unsigned(max_refl.size()); i < n; ++i)
+        {
+            const float *s = &grid_spectra[i * (SPECTRAL_XYZ_RES + 1) + 1];
+            float *const t = &spectra[size_t(i) * CHROMA_SPECTRUM_STRIDE];
+
+            max_refl[i] = s[-1];
+            for (unsigned int k = 0; k < SPECTRAL_XYZ_RES; ++k)
+                t[k] = s[k] / illum[k];
+        }
     }
+};
 
-    memset(values, 0, SPECTRAL_XYZ_RES * sizeof(float));
-
-    const Chroma_grid_info *chroma_grid_info;
-    const Chroma_cell *chroma_cells;
-    const float *chroma_spectra;
-    float illum_cs; // illuminant in color space (is 'white' in that color space, so only scalar)
+// get the (lazily prepared) chromaticity grid for the white point of a color space
+static const Chroma_grid &get_chroma_grid(const Color_space_id cs)
+{
     switch (cs)
     {
         default:
         case CS_XYZ:
-            chroma_grid_info = &chroma_grid_info_e;
-            chroma_cells = chroma_cells_e;
-            chroma_spectra = chroma_spectra_e;
-            illum_cs = (float)(1.0 / 3.0);
-            break;
+        {
+            static const Chroma_grid grid_e(
+                &chroma_grid_info_e, chroma_cells_e, chroma_spectra_e, (float)(1.0 / 3.0));
+            return grid_e;
+        }
         case CS_ACES:
-            chroma_grid_info = &chroma_grid_info_d60;
-            chroma_cells = chroma_cells_d60;
-            chroma_spectra = chroma_spectra_d60;
-            illum_cs = 0.337670f;
-            break;
+        {
+            static const Chroma_grid grid_d60(
+                &chroma_grid_info_d60, chroma_cells_d60, chroma_spectra_d60, 0.337670f);
+            return grid_d60;
+        }
         case CS_sRGB:
         case CS_Rec2020:
-            chroma_grid_info = &chroma_grid_info_d65;
-            chroma_cells = chroma_cells_d65;
-            chroma_spectra = chroma_spectra_d65;
-            illum_cs = 0.329000f;
-            break;
+        {
+            static const Chroma_grid grid_d65(
+                &chroma_grid_info_d65, chroma_cells_d65, chroma_spectra_d65, 0.329000f);
+            return grid_d65;
+        }
     }
+}
+
+// re-construct a reflectivity spectrum from a color using a prepared chromaticity grid
+static void cs_refl_to_spectrum_grid(
+    float values[SPECTRAL_XYZ_RES],
+    const float color[3],
+    const Color_space_id cs,
+    const Chroma_grid &grid,
+    const bool ignore_scale)
+{
+    memset(values, 0, SPECTRAL_XYZ_RES * sizeof(float));
 
     const float val_cs[3] = {
-        color[0] * illum_cs,
-        color[1] * illum_cs,
-        color[2] * illum_cs
+        color[0] * grid.illum_cs,
+        color[1] * grid.illum_cs,
+        color[2] * grid.illum_cs
     };
 
     float val_XYZ[3];
@@ -547,20 +803,19 @@ void cs_refl_to_spectrum(
 
     unsigned int idx[4];
     float w[4];
-    const unsigned int num = get_spectra(idx, w, x, y, chroma_grid_info, chroma_cells);
+    const unsigned int num = get_spectra(idx, w, x, y, grid.info, grid.cells);
     if (num == 0)
         return;
 
-    const float *illum = &chroma_spectra[chroma_grid_info->white_idx * (SPECTRAL_XYZ_RES + 1) + 1];
-
     float max_refl = 0.0f;
     for (unsigned int j = 0; j < num; ++j)
     {
-        const float *s = &chroma_spectra[idx[j] * (SPECTRAL_XYZ_RES + 1) + 1];
-        max_refl += w[j] * s[-1];
+        const float *s = &grid.spectra[size_t(idx[j]) * CHROMA_SPECTRUM_STRIDE];
+        const float wj = w[j];
+        max_refl += wj * grid.max_refl[idx[j]];
 
         for (unsigned int k = 0; k < SPECTRAL_XYZ_RES; ++k)
-            values[k] += w[j] * s[k] / illum[k];
+            values[k] += wj * s[k];
     }
 
     float scale = val_XYZ[1] / y;
@@ -579,6 +834,43 @@ void cs_refl_to_spectrum(
     }
 }
 
+void cs_refl_to_spectrum(
+    float values[SPECTRAL_XYZ_RES],
+    const float color[3],
+    const Color_space_id cs,
+    const bool aggressive,
+    const bool ignore_scale)
+{
+    if (aggressive && (cs == CS_sRGB))
+    {
+        cs_refl_to_spectrum_smits(values, color, cs);
+        return;
+    }
+
+    cs_refl_to_spectrum_grid(values, color, cs, get_chroma_grid(cs), ignore_scale);
+}
+
+void cs_refl_to_spectrum_batch(
+    float *const values,
+    const float *const colors,
+    const unsigned int num_colors,
+    const Color_space_id cs,
+    const bool aggressive,
+    const bool ignore_scale)
+{
+    if (aggressive && (cs == CS_sRGB))
+    {
+        for (unsigned int i = 0; i < num_colors; ++i)
+            cs_refl_to_spectrum_smits(values + size_t(i) * SPECTRAL_XYZ_RES, colors + 3 * i, cs);
+        return;
+    }
+
+    const Chroma_grid &grid = get_chroma_grid(cs);
+    for (unsigned int i = 0; i < num_colors; ++i)
+        cs_refl_to_spectrum_grid(
+            values + size_t(i) * SPECTRAL_XYZ_RES, colors + 3 * i, cs, grid, ignore_scale);
+}
+
 } // namespace mi
 } // namespace mdl
 } // namespace spectral
@@ -47,9 +47,15 @@
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <mi/base/handle.h>
+#include <mi/base/lock.h>
 #include <mi/mdl/mdl_generated_dag.h>
 #include <mi/mdl/mdl_code_generators.h>
 
@@ -57,8 +63,12 @@
 #include <string>
 #include <algorithm>
 #include <base/system/version/i_version.h>
+#include <base/hal/time/i_time.h>
 
 #include <mdl/compiler/compilercore/compilercore_mdl.h>
+#include <mdl/compiler/compilercore/compilercore_thread_context.h>
+#include <mdl/compiler/compilercore/compilercore_thread_pool.h>
+#include <mdl/compiler/compilercore/compilercore_tools.h>
 
 #include "search_path.h"
 #include "getopt.h"
@@ -88,10 +98,184 @@ using mi::mdl::IGenerated_code_executable;
 using mi::mdl::IOutput_stream;
 using mi::mdl::IInput_stream;
 using mi::mdl::IThread_context;
+using mi::mdl::IModule_cache;
+using mi::mdl::IModule_load_coordinator;
 
 
 using namespace std;
 
+/// A thread safe module cache shared by the concurrent compilations of one mdlc run.
+///
+/// Every loaded module is registered together with all its imports, so modules compiled later
+/// reuse already loaded imports. A module being compiled by one thread is marked as in flight,
+/// other threads needing it wait for the result instead of compiling it again.
+class Module_cache : public IModule_cache, public IModule_load_coordinator
+{
+public:
+    /// Constructor.
+    Module_cache()
+    : m_mutex()
+    , m_cond()
+    , m_modules()
+    , m_loading()
+    , m_waiting()
+    {
+    }
+
+    /// Lookup a module.
+    IModule const *lookup(char const *absname) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Module_map::const_iterator it(m_modules.find(absname));
+        if (it == m_modules.end())
+            return NULL;
+
+        IModule const *mod = it->second.get();
+        mod->retain();
+        return mod;
+    }
+
+    /// Called before a module not found in the cache is compiled.
+    bool begin_load(char const *absname)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        std::thread::id self = std::this_thread::get_id();
+
+        for (;;) {
+            if (m_modules.find(absname) != m_modules.end())
+                return false;
+
+            Loading_map::const_iterator it(m_loading.find(absname));
+            if (it == m_loading.end()) {
+                m_loading[absname] = self;
+                return true;
+            }
+            if (it->second == self || would_deadlock(absname, self)) {
+                // an import loop, compile it and let the compiler report the loop
+                return true;
+            }
+
+            m_waiting[self] = absname;
+            m_cond.wait(lock);
+            m_waiting.erase(self);
+
+            // if the other thread failed, the module is loaded here
+        }
+    }
+
+    /// Called after a compilation announced by begin_load() is finished.
+    void end_load(char const *absname, IModule const *mod)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (mod != NULL && mod->is_analyzed())
+            enter_locked(mod);
+
+        Loading_map::iterator it(m_loading.find(absname));
+        if (it != m_loading.end() && it->second == std::this_thread::get_id())
+            m_loading.erase(it);
+        m_cond.notify_all();
+    }
+
+    /// Register a loaded module and all its imports.
+    ///
+    /// \param mod  the module
+    void enter(IModule const *mod)
+    {
+        if (mod == NULL || !mod->is_analyzed())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        enter_locked(mod);
+    }
+
+private:
+    /// Register a module and its imports, the lock must be held.
+    void enter_locked(IModule const *mod)
+    {
+        bool inserted = m_modules.insert(
+            Module_map::value_type(
+                mod->get_name(),
+                mi::base::Handle<IModule const>(mod, mi::base::DUP_INTERFACE))).second;
+        if (!inserted)
+            return;
+
+        for (int i = 0, n = mod->get_import_count(); i < n; ++i) {
+            mi::base::Handle<IModule const> imp(mod->get_import(i));
+            if (imp.is_valid_interface())
+                enter_locked(imp.get());
+        }
+    }
+
+    /// Check if waiting for a module would close a cycle of threads waiting for each other,
+    /// the lock must be held.
+    ///
+    /// \param absname  the module to wait for
+    /// \param self     the waiting thread
+    bool would_deadlock(std::string absname, std::thread::id self) const
+    {
+        for (size_t i = 0, n = m_waiting.size(); i <= n; ++i) {
+            Loading_map::const_iterator l_it(m_loading.find(absname));
+            if (l_it == m_loading.end())
+                return false;
+            if (l_it->second == self)
+                return true;
+
+            Waiting_map::const_iterator w_it(m_waiting.find(l_it->second));
+            if (w_it == m_waiting.end())
+                return false;
+            absname = w_it->second;
+        }
+        return true;
+    }
+
+private:
+    typedef std::map<std::string, mi::base::Handle<IModule const> > Module_map;
+    typedef std::map<std::string, std::thread::id>                  Loading_map;
+    typedef std::map<std::thread::id, std::string>                  Waiting_map;
+
+    /// The mutex protecting all maps.
+    mutable std::mutex m_mutex;
+
+    /// Signals finished compilations.
+    std::condition_variable m_cond;
+
+    /// All known modules, indexed by their absolute name.
+    Module_map m_modules;
+
+    /// The modules in flight and the threads compiling them.
+    Loading_map m_loading;
+
+    /// The threads waiting for a module in flight.
+    Waiting_map m_waiting;
+};
+
+/// Write a string as a JSON string literal.
+///
+/// \param f  the output file
+/// \param s  the string
+static void write_json_string(FILE *f, char const *s)
+{
+    fputc('"', f);
+    for (; *s != '\0'; ++s) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+        case '"':  fputs("\\\"", f); break;
+        case '\\': fputs("\\\\", f); break;
+        case '\n': fputs("\\n", f); break;
+        case '\t': fputs("\\t", f); break;
+        default:
+            if (c < 0x20)
+                fprintf(f, "\\u%04x", c);
+            else
+                fputc(c, f);
+            break;
+        }
+    }
+    fputc('"', f);
+}
+
 /// Print messages to a printer.
 ///
 /// \param msgs     the messages
@@ -117,6 +301,9 @@ Mdlc::Mdlc(char const *program_name)
 , m_backend_options()
 , m_target_lang(TL_NONE)
 , m_input_modules()
+, m_jobs(1)
+, m_report_file()
+, m_output_lock()
 {
 }
 
@@ -161,6 +348,13 @@ void Mdlc::usage()
         "\tColor the output.\n"
         "  --check-lib <root>\n"
         "\tCheck a library stored at root.\n"
+        "  --jobs <n>\n"
+        "  -j <n>\n"
+        "\tCompile up to <n> modules concurrently (default 1). Imports shared\n"
+        "\tby several modules are compiled only once.\n"
+        "  --timing-report <file>\n"
+        "\tWrite the per-module load, DAG and backend times in JSON format\n"
+        "\tto <file>.\n"
         "  --target <target>\n"
         "  -t <target>\n"
         "\tSet target language.\n"
@@ -209,8 +403,10 @@ int Mdlc::run(int argc, char *argv[])
         /*11*/ { "backend",                mi::getopt::REQUIRED_ARGUMENT, NULL, 'B' },
         /*12*/ { "internal-space",         mi::getopt::REQUIRED_ARGUMENT, NULL, 0 },
         /*13*/ { "show-positions",         mi::getopt::NO_ARGUMENT,       NULL, 0 },
-        /*15*/ { "help",                   mi::getopt::NO_ARGUMENT,       NULL, '?' },
-        /*16*/ { NULL,                     0,                             NULL, 0 }
+        /*14*/ { "jobs",                   mi::getopt::REQUIRED_ARGUMENT, NULL, 'j' },
+        /*15*/ { "timing-report",          mi::getopt::REQUIRED_ARGUMENT, NULL, 0 },
+        /*16*/ { "help",                   mi::getopt::NO_ARGUMENT,       NULL, '?' },
+        /*17*/ { NULL,                     0,                             NULL, 0 }
     };
 
     bool opt_error = false;
@@ -226,7 +422,7 @@ int Mdlc::run(int argc, char *argv[])
 
 
     while (
-        (c = mi::getopt::getopt_long(argc, argv, "O:W:Vvp:Ct:d:B:?", long_options, &longidx)) != -1
+        (c = mi::getopt::getopt_long(argc, argv, "O:W:Vvp:Ct:d:B:j:?", long_options, &longidx)) != -1
     ) {
         switch (c) {
         case 'O':
@@ -325,6 +521,22 @@ int Mdlc::run(int argc, char *argv[])
         case 'B':
             m_backend_options.push_back(mi::getopt::optarg);
             break;
+        case 'j':
+            {
+                unsigned jobs = 0;
+                char     dummy;
+                if (sscanf(mi::getopt::optarg, "%u%c", &jobs, &dummy) != 1 || jobs == 0) {
+                    fprintf(
+                        stderr,
+                        "%s error: invalid number of jobs '%s'\n",
+                        argv[0],
+                        mi::getopt::optarg);
+                    opt_error = true;
+                } else {
+                    m_jobs = jobs;
+                }
+            }
+            break;
         case '?':
             usage();
             return EXIT_SUCCESS;
@@ -359,6 +571,9 @@ int Mdlc::run(int argc, char *argv[])
             case 13:
                 m_show_positions = true;
                 break;
+            case 15:
+                m_report_file = mi::getopt::optarg;
+                break;
             default:
                 fprintf(
                     stderr,
@@ -414,31 +629,43 @@ int Mdlc::run(int argc, char *argv[])
         m_input_modules.push_back(argv[i]);
     }
 
+    Module_stats_vector stats;
+    stats.reserve(m_input_modules.size());
     for (String_list::const_iterator it(m_input_modules.begin()), end(m_input_modules.end());
          it != end;
          ++it)
     {
-        std::string const &input_module = *it;
-
-        unsigned errors = 0;
-        mi::base::Handle<IModule const> module;
+        stats.push_back(Module_stats(*it));
+    }
 
-        if (is_binary(input_module.c_str())) {
-            module = mi::base::make_handle(load_binary(input_module.c_str(), errors));
-        } else {
-            module = mi::base::make_handle(compile(input_module.c_str(), errors));
-        }
-        if (!module.is_valid_interface())
-            return EXIT_FAILURE;
-        err_count += errors;
-
-        if (m_check_root.empty()) {
-            // compile
-            if (!backend(module.get()))
-                return EXIT_FAILURE;
+    if (m_jobs > 1 && stats.size() > 1) {
+        process_modules_parallel(stats);
+    } else {
+        for (size_t i = 0, n = stats.size(); i < n; ++i) {
+            process_module(stats[i], /*cache=*/NULL);
+            if (stats[i].m_failed)
+                break;
         }
     }
 
+    bool failed = false;
+    for (size_t i = 0, n = stats.size(); i < n; ++i) {
+        err_count += stats[i].m_errors;
+        failed = failed || stats[i].m_failed;
+    }
+
+    if (!m_report_file.empty() && !write_report(stats)) {
+        fprintf(
+            stderr,
+            "%s error: could not write timing report '%s'\n",
+            m_program,
+            m_report_file.c_str());
+        failed = true;
+    }
+
+    if (failed)
+        return EXIT_FAILURE;
+
     if (!m_check_root.empty()) {
         if (err_count > 0) {
             fprintf(
@@ -458,11 +685,119 @@ int Mdlc::run(int argc, char *argv[])
     return err_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+// Process one input module: load it and run the selected backend.
+void Mdlc::process_module(Module_stats &stats, Module_cache *cache)
+{
+    char const *input_module = stats.m_name.c_str();
+
+    unsigned errors = 0;
+    mi::base::Handle<IModule const> module;
+
+    if (is_binary(input_module)) {
+        module = mi::base::make_handle(load_binary(input_module, errors));
+    } else {
+        module = mi::base::make_handle(compile(input_module, errors, cache, &stats));
+    }
+    if (!module.is_valid_interface()) {
+        stats.m_failed = true;
+        return;
+    }
+    stats.m_errors = errors;
+
+    // in library check mode, the target code is only generated if explicitly requested
+    if (m_check_root.empty() || m_target_lang != TL_NONE) {
+        // compile
+        if (!backend(module.get(), &stats))
+            stats.m_failed = true;
+    }
+}
+
+// Process all input modules using the given number of worker threads.
+void Mdlc::process_modules_parallel(Module_stats_vector &stats)
+{
+    Module_cache      cache;
+    std::atomic<bool> failed(false);
+
+    // like the sequential mode, no new module is started after a serious error
+    mi::mdl::Thread_pool::get()->parallel_for(
+        stats.size(), m_jobs, [this, &stats, &cache, &failed](size_t idx) {
+            if (failed)
+                return;
+            process_module(stats[idx], &cache);
+            if (stats[idx].m_failed)
+                failed = true;
+        });
+}
+
+// Write the per-module timing report in JSON format.
+bool Mdlc::write_report(Module_stats_vector const &stats) const
+{
+    FILE *f = fopen(m_report_file.c_str(), "w");
+    if (f == NULL)
+        return false;
+
+    double total_load = 0.0, total_dag = 0.0, total_backend = 0.0;
+
+    fprintf(f, "{\n  \"library\": ");
+    write_json_string(f, m_check_root.c_str());
+    fprintf(f, ",\n  \"jobs\": %u,\n  \"modules\": [", m_jobs);
+
+    for (size_t i = 0, n = stats.size(); i < n; ++i) {
+        Module_stats const &s = stats[i];
+
+        fprintf(f, "%s\n    { \"name\": ", i == 0 ? "" : ",");
+        write_json_string(f, s.m_name.c_str());
+        fprintf(
+            f,
+            ", \"errors\": %u, \"failed\": %s, \"load\": %.6f"
+            ", \"dag\": %.6f, \"backend\": %.6f }",
+            s.m_errors,
+            s.m_failed ? "true" : "false",
+            s.m_load_time,
+            s.m_dag_time,
+            s.m_backend_time);
+
+        total_load    += s.m_load_time;
+        total_dag     += s.m_dag_time;
+        total_backend += s.m_backend_time;
+    }
+
+    fprintf(
+        f,
+        "\n  ],\n  \"total\": { \"load\": %.6f"
+        ", \"dag\": %.6f, \"backend\": %.6f }\n}\n",
+        total_load,
+        total_dag,
+        total_backend);
+
+    bool res = ferror(f) == 0;
+    return fclose(f) == 0 && res;
+}
+
 // Compile one module.
-IModule const *Mdlc::compile(char const *module_name, unsigned &errors)
+IModule const *Mdlc::compile(
+    char const   *module_name,
+    unsigned     &errors,
+    Module_cache *cache,
+    Module_stats *stats)
 {
     mi::base::Handle<IThread_context> ctx(m_imdl->create_thread_context());
-    IModule const *module = m_imdl->load_module(ctx.get(), module_name, /*cache=*/NULL);
+    if (cache != NULL) {
+        mi::mdl::Thread_context *tctx = mi::mdl::impl_cast<mi::mdl::Thread_context>(ctx.get());
+        tctx->set_module_load_coordinator(cache);
+    }
+
+    MI::TIME::Stopwatch load_watch;
+    load_watch.start();
+    IModule const *module = m_imdl->load_module(ctx.get(), module_name, cache);
+    load_watch.stop();
+
+    if (stats != NULL)
+        stats->m_load_time = load_watch.elapsed();
+    if (cache != NULL)
+        cache->enter(module);
+
+    mi::base::Lock::Block block(&m_output_lock);
 
     mi::base::Handle<IOutput_stream> os_stderr(m_imdl->create_std_stream(IMDL::OS_STDERR));
     mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stderr.get()));
@@ -509,18 +844,26 @@ void Mdlc::apply_backend_options(mi::mdl::Options &opts)
 
 
 // Compile a module to a target language.
-bool Mdlc::backend(IModule const *module)
+bool Mdlc::backend(IModule const *module, Module_stats *stats)
 {
     mi::base::Handle<IOutput_stream> os_stderr(m_imdl->create_std_stream(IMDL::OS_STDERR));
     mi::base::Handle<IPrinter> printer(m_imdl->create_printer(os_stderr.get()));
 
     printer->enable_color(m_syntax_coloring);
 
+    MI::TIME::Stopwatch backend_watch;
+
     switch (m_target_lang) {
     case TL_NONE:
         break;
     case TL_MDL:
-        print_generated_code(module);
+        {
+            mi::base::Lock::Block block(&m_output_lock);
+
+            backend_watch.start();
+            print_generated_code(module);
+            backend_watch.stop();
+        }
         break;
     case TL_DAG:
         if (module->is_valid()) {
@@ -549,7 +892,16 @@ bool Mdlc::backend(IModule const *module)
 
             apply_backend_options(dag_opts);
 
+            MI::TIME::Stopwatch dag_watch;
+            dag_watch.start();
             mi::base::Handle<IGenerated_code_dag> dag(generator->compile(module));
+            dag_watch.stop();
+
+            if (stats != NULL)
+                stats->m_dag_time = dag_watch.elapsed();
+
+            mi::base::Lock::Block block(&m_output_lock);
+
             if (!dag.is_valid_interface()) {
                 fprintf(stderr, "%s error: failed to generate dag code for module %s\n",
                                 m_program, module->get_name());
@@ -565,7 +917,9 @@ bool Mdlc::backend(IModule const *module)
                                 m_program, err_count, module->get_name());
                 return false;
             } else {
+                backend_watch.start();
                 print_generated_code(dag.get());
+                backend_watch.stop();
             }
         }
         break;
@@ -577,16 +931,22 @@ bool Mdlc::backend(IModule const *module)
         break;
     case TL_BIN:
         if (module->is_valid()) {
+            mi::base::Lock::Block block(&m_output_lock);
+
+            backend_watch.start();
             mi::base::Handle<IOutput_stream> os(m_imdl->create_file_output_stream("output.bin"));
             mi::mdl::Stream_serializer stream_serializer(os.get());
 
             if (os.is_valid_interface()) {
                 m_imdl->serialize_module(module, &stream_serializer, true);
             }
+            backend_watch.stop();
         }
         break;
     }
 
+    if (stats != NULL)
+        stats->m_backend_time = backend_watch.elapsed();
     return true;
 }
 
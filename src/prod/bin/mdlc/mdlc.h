@@ -30,9 +30,11 @@
 #define _MDLC_ 1
 
 #include <mi/base/handle.h>
+#include <mi/base/lock.h>
 
 #include <string>
 #include <list>
+#include <vector>
 
 namespace mi {
     namespace mdl {
@@ -44,6 +46,8 @@ namespace mi {
     }
 }
 
+class Module_cache;
+
 /// The MDL command line compiler application.
 class Mdlc
 {
@@ -79,24 +83,72 @@ public:
     int run(int argc, char *argv[]);
 
 private:
+    /// Compilation statistics of one input module.
+    struct Module_stats {
+        /// Constructor.
+        explicit Module_stats(std::string const &name)
+        : m_name(name)
+        , m_errors(0)
+        , m_failed(false)
+        , m_load_time(0.0)
+        , m_dag_time(0.0)
+        , m_backend_time(0.0)
+        {
+        }
+
+        std::string m_name;          ///< The name of the module.
+        unsigned    m_errors;        ///< The number of errors detected.
+        bool        m_failed;        ///< True, if a serious error occurred.
+        double      m_load_time;     ///< Time spent loading the module and its imports.
+        double      m_dag_time;      ///< Time spent generating the DAG.
+        double      m_backend_time;  ///< Time spent emitting the target code.
+    };
+
+    typedef std::vector<Module_stats> Module_stats_vector;
+
     /// Prints usage.
     void usage();
 
     /// Compile one module.
     /// \param      module_name     The name of the module to compile.
     /// \param      errors          The number of errors detected during compilation.
+    /// \param      cache           If non-NULL, a module cache shared between compilations.
+    /// \param      stats           If non-NULL, receives the load time.
     /// \returns                    NULL: Some serious error occurred and no modules was created.
     ///                             The created module.
-    mi::mdl::IModule const *compile(char const *module_name, unsigned &errors);
+    mi::mdl::IModule const *compile(
+        char const   *module_name,
+        unsigned     &errors,
+        Module_cache *cache = NULL,
+        Module_stats *stats = NULL);
+
+    /// Process one input module: load it and run the selected backend.
+    ///
+    /// \param stats  the statistics of the module, its name selects the module
+    /// \param cache  if non-NULL, a module cache shared between compilations
+    void process_module(Module_stats &stats, Module_cache *cache);
+
+    /// Process all input modules using the given number of worker threads.
+    ///
+    /// \param stats  the statistics of all input modules
+    void process_modules_parallel(Module_stats_vector &stats);
+
+    /// Write the per-module timing report in JSON format.
+    ///
+    /// \param stats  the statistics of all processed modules
+    ///
+    /// \returns false if the report file could not be written
+    bool write_report(Module_stats_vector const &stats) const;
 
     // Apply backend options.
     void apply_backend_options(mi::mdl::Options &opts);
 
     /// Compile a module to a target language.
     /// \param      module          The module to compile.
+    /// \param      stats           If non-NULL, receives the DAG and backend times.
     /// \returns                    false: Some serious error occurred.
     ///                             true: compiled to target
-    bool backend(mi::mdl::IModule const *module);
+    bool backend(mi::mdl::IModule const *module, Module_stats *stats = NULL);
 
     /// Check if the given filename exists and if it represents a binary,
     ///
@@ -156,6 +208,15 @@ private:
     /// The list of modules to compile.
     String_list m_input_modules;
 
+    /// The number of worker threads used to compile the input modules.
+    unsigned m_jobs;
+
+    /// If non empty, the name of the timing report file.
+    std::string m_report_file;
+
+    /// Serializes the output of concurrently compiled modules.
+    mi::base::Lock m_output_lock;
+
 };
 
 #endif
@@ -31,6 +31,7 @@
 #include <cstring>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <mi/base/handle.h>
 #include <mi/base/types.h>
@@ -54,6 +55,7 @@
 #include <mdl/codegenerators/generator_dag/generator_dag_tools.h>
 #include <mdl/codegenerators/generator_dag/generator_dag_dumper.h>
 #include <mdl/compiler/compilercore/compilercore_streams.h>
+#include <mdl/compiler/compilercore/compilercore_thread_pool.h>
 
 #include "backends_link_unit.h"
 #include "backends_backends.h"
@@ -1639,6 +1641,31 @@ mi::Sint32 Target_value_layout::set_value(
 
 // ------------------------- LLVM based link unit -------------------------
 
+/// Optimize a set of independent lambda functions.
+///
+/// Every lambda owns its node factory, hence different lambdas can be optimized concurrently.
+/// This is the only parallel step of a link unit: all functions of a unit are generated
+/// incrementally into one LLVM module of one LLVMContext, which is not thread safe, and they
+/// share the resource tables, the string constant table and the instantiated DF functions.
+///
+/// \param transaction  the current transaction
+/// \param lambdas      the lambda functions to optimize
+/// \param n_threads    the maximum number of threads to use
+static void optimize_lambdas(
+    DB::Transaction                                *transaction,
+    std::vector<mi::mdl::ILambda_function *> const &lambdas,
+    unsigned                                       n_threads)
+{
+    mi::mdl::Thread_pool::get()->parallel_for(
+        lambdas.size(), n_threads, [transaction, &lambdas](size_t idx) {
+            // resolver and evaluator are cheap
+            MDL::Mdl_call_resolver resolver(transaction);
+            MDL::Call_evaluator    call_evaluator(transaction);
+
+            lambdas[idx]->optimize(&resolver, &call_evaluator);
+        });
+}
+
 static mi::mdl::ILink_unit *create_link_unit(Mdl_llvm_backend &llvm_be)
 {
     mi::base::Handle<mi::mdl::ICode_generator_jit> be = llvm_be.get_jit_be();
@@ -1690,6 +1717,7 @@ Link_unit::Link_unit(
 , m_compile_consts(llvm_be.get_compile_consts())
 , m_strings_mapped_to_ids(llvm_be.get_strings_mapped_to_ids())
 , m_calc_derivatives(llvm_be.get_calc_derivatives())
+, m_num_translation_threads(llvm_be.get_num_translation_threads())
 {
 }
 
@@ -1836,6 +1864,16 @@ mi::Sint32 Link_unit::add_material(
     // increment once for each add_material invocation
     m_gen_base_name_suffix_counter++;
 
+    // Translation happens in three steps:
+    //  1. build the lambda (or distribution function) for every description and enumerate its
+    //     resources, this must be sequential to get deterministic resource indices
+    //  2. optimize all expression lambdas, these are independent and run concurrently
+    //  3. add all functions in order to the link unit, which generates the LLVM IR into the
+    //     single module of the unit
+    std::vector<mi::base::Handle<mi::mdl::IDistribution_function> > dist_funcs(
+        description_count);
+    std::vector<mi::base::Handle<mi::mdl::ILambda_function> > lambdas(description_count);
+
     for (mi::Size i = 0; i < description_count; ++i)
     {
         if (function_descriptions[i].path == NULL)
@@ -1973,36 +2011,7 @@ mi::Sint32 Link_unit::add_material(
                     lambda->enumerate_resources(enumerator, lambda->get_body());
                 }
 
-                MDL::Mdl_call_resolver resolver(m_transaction);
-
-                // ... optimize all expression lambdas
-                // (for derivatives, optimization already happened while building derivative info,
-                // and doing it again may destroy the analysis result)
-                if (!m_calc_derivatives) {
-                    MDL::Call_evaluator    call_evaluator(m_transaction);
-                    for (size_t i = 0, n = dist_func->get_expr_lambda_count(); i < n; ++i)
-                    {
-                        mi::base::Handle<mi::mdl::ILambda_function> lambda(
-                            dist_func->get_expr_lambda(i));
-                        lambda->optimize(&resolver, &call_evaluator);
-                    }
-                }
-
-                // ... and add it to the compilation unit
-                if (!m_unit->add(
-                    dist_func.get(),
-                    &resolver,
-                    &arg_block_index,
-                    &function_descriptions[i].function_index))
-                {
-                    MDL::report_messages(m_unit->access_messages(), context);
-                    function_descriptions[i].return_code = 
-                        add_error_message(context, 
-                            "The JIT backend failed to compile the function at index " 
-                            + std::to_string(i) + ".", -300);
-                    return -1;
-                }
-
+                dist_funcs[i] = dist_func;
                 break;
             }
 
@@ -2041,27 +2050,72 @@ mi::Sint32 Link_unit::add_material(
                 // set further infos that are passed back
                 function_descriptions[i].distribution_kind = mi::mdl::ILink_unit::DK_NONE;
 
-                // ... and add it to the compilation unit
-                if (!m_unit->add(
-                    lambda.get(),
-                    &resolver,
-                    mi::mdl::ILink_unit::FK_LAMBDA,
-                    &arg_block_index,
-                    &function_descriptions[i].function_index))
-                {
-                    MDL::report_messages(m_unit->access_messages(), context);
-                    function_descriptions[i].return_code =
-                        add_error_message(
-                            context, "The JIT backend failed to compile the function at index" + 
-                            std::to_string(i), -30);
-                    return -1;
-                }
+                lambdas[i] = lambda;
                 break;
             }
 
         }
     }
 
+    // ... optimize all expression lambdas
+    // (for derivatives, optimization already happened while building derivative info,
+    // and doing it again may destroy the analysis result)
+    if (!m_calc_derivatives) {
+        std::vector<mi::mdl::ILambda_function *> expr_lambdas;
+        for (mi::Size i = 0; i < description_count; ++i) {
+            if (!dist_funcs[i].is_valid_interface())
+                continue;
+            for (size_t j = 0, n = dist_funcs[i]->get_expr_lambda_count(); j < n; ++j) {
+                mi::base::Handle<mi::mdl::ILambda_function> lambda(
+                    dist_funcs[i]->get_expr_lambda(j));
+
+                // the distribution function keeps the lambda alive
+                expr_lambdas.push_back(lambda.get());
+            }
+        }
+        optimize_lambdas(m_transaction, expr_lambdas, m_num_translation_threads);
+    }
+
+    // ... and add them to the compilation unit
+    for (mi::Size i = 0; i < description_count; ++i)
+    {
+        MDL::Mdl_call_resolver resolver(m_transaction);
+
+        if (dist_funcs[i].is_valid_interface())
+        {
+            if (!m_unit->add(
+                dist_funcs[i].get(),
+                &resolver,
+                &arg_block_index,
+                &function_descriptions[i].function_index))
+            {
+                MDL::report_messages(m_unit->access_messages(), context);
+                function_descriptions[i].return_code = 
+                    add_error_message(context, 
+                        "The JIT backend failed to compile the function at index " 
+                        + std::to_string(i) + ".", -300);
+                return -1;
+            }
+        }
+        else if (lambdas[i].is_valid_interface())
+        {
+            if (!m_unit->add(
+                lambdas[i].get(),
+                &resolver,
+                mi::mdl::ILink_unit::FK_LAMBDA,
+                &arg_block_index,
+                &function_descriptions[i].function_index))
+            {
+                MDL::report_messages(m_unit->access_messages(), context);
+                function_descriptions[i].return_code =
+                    add_error_message(
+                        context, "The JIT backend failed to compile the function at index" + 
+                        std::to_string(i), -30);
+                return -1;
+            }
+        }
+    }
+
     // Was a target argument block layout created for this entity?
     if (arg_block_index != size_t(~0))
     {
@@ -2075,6 +2129,7 @@ mi::Sint32 Link_unit::add_material(
 
         m_arg_block_comp_material_args.push_back(
             mi::base::make_handle(compiled_material->get_arguments()));
+        m_arg_block_comp_material_hashes.push_back(compiled_material->get_hash());
         ASSERT(M_BACKENDS, index == m_arg_block_comp_material_args.size() - 1 &&
                "Unit and arg block material arg list should be in sync");
 
@@ -2169,7 +2224,8 @@ Mdl_llvm_backend::Mdl_llvm_backend(
     m_output_ptx(true),
     m_strings_mapped_to_ids(string_ids),
     m_calc_derivatives(false),
-    m_use_builtin_resource_handler(true)
+    m_use_builtin_resource_handler(true),
+    m_num_translation_threads(1)
 {
     mi::mdl::Options &options = m_jit->access_options();
 
@@ -2308,6 +2364,52 @@ mi::Sint32 Mdl_llvm_backend::set_option(
         return 0;
     }
 
+    if (strcmp(name, "optimization_pipeline") == 0) {
+        if (m_kind == mi::neuraylib::IMdl_compiler::MB_GLSL)
+            return -1;
+        if (strcmp(value, "default") == 0 ||
+                strcmp(value, "preview") == 0 ||
+                strcmp(value, "final") == 0) {
+            jit_options.set_option(MDL_JIT_OPTION_OPT_PIPELINE, value);
+            return 0;
+        }
+        return -2;
+    }
+    if (strcmp(name, "collect_timing") == 0) {
+        if (m_kind == mi::neuraylib::IMdl_compiler::MB_GLSL)
+            return -1;
+        if (strcmp(value, "off") == 0) {
+            value = "false";
+        } else if (strcmp(value, "on") == 0) {
+            value = "true";
+        } else {
+            return -2;
+        }
+        jit_options.set_option(MDL_JIT_OPTION_COLLECT_TIMING, value);
+        return 0;
+    }
+    if (strcmp(name, "df_lambda_profile") == 0) {
+        if (m_kind == mi::neuraylib::IMdl_compiler::MB_GLSL)
+            return -1;
+        if (strcmp(value, "off") != 0 &&
+                strcmp(value, "use") != 0 &&
+                (strcmp(value, "record") != 0 ||
+                    m_kind != mi::neuraylib::IMdl_compiler::MB_NATIVE)) {
+            return -2;
+        }
+        jit_options.set_option(MDL_JIT_OPTION_DF_LAMBDA_PROFILE, value);
+        return 0;
+    }
+
+    if (strcmp(name, "num_translation_threads") == 0) {
+        unsigned v = 0;
+        if (sscanf(value, "%u", &v) != 1 || v == 0) {
+            return -2;
+        }
+        m_num_translation_threads = v;
+        return 0;
+    }
+
     if (strcmp(name, "texture_runtime_with_derivs") == 0) {
         if (m_kind == mi::neuraylib::IMdl_compiler::MB_GLSL)
             return -1;
@@ -2667,7 +2769,7 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
     mi::Size arg_block_index = ~0;
     if (compiled_material->get_parameter_count() != 0) {
         mi::base::Handle<const MI::MDL::IValue_list> args(compiled_material->get_arguments());
-        tc->init_argument_block(0, transaction, args.get());
+        tc->init_argument_block(0, transaction, args.get(), compiled_material->get_hash());
         arg_block_index = 0;
     }
 
@@ -2823,7 +2925,7 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
     mi::Size arg_block_index = ~0;
     if (compiled_material->get_parameter_count() != 0) {
         mi::base::Handle<const MI::MDL::IValue_list> args(compiled_material->get_arguments());
-        tc->init_argument_block(0, transaction, args.get());
+        tc->init_argument_block(0, transaction, args.get(), compiled_material->get_hash());
         arg_block_index = 0;
     }
 
@@ -2996,7 +3098,7 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_material_expressi
     mi::Size arg_block_index = ~0;
     if (compiled_material->get_parameter_count() != 0) {
         mi::base::Handle<const MI::MDL::IValue_list> args(compiled_material->get_arguments());
-        tc->init_argument_block(0, transaction, args.get());
+        tc->init_argument_block(0, transaction, args.get(), compiled_material->get_hash());
         arg_block_index = 0;
     }
 
@@ -3131,7 +3233,7 @@ const mi::neuraylib::ITarget_code* Mdl_llvm_backend::translate_material_df(
     mi::Size arg_block_index = ~0;
     if (compiled_material->get_parameter_count() != 0) {
         mi::base::Handle<const MI::MDL::IValue_list> args(compiled_material->get_arguments());
-        tc->init_argument_block(0, transaction, args.get());
+        tc->init_argument_block(0, transaction, args.get(), compiled_material->get_hash());
         arg_block_index = 0;
     }
 
@@ -3247,12 +3349,14 @@ mi::neuraylib::ITarget_code const *Mdl_llvm_backend::translate_link_unit(
     {
         std::vector<mi::base::Handle<MDL::IValue_list const> > const &args =
             lu->get_arg_block_comp_material_args();
+        std::vector<mi::base::Uuid> const &hashes = lu->get_arg_block_comp_material_hashes();
         DB::Transaction *trans = lu->get_transaction();
         for (size_t i = 0, n_args = args.size(); i < n_args; ++i) {
             tc->init_argument_block(
                 i,
                 trans,
-                args[i].get());
+                args[i].get(),
+                hashes[i]);
         }
     }
 
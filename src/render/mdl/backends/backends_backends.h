@@ -176,6 +176,9 @@ public:
     /// If true, derivatives should be calculated.
     bool get_calc_derivatives() const { return m_calc_derivatives; }
 
+    /// Get the maximum number of threads used to prepare the functions of a link unit.
+    unsigned get_num_translation_threads() const { return m_num_translation_threads; }
+
     /// Add a function to the given target code, also registering the function prototypes
     /// applicable for the used backend.
     ///
@@ -230,6 +233,10 @@ private:
 
     /// If true, use the builtin resource handler when running native code
     bool m_use_builtin_resource_handler;
+
+    /// The maximum number of threads used to optimize the expression lambdas of the distribution
+    /// functions of a link unit.
+    unsigned m_num_translation_threads;
 };
 
 
@@ -236,6 +236,10 @@ public:
     std::vector<mi::base::Handle<MDL::IValue_list const> > const &
         get_arg_block_comp_material_args() const { return m_arg_block_comp_material_args; }
 
+    /// Get the hashes of the compiled materials for the target argument blocks.
+    std::vector<mi::base::Uuid> const &
+        get_arg_block_comp_material_hashes() const { return m_arg_block_comp_material_hashes; }
+
     /// Get the internal space used in this link unit
     const char* get_internal_space() const {
         return m_internal_space.c_str();
@@ -286,10 +290,17 @@ private:
     /// If true, derivatives should be calculated.
     bool m_calc_derivatives;
 
+    /// The maximum number of threads used to optimize the expression lambdas of the materials
+    /// added to this unit.
+    unsigned m_num_translation_threads;
+
     /// The arguments of the compiled materials for which target argument blocks should be
     /// created.
     std::vector<mi::base::Handle<MDL::IValue_list const> > m_arg_block_comp_material_args;
 
+    /// The hashes of the compiled materials for which target argument blocks should be created.
+    std::vector<mi::base::Uuid> m_arg_block_comp_material_hashes;
+
     std::string m_internal_space;
 };
 
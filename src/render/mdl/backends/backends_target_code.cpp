@@ -123,15 +123,18 @@ Target_code::Target_code(
     m_data(),
     m_cap_arg_layouts(),
     m_cap_arg_blocks(),
+    m_cap_arg_material_hashes(),
     m_rh( NULL),
     m_render_state_usage(~0u),
     m_string_args_mapped_to_ids(string_ids),
-    m_use_builtin_resource_handler(use_builtin_resource_handler)
+    m_use_builtin_resource_handler(use_builtin_resource_handler),
+    m_use_derivatives(use_derivatives)
 {
     finalize(code, transaction, use_derivatives);
 
     size_t num_layouts = code->get_captured_argument_layouts_count();
     m_cap_arg_blocks.resize(num_layouts);   // already prepare the empty argument block slots
+    m_cap_arg_material_hashes.resize(num_layouts);
 
     for (size_t i = 0; i < num_layouts; ++i) {
         mi::base::Handle<mi::mdl::IGenerated_code_value_layout const> layout(
@@ -160,10 +163,12 @@ Target_code::Target_code(
     m_data(),
     m_cap_arg_layouts(),
     m_cap_arg_blocks(),
+    m_cap_arg_material_hashes(),
     m_rh( NULL),
     m_render_state_usage( ~0u),
     m_string_args_mapped_to_ids(string_ids),
-    m_use_builtin_resource_handler(true)
+    m_use_builtin_resource_handler(true),
+    m_use_derivatives(false)
 {
 }
 
@@ -190,6 +195,8 @@ void Target_code::finalize(
     m_native_code = mi::base::make_handle(
         code->get_interface<mi::mdl::IGenerated_code_lambda_function>());
     m_render_state_usage = code->get_state_usage();
+    m_timing_report = code->get_timing_report();
+    m_use_derivatives = use_derivatives;
 
     if (m_native_code.is_valid_interface()) {
         if(m_use_builtin_resource_handler)
@@ -359,6 +366,24 @@ const char* Target_code::get_ro_data_segment_data( mi::Size index) const
 }
 
 
+// get the captured arguments data for a callable function
+const char *Target_code::get_cap_args_data(
+    mi::Size index,
+    const mi::neuraylib::ITarget_argument_block *cap_args) const
+{
+    if (cap_args != NULL)
+        return cap_args->get_data();
+
+    mi::Size block_index = get_callable_function_argument_block_index(index);
+    if (block_index != mi::Size(~0) &&
+        block_index < m_cap_arg_blocks.size() &&
+        m_cap_arg_blocks[block_index])
+    {
+        return m_cap_arg_blocks[block_index]->get_data();
+    }
+    return NULL;
+}
+
 // reduce redundant code be wrapping bsdf, edf, ... calls
 mi::Sint32 Target_code::execute_df_init_function(
     mi::neuraylib::ITarget_code::Distribution_kind dist_kind,
@@ -373,19 +398,7 @@ mi::Sint32 Target_code::execute_df_init_function(
     if (m_callable_function_infos[index].m_kind != mi::neuraylib::ITarget_code::FK_DF_INIT)
         return -2;
 
-    const char *args_data = NULL;
-    if (cap_args != NULL)
-        args_data = cap_args->get_data();
-    else
-    {
-        mi::Size block_index = get_callable_function_argument_block_index(index);
-        if (block_index != mi::Size(~0) &&
-            block_index < m_cap_arg_blocks.size() &&
-            m_cap_arg_blocks[block_index])
-        {
-            args_data = m_cap_arg_blocks[block_index]->get_data();
-        }
-    }
+    const char *args_data = get_cap_args_data(index, cap_args);
 
     return m_native_code->run_init(
         index,
@@ -410,19 +423,7 @@ mi::Sint32 Target_code::execute_generic_function(
     if (m_callable_function_infos[index].m_dist_kind != dist_kind) return -2;
     if (m_callable_function_infos[index].m_kind != func_kind) return -2;
 
-    const char *args_data = NULL;
-    if (cap_args != NULL)
-        args_data = cap_args->get_data();
-    else
-    {
-        mi::Size block_index = get_callable_function_argument_block_index(index);
-        if (block_index != mi::Size(~0) &&
-            block_index < m_cap_arg_blocks.size() &&
-            m_cap_arg_blocks[block_index])
-        {
-            args_data = m_cap_arg_blocks[block_index]->get_data();
-        }
-    }
+    const char *args_data = get_cap_args_data(index, cap_args);
 
     return m_native_code->run_generic(
         index,
@@ -433,6 +434,43 @@ mi::Sint32 Target_code::execute_generic_function(
         args_data) ? 0 : -1;
 }
 
+// packet variant of execute_generic_function()
+mi::Sint32 Target_code::execute_generic_packet(
+    mi::neuraylib::ITarget_code::Distribution_kind dist_kind,
+    mi::neuraylib::ITarget_code::Function_kind func_kind,
+    mi::Size index,
+    mi::Size count,
+    void *data,
+    mi::Size data_size,
+    const mi::neuraylib::Shading_state_material *states,
+    mi::neuraylib::Texture_handler_base* tex_handler,
+    const mi::neuraylib::ITarget_argument_block *cap_args) const
+{
+    if (!m_native_code.is_valid_interface()) return -2;
+    if (index >= m_callable_function_infos.size()) return -2;
+    if (m_callable_function_infos[index].m_dist_kind != dist_kind) return -2;
+    if (m_callable_function_infos[index].m_kind != func_kind) return -2;
+    if (count == 0) return 0;
+
+    const char *args_data = get_cap_args_data(index, cap_args);
+
+    // the states array is of the layout the code was generated for
+    mi::Size state_size = m_use_derivatives
+        ? sizeof(mi::neuraylib::Shading_state_material_with_derivs)
+        : sizeof(mi::neuraylib::Shading_state_material);
+
+    return m_native_code->run_generic_packet(
+        index,
+        count,
+        data,
+        data_size,
+        // ugly cast necessary because the C++ I/F cannot handle the layout options
+        reinterpret_cast<const mi::mdl::Shading_state_material*>(states),
+        state_size,
+        tex_handler,
+        args_data) ? 0 : -1;
+}
+
 
 mi::Sint32 Target_code::execute(
     mi::Size index,
@@ -507,6 +545,45 @@ mi::Sint32 Target_code::execute_bsdf_pdf(
         mi::neuraylib::ITarget_code::FK_DF_PDF, index, data, state, tex_handler, cap_args);
 }
 
+mi::Sint32 Target_code::execute_bsdf_sample_packet(
+    mi::Size index,
+    mi::Size count,
+    mi::neuraylib::Bsdf_sample_data *data,
+    const mi::neuraylib::Shading_state_material *states,
+    mi::neuraylib::Texture_handler_base* tex_handler,
+    const mi::neuraylib::ITarget_argument_block *cap_args) const
+{
+    return execute_generic_packet(mi::neuraylib::ITarget_code::DK_BSDF,
+        mi::neuraylib::ITarget_code::FK_DF_SAMPLE, index, count,
+        data, sizeof(mi::neuraylib::Bsdf_sample_data), states, tex_handler, cap_args);
+}
+
+mi::Sint32 Target_code::execute_bsdf_evaluate_packet(
+    mi::Size index,
+    mi::Size count,
+    mi::neuraylib::Bsdf_evaluate_data *data,
+    const mi::neuraylib::Shading_state_material *states,
+    mi::neuraylib::Texture_handler_base* tex_handler,
+    const mi::neuraylib::ITarget_argument_block *cap_args) const
+{
+    return execute_generic_packet(mi::neuraylib::ITarget_code::DK_BSDF,
+        mi::neuraylib::ITarget_code::FK_DF_EVALUATE, index, count,
+        data, sizeof(mi::neuraylib::Bsdf_evaluate_data), states, tex_handler, cap_args);
+}
+
+mi::Sint32 Target_code::execute_bsdf_pdf_packet(
+    mi::Size index,
+    mi::Size count,
+    mi::neuraylib::Bsdf_pdf_data *data,
+    const mi::neuraylib::Shading_state_material *states,
+    mi::neuraylib::Texture_handler_base* tex_handler,
+    const mi::neuraylib::ITarget_argument_block *cap_args) const
+{
+    return execute_generic_packet(mi::neuraylib::ITarget_code::DK_BSDF,
+        mi::neuraylib::ITarget_code::FK_DF_PDF, index, count,
+        data, sizeof(mi::neuraylib::Bsdf_pdf_data), states, tex_handler, cap_args);
+}
+
 mi::Sint32 Target_code::execute_edf_init(
     mi::Size index,
     mi::neuraylib::Shading_state_material& state,
@@ -550,6 +627,11 @@ mi::Sint32 Target_code::execute_edf_pdf(
         mi::neuraylib::ITarget_code::FK_DF_PDF, index, data, state, tex_handler, cap_args);
 }
 
+const char* Target_code::get_timing_report() const
+{
+    return m_timing_report.c_str();
+}
+
 Target_code::State_usage Target_code::get_render_state_usage() const
 {
     return m_render_state_usage;
@@ -721,19 +803,40 @@ mi::neuraylib::ITarget_argument_block *Target_code::create_argument_block(
     return arg_block;
 }
 
+// Create a target argument block for an edited class-compiled material for this target code.
+mi::neuraylib::ITarget_argument_block *Target_code::create_argument_block_for_edit(
+    Size index,
+    const mi::neuraylib::ICompiled_material* material,
+    mi::neuraylib::ITarget_resource_callback *resource_callback) const
+{
+    if ( !material || index >= m_cap_arg_material_hashes.size())
+        return NULL;
+
+    // the arguments are not part of the hash of class-compiled materials, so an identical hash
+    // means an identical structure and thus an identical argument block layout
+    mi::base::Uuid const &hash = m_cap_arg_material_hashes[index];
+    if ( hash == mi::base::Uuid() || hash != material->get_hash())
+        return NULL;
+
+    return create_argument_block( index, material, resource_callback);
+}
+
 // Initializes the target argument block for the class-compiled material which was used
 // to generate this target code and adds all resources from the arguments to the target code
 // resource lists.
 void Target_code::init_argument_block(
     Size index,
     MI::DB::Transaction* transaction,
-    const MDL::IValue_list* args)
+    const MDL::IValue_list* args,
+    const mi::base::Uuid& material_hash)
 {
     ASSERT( M_BACKENDS, index < m_cap_arg_blocks.size() &&
         "captured argument block not prepared");
     if ( !args || index >= m_cap_arg_blocks.size())
         return;
 
+    m_cap_arg_material_hashes[index] = material_hash;
+
     // Argument block already initialized? Do nothing
     if ( m_cap_arg_blocks[index])
         return;
@@ -769,6 +872,7 @@ mi::Size Target_code::add_argument_block_layout(Target_value_layout *layout)
 {
     m_cap_arg_layouts.push_back(mi::base::make_handle_dup(layout));
     m_cap_arg_blocks.push_back(mi::base::Handle<mi::neuraylib::ITarget_argument_block>());
+    m_cap_arg_material_hashes.push_back(mi::base::Uuid());
     return m_cap_arg_layouts.size() - 1;
 }
 
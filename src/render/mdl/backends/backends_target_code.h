@@ -238,6 +238,20 @@ public:
         const mi::neuraylib::ICompiled_material *material,
         mi::neuraylib::ITarget_resource_callback *resource_callback) const NEURAY_OVERRIDE;
 
+    /// Create a new target argument block for an edited class-compiled material, reusing this
+    /// target code.
+    ///
+    /// \param index              The index of the base target argument block of this target code.
+    /// \param material           The edited class-compiled MDL material.
+    /// \param resource_callback  Callback for retrieving resource indices for resource values.
+    ///
+    /// \returns the generated target argument block or \c NULL if the index was invalid or the
+    ///          hash of the material differs from the one used to generate this target code.
+    mi::neuraylib::ITarget_argument_block *create_argument_block_for_edit(
+        Size index,
+        const mi::neuraylib::ICompiled_material *material,
+        mi::neuraylib::ITarget_resource_callback *resource_callback) const NEURAY_OVERRIDE;
+
     /// Get a captured arguments block layout if available.
     ///
     /// \param index   The index of the target argument block.
@@ -458,6 +472,35 @@ public:
         mi::neuraylib::Texture_handler_base* tex_handler,
         const mi::neuraylib::ITarget_argument_block *cap_args) const NEURAY_OVERRIDE;
 
+    /// Run the BSDF sample function for this code on the native CPU for a packet of samples.
+    mi::Sint32 execute_bsdf_sample_packet(
+        mi::Size index,
+        mi::Size count,
+        mi::neuraylib::Bsdf_sample_data *data,
+        const mi::neuraylib::Shading_state_material *states,
+        mi::neuraylib::Texture_handler_base* tex_handler,
+        const mi::neuraylib::ITarget_argument_block *cap_args) const NEURAY_OVERRIDE;
+
+    /// Run the BSDF evaluation function for this code on the native CPU for a packet of
+    /// directions.
+    mi::Sint32 execute_bsdf_evaluate_packet(
+        mi::Size index,
+        mi::Size count,
+        mi::neuraylib::Bsdf_evaluate_data *data,
+        const mi::neuraylib::Shading_state_material *states,
+        mi::neuraylib::Texture_handler_base* tex_handler,
+        const mi::neuraylib::ITarget_argument_block *cap_args) const NEURAY_OVERRIDE;
+
+    /// Run the BSDF PDF calculation function for this code on the native CPU for a packet of
+    /// directions.
+    mi::Sint32 execute_bsdf_pdf_packet(
+        mi::Size index,
+        mi::Size count,
+        mi::neuraylib::Bsdf_pdf_data *data,
+        const mi::neuraylib::Shading_state_material *states,
+        mi::neuraylib::Texture_handler_base* tex_handler,
+        const mi::neuraylib::ITarget_argument_block *cap_args) const NEURAY_OVERRIDE;
+
     /// Run the EDF init function for this code on the native CPU.
     mi::Sint32 execute_edf_init(
         mi::Size index,
@@ -489,6 +532,9 @@ public:
         mi::neuraylib::Texture_handler_base* tex_handler,
         const mi::neuraylib::ITarget_argument_block *cap_args) const NEURAY_OVERRIDE;
 
+    /// Returns the timing report of the JIT optimizer.
+    const char* get_timing_report() const NEURAY_OVERRIDE;
+
 
     // non-API methods.
 
@@ -551,11 +597,13 @@ public:
     /// \param index         The index of the target argument block
     /// \param transaction   Transaction to retrieve resource names from tags
     /// \param args          The argument list of the compiled material
+    /// \param material_hash The hash of the compiled material
     /// \return              The generated target argument block
     void init_argument_block(
         mi::Size index,
         MI::DB::Transaction* transaction,
-        const MDL::IValue_list* args);
+        const MDL::IValue_list* args,
+        const mi::base::Uuid& material_hash);
 
     /// Returns the resource index for use in an \c ITarget_argument_block of resources already
     /// known when this \c Target_code object was generated.
@@ -591,6 +639,9 @@ private:
     /// The code.
     std::string m_code;
 
+    /// The timing report of the JIT optimizer if any.
+    std::string m_timing_report;
+
     /// The code segments if any.
     std::vector<std::string> m_code_segments;
 
@@ -651,6 +702,24 @@ private:
         mi::neuraylib::Texture_handler_base* tex_handler,
         const mi::neuraylib::ITarget_argument_block *cap_args) const;
 
+    // packet variant of execute_generic_function(), data points to count elements of data_size,
+    // states to count elements of the state type the code was generated for
+    mi::Sint32 execute_generic_packet(
+        mi::neuraylib::ITarget_code::Distribution_kind dist_kind,
+        mi::neuraylib::ITarget_code::Function_kind func_kind,
+        mi::Size index,
+        mi::Size count,
+        void *data,
+        mi::Size data_size,
+        const mi::neuraylib::Shading_state_material *states,
+        mi::neuraylib::Texture_handler_base* tex_handler,
+        const mi::neuraylib::ITarget_argument_block *cap_args) const;
+
+    // get the captured arguments data for a callable function
+    const char *get_cap_args_data(
+        mi::Size index,
+        const mi::neuraylib::ITarget_argument_block *cap_args) const;
+
     /// The texture resource table.
     std::vector<Texture_info> m_texture_table;
 
@@ -705,6 +774,10 @@ private:
     /// The captured arguments blocks.
     std::vector<mi::base::Handle<mi::neuraylib::ITarget_argument_block> > m_cap_arg_blocks;
 
+    /// The hashes of the class-compiled materials used for the captured arguments blocks, a null
+    /// UUID if unknown.
+    std::vector<mi::base::Uuid> m_cap_arg_material_hashes;
+
     /// The resource handler if any.
     MDLRT::Resource_handler *m_rh;
 
@@ -716,6 +789,10 @@ private:
 
     /// True, if the builtin resource handler is supposed to be used when running native code
     bool m_use_builtin_resource_handler;
+
+    /// True, if the native code was generated with derivative support, i.e. it expects
+    /// states of type Shading_state_material_with_derivs.
+    bool m_use_derivatives;
 };
 
 } // namespace BACKENDS
@@ -83,8 +83,8 @@ protected:
     unsigned        m_has_data[2];                // true if there is a measurement for this part
     float*          m_eval_data[2];               // uses filter mode cudaFilterModeLinear
     float           m_max_albedo[2];              // max albedo used to limit the multiplier
-    float*          m_sample_data[2];             // CDFs for sampling a BSDF measurement
-    float*          m_albedo_data[2];             // max albedo for each theta (isotropic)
+    const float*    m_sample_data[2];             // CDFs for sampling (owned by the DB element)
+    const float*    m_albedo_data[2];             // max albedo for each theta (isotropic)
 
     mi::Uint32_2    m_angular_resolution[2];      // size of the dataset, needed for texel access
     mi::Float32_2   m_inv_angular_resolution[2];  // the inverse values of the size of the dataset
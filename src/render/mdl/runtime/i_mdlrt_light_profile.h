@@ -74,7 +74,7 @@ protected:
     float   m_candela_multiplier;           // factor to rescale the normalized data
     float   m_total_power;                  // power of the light source to be able to rescale
 
-    float*  m_cdf_data;                     // CDFs for sampling a light profile
+    const float* m_cdf_data;                // CDFs for sampling (owned by the DB element)
 };
 
 }  // MDLRT
@@ -74,7 +74,7 @@ Bsdf_measurement::Bsdf_measurement(Tag_type const  &bm_t, DB::Transaction *trans
     dataset = mi::base::Handle<const mi::neuraylib::IBsdf_isotropic_data>(
         m_bsdf_measurement->get_transmission<const mi::neuraylib::IBsdf_isotropic_data>());
     if (dataset)
-        prepare_mbsdfs_part(mi::mdl::stdlib::mbsdf_data_reflection, dataset.get());
+        prepare_mbsdfs_part(mi::mdl::stdlib::mbsdf_data_transmission, dataset.get());
 }
 
 Bsdf_measurement::~Bsdf_measurement()
@@ -84,8 +84,6 @@ Bsdf_measurement::~Bsdf_measurement()
         if(m_has_data[i] == 1u)
         {
             delete[] m_eval_data[i];
-            delete[] m_sample_data[i];
-            delete[] m_albedo_data[i];
         }
     }
 }
@@ -113,100 +111,16 @@ void Bsdf_measurement::prepare_mbsdfs_part(Mbsdf_part part,
     const mi::Float32* src_data = buffer->get_data();
 
     // ----------------------------------------------------------------------------------------
-    // prepare importance sampling data:
-    // - for theta_in we will be able to perform a two stage CDF, first to select theta_out,
-    //   and second to select phi_out
-    // - maximum component is used to "probability" in case of colored measurements
-
-    // CDF of the probability to select a certain theta_out for a given theta_in
-    const unsigned int cdf_theta_size = res.x * res.x;
-
-    // for each of theta_in x theta_out combination, a CDF of the probabilities to select a
-    // a certain theta_out is stored
-    const unsigned sample_data_size = cdf_theta_size + cdf_theta_size * res.y;
-    float* sample_data = new float[sample_data_size];
-
-    float* albedo_data = new float[res.x]; // albedo for sampling reflection and transmission
-
-    float* sample_data_theta = sample_data;                // begin of the first (theta) CDF
-    float* sample_data_phi = sample_data + cdf_theta_size; // begin of the second (phi) CDFs
-
-    const float s_theta = (float) (M_PI * 0.5) / float(res.x);  // step size
-    const float s_phi = (float) (M_PI) / float(res.y);          // step size
-
-    float max_albedo = 0.0f;
-    for (unsigned int t_in = 0; t_in < res.x; ++t_in)
-    {
-        float sum_theta = 0.0f;
-        float sintheta0_sqd = 0.0f;
-        for (unsigned int t_out = 0; t_out < res.x; ++t_out)
-        {
-            const float sintheta1 = sinf(float(t_out + 1) * s_theta);
-            const float sintheta1_sqd = sintheta1 * sintheta1;
-
-            // BSDFs are symmetric: f(w_in, w_out) = f(w_out, w_in)
-            // take the average of both measurements
-
-            // area of two the surface elements (the ones we are averaging) 
-            const float mu = (sintheta1_sqd - sintheta0_sqd) * s_phi * 0.5f;
-            sintheta0_sqd = sintheta1_sqd;
-
-            // offset for both the thetas into the measurement data (select row in the volume) 
-            const unsigned int offset_phi  = (t_in  * res.x + t_out) * res.y;
-            const unsigned int offset_phi2 = (t_out * res.x + t_in)  * res.y;
-
-            // build CDF for phi
-            float sum_phi = 0.0f;
-            for (unsigned int p_out = 0; p_out < res.y; ++p_out)
-            {
-                const unsigned int idx  = offset_phi  + p_out;
-                const unsigned int idx2 = offset_phi2 + p_out;
-
-                float value = 0.0f;
-                if (num_channels == 3)
-                {
-                    value = fmax(fmaxf(src_data[3 * idx + 0], src_data[3 * idx + 1]),
-                                 fmaxf(src_data[3 * idx + 2], 0.0f))
-                          + fmax(fmaxf(src_data[3 * idx2 + 0], src_data[3 * idx2 + 1]),
-                                 fmaxf(src_data[3 * idx2 + 2], 0.0f));
-                }
-                else /* num_channels == 1 */
-                {
-                    value = fmaxf(src_data[idx], 0.0f) + fmaxf(src_data[idx2], 0.0f);
-                }
-
-                sum_phi += value * mu;
-                sample_data_phi[idx] = sum_phi;
-            }
-
-            // normalize CDF for phi
-            for (unsigned int p_out = 0; p_out < res.y; ++p_out)
-            {
-                const unsigned int idx = offset_phi + p_out;
-                sample_data_phi[idx] = sample_data_phi[idx] / sum_phi;
-            }
-
-            // build CDF for theta
-            sum_theta += sum_phi;
-            sample_data_theta[t_in * res.x + t_out] = sum_theta;
-        }
-
-        if (sum_theta > max_albedo)
-            max_albedo = sum_theta;
-
-        albedo_data[t_in] = sum_theta;
-
-        // normalize CDF for theta 
-        for (unsigned int t_out = 0; t_out < res.x; ++t_out)
-        {
-            const unsigned int idx = t_in * res.x + t_out;
-            sample_data_theta[idx] = sample_data_theta[idx] / sum_theta;
-        }
-    }
-
-    m_sample_data[part_idx] = sample_data;
-    m_albedo_data[part_idx] = albedo_data;
-    m_max_albedo[part_idx] = max_albedo;
+    // importance sampling data is precomputed and owned by the DB element
+    const BSDFM::Sampling_data& sampling_data
+        = part == mi::mdl::stdlib::mbsdf_data_reflection
+            ? m_bsdf_measurement->get_reflection_sampling_data()
+            : m_bsdf_measurement->get_transmission_sampling_data();
+
+    m_sample_data[part_idx] = sampling_data.m_cdf.empty() ? nullptr : &sampling_data.m_cdf[0];
+    m_albedo_data[part_idx]
+        = sampling_data.m_albedo.empty() ? nullptr : &sampling_data.m_albedo[0];
+    m_max_albedo[part_idx] = sampling_data.m_max_albedo;
 
 
     // ----------------------------------------------------------------------------------------
@@ -43,6 +43,7 @@ namespace MI {
 namespace MDLRT {
 
 Light_profile::Light_profile()
+: m_cdf_data(nullptr)
 {
 }
 
@@ -63,74 +64,15 @@ Light_profile::Light_profile(
     m_inv_delta_t = m_delta_t ? (1.f / m_delta_t) : 0.f;
     m_inv_delta_p = m_delta_p ? (1.f / m_delta_p) : 0.f;
 
-    // phi-mayor: [m_m_res_t x m_res_p]
-    const float* m_data = m_light_profile->get_data();
     m_candela_multiplier = m_light_profile->get_candela_multiplier();
-    m_total_power = 0.0f;
+    m_total_power = m_light_profile->get_power();
 
-    // -------------------------------------------------------------------------------------------- 
-    // compute total power
-    // compute inverse CDF data for sampling
-    // sampling will work on cells rather than grid nodes (used for evaluation)
-
-    // first (m_m_res_t-1) for the cdf for sampling theta
-    // rest (rex_t-1) * (m_res_p-1) for the individual cdfs for sampling phi (after theta)
-    size_t cdf_data_size = (m_res_t - 1) + (m_res_t - 1) * (m_res_p - 1);
-    this->m_cdf_data = new float[cdf_data_size];
-
-    float sum_theta = 0.0;
-    float cos_theta0 = cosf(m_start_t);
-    for (unsigned int t = 0; t < m_res_t - 1; ++t)
-    {
-        const float cos_theta1 = cosf(m_start_t + float(t + 1) * m_delta_t);
-
-        // area of the patch (grid cell)
-        // \mu = int_{theta0}^{theta1} sin{theta} \delta theta
-        const float mu = cos_theta0 - cos_theta1;
-        cos_theta0 = cos_theta1;
-
-        // build CDF for phi
-        float* cdf_data_phi = m_cdf_data + (m_res_t - 1) + t * (m_res_p - 1);
-        float sum_phi = 0.0f;
-        for (unsigned int p = 0; p < m_res_p - 1; ++p)
-        {
-            // the probability to select a patch corresponds to the value times area
-            // the value of a cell is the average of the corners
-            // omit the *1/4 as we normalize in the end
-            float value = m_data[p * m_res_t + t]
-                        + m_data[p * m_res_t + t + 1]
-                        + m_data[(p + 1) * m_res_t + t]
-                        + m_data[(p + 1) * m_res_t + t + 1];
-
-            sum_phi += value * mu;
-            cdf_data_phi[p] = sum_phi;
-        }
-
-        // normalize CDF for phi
-        for (unsigned int p = 0; p < m_res_p - 2; ++p)
-            cdf_data_phi[p] = sum_phi ? (cdf_data_phi[p] / sum_phi) : 0.0f;
-
-        cdf_data_phi[m_res_p - 2] = 1.0f;
-
-        // build CDF for theta
-        sum_theta += sum_phi;
-        m_cdf_data[t] = sum_theta;
-    }
-
-    m_total_power = m_candela_multiplier * sum_theta * 0.25f * m_delta_p;
-    // equals m_light_profile->get_power();
-
-    // normalize CDF for theta
-    for (unsigned int t = 0; t < m_res_t - 2; ++t)
-        m_cdf_data[t] = sum_theta ? (m_cdf_data[t] / sum_theta) : m_cdf_data[t];
-
-    m_cdf_data[m_res_t - 2] = 1.0f;
+    // CDFs for sampling are precomputed and owned by the DB element
+    m_cdf_data = m_light_profile->get_cdf_data();
 }
 
 Light_profile::~Light_profile()
 {
-    if (m_cdf_data) 
-        delete[] m_cdf_data;
 }
 
 
@@ -210,6 +152,9 @@ mi::Float32_3 Light_profile::sample(const mi::Float32_3& xi) const
     result.y = -1.0f;
     result.z = 0.0f;
 
+    if (!m_cdf_data)
+        return result; // invalid light profile
+
     // sample theta_out
     //-------------------------------------------
     float xi0 = xi.x;
@@ -271,6 +216,9 @@ mi::Float32_3 Light_profile::sample(const mi::Float32_3& xi) const
 
 mi::Float32 Light_profile::pdf(const mi::Float32_2& theta_phi) const
 {
+    if (!m_cdf_data)
+        return 0.0f; // invalid light profile
+
     // map theta to 0..1 range
     float theta = theta_phi.x - m_start_t;
     const int idx_theta = int(theta * m_inv_delta_t);
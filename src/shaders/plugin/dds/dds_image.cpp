@@ -36,12 +36,38 @@
 
 #include <algorithm>
 #include <cstring>
+#include <vector>
 #include <io/image/image/i_image_utilities.h>
 
 namespace MI {
 
 namespace DDS {
 
+namespace {
+
+/// Reads \p size bytes from \p reader.
+///
+/// If the reader supports lookahead, e.g., readers for memory-mapped files, the returned pointer
+/// refers directly to the data of the reader and \p buffer is not used. Otherwise, the data is
+/// read into \p buffer.
+///
+/// \return   The data, or \c NULL in case of failure.
+const mi::Uint8* read_data(
+    mi::neuraylib::IReader* reader, mi::Uint32 size, std::vector<mi::Uint8>& buffer)
+{
+    if( reader->supports_lookahead() && reader->supports_absolute_access()) {
+        const char* data = 0;
+        mi::Sint64 available = reader->lookahead( size, &data);
+        if( data && available >= size && reader->seek_absolute( reader->tell_absolute() + size))
+            return reinterpret_cast<const mi::Uint8*>( data);
+    }
+
+    buffer.resize( size);
+    mi::Sint64 bytes_read = reader->read( reinterpret_cast<char*>( &buffer[0]), size);
+    return bytes_read == size ? &buffer[0] : 0;
+}
+
+} // namespace
 
 Image::Image()
 {
@@ -264,18 +290,23 @@ bool Image::load( mi::neuraylib::IReader* reader, bool for_hw)
             if( halfs)
                 size /= 2;
 
-            std::vector<mi::Uint8> buffer( size);
-            mi::Sint64 bytes_read = reader->read( reinterpret_cast<char*>( &buffer[0]), size);
-            if( bytes_read != size) {
+            std::vector<mi::Uint8> buffer;
+            const mi::Uint8* data = read_data( reader, size, buffer);
+            if( !data) {
                 clear();
                 return false;
             }
 
-            if( halfs)
+            if( halfs) {
+                if( buffer.empty())
+                    buffer.assign( data, data + size);
                 expand_half( buffer);
+                data = &buffer[0];
+                size = static_cast<mi::Uint32>( buffer.size());
+            }
 
             // Create miplevel
-            Surface surface( width, height, depth, buffer.size(), &buffer[0]);
+            Surface surface( width, height, depth, size, data);
             flip_surface( surface);
 
             m_texture.add_surface( surface);
@@ -317,22 +348,25 @@ bool Image::load( mi::neuraylib::IReader* reader, bool for_hw)
                 if( halfs)
                     size /= 2;
 
-                std::vector<mi::Uint8> buffer( size);
-                mi::Sint64 bytes_read = reader->read( reinterpret_cast<char*>( &buffer[0]), size);
-                if( bytes_read != size) {
+                std::vector<mi::Uint8> buffer;
+                const mi::Uint8* data = read_data( reader, size, buffer);
+                if( !data) {
                     clear();
                     return false;
                 }
 
                 if( halfs) {
+                    if( buffer.empty())
+                        buffer.assign( data, data + size);
                     expand_half( buffer);
+                    data = &buffer[0];
                     size *= 2;
                 }
 
                 // Copy miplevel of this face into corresponding miplevel layer
                 Surface& surface = m_texture.get_surface( s);
                 mi::Uint8* pixels = surface.get_pixels() + face * size;
-                memcpy( pixels, &buffer[0], size);
+                memcpy( pixels, data, size);
 
                 width  = std::max( width  >> 1, 1u);
                 height = std::max( height >> 1, 1u);
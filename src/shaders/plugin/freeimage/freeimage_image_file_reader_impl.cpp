@@ -67,7 +67,7 @@ Image_file_reader_impl::Image_file_reader_impl(
     if( m_format != FIF_TIFF && FreeImage_FIFSupportsNoPixels( m_format))
         flags |= FIF_LOAD_NOPIXELS;
 
-    m_bitmap = FreeImage_LoadFromHandle( m_format, &io, static_cast<fi_handle>( m_reader), flags);
+    m_bitmap = load_from_reader( m_format, m_reader, flags);
 
     if( !m_bitmap) {
         m_resolution_x = 1;
@@ -190,9 +190,7 @@ bool Image_file_reader_impl::read(
             flags |= PNG_IGNOREGAMMA;
 
         m_reader->seek_absolute( 0);
-        FreeImageIO io = construct_io_for_reading();
-        m_bitmap = FreeImage_LoadFromHandle(
-            m_format, &io, static_cast<fi_handle>( m_reader), flags);
+        m_bitmap = load_from_reader( m_format, m_reader, flags);
 
         if( !m_bitmap)
             return false;
@@ -127,6 +127,26 @@ FreeImageIO construct_io_for_writing()
     return result;
 }
 
+FIBITMAP* load_from_reader( FREE_IMAGE_FORMAT format, mi::neuraylib::IReader* reader, int flags)
+{
+    if( reader->supports_lookahead() && reader->supports_absolute_access()) {
+        mi::Sint64 size = reader->get_file_size() - reader->tell_absolute();
+        const char* data = 0;
+        if(    size > 0 && size <= 0xffffffff
+            && reader->lookahead( size, &data) >= size && data) {
+            // FreeImage does not copy or modify memory passed to FreeImage_OpenMemory()
+            FIMEMORY* memory = FreeImage_OpenMemory(
+                reinterpret_cast<BYTE*>( const_cast<char*>( data)), static_cast<DWORD>( size));
+            FIBITMAP* bitmap = FreeImage_LoadFromMemory( format, memory, flags);
+            FreeImage_CloseMemory( memory);
+            return bitmap;
+        }
+    }
+
+    FreeImageIO io = construct_io_for_reading();
+    return FreeImage_LoadFromHandle( format, &io, static_cast<fi_handle>( reader), flags);
+}
+
 const char* convert_freeimage_pixel_type_to_neuray_pixel_type( FREE_IMAGE_TYPE type)
 {
     switch( type) {
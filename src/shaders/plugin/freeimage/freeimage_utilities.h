@@ -32,6 +32,8 @@
 #include <mi/base.h>
 #include <mi/neuraylib/itile.h>
 
+namespace mi { namespace neuraylib { class IReader; } }
+
 #include <FreeImage.h>
 
 namespace MI {
@@ -53,6 +55,13 @@ FreeImageIO construct_io_for_reading();
 /// Returns a struct with function pointers that can be used for export operations.
 FreeImageIO construct_io_for_writing();
 
+/// Loads a bitmap from a reader, starting at its current position.
+///
+/// If the reader supports lookahead for the remaining data, e.g., readers for memory-mapped files,
+/// the bitmap is decoded directly from that data. Otherwise, the data is read via the function
+/// pointers from #construct_io_for_reading().
+FIBITMAP* load_from_reader( FREE_IMAGE_FORMAT format, mi::neuraylib::IReader* reader, int flags);
+
 /// Converts a FreeImage pixel type to a neuray pixel type.
 ///
 /// Note that this method can not handle FIT_BITMAP (not enough information). Use the overloaded